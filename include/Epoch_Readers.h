@@ -0,0 +1,39 @@
+#ifndef CLASS_EPOCH_READERS_H
+#define CLASS_EPOCH_READERS_H
+
+#include <atomic>
+
+#define EPOCH_READERS_STRIPES	8
+
+/**
+ * @brief Epoch based reclamation for data published through an atomic pointer and read without locks.
+ * @details Readers never block: 'read_begin()' registers the reader in a striped counter of the current
+ *  epoch, 'read_end()' unregisters it. A writer publishes the new data, calls 'synchronize()', that flips the
+ *  epoch twice and waits until no reader can still access the previous data, and then frees it. Writers must
+ *  be serialized by the caller.
+ */
+class Epoch_Readers {
+	private:
+	struct alignas(64) readers_t {
+		std::atomic<unsigned int> count[2]; // indexed by the parity of the epoch
+	};
+	mutable readers_t readers[EPOCH_READERS_STRIPES];
+	std::atomic<unsigned int> epoch;
+
+	public:
+	Epoch_Readers();
+	/**
+	 * @brief Registers a reader in the current epoch.
+	 * @return The counter to pass to 'read_end()'.
+	 */
+	std::atomic<unsigned int>& read_begin() const;
+	static inline void read_end(std::atomic<unsigned int>& count) {
+		count.fetch_sub(1, std::memory_order_release);
+	}
+	/**
+	 * @brief Waits until all the readers registered before the call are gone.
+	 */
+	void synchronize();
+};
+
+#endif // CLASS_EPOCH_READERS_H
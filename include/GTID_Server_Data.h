@@ -10,18 +10,22 @@ class GTID_Server_Data {
 	size_t size;
 	size_t pos;
 	struct ev_io *w;
-	char uuid_server[64];
+	GTID_Stream_Parser parser;
 	unsigned long long events_read;
 	gtid_set_t gtid_executed;
+	bool gtid_executed_changed; // 'gtid_executed' changed since the last published snapshot
 	bool active;
 	GTID_Server_Data(struct ev_io *_w, char *_address, uint16_t _port, uint16_t _mysql_port);
 	void resize(size_t _s);
 	~GTID_Server_Data();
 	bool readall();
 	bool writeout();
-	bool read_next_gtid();
 	bool gtid_exists(char *gtid_uuid, uint64_t gtid_trxid);
 	void read_all_gtids();
 	void dump();
+	/**
+	 * @brief Publishes a snapshot of 'gtid_executed' for the lookups of 'MySQL_HostGroups_Manager::gtid_exists'.
+	 */
+	void publish_snapshot();
 };
 #endif // CLASS_GTID_Server_Data_H
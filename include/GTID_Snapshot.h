@@ -0,0 +1,57 @@
+#ifndef CLASS_GTID_Snapshot_H
+#define CLASS_GTID_Snapshot_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "proxysql_gtid.h"
+#include "Epoch_Readers.h"
+
+/**
+ * @brief Immutable copy of the GTID executed set of a server.
+ * @details The uuids and the intervals of every uuid are stored sorted in contiguous arrays, lookups are
+ *  binary searches.
+ */
+class GTID_Snapshot {
+	private:
+	std::vector<std::pair<std::string, std::vector<gtid_interval_t>>> uuids;
+
+	public:
+	explicit GTID_Snapshot(const gtid_set_t& gtid_executed);
+	bool gtid_exists(const char *gtid_uuid, int64_t gtid_trxid) const;
+};
+
+typedef std::unordered_map<std::string, std::shared_ptr<const GTID_Snapshot>> gtid_snapshots_t;
+
+/**
+ * @brief The GTID snapshots of all the servers ("address:port"), published for wait-free lookups.
+ * @details Readers never block: they read the published map under 'Epoch_Readers'. Writers (the GTID thread)
+ *  copy the map, replace the snapshot of one server, publish the new map and wait until no reader can still
+ *  access the previous map before freeing it. A server's snapshot is shared by all the maps that reference it.
+ */
+class GTID_Snapshots {
+	private:
+	Epoch_Readers readers;
+	std::atomic<gtid_snapshots_t *> current;
+	std::mutex writers_mutex;
+
+	public:
+	GTID_Snapshots();
+	~GTID_Snapshots();
+	/**
+	 * @brief Checks if the GTID was executed on the server, according to its last published snapshot.
+	 * @return 'false' if the GTID wasn't executed, or if there is no snapshot for the server.
+	 */
+	bool gtid_exists(const std::string& server, const char *gtid_uuid, int64_t gtid_trxid);
+	/**
+	 * @brief Replaces the snapshot of the server. A NULL 'snapshot' removes the server.
+	 */
+	void publish(const std::string& server, std::shared_ptr<const GTID_Snapshot> snapshot);
+};
+
+#endif // CLASS_GTID_Snapshot_H
@@ -24,6 +24,8 @@ typedef struct P_st_ma_pvio_tls {
 
 #define QUEUE_T_DEFAULT_SIZE	32768
 #define MY_SSL_BUFFER	8192
+#define GATHER_OUT_MAX_IOV	64	// max number of packets sent by a single gather_to_net() call
+#define GATHER_OUT_MAX_BYTES	(QUEUE_T_DEFAULT_SIZE*8)	// max number of bytes sent by a single gather_to_net() call
 
 typedef struct _queue_t {
 	void *buffer;
@@ -172,6 +174,11 @@ class MySQL_Data_Stream
 
 	bool encrypted;
 	bool net_failure;
+	bool recv_buffer_filled; // true if the last recv() of read_from_net() filled all the space available in queueIN
+
+	int splice_pipe[2]; // pipe used by the peer's splice_to() to relay data to this data stream without copying it
+	unsigned int splice_pipe_len; // bytes in splice_pipe not yet written to fd
+	unsigned int gather_partial; // bytes of the first packet in PSarrayOUT already sent by gather_to_net()
 
 	uint8_t pkt_sid;
 
@@ -188,6 +195,11 @@ class MySQL_Data_Stream
 	void shut_hard();
 	int read_from_net();
 	int write_to_net();
+	bool can_splice_to(MySQL_Data_Stream *dst);
+	int splice_to(MySQL_Data_Stream *dst);
+	int splice_flush();
+	bool can_gather_out();
+	int gather_to_net();
 	int write_to_net_poll();
 	bool available_data_out();	
 	void remove_pollout();
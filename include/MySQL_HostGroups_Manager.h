@@ -131,6 +131,8 @@ std::string gtid_executed_to_string(gtid_set_t& gtid_executed);
 void addGtid(const gtid_t& gtid, gtid_set_t& gtid_executed);
 
 #include "GTID_Server_Data.h"
+#include "GTID_Snapshot.h"
+#include "MySQL_Passive_Health.h"
 
 /*
 class GTID_Server_Data {
@@ -163,27 +165,28 @@ class GTID_Server_Data {
 class MySrvConnList {
 	private:
 	MySrvC *mysrvc;
-	int find_idx(MySQL_Connection *c) {
-		//for (unsigned int i=0; i<conns_length(); i++) {
-		for (unsigned int i=0; i<conns->len; i++) {
-			MySQL_Connection *conn = NULL;
-			conn = (MySQL_Connection *)conns->index(i);
-			if (conn==c) {
-				return (unsigned int)i;
-			}
-		}
-		return -1;
-	}
+	/**
+	 * @brief Index of the connections by 'MySQL_Connection::pool_fingerprint'.
+	 * @details Maintained only for lists of free connections, it allows
+	 *  'get_random_MyConn' to find a perfect match without scanning the list.
+	 *  Every connection knows its position in its bucket ('pool_fingerprint_idx'),
+	 *  so that removals and random picks don't scan the bucket either.
+	 */
+	std::unordered_map<uint64_t, std::vector<MySQL_Connection *>> fingerprints;
+	bool indexed;
+	int find_idx(MySQL_Connection *c);
+	void fingerprint_remove(MySQL_Connection *c);
+	MySQL_Connection * get_MyConn_by_fingerprint(const MySQL_Connection *client_conn);
 	public:
 	PtrArray *conns;
-	MySrvConnList(MySrvC *);
+	MySrvConnList(MySrvC *, bool _indexed=false);
 	~MySrvConnList();
 	void add(MySQL_Connection *);
 	void remove(MySQL_Connection *c) {
 		int i = -1;
 		i = find_idx(c);
 		assert(i>=0);
-		conns->remove_index_fast((unsigned int)i);
+		remove(i);
 	}
 	MySQL_Connection *remove(int);
 	MySQL_Connection * get_random_MyConn(MySQL_Session *sess, bool ff);
@@ -206,12 +209,15 @@ class MySrvC {	// MySQL Server Container
 	unsigned int aws_aurora_current_lag_us;
 	unsigned int max_replication_lag;
 	unsigned int max_connections_used; // The maximum number of connections that has been opened
+	unsigned int prewarm_used_peak; // peak of the connections used since the last planning, see 'MyHGC::plan_prewarm_connections'
+	unsigned int prewarm_connecting; // connections being pre-opened, already in 'ConnectionsUsed'
 	unsigned int connect_OK;
 	unsigned int connect_ERR;
 	int cur_replication_lag;
 	unsigned int cur_replication_lag_count;
 	// note that these variables are in microsecond, while user defines max latency in millisecond
 	unsigned int current_latency_us;
+	unsigned int ping_latency_us; // latency reported by the monitor, 'current_latency_us' can be higher from live traffic
 	unsigned int max_latency_us;
 	time_t time_last_detected_error;
 	unsigned int connect_ERR_at_time_last_detected_error;
@@ -251,6 +257,20 @@ class MySrvC {	// MySQL Server Container
 	~MySrvC();
 	void connect_error(int, bool get_mutex=true);
 	void shun_and_killall();
+	MySQL_Passive_Health passive_health;
+	/**
+	 * @brief Records a query successfully executed on the server, see 'mysql-passive_health_latency_percentile'.
+	 * @param now Current monotonic time.
+	 * @param time_us Execution time of the query.
+	 */
+	void passive_query_ok(unsigned long long now, unsigned long long time_us);
+	/**
+	 * @brief Records a query failed on the server, see 'mysql-passive_health_error_pct'. If the ratio of
+	 *   failed queries in the current window reaches the threshold, the server is automatically shunned.
+	 * @param now Current monotonic time.
+	 * @param err The error returned by the server.
+	 */
+	void passive_query_error(unsigned long long now, int err);
 	/**
 	 * @brief Update the maximum number of used connections
 	 * @return The maximum number of used connections
@@ -262,6 +282,17 @@ class MySrvC {	// MySQL Server Container
 			max_connections_used = connections_used;
 		return max_connections_used;
 	}
+	/**
+	 * @brief Records the connections used after a checkout, excluding the ones being pre-opened.
+	 */
+	inline
+	void update_prewarm_used_peak() {
+		unsigned int connections_used = ConnectionsUsed->conns_length();
+		unsigned int connecting = __sync_fetch_and_add(&prewarm_connecting, 0);
+		connections_used = connections_used > connecting ? connections_used - connecting : 0;
+		if (prewarm_used_peak < connections_used)
+			prewarm_used_peak = connections_used;
+	}
 	void set_status(MySerStatus _status);
 	inline
 	MySerStatus get_status() const { return status; }
@@ -291,6 +322,13 @@ class MyHGC {	// MySQL Host Group Container
 	unsigned long long current_time_now;
 	uint32_t new_connections_now;
 	MySrvList *mysrvs;
+	/**
+	 * @brief Protects the connection lists of the servers in this hostgroup.
+	 * @details Only needed by threads holding the global lock in shared mode
+	 *  (see 'MySQL_HostGroups_Manager::pool_rdlock'), as 'wrlock' excludes
+	 *  any access to the connection pool.
+	 */
+	pthread_mutex_t pool_mutex;
 	struct { // this is a series of attributes specific for each hostgroup
 		char * init_connect;
 		char * comment;
@@ -301,6 +339,7 @@ class MyHGC {	// MySQL Host Group Container
 		int8_t autocommit;
 		int8_t free_connections_pct;
 		int8_t handle_warnings;
+		int8_t server_selection; // 'hostgroup_settings.server_selection', see 'get_random_MySrvC'
 		bool multiplex;
 		bool connection_warming;
 		bool configured; // this variable controls if attributes are configured or not. If not configured, they do not apply
@@ -312,11 +351,64 @@ class MyHGC {	// MySQL Host Group Container
 		int64_t max_connections;
 		int32_t use_ssl;
 	} servers_defaults;
+	/**
+	 * @brief Precomputed weighted selection of the ONLINE servers, used by 'get_random_MySrvC'.
+	 * @details Rebuilt lazily, only after 'invalidate_selection' is called because of a change
+	 *  of servers, status or weight. Accessed only holding 'pool_mutex' or the exclusive lock.
+	 */
+	struct {
+		std::vector<MySrvC *> servers;
+		std::vector<uint64_t> cumulative_weights; // running sum of the weights of 'servers'
+		bool usable; // false if the full scan is required, e.g. there are SHUNNED servers to recover
+	} selection;
+	std::atomic<bool> selection_stale;
+	/**
+	 * @brief State of the connection pre-warming, see 'mysql-connection_prewarm_pct'.
+	 * @details Accessed only holding 'pool_mutex' or the exclusive lock.
+	 */
+	struct {
+		std::string username; // frontend user of the last connection checked out
+		std::string schemaname; // its schema, at the time of the checkout
+		double demand; // predicted concurrent connections of the hostgroup: rises to the peak, then decays
+	} prewarm;
+	/**
+	 * @brief Records the user of a connection checked out, pre-opened connections will use it.
+	 */
+	void set_prewarm_user(const MySQL_Connection_userinfo *userinfo);
+	/**
+	 * @brief Updates the predicted demand of the hostgroup and creates the connections missing to serve it.
+	 * @details The demand is the peak of the connections used in the hostgroup since the previous call, kept
+	 *  while decaying slowly so that it survives a failover. Every ONLINE server should have its share of it,
+	 *  by weight, increased by 'mysql-connection_prewarm_pct', within 3/4 of 'max_connections' and without more
+	 *  free connections than 'free_connections_pct' allows: the connections missing are created here, in
+	 *  'ConnectionsUsed', and must be connected by the caller. A server just added to the hostgroup, e.g. a
+	 *  new primary, gets its share at the first call.
+	 * @param curtime Current monotonic time.
+	 * @param conn_list Output array for the created connections.
+	 * @param num_conn Maximum number of connections to create.
+	 * @return The number of connections created.
+	 */
+	int plan_prewarm_connections(unsigned long long curtime, MySQL_Connection **conn_list, int num_conn);
+	inline
+	void invalidate_selection() {
+		selection_stale.store(true, std::memory_order_relaxed);
+	}
+	void rebuild_selection();
+	MySrvC *get_weighted_MySrvC_precomputed();
+	MySrvC *get_random_MySrvC_precomputed();
 	void reset_attributes();
 	inline
 	bool handle_warnings_enabled() const {
 		return attributes.configured == true && attributes.handle_warnings != -1 ? attributes.handle_warnings : mysql_thread___handle_warnings;
 	}
+	/**
+	 * @brief Returns 'true' if the hostgroup selects servers with power-of-two-choices, picking the less
+	 *   loaded of two weighted random candidates, instead of a single weighted random pick.
+	 */
+	inline
+	bool p2c_selection_enabled() const {
+		return attributes.configured == true && attributes.server_selection == 1;
+	}
 	inline
 	int32_t get_monitor_slave_lag_when_null() const {
 		return attributes.configured == true && attributes.monitor_slave_lag_when_null != -1 ? attributes.monitor_slave_lag_when_null : mysql_thread___monitor_slave_lag_when_null;
@@ -604,7 +696,7 @@ class MySQL_HostGroups_Manager {
 	std::set<std::string> read_only_set1;
 	std::set<std::string> read_only_set2;
 #ifdef MHM_PTHREAD_MUTEX
-	pthread_mutex_t lock;
+	pthread_rwlock_t lock;
 #else
 	rwlock_t rwlock;
 #endif
@@ -623,6 +715,11 @@ class MySQL_HostGroups_Manager {
 	};
 
 	std::array<uint64_t, __HGM_TABLES_SIZE> table_resultset_checksum { {0} };
+	/**
+	 * @brief Tables regenerated since their checksum in 'table_resultset_checksum' was computed.
+	 * @details Only the tables regenerated by 'commit()' are marked, the checksums of the others are reused.
+	 */
+	std::array<bool, __HGM_TABLES_SIZE> table_resultset_checksum_stale;
 
 	class HostGroup_Server_Mapping {
 	public:
@@ -734,6 +831,16 @@ class MySQL_HostGroups_Manager {
 
 	void add(MySrvC *, unsigned int);
 	void purge_mysql_servers_table();
+	/**
+	 * @brief Applies 'mysql_servers_incoming' to the live 'MySrvC' objects.
+	 * @details The incoming servers are diffed in memory against the servers currently in 'MyHostGroups':
+	 *  servers missing from 'mysql_servers_incoming' are set OFFLINE_HARD, new servers are created, and only
+	 *  the changed attributes of the other servers are updated. 'myhgm.mysql_servers' isn't touched, it's
+	 *  regenerated once by 'commit_update_checksum_from_mysql_servers()'.
+	 *  Requires caller to hold 'wrlock()'.
+	 * @return True if any server has 'gtid_port' configured.
+	 */
+	bool commit_mysql_servers_incoming();
 	void generate_mysql_servers_table(int *_onlyhg=NULL);
 	void generate_mysql_replication_hostgroups_table();
 	Galera_Info *get_galera_node_info(int hostgroup);
@@ -853,6 +960,10 @@ class MySQL_HostGroups_Manager {
 
 	pthread_rwlock_t gtid_rwlock;
 	std::unordered_map <string, GTID_Server_Data *> gtid_map;
+	/**
+	 * @brief Snapshots of the GTID executed sets in 'gtid_map', used by 'gtid_exists' without locks.
+	 */
+	GTID_Snapshots gtid_snapshots;
 	struct ev_async * gtid_ev_async;
 	struct ev_loop * gtid_ev_loop;
 	struct ev_timer * gtid_ev_timer;
@@ -950,8 +1061,18 @@ class MySQL_HostGroups_Manager {
 	void init();
 	void wrlock();
 	void wrunlock();
+	/**
+	 * @brief Acquires the global lock in shared mode, for the connection pool hot path.
+	 * @details While holding it the hostgroups topology cannot change, but
+	 *  connections can still be checked out and returned concurrently.
+	 *  Connection lists of a hostgroup must only be accessed holding also
+	 *  'MyHGC::pool_mutex' of the hostgroup.
+	 */
+	void pool_rdlock();
+	void pool_rdunlock();
 #ifdef DEBUG
 	bool is_locked = false;
+	std::atomic<unsigned int> is_pool_locked { 0 };
 #endif
 	int servers_add(SQLite3_result *resultset);
 	/**
@@ -1007,10 +1128,12 @@ class MySQL_HostGroups_Manager {
 	 * @param init If the supplied 'SpookyHash' has already being initialized.
 	 * @param TableName The tablename from which to obtain the resultset for the 'raw_checksum' computation.
 	 * @param ColumnName A column name to use for ordering in the supplied 'TableName'.
-	 * @param raw_checksum A 'raw_checksum' to be updated with the obtained resultset.
+	 * @param table The 'table_resultset_checksum' entry to be updated with the obtained resultset. The
+	 *  resultset is only fetched when the table is marked in 'table_resultset_checksum_stale', otherwise
+	 *  the current checksum is reused.
 	 */
 	void CUCFT1(
-		SpookyHash& myhash, bool& init, const string& TableName, const string& ColumnName, uint64_t& raw_checksum
+		SpookyHash& myhash, bool& init, const string& TableName, const string& ColumnName, HGM_TABLES table
 	);
 	/**
 	 * @brief Store the resultset for the 'runtime_mysql_servers' table set that have been loaded to runtime.
@@ -1101,6 +1224,14 @@ class MySQL_HostGroups_Manager {
 
 	void drop_all_idle_connections();
 	int get_multiple_idle_connections(int, unsigned long long, MySQL_Connection **, int);
+	/**
+	 * @brief Creates the connections to pre-open in all the hostgroups, see 'MyHGC::plan_prewarm_connections'.
+	 * @details Called by all the MySQL threads, the planning is performed at most once per second by one of them.
+	 *  The created connections are in 'ConnectionsUsed' and must be connected by the caller.
+	 * @return The number of connections created.
+	 */
+	int get_prewarm_connections(unsigned long long curtime, MySQL_Connection **conn_list, int num_conn);
+	std::atomic<unsigned long long> last_prewarm_planning { 0 };
 	SQLite3_result * SQL3_Connection_Pool(bool _reset, int *hid = NULL);
 	SQLite3_result * SQL3_Free_Connections();
 
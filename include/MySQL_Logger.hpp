@@ -3,8 +3,13 @@
 #include "proxysql.h"
 #include "cpp.h"
 
+#include <atomic>
+
 #define PROXYSQL_LOGGER_PTHREAD_MUTEX
 
+class MySQL_Events_Buffer;
+class MySQL_Events_Block;
+
 class MySQL_Event {
 	private:
 	uint32_t thread_id;
@@ -34,12 +39,14 @@ class MySQL_Event {
 	uint64_t rows_sent;
 	uint32_t client_stmt_id;
 	const char * gtid;
+	int format; // events log format used by write(), 'mysql-eventslog_format' of the thread by default
 	public:
 	MySQL_Event(log_event_type _et, uint32_t _thread_id, char * _username, char * _schemaname , uint64_t _start_time , uint64_t _end_time , uint64_t _query_digest, char *_client, size_t _client_len);
-	uint64_t write(std::fstream *f, MySQL_Session *sess);
-	uint64_t write_query_format_1(std::fstream *f);
-	uint64_t write_query_format_2_json(std::fstream *f);
-	void write_auth(std::fstream *f, MySQL_Session *sess);
+	uint64_t write(std::ostream *f, MySQL_Session *sess);
+	uint64_t write_query_format_1(std::ostream *f);
+	uint64_t write_query_format_2_json(std::ostream *f);
+	uint64_t write_query_format_3(std::ostream *f);
+	void write_auth(std::ostream *f, MySQL_Session *sess);
 	void set_client_stmt_id(uint32_t client_stmt_id);
 	void set_query(const char *ptr, int len);
 	void set_server(int _hid, const char *ptr, int len);
@@ -47,6 +54,8 @@ class MySQL_Event {
 	void set_affected_rows(uint64_t ar, uint64_t lid);
 	void set_rows_sent(uint64_t rs);
 	void set_gtid(MySQL_Session *sess);
+	void set_format(int _format);
+	int get_format();
 };
 
 class MySQL_Logger {
@@ -58,6 +67,8 @@ class MySQL_Logger {
 		unsigned int log_file_id;
 		unsigned int max_log_file_size;
 		std::fstream *logfile;
+		int format;
+		MySQL_Events_Block *block; // events not yet written, when format is 3
 	} events;
 	struct {
 		bool enabled;
@@ -67,6 +78,20 @@ class MySQL_Logger {
 		unsigned int max_log_file_size;
 		std::fstream *logfile;
 	} audit;
+	/**
+	 * @brief Per-thread buffers used when 'mysql-eventslog_buffer_size' is not 0.
+	 * @details Worker threads render events into their own lock-free buffer, that is drained into
+	 *  'events.logfile' by a dedicated writer thread. 'mutex' is taken only when a thread creates its
+	 *  buffer, and by the writer thread to get the list of buffers.
+	 */
+	struct {
+		std::vector<MySQL_Events_Buffer *> buffers;
+		pthread_mutex_t mutex;
+		pthread_t writer;
+		bool writer_started;
+		std::atomic<bool> shutdown;
+		std::atomic<unsigned long long> dropped;
+	} async;
 #ifdef PROXYSQL_LOGGER_PTHREAD_MUTEX
 	pthread_mutex_t wmutex;
 #else
@@ -78,6 +103,13 @@ class MySQL_Logger {
 	void audit_open_log_unlocked();
 	unsigned int events_find_next_id();
 	unsigned int audit_find_next_id();
+	MySQL_Events_Buffer * events_get_thread_buffer();
+	void events_write_async(MySQL_Event& me, MySQL_Session *sess);
+	size_t events_drain_buffers();
+	void events_write_unlocked(const char *data, size_t len, bool rotate);
+	void events_write_buffered_unlocked(const std::string& data, bool rotate);
+	void events_block_append_unlocked(const char *data, size_t len);
+	void events_block_write_unlocked(bool force);
 	public:
 	MySQL_Logger();
 	~MySQL_Logger();
@@ -92,6 +124,8 @@ class MySQL_Logger {
 	void log_request(MySQL_Session *, MySQL_Data_Stream *);
 	void log_audit_entry(log_event_type, MySQL_Session *, MySQL_Data_Stream *, char *e = NULL);
 	void flush();
+	void events_writer_loop();
+	unsigned long long get_events_dropped();
 	void wrlock();
 	void wrunlock();
 };
@@ -1,6 +1,7 @@
 #ifndef __CLASS_MYSQL_MONITOR_H
 #define __CLASS_MYSQL_MONITOR_H
 #include <future>
+#include <mutex>
 #include "prometheus/counter.h"
 #include "prometheus/gauge.h"
 
@@ -9,6 +10,7 @@
 #include "cpp.h"
 #include "thread.h"
 #include "wqueue.h"
+#include "Epoch_Readers.h"
 
 //#define MONITOR_SQLITE_TABLE_MYSQL_SERVER_CONNECT "CREATE TABLE mysql_server_connect (hostname VARCHAR NOT NULL , port INT NOT NULL DEFAULT 3306 , time_since INT NOT NULL DEFAULT 0 , time_until INT NOT NULL DEFAULT 0 , connect_success_count INT NOT NULL DEFAULT 0 , connect_success_first INT NOT NULL DEFAULT 0 , connect_success_last INT NOT NULL DEFAULT 0 , connect_success_time_min INT NOT NULL DEFAULT 0 , connect_success_time_max INT NOT NULL DEFAULT 0 , connect_success_time_total INT NOT NULL DEFAULT 0 , connect_failure_count INT NOT NULL DEFAULT 0 , connect_failure_first INT NOT NULL DEFAULT 0 , connect_failure_last INT NOT NULL DEFAULT 0 , PRIMARY KEY (hostname, port))"
 
@@ -53,6 +55,7 @@ struct cmp_str {
 #define MyGR_Nentries	100
 #define Galera_Nentries	100
 #define AWS_Aurora_Nentries	150
+#define Monitor_check_Nentries	100
 
 #define N_L_ASE 16
 
@@ -185,6 +188,108 @@ class MyGR_monitor_node {
 	int get_timeout_count();
 };
 
+/**
+ * @brief Result of a single connect, ping, read_only or replication lag check.
+ */
+typedef struct _Monitor_check_entry_t {
+	unsigned long long time_start_us; // 0 if the entry is not used
+	unsigned long long success_time_us;
+	long long value; // read_only or replication lag, only if 'has_value'
+	bool has_value;
+	char *error;
+} Monitor_check_entry_t;
+
+/**
+ * @brief Last Monitor_check_Nentries results of one check type for a single server, in a ring buffer.
+ */
+class Monitor_check_node {
+	private:
+	int idx_last_entry;
+	public:
+	Monitor_check_entry_t last_entries[Monitor_check_Nentries];
+	unsigned int consecutive_failures; // failed checks since the last one that didn't fail
+	Monitor_check_node();
+	~Monitor_check_node();
+	void add_entry(unsigned long long _st, unsigned long long _ct, bool _has_value, long long _value, const char *_error, bool _failure);
+	unsigned int purge(unsigned long long min_time_start_us); // returns the number of entries left
+	long long get_avg_success_time(unsigned int n);
+	bool get_last_value(long long& value);
+};
+
+/**
+ * @brief In-memory history of one check type (connect, ping, read_only or replication lag) for all servers.
+ * @details Monitoring decisions are taken in O(1) from the last results of every server. The matching table
+ *   in 'monitor' (e.g. 'mysql_server_ping_log') is only populated when queried from Admin, through
+ *   'populate_table()'. Entries older than 'mysql-monitor_history' are removed by 'purge()'.
+ */
+class Monitor_check_log {
+	private:
+	pthread_mutex_t mutex;
+	std::map<std::string, Monitor_check_node *> nodes; // "hostname:port" as key
+	const char *table_name;
+	bool has_value_column; // the table has a 'read_only' or 'repl_lag' column before 'error'
+	public:
+	Monitor_check_log(const char *_table_name, bool _has_value_column);
+	~Monitor_check_log();
+	/**
+	 * @brief Adds the result of a check.
+	 * @param failure Whether the result counts as a failure for the monitoring decisions, e.g. a ping error
+	 *   other than 'Access denied'.
+	 */
+	void add_entry(const char *hostname, int port, unsigned long long time_start_us, unsigned long long success_time_us, bool has_value, long long value, const char *error, bool failure);
+	unsigned int get_consecutive_failures(const char *hostname, int port);
+	/**
+	 * @brief Returns the average 'success_time_us' of the checks without errors among the last 'n', or -1 if none.
+	 */
+	long long get_avg_success_time(const char *hostname, int port, unsigned int n);
+	/**
+	 * @brief Retrieves the value (read_only or replication lag) of the last check, if it returned one.
+	 * @return False if the last check of the server has no value, or if the server has no check.
+	 */
+	bool get_last_value(const char *hostname, int port, long long& value);
+	void purge(unsigned long long min_time_start_us);
+	void populate_table(SQLite3DB *db);
+};
+
+/**
+ * @brief Per-server schedule of one check type (ping, read_only or replication lag), for adaptive intervals.
+ * @details Every check without issues doubles the interval of the server, up to the check interval times
+ *   'mysql-monitor_adaptive_interval_max_factor'. A failed check, or a signal from 'expedite()' (connection
+ *   pool errors, latency spikes), brings the server back to the base interval. With a factor of '1'
+ *   every server is checked at every interval.
+ */
+class Monitor_check_schedule {
+	private:
+	struct server_schedule_t {
+		unsigned int factor;
+		unsigned long long next_check_at; // monotonic time, us
+		unsigned long long last_update; // monotonic time, us
+	};
+	pthread_mutex_t mutex;
+	std::unordered_map<std::string, server_schedule_t> servers; // "hostname:port" as key
+	public:
+	Monitor_check_schedule();
+	~Monitor_check_schedule();
+	/**
+	 * @brief Returns 'true' if the server needs to be checked at 'now', always for unknown servers.
+	 */
+	bool is_due(const char *hostname, int port, unsigned long long now);
+	/**
+	 * @brief Schedules the next check of the server after the result of a check.
+	 * @param interval_ms The configured interval of the check.
+	 * @param stable Whether the check reported no issue, allowing the interval to back off.
+	 */
+	void update(const char *hostname, int port, unsigned long long now, unsigned int interval_ms, bool stable);
+	/**
+	 * @brief Resets the server to the base interval, and makes it due for the next loop of the check.
+	 */
+	void expedite(const char *hostname, int port);
+	/**
+	 * @brief Removes the servers not updated for more than 'max_age' us, e.g. removed from 'mysql_servers'.
+	 */
+	void purge(unsigned long long now, unsigned long long max_age);
+};
+
 
 class MySQL_Monitor_Connection_Pool;
 
@@ -274,6 +379,13 @@ public:
 	// The working of monitor_*_thread version will remain same, as for async version, init_async needs
 	// to be called before calling task_handler to initialize required data.
 	void init_async();
+	/**
+	 * @brief Prepares a new non-blocking connection for the task, to be created by 'task_handler'.
+	 * @details Used in place of 'init_async' when no connection is available in 'My_Conn_Pool'. Once the
+	 *   connection is established, the handler of the task is initialized and executed on it, so that the
+	 *   creation of the connection doesn't block the event loop.
+	 */
+	void init_async_connect();
 	bool create_new_connection();
 	
 	int async_exit_status;
@@ -293,8 +405,14 @@ public:
 		return task_result_;
 	}
 
+	inline
+	bool is_connecting() const {
+		return async_state_machine_ >= ASYNC_CONNECT_START && async_state_machine_ <= ASYNC_CONNECT_TIMEOUT;
+	}
+
 private:
 	std::string query_;
+	std::string connect_host_; // address resolved for the non-blocking connect, see 'init_async_connect'
 	unsigned long long task_expiry_time_; // task expiry time (t1 + task_timeout_ * 1000)
 	int task_timeout_; // task timout in ms
 
@@ -304,6 +422,7 @@ private:
 
 	short next_event(MDB_ASYNC_ST new_st, int status);
 	MySQL_Monitor_State_Data_Task_Result (MySQL_Monitor_State_Data::*task_handler_)(short event_, short& wait_event);
+	MySQL_Monitor_State_Data_Task_Result connect_handler(short event_, short& wait_event);
 	MySQL_Monitor_State_Data_Task_Result ping_handler(short event_, short& wait_event);
 	MySQL_Monitor_State_Data_Task_Result generic_handler(short event_, short& wait_event);
 	void mark_task_as_timeout(unsigned long long time = monotonic_time());
@@ -355,6 +474,7 @@ struct p_mon_counter {
 		mysql_monitor_dns_cache_queried,
 		mysql_monitor_dns_cache_lookup_success,
 		mysql_monitor_dns_cache_record_updated, 
+		mysql_monitor_dns_cache_record_refreshed,
 		__size
 	};
 };
@@ -395,42 +515,97 @@ struct DNS_Cache_Record {
 	unsigned long long ttl_ = 0;
 };
 
+/**
+ * @brief Changes to the DNS cache collected during a refresh of the monitor, applied at once by
+ *   'DNS_Cache::update()'. Filled concurrently by the resolver threads.
+ */
+struct DNS_Cache_Batch {
+	std::mutex mutex;
+	std::vector<std::pair<std::string, std::vector<std::string>>> records;
+	std::vector<std::pair<std::string, unsigned long long>> negative_records; // hostname, expire time
+	std::vector<std::string> removed;
+};
+
+// maximum time (ms) a failed resolution is cached, shorter if 'monitor_local_dns_cache_refresh_interval' is
+#define DNS_CACHE_NEGATIVE_TTL	5000
+
+/**
+ * @brief Cache of the IPs of the hostnames of the servers, used by the monitor and by the backend connects.
+ * @details Lookups are wait-free: readers read the published map of records under 'Epoch_Readers'. Writers
+ *  copy the map, change it, publish the new map and wait until no reader can still access the previous one
+ *  before freeing it. A refresh of the monitor publishes all its changes at once, see 'update()'. The records
+ *  are shared by all the maps that reference them. Failed resolutions are kept as negative records for a short
+ *  time, so that the connects to a hostname that doesn't resolve fail fast.
+ */
 class DNS_Cache {
 
 public:
+	enum lookup_result {
+		MISS = 0,
+		HIT,
+		NEGATIVE
+	};
+
 	// By default, the DNS cache is disabled.
 	// This handles the case when ProxySQL is executed with the -M/--no-monitor option.
-	DNS_Cache() : enabled(false) {
-		int rc = pthread_rwlock_init(&rwlock_, NULL);
-		assert(rc == 0);
-	}
-
-	~DNS_Cache() {
-		pthread_rwlock_destroy(&rwlock_);
-	}
+	DNS_Cache();
+	~DNS_Cache();
 
 	inline 
 	void set_enabled_flag(bool value) {
 		enabled = value;
 	}
 
+	inline
+	bool is_enabled() const {
+		return enabled;
+	}
+
 	bool add(const std::string& hostname, std::vector<std::string>&& ips);
 	bool add_if_not_exist(const std::string& hostname, std::vector<std::string>&& ips);
+	/**
+	 * @brief Records a failed resolution of 'hostname', valid until 'expire_at' (monotonic time).
+	 * @details A hostname that already has IPs is left untouched: its last IPs keep being served.
+	 */
+	void add_negative(const std::string& hostname, unsigned long long expire_at);
 	void remove(const std::string& hostname);
+	/**
+	 * @brief Applies all the changes of 'batch' publishing a single copy of the records.
+	 */
+	void update(DNS_Cache_Batch& batch);
 	void clear();
 	bool empty() const;
 	std::string lookup(const std::string& hostname, size_t* ip_count) const;
+	/**
+	 * @brief Checks the record of 'hostname', without picking one of its IPs. Expired negative records are
+	 *   reported as 'MISS'.
+	 */
+	lookup_result find(const std::string& hostname) const;
+	/**
+	 * @brief Marks a resolution of 'hostname' as requested. The mark is cleared when its record is updated.
+	 * @return 'false' if a resolution of 'hostname' was already requested.
+	 */
+	bool set_pending(const std::string& hostname);
 
 private:
 	struct IP_ADDR {
 		std::vector<std::string> ips;
-		unsigned long counter = 0;
+		mutable std::atomic<unsigned long> counter { 0 };
+		unsigned long long negative_until = 0; // set for failed resolutions, 'ips' is empty
 	};
+	typedef std::unordered_map<std::string, std::shared_ptr<const IP_ADDR>> records_t;
 
 	std::string get_next_ip(const IP_ADDR& ip_addr) const;
-	std::unordered_map<std::string, IP_ADDR> records;
+	records_t* copy_records() const;
+	void publish(records_t* next);
+	void clear_pending(const std::string& hostname);
+
+	Epoch_Readers readers;
+	std::atomic<records_t*> records;
+	std::mutex writers_mutex;
+	std::mutex pending_mutex;
+	std::set<std::string> pending;
 	std::atomic_bool enabled;
-	mutable pthread_rwlock_t rwlock_;
 };
 
 struct DNS_Resolve_Data {
@@ -440,6 +615,17 @@ struct DNS_Resolve_Data {
 	std::set<std::string> cached_ips;
 	unsigned int ttl = 0;
 	unsigned int refresh_intv = 0;
+	// set by the refresh of the monitor: the result is added to the batch instead of the cache
+	std::shared_ptr<DNS_Cache_Batch> batch;
+};
+
+/**
+ * @brief Status of the resolution of the hostname of a server, before connecting to it.
+ */
+enum DNS_RESOLVE_STATUS {
+	DNS_RESOLVE_READY = 0, // IP, UNIX socket, cached hostname or DNS cache disabled: the connect can start
+	DNS_RESOLVE_PENDING, // the hostname is being resolved asynchronously
+	DNS_RESOLVE_FAILED // the last resolution of the hostname failed
 };
 
 
@@ -450,6 +636,19 @@ class MySQL_Monitor {
 	static bool update_dns_cache_from_mysql_conn(const MYSQL* mysql);
 	static void remove_dns_record_from_dns_cache(const std::string& hostname);
 	static void trigger_dns_cache_update();
+	/**
+	 * @brief Checks if the hostname of a server is resolved, without blocking.
+	 * @details A hostname missing from the DNS cache is queued to the asynchronous resolver, the caller is
+	 *   expected to check again later. Used by the worker threads before starting a backend connect, so that
+	 *   'libmariadbclient' never has to resolve it synchronously.
+	 */
+	static DNS_RESOLVE_STATUS dns_lookup_async(const char* hostname, int port);
+	/**
+	 * @brief Brings the server back to fast probing for the ping, read_only and replication lag checks.
+	 * @details Called on signals of trouble outside of the checks themselves, e.g. connection errors
+	 *   reported by the connection pool. See 'Monitor_check_schedule'.
+	 */
+	void expedite_checks(const char *hostname, int port);
 
 	void process_discovered_topology(const std::string& originating_server_hostname, const vector<MYSQL_ROW>& discovered_servers, int reader_hostgroup);
 	bool is_aws_rds_multi_az_db_cluster_topology(const std::vector<MYSQL_ROW>& discovered_servers);
@@ -475,6 +674,13 @@ class MySQL_Monitor {
 	std::map<std::string, Galera_monitor_node *> Galera_Hosts_Map;
 	SQLite3_result *Galera_Hosts_resultset;
 	std::map<std::string, AWS_Aurora_monitor_node *> AWS_Aurora_Hosts_Map;
+	Monitor_check_log connect_log { "mysql_server_connect_log", false };
+	Monitor_check_log ping_log { "mysql_server_ping_log", false };
+	Monitor_check_log read_only_log { "mysql_server_read_only_log", true };
+	Monitor_check_log replication_lag_log { "mysql_server_replication_lag_log", true };
+	Monitor_check_schedule ping_schedule {};
+	Monitor_check_schedule read_only_schedule {};
+	Monitor_check_schedule replication_lag_schedule {};
 	SQLite3_result *AWS_Aurora_Hosts_resultset;
 	uint64_t AWS_Aurora_Hosts_resultset_checksum;
 	unsigned int num_threads;
@@ -491,6 +697,7 @@ class MySQL_Monitor {
 	unsigned long long dns_cache_queried;
 	unsigned long long dns_cache_lookup_success; //cache hit
 	unsigned long long dns_cache_record_updated;
+	unsigned long long dns_cache_record_refreshed; // renewed before their TTL expired
 	std::atomic_bool force_dns_cache_update;
 	struct {
 		/// Prometheus metrics arrays
@@ -511,6 +718,8 @@ class MySQL_Monitor {
 #endif
 
 	std::shared_ptr<DNS_Cache> dns_cache;
+	// on-demand resolutions, requested by 'dns_lookup_async'
+	std::unique_ptr<wqueue<WorkItem<DNS_Resolve_Data>*>> dns_resolver_queue;
 
 	MySQL_Monitor();
 	~MySQL_Monitor();
@@ -555,7 +764,9 @@ private:
 	 * @brief Handling of monitor tasks asyncronously
 	 * @details Basic workflow is same for all monitor_*_async methods:
 	 *	- Finding mysql connection in My_Conn_Pool (get_connection)
-	 *	- Delegate task to Consumer Thread if connection is not available, else execute task asynchronously (add task to monitor_poll)
+	 *	- Execute task asynchronously (add task to monitor_poll). If a connection is not available, a new one is
+	 *	  created asynchronously before executing the task (see 'init_async_connect').
+	 *	- Tasks are started within a jitter window of the check interval (see 'mysql-monitor_checks_jitter')
 	 * 	- On task completion, one of the following status will be returned and will be processed by monitor_*_process_ready_tasks.
 	 *		- TASK_RESULT_SUCCESS = mysql connection will be returned back to My_Conn_Pool (put_connection)
 	 *		- TASK_RESULT_TIMEOUT = mysql connection will be closed and error log will be generated.		
@@ -569,6 +780,7 @@ private:
 	void monitor_replication_lag_async(SQLite3_result* resultset);
 	void monitor_group_replication_async();
 	void monitor_galera_async();
+	void monitor_connect_async(SQLite3_result* resultset);
 
 	// bulk processing of ready taks
 	bool monitor_ping_process_ready_tasks(const std::vector<MySQL_Monitor_State_Data*>& mmsds);
@@ -582,6 +794,7 @@ private:
 	 */
 	bool monitor_group_replication_process_ready_tasks_2(const std::vector<MySQL_Monitor_State_Data*>& mmsds);
 	bool monitor_galera_process_ready_tasks(const std::vector<MySQL_Monitor_State_Data*>& mmsds);
+	bool monitor_connect_process_ready_tasks(const std::vector<MySQL_Monitor_State_Data*>& mmsds);
 };
 
 #endif /* __CLASS_MYSQL_MONITOR_H */
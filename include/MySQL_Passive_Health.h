@@ -0,0 +1,66 @@
+#ifndef __CLASS_MYSQL_PASSIVE_HEALTH
+#define __CLASS_MYSQL_PASSIVE_HEALTH
+
+#include <atomic>
+
+#define PASSIVE_HEALTH_STRIPES	8
+#define PASSIVE_HEALTH_LATENCY_BUCKETS	24
+#define PASSIVE_HEALTH_WINDOW_US	1000000
+
+/**
+ * @brief Health of a backend server as seen by live traffic: queries, errors and latency distribution.
+ * @details Counters are kept per window of PASSIVE_HEALTH_WINDOW_US, in PASSIVE_HEALTH_STRIPES stripes.
+ *  Every worker thread always writes the same stripe, so threads don't share cache lines for the most
+ *  part, and no lock is taken. Every stripe holds the current and the previous window, readers sum the
+ *  stripes of the window they need. A stripe is reset by its writer when it enters a new window: readers
+ *  can see partial values, these are statistics and not exact counters.
+ *  Latencies are counted in log2 buckets of microseconds (bucket N: [2^N, 2^(N+1)) ), the last bucket
+ *  holding everything above.
+ */
+class MySQL_Passive_Health {
+	private:
+	struct window_t {
+		std::atomic<unsigned long long> id;
+		std::atomic<unsigned int> queries;
+		std::atomic<unsigned int> errors;
+		std::atomic<unsigned int> latency[PASSIVE_HEALTH_LATENCY_BUCKETS];
+	};
+	struct alignas(64) stripe_t {
+		window_t windows[2]; // indexed by the parity of the window id
+	};
+	stripe_t stripes[PASSIVE_HEALTH_STRIPES];
+	std::atomic<unsigned long long> last_completed_window; // last window whose latency was computed
+	std::atomic<unsigned int> latency_us; // latency percentile of 'last_completed_window'
+	window_t& get_window(unsigned long long id);
+	void sum_window(unsigned long long id, unsigned int& queries, unsigned int& errors, unsigned int *latency);
+
+	public:
+	MySQL_Passive_Health();
+	/**
+	 * @brief Records a query completed successfully after 'time_us'.
+	 * @return 'true' for the first query of a new window: the caller should call 'compute_latency()'.
+	 */
+	bool add_query(unsigned long long now, unsigned long long time_us);
+	/**
+	 * @brief Records a failed query.
+	 * @return The percentage of failed queries in the current window, or -1 if the window has less than
+	 *   'min_queries' queries.
+	 */
+	int add_error(unsigned long long now, unsigned int min_queries);
+	/**
+	 * @brief Computes the 'percentile' latency of the previous (complete) window, see 'get_latency_us()'.
+	 *   A 'percentile' of '0' resets the latency to '0'.
+	 */
+	unsigned int compute_latency(unsigned long long now, unsigned int percentile);
+	/**
+	 * @brief Returns the latency computed by 'compute_latency()', or 0 if outdated (e.g. no more traffic).
+	 */
+	unsigned int get_latency_us(unsigned long long now);
+	/**
+	 * @brief Returns 'true' for the errors that denote a problem with the server itself, e.g. lost
+	 *   connections or a shutdown in progress, as opposed to errors caused by the query.
+	 */
+	static bool is_server_error(int err);
+};
+
+#endif /* __CLASS_MYSQL_PASSIVE_HEALTH */
@@ -104,13 +104,24 @@ class stmt_execute_metadata_t {
 		if (lengths)
 			free(lengths);
 		lengths = NULL;
-		size = 0;
-		stmt_id = 0;
 		if (pkt) {
-			free(pkt);
+			// the packet was allocated with l_alloc() in buffer2array()
+			l_free(size, pkt);
 			pkt = NULL;
 		}
+		size = 0;
+		stmt_id = 0;
 	}
+	/**
+	 * @brief Serializes the currently bound parameters into a Query Cache key.
+	 * @details The key is made of the statement hash ('MySQL_STMT_Global_info::hash')
+	 *   followed by type, nullity and value of every parameter, so that two
+	 *   executions of the same statement with identical values produce the same key.
+	 * @param stmt_hash The global hash of the prepared statement.
+	 * @param key Output string where the serialized key is written.
+	 * @return False if a parameter couldn't be serialized, true otherwise.
+	 */
+	bool serialize_binds(uint64_t stmt_hash, std::string& key) const;
 };
 
 
@@ -13,6 +13,7 @@
 #include "proxysql.h"
 #include "cpp.h"
 #include "MySQL_Variables.h"
+#include "ProxySQL_Timer_Wheel.h"
 
 #include "../deps/json/json.hpp"
 using json = nlohmann::json;
@@ -96,6 +97,8 @@ class Query_Info {
 	uint64_t rows_sent;
 	uint64_t waiting_since;
 	std::string show_warnings_prev_query_digest;
+	// Query Cache key of the current COM_STMT_EXECUTE, empty if the execution isn't cacheable
+	std::string stmt_cache_key;
 
 	Query_Info();
 	~Query_Info();
@@ -166,6 +169,7 @@ class MySQL_Session
 	void handler___client_DSS_QUERY_SENT___server_DSS_NOT_INITIALIZED__get_connection();	
 
 	void return_proxysql_internal(PtrSize_t *);
+	void set_data_streams_dirty();
 	bool handler_special_queries(PtrSize_t *);
 	bool handler_special_queries_STATUS(PtrSize_t *);
 	/**
@@ -202,6 +206,7 @@ class MySQL_Session
 
 	void handler___status_WAITING_CLIENT_DATA___STATE_SLEEP___MYSQL_COM_QUERY___create_mirror_session();
 	int handler_again___status_PINGING_SERVER();
+	int handler_again___status_PREWARMING_SERVER();
 	int handler_again___status_RESETTING_CONNECTION();
 	bool handler_again___status_SHOW_WARNINGS(MySQL_Data_Stream *, bool);
 	void handler_again___new_thread_to_kill_connection();
@@ -250,6 +255,7 @@ class MySQL_Session
 	void handler___status_WAITING_CLIENT_DATA___STATE_SLEEP___MYSQL_COM_STMT_SEND_LONG_DATA(PtrSize_t&);
 	void handler___status_WAITING_CLIENT_DATA___STATE_SLEEP___MYSQL_COM_STMT_PREPARE(PtrSize_t& pkt);
 	void handler___status_WAITING_CLIENT_DATA___STATE_SLEEP___MYSQL_COM_STMT_EXECUTE(PtrSize_t& pkt);
+	bool handler___status_WAITING_CLIENT_DATA___STATE_SLEEP___MYSQL_COM_STMT_EXECUTE_QueryCache();
 
 	// these functions have code that used to be inline, and split into functions for readibility
 	int handler_ProcessingQueryError_CheckBackendConnectionStatus(MySQL_Data_Stream *myds);
@@ -296,6 +302,7 @@ class MySQL_Session
 
 	unsigned long long idle_since;
 	unsigned long long transaction_started_at;
+	timer_wheel_node timeout_timer; // next check of the timeouts, see MySQL_Thread::schedule_session_timeout()
 
 	// pointers
 	MySQL_Thread *thread;
@@ -349,6 +356,7 @@ class MySQL_Session
 	bool autocommit_handled;
 	bool sending_set_autocommit;
 	bool killed;
+	bool queued_to_process; // the session is in 'thread->sessions_to_process', see MySQL_Thread::queue_session_to_process()
 	bool locked_on_hostgroup_and_all_variables_set;
 	//bool admin;
 	bool max_connections_reached;
@@ -7,6 +7,7 @@
 #include "proxysql.h"
 #include "cpp.h"
 #include "MySQL_Variables.h"
+#include "ProxySQL_Timer_Wheel.h"
 #ifdef IDLE_THREADS
 #include <sys/epoll.h>
 #endif // IDLE_THREADS
@@ -95,6 +96,11 @@ enum MySQL_Thread_status_variable {
 	st_var_automatic_detected_sqli,
 	st_var_whitelisted_sqli_fingerprint,
 	st_var_client_host_error_killed_connections,
+	st_var_sessions_migrated,
+	st_var_client_connections_numa_local,
+	st_var_client_connections_numa_remote,
+	st_var_poll_entries_processed,
+	st_var_fast_forward_splice_bytes,
 	st_var_END
 };
 
@@ -111,13 +117,26 @@ class __attribute__((aligned(64))) MySQL_Thread
 
 	PtrArray *cached_connections;
 
+	ProxySQL_Timer_Wheel session_timers;
+	std::vector<timer_wheel_node *> expired_session_timers;
+	int session_timeouts_conf[4]; // timeout variables used to schedule 'session_timers'
+	std::vector<MySQL_Session *> sessions_to_process; // sessions to be processed by process_all_sessions() in the current loop
+
 #ifdef IDLE_THREADS
 	struct epoll_event events[MY_EPOLL_THREAD_MAXEVENTS];
 	int efd;
 	unsigned int mysess_idx;
 	std::map<unsigned int, unsigned int> sessmap;
+	PtrArray *migrate_mysql_sessions; // sessions to be moved to a less loaded worker thread
+	MySQL_Thread *migration_target;
+	unsigned long long last_session_migration_time;
+	bool check_resumed_sessions; // set when the pipe is signaled, sessions may be waiting in myexchange
 #endif // IDLE_THREADS
 
+	unsigned long long busy_since; // when the thread returned from poll()
+	unsigned long long load_sample_time;
+	unsigned long long load_sample_busy_time;
+
 	Session_Regex **match_regexes;
 
 #ifdef IDLE_THREADS
@@ -129,6 +148,9 @@ class __attribute__((aligned(64))) MySQL_Thread
 	void idle_thread_prepares_session_to_send_to_worker_thread(int i);
 	void idle_thread_to_kill_idle_sessions();
 	bool move_session_to_idle_mysql_sessions(MySQL_Data_Stream *myds, unsigned int n);
+	MySQL_Thread * get_session_migration_target(unsigned int& quota);
+	bool move_session_to_migrate_mysql_sessions(MySQL_Data_Stream *myds, unsigned int n);
+	void worker_thread_assigns_sessions_to_worker_thread(MySQL_Thread *thr);
 	void run_Handle_epoll_wait(int);
 #endif // IDLE_THREADS
 
@@ -142,12 +164,23 @@ class __attribute__((aligned(64))) MySQL_Thread
 	void tune_timeout_for_myds_needs_pause(MySQL_Data_Stream *myds);
 	void tune_timeout_for_session_needs_pause(MySQL_Data_Stream *myds);
 	void configure_pollout(MySQL_Data_Stream *myds, unsigned int n);
+	void ProcessMyDS_BeforePoll(unsigned int n);
+	void ProcessReadyMyDS_AfterPoll();
 
 	void run_MoveSessionsBetweenThreads();
 	void run_BootstrapListener();
 	int run_ComputePollTimeout();
 	void run_StopListener();
 	void run_SetAllSession_ToProcess0();
+	void update_load();
+	void schedule_session_timeout(MySQL_Session *sess, unsigned long long sess_time);
+	void check_session_timeouts(MySQL_Session *sess);
+	void process_session_timeouts();
+	void set_session_to_process(MySQL_Session *sess);
+	void queue_session_to_process(MySQL_Session *sess);
+	void dequeue_session_to_process(MySQL_Session *sess);
+	void set_cpu_affinity(bool pinned);
+	void set_listener_incoming_cpu(int sock);
 
 
 	protected:
@@ -164,6 +197,10 @@ class __attribute__((aligned(64))) MySQL_Thread
 	unsigned long long last_maintenance_time;
 	unsigned long long last_move_to_idle_thread_time;
 	std::atomic<unsigned long long> atomic_curtime;
+	unsigned long long busy_time; // total time spent outside poll(), in microseconds
+	std::atomic<unsigned int> load_pct; // percentage of time spent outside poll() during the last maintenance interval
+	int cpu; // CPU the thread is pinned to, -1 if not pinned. See mysql-threads_cpu_affinity
+	int numa_node; // NUMA node of 'cpu'
 	PtrArray *mysql_sessions;
 	PtrArray *mirror_queue_mysql_sessions;
 	PtrArray *mirror_queue_mysql_sessions_cache;
@@ -207,6 +244,7 @@ class __attribute__((aligned(64))) MySQL_Thread
 	MySQL_Session * create_new_session_and_client_data_stream(int _fd);
 	bool init();
 	void run___get_multiple_idle_connections(int& num_idles);
+	void run___prewarm_connections();
 	void run___cleanup_mirror_queue();
   	void ProcessAllMyDS_BeforePoll();
   	void ProcessAllMyDS_AfterPoll();
@@ -219,8 +257,11 @@ class __attribute__((aligned(64))) MySQL_Thread
   bool process_data_on_data_stream(MySQL_Data_Stream *myds, unsigned int n);
 	void ProcessAllSessions_SortingSessions();
 	void ProcessAllSessions_CompletedMirrorSession(unsigned int& n, MySQL_Session *sess);
-	void ProcessAllSessions_MaintenanceLoop(MySQL_Session *sess, unsigned long long sess_time, unsigned int& total_active_transactions_);
+	void ProcessAllSessions_MaintenanceLoop(MySQL_Session *sess, unsigned int& total_active_transactions_);
 	void ProcessAllSessions_Healthy0(MySQL_Session *sess, unsigned int& n);
+	void ProcessAllSessions_Close(MySQL_Session *sess, unsigned int& n);
+	void ProcessAllSessions_SortingSessionsToProcess();
+	void process_queued_sessions();
 	void process_all_sessions();
   void refresh_variables();
   void register_session_connection_handler(MySQL_Session *_sess, bool _new=false);
@@ -291,6 +332,11 @@ struct p_th_counter {
 		mysql_killed_backend_connections,
 		mysql_killed_backend_queries,
 		client_host_error_killed_connections,
+		sessions_migrated,
+		client_connections_numa_local,
+		client_connections_numa_remote,
+		poll_entries_processed,
+		fast_forward_splice_bytes,
 		__size
 	};
 };
@@ -389,6 +435,8 @@ class MySQL_Threads_Handler
 	struct {
 		int monitor_history;
 		int monitor_connect_interval;
+		int monitor_checks_jitter;
+		int monitor_adaptive_interval_max_factor;
 		int monitor_connect_timeout;
 		//! Monitor ping interval. Unit: 'ms'.
 		int monitor_ping_interval;
@@ -436,6 +484,9 @@ class MySQL_Threads_Handler
 		int ping_timeout_server;
 		int shun_on_failures;
 		int shun_recovery_time_sec;
+		int passive_health_error_pct;
+		int passive_health_min_queries;
+		int passive_health_latency_percentile;
 		int unshun_algorithm;
 		int query_retries_on_failure;
 		bool connection_warming;
@@ -449,9 +500,11 @@ class MySQL_Threads_Handler
 		int connect_timeout_server;
 		int connect_timeout_server_max;
 		int free_connections_pct;
+		int connection_prewarm_pct;
 		int show_processlist_extended;
 #ifdef IDLE_THREADS
 		int session_idle_ms;
+		int session_migration_threshold;
 		bool session_idle_show_processlist;
 #endif // IDLE_THREADS
 		bool sessions_sort;
@@ -496,6 +549,9 @@ class MySQL_Threads_Handler
 		int max_transaction_time;
 		int threshold_query_length;
 		int threshold_resultset_size;
+		int fast_forward_splice;
+		int gather_writes;
+		int threads_cpu_affinity;
 		int query_digests_max_digest_length;
 		int query_digests_max_query_length;
 		int query_rules_fast_routing_algorithm;
@@ -531,11 +587,14 @@ class MySQL_Threads_Handler
 #endif /* DEBUG */
 		uint32_t server_capabilities;
 		int poll_timeout;
+		int poll_backend;
 		int poll_timeout_on_failure;
 		int connpoll_reset_queue_length;
 		char *eventslog_filename;
 		int eventslog_filesize;
 		int eventslog_default_log;
+		int eventslog_buffer_size;
+		int eventslog_buffer_full_policy;
 		int eventslog_format;
 		char *auditlog_filename;
 		int auditlog_filesize;
@@ -550,6 +609,8 @@ class MySQL_Threads_Handler
 		int query_cache_size_MB;
 		int query_cache_soft_ttl_pct;
 		int query_cache_handle_warnings;
+		int query_cache_persist_interval_sec;
+		int query_cache_persist_max_age_sec;
 		int min_num_servers_lantency_awareness;
 		int aurora_max_lag_ms_only_read_from_replicas;
 		bool stats_time_backend_query;
@@ -650,6 +711,23 @@ class MySQL_Threads_Handler
 	 * @brief Callback to update the metrics.
 	 */
 	void p_update_metrics();
+	/**
+	 * @brief CPUs the process is allowed to run on, in ascending order, and the NUMA node of every CPU.
+	 * @details Both are computed in 'init()'. Worker threads are pinned to 'cpus_allowed' when
+	 *   'mysql-threads_cpu_affinity' is enabled, see 'get_thread_cpu()'.
+	 */
+	std::vector<int> cpus_allowed;
+	std::vector<int> cpus_numa_node;
+	/**
+	 * @brief Returns the CPU for the worker (and idle) thread number 'tn', or -1 if none is available.
+	 * @details Threads are assigned round robin to the NUMA nodes, so that with fewer threads than CPUs
+	 *   every node gets its share: thread 'tn' runs on node 'tn % nodes', on the CPUs of that node in
+	 *   ascending order. A worker and its idle thread have the same number, so they get the same CPU, and
+	 *   the sessions exchanged between them, with their buffers, stay on the same node.
+	 */
+	int get_thread_cpu(unsigned int tn);
+	int get_cpu_numa_node(int cpu);
+	unsigned int get_pinned_threads();
 	unsigned int num_threads;
 	proxysql_mysql_thread_t *mysql_threads;
 #ifdef IDLE_THREADS
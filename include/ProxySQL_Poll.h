@@ -1,8 +1,21 @@
 #ifndef __CLASS_PROXYSQL_POLL
 #define __CLASS_PROXYSQL_POLL
 
+#include <vector>
+
 //#include "MySQL_Data_Stream.h"
 
+struct epoll_event;
+
+/**
+ * @brief Kernel interface used by 'ProxySQL_Poll::wait()'.
+ * @details Configured through 'mysql-poll_backend'.
+ */
+enum PROXYSQL_POLL_BACKEND {
+	POLL_BACKEND_POLL = 0,	// poll(): each call costs O(number of fds)
+	POLL_BACKEND_EPOLL = 1,	// level-triggered epoll: each call costs O(number of ready fds)
+};
+
 class iface_info {
 	public:
 	char *iface;
@@ -22,10 +35,93 @@ class iface_info {
 	}
 };
 
+/**
+ * @brief A set of indexes of entries of 'ProxySQL_Poll', that follows the entries moved by
+ *   'ProxySQL_Poll::remove_index_fast()'.
+ * @details 'flags' has an element for each entry. 'idxs' can hold stale or duplicated indexes: an index is
+ *  part of the set only while its flag is set.
+ */
+class ProxySQL_Poll_Index_Set {
+	public:
+	std::vector<unsigned int> idxs;
+	std::vector<unsigned char> flags;
+	void insert(unsigned int i) {
+		if (flags[i] == 0) {
+			flags[i] = 1;
+			idxs.push_back(i);
+		}
+	}
+	bool contains(unsigned int i, unsigned int len) const {
+		return i < len && flags[i];
+	}
+	/**
+	 * @brief Removes an index from the set.
+	 * @return False if the set is empty.
+	 */
+	bool pop(unsigned int len, unsigned int& i) {
+		while (idxs.empty() == false) {
+			i = idxs.back();
+			idxs.pop_back();
+			if (contains(i, len)) {
+				flags[i] = 0;
+				return true;
+			}
+		}
+		return false;
+	}
+	/**
+	 * @brief Tracks the removal of entry 'i', replaced by entry 'last'.
+	 */
+	void remove(unsigned int i, unsigned int last) {
+		if (i != last) {
+			flags[i] = flags[last];
+			if (flags[i]) {
+				idxs.push_back(i);
+			}
+		}
+		flags[last] = 0;
+	}
+	void clear() {
+		for (unsigned int i : idxs) {
+			if (i < flags.size()) {
+				flags[i] = 0;
+			}
+		}
+		idxs.clear();
+	}
+};
+
 class ProxySQL_Poll {
 	private:
 	void shrink();
 	void expand(unsigned int more);
+	void resize_sets(unsigned int new_size);
+
+	/**
+	 * @brief Per fd number state, needed by the epoll backend.
+	 * @details 'fds' remains the authoritative interest list, and it is modified in place by the
+	 *  callers. The state registered in the kernel is reconciled with it by 'epoll_sync()', only for the
+	 *  entries in 'sync' (see 'events_changed()'), or for all of them if 'full_sync' is set.
+	 */
+	struct fd_state_t {
+		unsigned int refs;	// number of entries in 'fds' with this fd number
+		unsigned int idx;	// index in 'fds' of the (last added) entry with this fd number
+		short events;		// events registered in the epoll instance
+		bool registered;	// true if the fd is registered in the epoll instance
+	};
+	std::vector<fd_state_t> fd_states;
+	int backend;
+	int epfd;
+	struct epoll_event *ep_events;
+	unsigned int ep_events_size;
+	ProxySQL_Poll_Index_Set sync;
+	bool full_sync;
+	std::vector<unsigned int> dirty_next;
+	void fd_ref(int fd, unsigned int idx);
+	void fd_unref(int fd);
+	void epoll_sync_entry(unsigned int i);
+	void epoll_sync();
+	int epoll_wait_events(int timeout);
 
 	public:
 	unsigned int len;
@@ -39,11 +135,44 @@ class ProxySQL_Poll {
 	unsigned int poll_timeout;
 	unsigned long loops;
 	StatCounters *loop_counters;
+	/**
+	 * @brief With POLL_BACKEND_EPOLL, the entries whose interest must be recomputed before the next wait():
+	 *  the new entries, the entries of the sessions processed, and the entries waiting for a timeout.
+	 */
+	ProxySQL_Poll_Index_Set dirty;
+	/**
+	 * @brief With POLL_BACKEND_EPOLL, the entries with events returned by the last wait().
+	 */
+	ProxySQL_Poll_Index_Set ready;
+	/**
+	 * @brief Set when all the entries must be processed, because 'dirty' and 'ready' were not maintained.
+	 */
+	bool full_scan;
 
 	ProxySQL_Poll();
 	~ProxySQL_Poll();
 	void add(uint32_t _events, int _fd, MySQL_Data_Stream *_myds, unsigned long long sent_time);
 	void remove_index_fast(unsigned int i);
 	int find_index(int fd);
+	void set_backend(int _backend);
+	bool is_epoll() const {
+		return backend == POLL_BACKEND_EPOLL;
+	}
+	void set_dirty(int i) {
+		if (backend == POLL_BACKEND_EPOLL && i >= 0) {
+			dirty.insert(i);
+		}
+	}
+	/**
+	 * @brief Keeps entry 'i' in 'dirty' for the next loop, once 'commit_dirty()' is called.
+	 */
+	void keep_dirty(unsigned int i) {
+		if (backend == POLL_BACKEND_EPOLL) {
+			dirty_next.push_back(i);
+		}
+	}
+	void commit_dirty();
+	void events_changed(unsigned int i);
+	int wait(int timeout);
 };
 #endif // __CLASS_PROXYSQL_POLL
@@ -0,0 +1,58 @@
+#ifndef __CLASS_PROXYSQL_TIMER_WHEEL
+#define __CLASS_PROXYSQL_TIMER_WHEEL
+
+#include <cstddef>
+#include <vector>
+
+#define TIMER_WHEEL_LEVELS	4
+#define TIMER_WHEEL_SLOT_BITS	6
+#define TIMER_WHEEL_SLOTS	(1 << TIMER_WHEEL_SLOT_BITS)
+#define TIMER_WHEEL_TICK_US	1000
+
+/**
+ * @brief Timer embedded in the object it belongs to (e.g. MySQL_Session).
+ * @details A node is linked in at most one slot of a ProxySQL_Timer_Wheel; 'next' is NULL when it isn't.
+ */
+struct timer_wheel_node {
+	timer_wheel_node *prev;
+	timer_wheel_node *next;
+	unsigned long long expires; // expiration time, in ticks
+	void *data;
+	timer_wheel_node() : prev(NULL), next(NULL), expires(0), data(NULL) {}
+	bool scheduled() const { return next != NULL; }
+};
+
+/**
+ * @brief Hierarchical timer wheel, with a resolution of TIMER_WHEEL_TICK_US microseconds.
+ * @details Level 0 has one slot per tick, every slot of level N covers TIMER_WHEEL_SLOTS slots of level
+ *  N-1. Scheduling and cancelling a timer are O(1), and 'advance()' only touches the slots of the
+ *  elapsed ticks: timers of the upper levels are moved (cascaded) to the lower ones as their time
+ *  approaches. Timers beyond the range of the wheel (~4.6 hours) are kept in the last level and
+ *  cascaded again until they are in range.
+ *  Not thread safe: every MySQL_Thread owns its wheel.
+ */
+class ProxySQL_Timer_Wheel {
+	private:
+	timer_wheel_node slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS]; // list heads
+	unsigned long long current_tick; // last processed tick
+	unsigned int count;
+	void link(timer_wheel_node *n);
+	void unlink(timer_wheel_node *n);
+	void cascade(unsigned int level);
+	public:
+	ProxySQL_Timer_Wheel();
+	/**
+	 * @brief Schedules 'n' to expire at 'expires_us' (monotonic time), rescheduling it if already scheduled.
+	 * @details Timers already expired fire on the next call to 'advance()'.
+	 */
+	void schedule(timer_wheel_node *n, unsigned long long expires_us);
+	void cancel(timer_wheel_node *n);
+	/**
+	 * @brief Processes the ticks up to 'now_us', and appends the expired timers to 'expired'.
+	 * @details Expired timers are unlinked, and can be scheduled again by the caller.
+	 */
+	void advance(unsigned long long now_us, std::vector<timer_wheel_node *>& expired);
+	unsigned int size() const { return count; }
+};
+
+#endif /* __CLASS_PROXYSQL_TIMER_WHEEL */
@@ -249,7 +249,7 @@ public:
 
 		if (ALLOC_MEM == true) {
 			if (mybuff.capacity < len) {
-				if (mybuff.data) free(mybuff.data);
+				if (mybuff.data) l_free(mybuff.capacity, mybuff.data);
 
 				mybuff.data = l_alloc(len);
 				mybuff.capacity = len;
@@ -259,7 +259,7 @@ public:
 			mybuff.len = len;
 
 		} else {
-			if (mybuff.data) free(mybuff.data);
+			if (mybuff.data) l_free(mybuff.capacity, mybuff.data);
 
 			mybuff.data = buff;
 			mybuff.capacity = mybuff.len = len;
@@ -105,6 +105,7 @@ class MySQL_Connection {
 		MYSQL_STMT *stmt;
 		MYSQL_RES *stmt_result;
 		stmt_execute_metadata_t *stmt_meta;
+		unsigned long long start_time; // thread time when the query was sent, for passive health
 	} query;
 	char scramble_buff[40];
 	unsigned long long creation_time;
@@ -120,6 +121,9 @@ class MySQL_Connection {
 	MySQL_ResultSet *MyRS;
 	MySQL_ResultSet *MyRS_reuse;
 	MySrvC *parent;
+	unsigned int pool_list_idx; // position inside the MySrvConnList holding the connection
+	uint64_t pool_fingerprint; // see compute_pool_fingerprint() , valid only while in an indexed MySrvConnList
+	unsigned int pool_fingerprint_idx; // position inside the bucket of 'pool_fingerprint' of the MySrvConnList
 	MySQL_Connection_userinfo *userinfo;
 	MySQL_Data_Stream *myds;
 
@@ -259,6 +263,7 @@ class MySQL_Connection {
 	void reduce_auto_increment_delay_token() { if (auto_increment_delay_token) auto_increment_delay_token--; };
 
 	bool match_tracked_options(const MySQL_Connection *c);
+	uint64_t compute_pool_fingerprint() const;
 	bool requires_CHANGE_USER(const MySQL_Connection *client_conn);
 	unsigned int number_of_matching_session_variables(const MySQL_Connection *client_conn, unsigned int& not_matching);
 	unsigned long get_mysql_thread_id() { return mysql ? mysql->thread_id : 0; }
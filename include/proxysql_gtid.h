@@ -2,6 +2,9 @@
 #define PROXYSQL_GTID
 // highly inspired by libslave
 // https://github.com/vozbu/libslave/
+#include <cstddef>
+#include <cstdint>
+#include <string>
 #include <unordered_map>
 #include <list>
 #include <utility>
@@ -10,6 +13,35 @@ typedef std::pair<std::string, int64_t> gtid_t;
 typedef std::pair<int64_t, int64_t> gtid_interval_t;
 typedef std::unordered_map<std::string, std::list<gtid_interval_t>> gtid_set_t;
 
+/**
+ * @brief Adds the interval of trxids ['from', 'to'] of 'uuid' to 'gtid_executed', merging it with the
+ *   overlapping and adjacent intervals.
+ */
+void addGtidInterval(const std::string& uuid, int64_t from, int64_t to, gtid_set_t& gtid_executed);
+
+/**
+ * @brief Parser of the stream sent by proxysql_binlog_reader.
+ * @details The stream is made of lines:
+ *  - 'ST=<uuid>:<from>-<to>,...': the bootstrap, the GTID executed set of the server.
+ *  - 'I1=<uuid>:<trxid>': a new GTID for a different uuid than the previous one.
+ *  - 'I2=<trxid>': a new GTID for the same uuid of the previous one.
+ *  All the complete lines available are parsed at once, and consecutive trxids are coalesced in a single
+ *  interval before being added to the GTID set.
+ */
+class GTID_Stream_Parser {
+	public:
+	std::string uuid; // uuid of the last GTID read, used by the following 'I2' lines
+	/**
+	 * @brief Parses all the complete lines in 'data' and applies them to 'gtid_executed'.
+	 * @param events Incremented by the number of GTIDs read.
+	 * @param changed Set to 'true' if 'gtid_executed' was updated.
+	 * @return The number of bytes consumed, an incomplete last line is left in the buffer.
+	 */
+	size_t parse(const char *data, size_t len, gtid_set_t& gtid_executed, unsigned long long& events, bool& changed);
+	private:
+	void parse_bootstrap(const char *data, size_t len, gtid_set_t& gtid_executed);
+};
+
 /*
 class Gtid_Server_Info {
 	public:
@@ -41,14 +41,23 @@ void * l_realloc(void *, size_t, size_t);
 //void l_free(size_t, void *);
 void * __l_alloc(l_sfp *, size_t);
 void __l_free(l_sfp *, size_t, void *);
+void * l_slab_alloc(size_t);
+void l_slab_free(void *);
+size_t l_slab_get_allocated_bytes();
 
 #ifndef L_STACK
 #define L_STACK
 
 //#define l_alloc(s) __l_alloc(__thr_sfp,s)
 //#define l_free(s,p) __l_free(__thr_sfp,s,p)
+#ifdef PROXYSQL_SLAB_ALLOC
+// per-thread slab allocator, see lib/proxysql_mem.cpp . Enabled building with WITHSLABALLOC=1
+#define l_alloc(s) l_slab_alloc(s)
+#define l_free(s,p) l_slab_free(p)
+#else
 #define l_alloc(s) malloc(s)
 #define l_free(s,p) free(p)
+#endif /* PROXYSQL_SLAB_ALLOC */
 
 static inline void l_stack_push (l_stack **s, void *p) {
   l_stack *d=(l_stack *)p;
@@ -259,6 +259,7 @@ enum session_status {
 	SHOW_WARNINGS,
 	SETTING_NEXT_ISOLATION_LEVEL,
 	SETTING_NEXT_TRANSACTION_READ,
+	PREWARMING_SERVER,
 	session_status___NONE // special marker
 };
 
@@ -798,6 +799,9 @@ __thread int mysql_thread___max_transaction_idle_time;
 __thread int mysql_thread___max_transaction_time;
 __thread int mysql_thread___threshold_query_length;
 __thread int mysql_thread___threshold_resultset_size;
+__thread int mysql_thread___fast_forward_splice;
+__thread int mysql_thread___gather_writes;
+__thread int mysql_thread___threads_cpu_affinity;
 __thread int mysql_thread___wait_timeout;
 __thread int mysql_thread___throttle_max_bytes_per_second_to_client;
 __thread int mysql_thread___throttle_ratio_server_to_client;
@@ -811,10 +815,14 @@ __thread int mysql_thread___default_query_delay;
 __thread int mysql_thread___default_query_timeout;
 __thread int mysql_thread___long_query_time;
 __thread int mysql_thread___free_connections_pct;
+__thread int mysql_thread___connection_prewarm_pct;
 __thread int mysql_thread___ping_interval_server_msec;
 __thread int mysql_thread___ping_timeout_server;
 __thread int mysql_thread___shun_on_failures;
 __thread int mysql_thread___shun_recovery_time_sec;
+__thread int mysql_thread___passive_health_error_pct;
+__thread int mysql_thread___passive_health_min_queries;
+__thread int mysql_thread___passive_health_latency_percentile;
 __thread int mysql_thread___unshun_algorithm;
 __thread int mysql_thread___query_retries_on_failure;
 __thread int mysql_thread___connect_retries_on_failure;
@@ -834,6 +842,7 @@ __thread int mysql_thread___auto_increment_delay_multiplex;
 __thread int mysql_thread___auto_increment_delay_multiplex_timeout_ms;
 __thread int mysql_thread___handle_unknown_charset;
 __thread int mysql_thread___poll_timeout;
+__thread int mysql_thread___poll_backend;
 __thread int mysql_thread___poll_timeout_on_failure;
 __thread bool mysql_thread___connection_warming;
 __thread bool mysql_thread___have_compress;
@@ -858,6 +867,7 @@ __thread int mysql_thread___query_digests_max_query_length;
 __thread bool mysql_thread___parse_failure_logs_digest;
 __thread int mysql_thread___show_processlist_extended;
 __thread int mysql_thread___session_idle_ms;
+__thread int mysql_thread___session_migration_threshold;
 __thread int mysql_thread___hostgroup_manager_verbose;
 __thread bool mysql_thread___default_reconnect;
 __thread bool mysql_thread___session_idle_show_processlist;
@@ -880,6 +890,8 @@ __thread int mysql_thread___evaluate_replication_lag_on_servers_load;
 __thread int mysql_thread___query_cache_size_MB;
 __thread int mysql_thread___query_cache_soft_ttl_pct;
 __thread int mysql_thread___query_cache_handle_warnings;
+__thread int mysql_thread___query_cache_persist_interval_sec;
+__thread int mysql_thread___query_cache_persist_max_age_sec;
 
 /* variables used for SSL , from proxy to server (p2s) */
 __thread char * mysql_thread___ssl_p2s_ca;
@@ -894,6 +906,8 @@ __thread char * mysql_thread___ssl_p2s_crlpath;
 __thread char * mysql_thread___eventslog_filename;
 __thread int mysql_thread___eventslog_filesize;
 __thread int mysql_thread___eventslog_default_log;
+__thread int mysql_thread___eventslog_buffer_size;
+__thread int mysql_thread___eventslog_buffer_full_policy;
 __thread int mysql_thread___eventslog_format;
 
 /* variables used by audit log */
@@ -904,6 +918,8 @@ __thread int mysql_thread___auditlog_filesize;
 __thread int mysql_thread___monitor_enabled;
 __thread int mysql_thread___monitor_history;
 __thread int mysql_thread___monitor_connect_interval;
+__thread int mysql_thread___monitor_checks_jitter;
+__thread int mysql_thread___monitor_adaptive_interval_max_factor;
 __thread int mysql_thread___monitor_connect_timeout;
 __thread int mysql_thread___monitor_ping_interval;
 __thread int mysql_thread___monitor_ping_max_failures;
@@ -971,6 +987,9 @@ extern __thread int mysql_thread___max_transaction_idle_time;
 extern __thread int mysql_thread___max_transaction_time;
 extern __thread int mysql_thread___threshold_query_length;
 extern __thread int mysql_thread___threshold_resultset_size;
+extern __thread int mysql_thread___fast_forward_splice;
+extern __thread int mysql_thread___gather_writes;
+extern __thread int mysql_thread___threads_cpu_affinity;
 extern __thread int mysql_thread___wait_timeout;
 extern __thread int mysql_thread___throttle_max_bytes_per_second_to_client;
 extern __thread int mysql_thread___throttle_ratio_server_to_client;
@@ -984,10 +1003,14 @@ extern __thread int mysql_thread___default_query_delay;
 extern __thread int mysql_thread___default_query_timeout;
 extern __thread int mysql_thread___long_query_time;
 extern __thread int mysql_thread___free_connections_pct;
+extern __thread int mysql_thread___connection_prewarm_pct;
 extern __thread int mysql_thread___ping_interval_server_msec;
 extern __thread int mysql_thread___ping_timeout_server;
 extern __thread int mysql_thread___shun_on_failures;
 extern __thread int mysql_thread___shun_recovery_time_sec;
+extern __thread int mysql_thread___passive_health_error_pct;
+extern __thread int mysql_thread___passive_health_min_queries;
+extern __thread int mysql_thread___passive_health_latency_percentile;
 extern __thread int mysql_thread___unshun_algorithm;
 extern __thread int mysql_thread___query_retries_on_failure;
 extern __thread int mysql_thread___connect_retries_on_failure;
@@ -1007,6 +1030,7 @@ extern __thread int mysql_thread___auto_increment_delay_multiplex;
 extern __thread int mysql_thread___auto_increment_delay_multiplex_timeout_ms;
 extern __thread int mysql_thread___handle_unknown_charset;
 extern __thread int mysql_thread___poll_timeout;
+extern __thread int mysql_thread___poll_backend;
 extern __thread int mysql_thread___poll_timeout_on_failure;
 extern __thread bool mysql_thread___connection_warming;
 extern __thread bool mysql_thread___have_compress;
@@ -1031,6 +1055,7 @@ extern __thread int mysql_thread___query_digests_max_query_length;
 extern __thread bool mysql_thread___parse_failure_logs_digest;
 extern __thread int mysql_thread___show_processlist_extended;
 extern __thread int mysql_thread___session_idle_ms;
+extern __thread int mysql_thread___session_migration_threshold;
 extern __thread int mysql_thread___hostgroup_manager_verbose;
 extern __thread bool mysql_thread___default_reconnect;
 extern __thread bool mysql_thread___session_idle_show_processlist;
@@ -1053,6 +1078,8 @@ extern __thread int mysql_thread___evaluate_replication_lag_on_servers_load;
 extern __thread int mysql_thread___query_cache_size_MB;
 extern __thread int mysql_thread___query_cache_soft_ttl_pct;
 extern __thread int mysql_thread___query_cache_handle_warnings;
+extern __thread int mysql_thread___query_cache_persist_interval_sec;
+extern __thread int mysql_thread___query_cache_persist_max_age_sec;
 
 /* variables used for SSL , from proxy to server (p2s) */
 extern __thread char * mysql_thread___ssl_p2s_ca;
@@ -1067,6 +1094,8 @@ extern __thread char * mysql_thread___ssl_p2s_crlpath;
 extern __thread char * mysql_thread___eventslog_filename;
 extern __thread int mysql_thread___eventslog_filesize;
 extern __thread int mysql_thread___eventslog_default_log;
+extern __thread int mysql_thread___eventslog_buffer_size;
+extern __thread int mysql_thread___eventslog_buffer_full_policy;
 extern __thread int mysql_thread___eventslog_format;
 
 /* variables used by audit log */
@@ -1077,6 +1106,8 @@ extern __thread int mysql_thread___auditlog_filesize;
 extern __thread int mysql_thread___monitor_enabled;
 extern __thread int mysql_thread___monitor_history;
 extern __thread int mysql_thread___monitor_connect_interval;
+extern __thread int mysql_thread___monitor_checks_jitter;
+extern __thread int mysql_thread___monitor_adaptive_interval_max_factor;
 extern __thread int mysql_thread___monitor_connect_timeout;
 extern __thread int mysql_thread___monitor_ping_interval;
 extern __thread int mysql_thread___monitor_ping_max_failures;
@@ -16,7 +16,10 @@
 #include "prometheus/counter.h"
 #include "prometheus/gauge.h"
 
+#define QC_SNAPSHOT_FILENAME "proxysql_query_cache.snapshot"
+
 class KV_BtreeArray;
+class QC_Snapshot;
 
 typedef struct __QC_entry_t QC_entry_t;
 
@@ -35,6 +38,7 @@ struct __QC_entry_t {
 	uint32_t row_eof_pkt_offset = 0;
 	uint32_t ok_pkt_offset = 0;
 	uint32_t ref_count; // reference counter
+	QC_Snapshot *snapshot; // if not NULL, 'value' points inside this memory-mapped snapshot and must not be freed
 };
 
 struct p_qc_counter {
@@ -70,6 +74,10 @@ class Query_Cache {
 	KV_BtreeArray * KVs[SHARED_QUERY_CACHE_HASH_TABLES];
 	uint64_t get_data_size_total();
 	unsigned int current_used_memory_pct();
+	unsigned long long last_snapshot_ms;
+	std::string snapshot_path();
+	bool save_snapshot();
+	uint64_t load_snapshot();
 	struct {
 		std::array<prometheus::Counter*, p_qc_counter::__size> p_counter_array {};
 		std::array<prometheus::Gauge*, p_qc_gauge::__size> p_gauge_array {};
@@ -401,10 +401,10 @@ char * ClickHouse_Authentication::lookup(char * username, enum cred_username_typ
 	lookup = cg.bt_map.find(hash1);
 	if (lookup != cg.bt_map.end()) {
 		ch_account_details_t *ad=lookup->second;
-		ret=l_strdup(ad->password);
+		ret=strdup(ad->password);
 		if (use_ssl) *use_ssl=ad->use_ssl;
 		if (default_hostgroup) *default_hostgroup=ad->default_hostgroup;
-		if (default_schema) *default_schema=l_strdup(ad->default_schema);
+		if (default_schema) *default_schema=strdup(ad->default_schema);
 		if (schema_locked) *schema_locked=ad->schema_locked;
 		if (transaction_persistent) *transaction_persistent=ad->transaction_persistent;
 		if (fast_forward) *fast_forward=ad->fast_forward;
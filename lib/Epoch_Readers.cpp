@@ -0,0 +1,41 @@
+#include <sched.h>
+
+#include "Epoch_Readers.h"
+
+// readers stripe used by the current thread, assigned round-robin on first use
+static std::atomic<unsigned int> epoch_readers_next_stripe { 0 };
+static __thread int epoch_readers_stripe = -1;
+
+Epoch_Readers::Epoch_Readers() {
+	for (unsigned int s = 0; s < EPOCH_READERS_STRIPES; s++) {
+		readers[s].count[0] = 0;
+		readers[s].count[1] = 0;
+	}
+	epoch = 0;
+}
+
+std::atomic<unsigned int>& Epoch_Readers::read_begin() const {
+	if (epoch_readers_stripe == -1) {
+		epoch_readers_stripe = epoch_readers_next_stripe.fetch_add(1, std::memory_order_relaxed) % EPOCH_READERS_STRIPES;
+	}
+	std::atomic<unsigned int>& count = readers[epoch_readers_stripe].count[epoch.load() & 1];
+	count.fetch_add(1);
+	return count;
+}
+
+void Epoch_Readers::synchronize() {
+	// a reader can have read the epoch before the previous flip too: both parities are drained
+	for (unsigned int phase = 0; phase < 2; phase++) {
+		const unsigned int parity = epoch.fetch_add(1) & 1;
+		for (;;) {
+			unsigned int active = 0;
+			for (unsigned int s = 0; s < EPOCH_READERS_STRIPES; s++) {
+				active += readers[s].count[parity].load(std::memory_order_acquire);
+			}
+			if (active == 0) {
+				break;
+			}
+			sched_yield();
+		}
+	}
+}
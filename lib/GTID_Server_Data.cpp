@@ -12,6 +12,9 @@ extern MySQL_Monitor *GloMyMon;
 
 static pthread_mutex_t ev_loop_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+// maximum data read from a binlog reader before it's parsed, not to stall the loop during a catch-up
+#define GTID_READ_BATCH_MAX	(16*1024*1024)
+
 static void gtid_async_cb(struct ev_loop *loop, struct ev_async *watcher, int revents) {
 	if (glovars.shutdown) {
 		ev_break(loop);
@@ -60,6 +63,7 @@ void reader_cb(struct ev_loop *loop, struct ev_io *w, int revents) {
 				it2->second = NULL;
 				delete sd;
 			}
+			MyHGM->gtid_snapshots.publish(s1, nullptr);
 			ev_io_stop(MyHGM->gtid_ev_loop, w);
 			free(w);
 		} else {
@@ -165,13 +169,13 @@ GTID_Server_Data::GTID_Server_Data(struct ev_io *_w, char *_address, uint16_t _p
 	w = _w;
 	size = 1024; // 1KB buffer
 	data = (char *)malloc(size);
-	memset(uuid_server, 0, sizeof(uuid_server));
 	pos = 0;
 	len = 0;
 	address = strdup(_address);
 	port = _port;
 	mysql_port = _mysql_port;
 	events_read = 0;
+	gtid_executed_changed = false;
 }
 
 void GTID_Server_Data::resize(size_t _s) {
@@ -189,22 +193,28 @@ GTID_Server_Data::~GTID_Server_Data() {
 
 bool GTID_Server_Data::readall() {
 	bool ret = true;
-	if (size == len) {
-		// buffer is full, expand
-		resize(len*2);
-	}
-	int rc = 0;
-	rc = read(w->fd,data+len,size-len);
-	if (rc > 0) {
-		len += rc;
-	} else {
-		int myerr = errno;
-		proxy_error("Read returned %d bytes, error %d\n", rc, myerr);
-		if (
-			(rc == 0) ||
-			(rc==-1 && myerr != EINTR && myerr != EAGAIN)
-		) {
+	// read all the available data, so that it's parsed and published as a single batch
+	while (len < GTID_READ_BATCH_MAX) {
+		if (size == len) {
+			// buffer is full, expand
+			resize(len*2);
+		}
+		const size_t avail = size - len;
+		int rc = 0;
+		rc = read(w->fd,data+len,avail);
+		if (rc > 0) {
+			len += rc;
+			if ((size_t)rc < avail) {
+				break;
+			}
+		} else {
+			int myerr = errno;
+			if (rc==-1 && (myerr == EINTR || myerr == EAGAIN)) {
+				break;
+			}
+			proxy_error("Read returned %d bytes, error %d\n", rc, myerr);
 			ret = false;
+			break;
 		}
 	}
 	return ret;
@@ -229,16 +239,26 @@ bool GTID_Server_Data::gtid_exists(char *gtid_uuid, uint64_t gtid_trxid) {
 	return false;
 }
 
+void GTID_Server_Data::publish_snapshot() {
+	std::string s1 = address;
+	s1.append(":");
+	s1.append(std::to_string(mysql_port));
+	MyHGM->gtid_snapshots.publish(s1, std::make_shared<const GTID_Snapshot>(gtid_executed));
+	gtid_executed_changed = false;
+}
+
 void GTID_Server_Data::read_all_gtids() {
-		while (read_next_gtid()) {
-		}
-	}
+	pos += parser.parse(data+pos, len-pos, gtid_executed, events_read, gtid_executed_changed);
+}
 
 void GTID_Server_Data::dump() {
 	if (len==0) {
 		return;
 	}
 	read_all_gtids();
+	if (gtid_executed_changed) {
+		publish_snapshot();
+	}
 	//int rc = write(1,data+pos,len-pos);
 	fflush(stdout);
 	///pos += rc;
@@ -267,104 +287,6 @@ bool GTID_Server_Data::writeout() {
 	return ret;
 }
 
-bool GTID_Server_Data::read_next_gtid() {
-	if (len==0) {
-		return false;
-	}
-	void *nlp = NULL;
-	nlp = memchr(data+pos,'\n',len-pos);
-	if (nlp == NULL) {
-		return false;
-	}
-	int l = (char *)nlp - (data+pos);
-	char rec_msg[80];
-	if (strncmp(data+pos,(char *)"ST=",3)==0) {
-		// we are reading the bootstrap
-		char *bs = (char *)malloc(l+1-3); // length + 1 (null byte) - 3 (header)
-		memcpy(bs, data+pos+3, l-3);
-		bs[l-3] = '\0';
-		char *saveptr1=NULL;
-		char *saveptr2=NULL;
-		//char *saveptr3=NULL;
-		char *token = NULL;
-		char *subtoken = NULL;
-		//char *subtoken2 = NULL;
-		char *str1 = NULL;
-		char *str2 = NULL;
-		//char *str3 = NULL;
-		for (str1 = bs; ; str1 = NULL) {
-			token = strtok_r(str1, ",", &saveptr1);
-			if (token == NULL) {
-				break;
-			}
-			int j = 0;
-			for (str2 = token; ; str2 = NULL) {
-				subtoken = strtok_r(str2, ":", &saveptr2);
-				if (subtoken == NULL) {
-					break;
-					}
-				j++;
-				if (j%2 == 1) { // we are reading the uuid
-					char *p = uuid_server;
-					for (unsigned int k=0; k<strlen(subtoken); k++) {
-						if (subtoken[k]!='-') {
-							*p = subtoken[k];
-							p++;
-						}
-					}
-					//fprintf(stdout,"BS from %s\n", uuid_server);
-				} else { // we are reading the trxids
-					uint64_t trx_from;
-					uint64_t trx_to;
-					sscanf(subtoken,"%lu-%lu",&trx_from,&trx_to);
-					//fprintf(stdout,"BS from %s:%lu-%lu\n", uuid_server, trx_from, trx_to);
-					std::string s = uuid_server;
-					gtid_executed[s].emplace_back(trx_from, trx_to);
-			   }
-			}
-		}
-		pos += l+1;
-		free(bs);
-		//return true;
-	} else {
-		strncpy(rec_msg,data+pos,l);
-		pos += l+1;
-		rec_msg[l] = 0;
-		//int rc = write(1,data+pos,l+1);
-		//fprintf(stdout,"%s\n", rec_msg);
-		if (rec_msg[0]=='I') {
-			//char rec_uuid[80];
-			uint64_t rec_trxid = 0;
-			char *a = NULL;
-			int ul = 0;
-			switch (rec_msg[1]) {
-				case '1':
-					//sscanf(rec_msg+3,"%s\:%lu",uuid_server,&rec_trxid);
-					a = strchr(rec_msg+3,':');
-					ul = a-rec_msg-3;
-					strncpy(uuid_server,rec_msg+3,ul);
-					uuid_server[ul] = 0;
-					rec_trxid=atoll(a+1);
-					break;
-				case '2':
-					//sscanf(rec_msg+3,"%lu",&rec_trxid);
-					rec_trxid=atoll(rec_msg+3);
-					break;
-				default:
-					break;
-			}
-			//fprintf(stdout,"%s:%lu\n", uuid_server, rec_trxid);
-			std::string s = uuid_server;
-			gtid_t new_gtid = std::make_pair(s,rec_trxid);
-			addGtid(new_gtid,gtid_executed);
-			events_read++;
-			//return true;
-		}
-	}
-	//std::cout << "current pos " << gtid_executed_to_string(gtid_executed) << std::endl << std::endl;
-	return true;
-}
-
 std::string gtid_executed_to_string(gtid_set_t& gtid_executed) {
 	std::string gtid_set;
 	for (auto it=gtid_executed.begin(); it!=gtid_executed.end(); ++it) {
@@ -0,0 +1,82 @@
+#include <string.h>
+
+#include <algorithm>
+
+#include "GTID_Snapshot.h"
+
+GTID_Snapshot::GTID_Snapshot(const gtid_set_t& gtid_executed) {
+	uuids.reserve(gtid_executed.size());
+	for (auto it = gtid_executed.begin(); it != gtid_executed.end(); ++it) {
+		std::vector<gtid_interval_t> intervals(it->second.begin(), it->second.end());
+		std::sort(intervals.begin(), intervals.end());
+		uuids.emplace_back(it->first, std::move(intervals));
+	}
+	std::sort(
+		uuids.begin(), uuids.end(),
+		[](const std::pair<std::string, std::vector<gtid_interval_t>>& a, const std::pair<std::string, std::vector<gtid_interval_t>>& b) {
+			return a.first < b.first;
+		}
+	);
+}
+
+bool GTID_Snapshot::gtid_exists(const char *gtid_uuid, int64_t gtid_trxid) const {
+	auto it = std::lower_bound(
+		uuids.begin(), uuids.end(), gtid_uuid,
+		[](const std::pair<std::string, std::vector<gtid_interval_t>>& a, const char *uuid) {
+			return strcmp(a.first.c_str(), uuid) < 0;
+		}
+	);
+	if (it == uuids.end() || strcmp(it->first.c_str(), gtid_uuid) != 0) {
+		return false;
+	}
+	const std::vector<gtid_interval_t>& intervals = it->second;
+	// first interval starting after 'gtid_trxid': the previous one is the only one that can contain it
+	auto itr = std::upper_bound(
+		intervals.begin(), intervals.end(), gtid_trxid,
+		[](int64_t trxid, const gtid_interval_t& interval) {
+			return trxid < interval.first;
+		}
+	);
+	if (itr == intervals.begin()) {
+		return false;
+	}
+	--itr;
+	return gtid_trxid <= itr->second;
+}
+
+GTID_Snapshots::GTID_Snapshots() {
+	current = new gtid_snapshots_t();
+}
+
+GTID_Snapshots::~GTID_Snapshots() {
+	delete current.load();
+}
+
+bool GTID_Snapshots::gtid_exists(const std::string& server, const char *gtid_uuid, int64_t gtid_trxid) {
+	std::atomic<unsigned int>& count = readers.read_begin();
+	bool ret = false;
+	const gtid_snapshots_t *snapshots = current.load();
+	auto it = snapshots->find(server);
+	if (it != snapshots->end()) {
+		ret = it->second->gtid_exists(gtid_uuid, gtid_trxid);
+	}
+	Epoch_Readers::read_end(count);
+	return ret;
+}
+
+void GTID_Snapshots::publish(const std::string& server, std::shared_ptr<const GTID_Snapshot> snapshot) {
+	std::lock_guard<std::mutex> lock(writers_mutex);
+	gtid_snapshots_t *prev = current.load();
+	if (snapshot == nullptr && prev->find(server) == prev->end()) {
+		return;
+	}
+	gtid_snapshots_t *next = new gtid_snapshots_t(*prev);
+	if (snapshot) {
+		(*next)[server] = std::move(snapshot);
+	} else {
+		next->erase(server);
+	}
+	current.store(next);
+	readers.synchronize();
+	delete prev;
+}
@@ -1,4 +1,9 @@
 #include "MySQL_HostGroups_Manager.h"
+#include "MySQL_Authentication.hpp"
+#include "MySQL_encode.h"
+#include "MySQL_Monitor.hpp"
+
+#include <cmath>
 
 #ifdef TEST_AURORA
 static unsigned long long array_mysrvc_total = 0;
@@ -6,12 +11,15 @@ static unsigned long long array_mysrvc_cands = 0;
 #endif // TEST_AURORA
 
 extern MySQL_Threads_Handler *GloMTH;
+extern MySQL_Authentication *GloMyAuth;
 
 MyHGC::MyHGC(int _hid) {
 	hid=_hid;
 	mysrvs=new MySrvList(this);
+	pthread_mutex_init(&pool_mutex, NULL);
 	current_time_now = 0;
 	new_connections_now = 0;
+	prewarm.demand = 0;
 	attributes.initialized = false;
 	reset_attributes();
 	// Uninitialized server defaults. Should later be initialized via 'mysql_hostgroup_attributes'.
@@ -20,6 +28,8 @@ MyHGC::MyHGC(int _hid) {
 	servers_defaults.use_ssl = -1;
 	num_online_servers.store(0, std::memory_order_relaxed);;
 	last_log_time_num_online_servers = 0;
+	selection.usable = false;
+	selection_stale.store(true, std::memory_order_relaxed);
 }
 	
 void MyHGC::reset_attributes() {
@@ -35,6 +45,7 @@ void MyHGC::reset_attributes() {
 	attributes.autocommit = -1;
 	attributes.free_connections_pct = 10;
 	attributes.handle_warnings = -1;
+	attributes.server_selection = -1;
 	attributes.monitor_slave_lag_when_null = -1;
 	attributes.multiplex = true;
 	attributes.connection_warming = false;
@@ -50,6 +61,103 @@ void MyHGC::reset_attributes() {
 MyHGC::~MyHGC() {
 	reset_attributes(); // free all memory
 	delete mysrvs;
+	pthread_mutex_destroy(&pool_mutex);
+}
+
+/**
+ * @brief Cost of sending a new request to the server, for power-of-two-choices selection.
+ * @details The connections in use approximate the requests in flight, and the latency, that includes the
+ *  one observed on live traffic (see 'mysql-passive_health_latency_percentile'), the time to serve them.
+ */
+static inline uint64_t p2c_server_cost(MySrvC *mysrvc) {
+	return ((uint64_t)mysrvc->ConnectionsUsed->conns_length() + 1) * ((uint64_t)mysrvc->current_latency_us + 1);
+}
+
+/**
+ * @brief Returns the less loaded of two servers, see 'p2c_server_cost'. Any of them can be NULL.
+ */
+static inline MySrvC *p2c_pick(MySrvC *a, MySrvC *b) {
+	if (a == NULL || b == NULL) {
+		return a ? a : b;
+	}
+	return p2c_server_cost(b) < p2c_server_cost(a) ? b : a;
+}
+
+void MyHGC::rebuild_selection() {
+	selection.servers.clear();
+	selection.cumulative_weights.clear();
+	selection.usable = online_servers_within_threshold();
+	uint64_t sum = 0;
+	for (unsigned int j=0; j<mysrvs->cnt(); j++) {
+		MySrvC *mysrvc = mysrvs->idx(j);
+		MySerStatus status = mysrvc->get_status();
+		if (status == MYSQL_SERVER_STATUS_ONLINE) {
+			if (mysrvc->weight > 0) {
+				sum += mysrvc->weight;
+				selection.servers.push_back(mysrvc);
+				selection.cumulative_weights.push_back(sum);
+			}
+		} else if (status == MYSQL_SERVER_STATUS_SHUNNED) {
+			// shunned servers are recovered only by the full scan
+			selection.usable = false;
+		}
+	}
+	if (sum == 0) {
+		selection.usable = false;
+	}
+}
+
+/**
+ * @brief Picks a server from the precomputed weighted selection, and checks its dynamic conditions.
+ * @return The picked server, or NULL if it doesn't satisfy the dynamic conditions.
+ */
+MySrvC *MyHGC::get_weighted_MySrvC_precomputed() {
+	uint64_t total = selection.cumulative_weights.back();
+	uint64_t k;
+	if (total > 32768) {
+		k=rand()%total;
+	} else {
+		k=fastrand()%total;
+	}
+	unsigned int j = std::upper_bound(selection.cumulative_weights.begin(), selection.cumulative_weights.end(), k) - selection.cumulative_weights.begin();
+	MySrvC *mysrvc = selection.servers[j];
+	if (mysrvc->get_status() != MYSQL_SERVER_STATUS_ONLINE) { // the status may have changed without an invalidation
+		return NULL;
+	}
+	if (mysrvc->ConnectionsUsed->conns_length() >= mysrvc->max_connections) {
+		return NULL;
+	}
+	if (mysrvc->current_latency_us >= (mysrvc->max_latency_us ? mysrvc->max_latency_us : mysql_thread___default_max_latency_ms*1000)) {
+		return NULL;
+	}
+	return mysrvc;
+}
+
+/**
+ * @brief Picks a server using the precomputed weighted selection.
+ * @details Only the dynamic conditions (server status, used connections, latency) are checked
+ *  for the picked server. If it doesn't satisfy them NULL is returned, and the caller falls back
+ *  to the full scan: the resulting distribution is still proportional to the weight of the
+ *  servers satisfying all the conditions.
+ * @return The picked server, or NULL if the full scan in 'get_random_MySrvC' is required.
+ */
+MySrvC *MyHGC::get_random_MySrvC_precomputed() {
+	if (selection_stale.exchange(false, std::memory_order_relaxed)) {
+		rebuild_selection();
+	}
+	if (selection.usable == false) {
+		return NULL;
+	}
+	MySrvC *mysrvc = get_weighted_MySrvC_precomputed();
+	if (p2c_selection_enabled() && selection.servers.size() > 1) {
+		// if any of the two candidates is not usable, the other one is used
+		mysrvc = p2c_pick(mysrvc, get_weighted_MySrvC_precomputed());
+	}
+	if (mysrvc == NULL) {
+		return NULL;
+	}
+	proxy_debug(PROXY_DEBUG_MYSQL_CONNPOOL, 7, "Returning MySrvC %p, server %s:%d\n", mysrvc, mysrvc->address, mysrvc->port);
+	return mysrvc;
 }
 
 MySrvC *MyHGC::get_random_MySrvC(char * gtid_uuid, uint64_t gtid_trxid, int max_lag_ms, MySQL_Session *sess) {
@@ -59,6 +167,13 @@ MySrvC *MyHGC::get_random_MySrvC(char * gtid_uuid, uint64_t gtid_trxid, int max_
 	unsigned int TotalUsedConn=0;
 	unsigned int l=mysrvs->cnt();
 	static time_t last_hg_log = 0;
+	// GTID, lag and latency awareness depend on the state of all the candidates, they always require the full scan
+	if (gtid_trxid == 0 && max_lag_ms < 0 && (sess == NULL || sess->thread->variables.min_num_servers_lantency_awareness == 0)) {
+		mysrvc = get_random_MySrvC_precomputed();
+		if (mysrvc) {
+			return mysrvc;
+		}
+	}
 #ifdef TEST_AURORA
 	unsigned long long a1 = array_mysrvc_total/10000;
 	array_mysrvc_total += l;
@@ -145,9 +260,8 @@ MySrvC *MyHGC::get_random_MySrvC(char * gtid_uuid, uint64_t gtid_trxid, int max_
 								mysrvc->connect_ERR_at_time_last_detected_error=0;
 								mysrvc->time_last_detected_error=0;
 								// note: the following function scans all the hostgroups.
-								// This is ok for now because we only have a global mutex.
-								// If one day we implement a mutex per hostgroup (unlikely,
-								// but possible), this must be taken into consideration
+								// Other hostgroups are only modified if their pool_mutex
+								// can be acquired without waiting, see unshun_server_all_hostgroups()
 								if (mysql_thread___unshun_algorithm == 1) {
 									MyHGM->unshun_server_all_hostgroups(mysrvc->address, mysrvc->port, t, max_wait_sec, &mysrvc->myhgc->hid);
 								}
@@ -360,12 +474,24 @@ MySrvC *MyHGC::get_random_MySrvC(char * gtid_uuid, uint64_t gtid_trxid, int max_
 			k=fastrand()%New_sum;
 		}
 		k++;
-		New_sum=0;
+		unsigned int cumulative_sum=0;
 
 		for (j=0; j<num_candidates; j++) {
 			mysrvc = mysrvcCandidates[j];
-			New_sum+=mysrvc->weight;
-			if (k<=New_sum) {
+			cumulative_sum+=mysrvc->weight;
+			if (k<=cumulative_sum) {
+				if (p2c_selection_enabled() && num_candidates > 1) {
+					// second weighted random candidate, the less loaded of the two is used
+					k = (New_sum > 32768 ? rand() : fastrand()) % New_sum + 1;
+					cumulative_sum=0;
+					for (unsigned int i=0; i<num_candidates; i++) {
+						cumulative_sum+=mysrvcCandidates[i]->weight;
+						if (k<=cumulative_sum) {
+							mysrvc = p2c_pick(mysrvc, mysrvcCandidates[i]);
+							break;
+						}
+					}
+				}
 				proxy_debug(PROXY_DEBUG_MYSQL_CONNPOOL, 7, "Returning MySrvC %p, server %s:%d\n", mysrvc, mysrvc->address, mysrvc->port);
 				if (l>32) {
 					free(mysrvcCandidates);
@@ -398,7 +524,7 @@ void MyHGC::refresh_online_server_count() {
 	if (__sync_fetch_and_add(&glovars.shutdown, 0) != 0)
 		return;
 #ifdef DEBUG
-	assert(MyHGM->is_locked);
+	assert(MyHGM->is_locked || MyHGM->is_pool_locked.load());
 #endif
 	unsigned int online_servers_count = 0;
 	for (unsigned int i = 0; i < mysrvs->servers->len; i++) {
@@ -408,6 +534,7 @@ void MyHGC::refresh_online_server_count() {
 		}
 	}
 	num_online_servers.store(online_servers_count, std::memory_order_relaxed);
+	invalidate_selection();
 }
 
 void MyHGC::log_num_online_server_count_error() {
@@ -421,3 +548,138 @@ void MyHGC::log_num_online_server_count_error() {
 			hid, num_online_servers.load(std::memory_order_relaxed), attributes.max_num_online_servers);
 	}
 }
+
+void MyHGC::set_prewarm_user(const MySQL_Connection_userinfo *userinfo) {
+	if (userinfo->username == NULL) {
+		return;
+	}
+	if (prewarm.username != userinfo->username) {
+		prewarm.username = userinfo->username;
+	}
+	const char *schemaname = userinfo->schemaname ? userinfo->schemaname : "";
+	if (prewarm.schemaname != schemaname) {
+		prewarm.schemaname = schemaname;
+	}
+}
+
+/**
+ * @brief Returns the credentials to pre-open connections with, NULL if the user was removed or only its
+ *   hashed password is known and no client authenticated yet.
+ */
+static MySQL_Connection_userinfo * get_prewarm_userinfo(const std::string& username, const std::string& schemaname) {
+	void *sha1_pass = NULL;
+	char *password = GloMyAuth->lookup((char *)username.c_str(), USERNAME_FRONTEND, NULL, NULL, NULL, NULL, NULL, NULL, NULL, &sha1_pass, NULL);
+	if (password == NULL) {
+		return NULL;
+	}
+	MySQL_Connection_userinfo *userinfo = NULL;
+	if (password[0] != '*' || sha1_pass) {
+		char *sha1_hex = sha1_pass ? sha1_pass_hex((char *)sha1_pass) : NULL;
+		userinfo = new MySQL_Connection_userinfo();
+		userinfo->set((char *)username.c_str(), password, (char *)schemaname.c_str(), sha1_hex);
+		free(sha1_hex);
+	}
+	free(sha1_pass);
+	free(password);
+	return userinfo;
+}
+
+int MyHGC::plan_prewarm_connections(unsigned long long curtime, MySQL_Connection **conn_list, int num_conn) {
+	const unsigned int l = mysrvs->cnt();
+	unsigned int used_peak = 0;
+	uint64_t total_weight = 0;
+	for (unsigned int i = 0; i < l; i++) {
+		MySrvC *mysrvc = mysrvs->idx(i);
+		used_peak += mysrvc->prewarm_used_peak;
+		// the next window starts from the connections in use now
+		mysrvc->prewarm_used_peak = 0;
+		mysrvc->update_prewarm_used_peak();
+		if (mysrvc->get_status() == MYSQL_SERVER_STATUS_ONLINE) {
+			total_weight += mysrvc->weight;
+		}
+	}
+	if (used_peak >= prewarm.demand) {
+		prewarm.demand = used_peak;
+	} else {
+		// down to ~15% in one minute: the demand outlasts a failover, when no connection is used
+		prewarm.demand -= prewarm.demand / 32;
+	}
+	if (num_conn <= 0 || prewarm.demand < 1 || total_weight == 0 || prewarm.username.empty()) {
+		return 0;
+	}
+
+	// pre-opened connections are subject to the same throttling of the ones created on demand
+	unsigned long long curtime_s = curtime / 1000 / 1000;
+	if (curtime_s > current_time_now) {
+		current_time_now = curtime_s;
+		new_connections_now = 0;
+	}
+	unsigned int throttle_connections_per_sec_to_hostgroup = (unsigned int) mysql_thread___throttle_connections_per_sec_to_hostgroup;
+	if (attributes.configured == true) {
+		// mysql_hostgroup_attributes takes priority
+		throttle_connections_per_sec_to_hostgroup = attributes.throttle_connections_per_sec;
+	}
+	if (new_connections_now >= throttle_connections_per_sec_to_hostgroup) {
+		return 0;
+	}
+	unsigned int quota = throttle_connections_per_sec_to_hostgroup - new_connections_now;
+	if (quota > (unsigned int)num_conn) {
+		quota = num_conn;
+	}
+
+	int free_connections_pct = mysql_thread___free_connections_pct;
+	if (attributes.configured == true) {
+		// mysql_hostgroup_attributes takes priority
+		free_connections_pct = attributes.free_connections_pct;
+	}
+
+	MySQL_Connection_userinfo *userinfo = NULL;
+	unsigned int num = 0;
+	for (unsigned int i = 0; i < l && num < quota; i++) {
+		MySrvC *mysrvc = mysrvs->idx(i);
+		if (mysrvc->get_status() != MYSQL_SERVER_STATUS_ONLINE || mysrvc->weight == 0) {
+			continue;
+		}
+		unsigned int target = ceil(prewarm.demand * mysrvc->weight / total_weight * mysql_thread___connection_prewarm_pct / 100);
+		// beyond 3/4 of max_connections 'get_random_MyConn' starts freeing connections
+		const unsigned int max_target = (3 * mysrvc->max_connections) / 4;
+		if (target > max_target) {
+			target = max_target;
+		}
+		unsigned int conns = mysrvc->ConnectionsFree->conns_length() + mysrvc->ConnectionsUsed->conns_length();
+		if (conns < target && MySQL_Monitor::dns_lookup_async(mysrvc->address, mysrvc->port) != DNS_RESOLVE_READY) {
+			// pre-opened once the hostname is resolved
+			continue;
+		}
+		// free connections beyond 'free_connections_pct' are dropped by 'drop_all_idle_connections'
+		const unsigned int max_free = free_connections_pct * mysrvc->max_connections / 100;
+		if (target > mysrvc->ConnectionsUsed->conns_length() + max_free) {
+			target = mysrvc->ConnectionsUsed->conns_length() + max_free;
+		}
+		while (conns < target && num < quota) {
+			if (userinfo == NULL) {
+				userinfo = get_prewarm_userinfo(prewarm.username, prewarm.schemaname);
+				if (userinfo == NULL) {
+					proxy_warning("Unable to pre-open connections to hostgroup %u: no credentials for user '%s'\n", hid, prewarm.username.c_str());
+					prewarm.username.clear();
+					return num;
+				}
+			}
+			MySQL_Connection *conn = new MySQL_Connection();
+			conn->parent = mysrvc;
+			// if attributes.multiplex == true , STATUS_MYSQL_CONNECTION_NO_MULTIPLEX_HG is set to false. And vice-versa
+			conn->set_status(!attributes.multiplex, STATUS_MYSQL_CONNECTION_NO_MULTIPLEX_HG);
+			conn->userinfo->set(userinfo);
+			conn->reusable = true;
+			mysrvc->ConnectionsUsed->add(conn);
+			__sync_fetch_and_add(&mysrvc->prewarm_connecting, 1);
+			__sync_fetch_and_add(&MyHGM->status.server_connections_created, 1);
+			proxy_debug(PROXY_DEBUG_MYSQL_CONNPOOL, 7, "Pre-opening MySQL Connection %p, server %s:%d\n", conn, mysrvc->address, mysrvc->port);
+			conn_list[num++] = conn;
+			new_connections_now++;
+			conns++;
+		}
+	}
+	delete userinfo;
+	return num;
+}
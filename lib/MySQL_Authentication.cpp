@@ -578,7 +578,7 @@ char * MySQL_Authentication::lookup(char * username, enum cred_username_type use
 		}
 		if (use_ssl) *use_ssl=ad->use_ssl;
 		if (default_hostgroup) *default_hostgroup=ad->default_hostgroup;
-		if (default_schema) *default_schema=l_strdup(ad->default_schema);
+		if (default_schema) *default_schema=strdup(ad->default_schema);
 		if (schema_locked) *schema_locked=ad->schema_locked;
 		if (transaction_persistent) *transaction_persistent=ad->transaction_persistent;
 		if (fast_forward) *fast_forward=ad->fast_forward;
@@ -589,7 +589,7 @@ char * MySQL_Authentication::lookup(char * username, enum cred_username_type use
 				memcpy(*sha1_pass,ad->sha1_pass,SHA_DIGEST_LENGTH);
 			}
 		}
-		if (attributes) *attributes=l_strdup(ad->attributes);
+		if (attributes) *attributes=strdup(ad->attributes);
 	}
 #ifdef PROXYSQL_AUTH_PTHREAD_MUTEX
 	pthread_rwlock_unlock(&cg.lock);
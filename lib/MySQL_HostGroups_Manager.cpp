@@ -587,6 +587,8 @@ MySQL_HostGroups_Manager::MySQL_HostGroups_Manager() {
 	status.servers_table_version=0;
 	pthread_mutex_init(&status.servers_table_version_lock, NULL);
 	pthread_cond_init(&status.servers_table_version_cond, NULL);
+	// no checksum computed yet for the configuration tables
+	table_resultset_checksum_stale.fill(true);
 	status.myconnpoll_get=0;
 	status.myconnpoll_get_ok=0;
 	status.myconnpoll_get_ping=0;
@@ -615,7 +617,14 @@ MySQL_HostGroups_Manager::MySQL_HostGroups_Manager() {
 	pthread_mutex_init(&Galera_Info_mutex, NULL);
 	pthread_mutex_init(&AWS_Aurora_Info_mutex, NULL);
 #ifdef MHM_PTHREAD_MUTEX
-	pthread_mutex_init(&lock, NULL);
+	{
+		// writers are preferred, or the hot path of the connection pool may starve commit()
+		pthread_rwlockattr_t attr;
+		pthread_rwlockattr_init(&attr);
+		pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+		pthread_rwlock_init(&lock, &attr);
+		pthread_rwlockattr_destroy(&attr);
+	}
 #else
 	spinlock_rwlock_init(&rwlock);
 #endif
@@ -710,14 +719,14 @@ MySQL_HostGroups_Manager::~MySQL_HostGroups_Manager() {
 	if (gtid_ev_timer)
 		free(gtid_ev_timer);
 #ifdef MHM_PTHREAD_MUTEX
-	pthread_mutex_destroy(&lock);
+	pthread_rwlock_destroy(&lock);
 #endif
 }
 
 // wrlock() is only required during commit()
 void MySQL_HostGroups_Manager::wrlock() {
 #ifdef MHM_PTHREAD_MUTEX
-	pthread_mutex_lock(&lock);
+	pthread_rwlock_wrlock(&lock);
 #else
 	spin_wrlock(&rwlock);
 #endif
@@ -762,12 +771,34 @@ void MySQL_HostGroups_Manager::wrunlock() {
 	is_locked = false;
 #endif
 #ifdef MHM_PTHREAD_MUTEX
-	pthread_mutex_unlock(&lock);
+	pthread_rwlock_unlock(&lock);
 #else
 	spin_wrunlock(&rwlock);
 #endif
 }
 
+void MySQL_HostGroups_Manager::pool_rdlock() {
+#ifdef MHM_PTHREAD_MUTEX
+	pthread_rwlock_rdlock(&lock);
+#else
+	spin_rdlock(&rwlock);
+#endif
+#ifdef DEBUG
+	is_pool_locked++;
+#endif
+}
+
+void MySQL_HostGroups_Manager::pool_rdunlock() {
+#ifdef DEBUG
+	is_pool_locked--;
+#endif
+#ifdef MHM_PTHREAD_MUTEX
+	pthread_rwlock_unlock(&lock);
+#else
+	spin_rdunlock(&rwlock);
+#endif
+}
+
 
 void MySQL_HostGroups_Manager::wait_servers_table_version(unsigned v, unsigned w) {
 	struct timespec ts;
@@ -899,37 +930,46 @@ SQLite3_result * MySQL_HostGroups_Manager::execute_query(char *query, char **err
  * This function calculates the checksum for a specified table in the database using the provided SpookyHash object.
  * The checksum is computed based on the table's contents, sorted by the specified column name. If the initialization
  * flag is false, the SpookyHash object is initialized with predefined parameters. The calculated checksum is stored
- * in the raw_checksum parameter.
+ * in the 'table_resultset_checksum' entry of the table.
+ * The table is only read if it was regenerated since its checksum was computed (see 'table_resultset_checksum_stale'),
+ * otherwise the stored checksum is reused: configuration tables are only regenerated by 'commit()' when new values
+ * were loaded for them.
  *
  * @param myhash A reference to the SpookyHash object used for calculating the checksum.
  * @param init A reference to a boolean flag indicating whether the SpookyHash object has been initialized.
  * @param TableName The name of the table for which the checksum is to be calculated.
  * @param ColumnName The name of the column to be used for sorting the table before calculating the checksum.
- * @param raw_checksum A reference to a uint64_t variable where the calculated checksum will be stored.
+ * @param table The entry of 'table_resultset_checksum' where the calculated checksum will be stored.
  */
 void MySQL_HostGroups_Manager::CUCFT1(
-	SpookyHash& myhash, bool& init, const string& TableName, const string& ColumnName, uint64_t& raw_checksum
+	SpookyHash& myhash, bool& init, const string& TableName, const string& ColumnName, HGM_TABLES table
 ) {
-	char *error=NULL;
-	int cols=0;
-	int affected_rows=0;
-	SQLite3_result *resultset=NULL;
-	string query = "SELECT * FROM " + TableName + " ORDER BY " + ColumnName;
-	mydb->execute_statement(query.c_str(), &error , &cols , &affected_rows , &resultset);
-	if (resultset) {
-		if (resultset->rows_count) {
-			if (init == false) {
-				init = true;
-				myhash.Init(19,3);
+	uint64_t& raw_checksum = table_resultset_checksum[table];
+	if (table_resultset_checksum_stale[table]) {
+		char *error=NULL;
+		int cols=0;
+		int affected_rows=0;
+		SQLite3_result *resultset=NULL;
+		string query = "SELECT * FROM " + TableName + " ORDER BY " + ColumnName;
+		mydb->execute_statement(query.c_str(), &error , &cols , &affected_rows , &resultset);
+		raw_checksum = 0;
+		if (resultset) {
+			if (resultset->rows_count) {
+				raw_checksum = resultset->raw_checksum();
 			}
-			uint64_t hash1_ = resultset->raw_checksum();
-			raw_checksum = hash1_;
-			myhash.Update(&hash1_, sizeof(hash1_));
-			proxy_info("Checksum for table %s is 0x%lX\n", TableName.c_str(), hash1_);
+			delete resultset;
 		}
-		delete resultset;
+		table_resultset_checksum_stale[table] = false;
+		proxy_info("Checksum for table %s is 0x%lX\n", TableName.c_str(), (long unsigned int)raw_checksum);
 	} else {
-		proxy_info("Checksum for table %s is 0x%lX\n", TableName.c_str(), (long unsigned int)0);
+		proxy_debug(PROXY_DEBUG_MYSQL_CONNPOOL, 5, "Checksum for table %s is unchanged: 0x%lX\n", TableName.c_str(), (long unsigned int)raw_checksum);
+	}
+	if (raw_checksum) {
+		if (init == false) {
+			init = true;
+			myhash.Init(19,3);
+		}
+		myhash.Update(&raw_checksum, sizeof(raw_checksum));
 	}
 }
 
@@ -941,24 +981,16 @@ void MySQL_HostGroups_Manager::CUCFT1(
  *
  * @param myhash A reference to a SpookyHash object used for computing the checksums.
  * @param init A reference to a boolean flag indicating whether the checksum computation has been initialized.
- * @note This function resets the current checksum values for all tables except MYSQL_SERVERS and MYSQL_SERVERS_V2
- *       before recomputing the checksums.
+ * @note Only the tables regenerated since the previous computation are read again, see 'CUCFT1'.
  * @note The computed checksum values are stored in the `table_resultset_checksum` array.
  */
 void MySQL_HostGroups_Manager::commit_update_checksums_from_tables(SpookyHash& myhash, bool& init) {
-	// Always reset the current table values before recomputing
-	for (size_t i = 0; i < table_resultset_checksum.size(); i++) {
-		if (i != HGM_TABLES::MYSQL_SERVERS && i != HGM_TABLES::MYSQL_SERVERS_V2) {
-			table_resultset_checksum[i] = 0;
-		}
-	}
-
-	CUCFT1(myhash,init,"mysql_replication_hostgroups","writer_hostgroup", table_resultset_checksum[HGM_TABLES::MYSQL_REPLICATION_HOSTGROUPS]);
-	CUCFT1(myhash,init,"mysql_group_replication_hostgroups","writer_hostgroup", table_resultset_checksum[HGM_TABLES::MYSQL_GROUP_REPLICATION_HOSTGROUPS]);
-	CUCFT1(myhash,init,"mysql_galera_hostgroups","writer_hostgroup", table_resultset_checksum[HGM_TABLES::MYSQL_GALERA_HOSTGROUPS]);
-	CUCFT1(myhash,init,"mysql_aws_aurora_hostgroups","writer_hostgroup", table_resultset_checksum[HGM_TABLES::MYSQL_AWS_AURORA_HOSTGROUPS]);
-	CUCFT1(myhash,init,"mysql_hostgroup_attributes","hostgroup_id", table_resultset_checksum[HGM_TABLES::MYSQL_HOSTGROUP_ATTRIBUTES]);
-	CUCFT1(myhash,init,"mysql_servers_ssl_params","hostname,port,username", table_resultset_checksum[HGM_TABLES::MYSQL_SERVERS_SSL_PARAMS]);
+	CUCFT1(myhash,init,"mysql_replication_hostgroups","writer_hostgroup", HGM_TABLES::MYSQL_REPLICATION_HOSTGROUPS);
+	CUCFT1(myhash,init,"mysql_group_replication_hostgroups","writer_hostgroup", HGM_TABLES::MYSQL_GROUP_REPLICATION_HOSTGROUPS);
+	CUCFT1(myhash,init,"mysql_galera_hostgroups","writer_hostgroup", HGM_TABLES::MYSQL_GALERA_HOSTGROUPS);
+	CUCFT1(myhash,init,"mysql_aws_aurora_hostgroups","writer_hostgroup", HGM_TABLES::MYSQL_AWS_AURORA_HOSTGROUPS);
+	CUCFT1(myhash,init,"mysql_hostgroup_attributes","hostgroup_id", HGM_TABLES::MYSQL_HOSTGROUP_ATTRIBUTES);
+	CUCFT1(myhash,init,"mysql_servers_ssl_params","hostname,port,username", HGM_TABLES::MYSQL_SERVERS_SSL_PARAMS);
 }
 
 /**
@@ -1255,12 +1287,6 @@ bool MySQL_HostGroups_Manager::commit(
 	wrlock();
 	// purge table
 	purge_mysql_servers_table();
-	// if any server has gtid_port enabled, use_gtid is set to true
-	// and then has_gtid_port is set too
-	bool use_gtid = false;
-	proxy_debug(PROXY_DEBUG_MYSQL_CONNPOOL, 4, "DELETE FROM mysql_servers\n");
-	mydb->execute("DELETE FROM mysql_servers");
-	generate_mysql_servers_table();
 
 	char *error=NULL;
 	int cols=0;
@@ -1278,200 +1304,15 @@ bool MySQL_HostGroups_Manager::commit(
 		}
 		if (resultset) { delete resultset; resultset=NULL; }
 	}
-	char *query=NULL;
-	query=(char *)"SELECT mem_pointer, t1.hostgroup_id, t1.hostname, t1.port FROM mysql_servers t1 LEFT OUTER JOIN mysql_servers_incoming t2 ON (t1.hostgroup_id=t2.hostgroup_id AND t1.hostname=t2.hostname AND t1.port=t2.port) WHERE t2.hostgroup_id IS NULL";
-	mydb->execute_statement(query, &error , &cols , &affected_rows , &resultset);
-	if (error) {
-		proxy_error("Error on %s : %s\n", query, error);
-	} else {
-		if (GloMTH->variables.hostgroup_manager_verbose) {
-			proxy_info("Dumping mysql_servers LEFT JOIN mysql_servers_incoming\n");
-			resultset->dump_to_stderr();
-		}
-		for (std::vector<SQLite3_row *>::iterator it = resultset->rows.begin() ; it != resultset->rows.end(); ++it) {
-			SQLite3_row *r=*it;
-			long long ptr=atoll(r->fields[0]);
-			proxy_warning("Removed server at address %lld, hostgroup %s, address %s port %s. Setting status OFFLINE HARD and immediately dropping all free connections. Used connections will be dropped when trying to use them\n", ptr, r->fields[1], r->fields[2], r->fields[3]);
-			MySrvC *mysrvc=(MySrvC *)ptr;
-			mysrvc->set_status(MYSQL_SERVER_STATUS_OFFLINE_HARD);
-			mysrvc->ConnectionsFree->drop_all_connections();
-			char *q1=(char *)"DELETE FROM mysql_servers WHERE mem_pointer=%lld";
-			char *q2=(char *)malloc(strlen(q1)+32);
-			sprintf(q2,q1,ptr);
-			mydb->execute(q2);
-			free(q2);
-		}
-	}
-	if (resultset) { delete resultset; resultset=NULL; }
-
-	// This seems unnecessary. Removed as part of issue #829
-	//mydb->execute("DELETE FROM mysql_servers");
-	//generate_mysql_servers_table();
-
-	mydb->execute("INSERT OR IGNORE INTO mysql_servers(hostgroup_id, hostname, port, gtid_port, weight, status, compression, max_connections, max_replication_lag, use_ssl, max_latency_ms, comment) SELECT hostgroup_id, hostname, port, gtid_port, weight, status, compression, max_connections, max_replication_lag, use_ssl, max_latency_ms, comment FROM mysql_servers_incoming");
-
-	// SELECT FROM mysql_servers whatever is not identical in mysql_servers_incoming, or where mem_pointer=0 (where there is no pointer yet)
-	query=(char *)"SELECT t1.*, t2.gtid_port, t2.weight, t2.status, t2.compression, t2.max_connections, t2.max_replication_lag, t2.use_ssl, t2.max_latency_ms, t2.comment FROM mysql_servers t1 JOIN mysql_servers_incoming t2 ON (t1.hostgroup_id=t2.hostgroup_id AND t1.hostname=t2.hostname AND t1.port=t2.port) WHERE mem_pointer=0 OR t1.gtid_port<>t2.gtid_port OR t1.weight<>t2.weight OR t1.status<>t2.status OR t1.compression<>t2.compression OR t1.max_connections<>t2.max_connections OR t1.max_replication_lag<>t2.max_replication_lag OR t1.use_ssl<>t2.use_ssl OR t1.max_latency_ms<>t2.max_latency_ms or t1.comment<>t2.comment";
-	proxy_debug(PROXY_DEBUG_MYSQL_CONNPOOL, 4, "%s\n", query);
-	mydb->execute_statement(query, &error , &cols , &affected_rows , &resultset);
-	if (error) {
-		proxy_error("Error on %s : %s\n", query, error);
-	} else {
-
-		if (GloMTH->variables.hostgroup_manager_verbose) {
-			proxy_info("Dumping mysql_servers JOIN mysql_servers_incoming\n");
-			resultset->dump_to_stderr();
-		}
-		// optimization #829
-		int rc;
-		sqlite3_stmt *statement1=NULL;
-		sqlite3_stmt *statement2=NULL;
-		//sqlite3 *mydb3=mydb->get_db();
-		char *query1=(char *)"UPDATE mysql_servers SET mem_pointer = ?1 WHERE hostgroup_id = ?2 AND hostname = ?3 AND port = ?4";
-		//rc=(*proxy_sqlite3_prepare_v2)(mydb3, query1, -1, &statement1, 0);
-		rc = mydb->prepare_v2(query1, &statement1);
-		ASSERT_SQLITE_OK(rc, mydb);
-		char *query2=(char *)"UPDATE mysql_servers SET weight = ?1 , status = ?2 , compression = ?3 , max_connections = ?4 , max_replication_lag = ?5 , use_ssl = ?6 , max_latency_ms = ?7 , comment = ?8 , gtid_port = ?9 WHERE hostgroup_id = ?10 AND hostname = ?11 AND port = ?12";
-		//rc=(*proxy_sqlite3_prepare_v2)(mydb3, query2, -1, &statement2, 0);
-		rc = mydb->prepare_v2(query2, &statement2);
-		ASSERT_SQLITE_OK(rc, mydb);
-
-		for (std::vector<SQLite3_row *>::iterator it = resultset->rows.begin() ; it != resultset->rows.end(); ++it) {
-			SQLite3_row *r=*it;
-			long long ptr=atoll(r->fields[12]); // increase this index every time a new column is added
-			proxy_debug(PROXY_DEBUG_MYSQL_CONNPOOL, 5, "Server %s:%d , weight=%d, status=%d, mem_pointer=%llu, hostgroup=%d, compression=%d\n", r->fields[1], atoi(r->fields[2]), atoi(r->fields[4]), atoi(r->fields[5]), ptr, atoi(r->fields[0]), atoi(r->fields[6]));
-			//fprintf(stderr,"%lld\n", ptr);
-			if (ptr==0) {
-				if (GloMTH->variables.hostgroup_manager_verbose) {
-					proxy_info("Creating new server in HG %d : %s:%d , gtid_port=%d, weight=%d, status=%d\n", atoi(r->fields[0]), r->fields[1], atoi(r->fields[2]), atoi(r->fields[3]), atoi(r->fields[4]), atoi(r->fields[5]));
-				}
-				MySrvC *mysrvc=new MySrvC(r->fields[1], atoi(r->fields[2]), atoi(r->fields[3]), atoi(r->fields[4]), (MySerStatus)atoi(r->fields[5]), atoi(r->fields[6]), atoi(r->fields[7]), atoi(r->fields[8]), atoi(r->fields[9]), atoi(r->fields[10]), r->fields[11]); // add new fields here if adding more columns in mysql_servers
-				proxy_debug(PROXY_DEBUG_MYSQL_CONNPOOL, 5, "Adding new server %s:%d , weight=%d, status=%d, mem_ptr=%p into hostgroup=%d\n", r->fields[1], atoi(r->fields[2]), atoi(r->fields[4]), atoi(r->fields[5]), mysrvc, atoi(r->fields[0]));
-				add(mysrvc,atoi(r->fields[0]));
-				ptr=(uintptr_t)mysrvc;
-				rc=(*proxy_sqlite3_bind_int64)(statement1, 1, ptr); ASSERT_SQLITE_OK(rc, mydb);
-				rc=(*proxy_sqlite3_bind_int64)(statement1, 2, atoi(r->fields[0])); ASSERT_SQLITE_OK(rc, mydb);
-				rc=(*proxy_sqlite3_bind_text)(statement1, 3,  r->fields[1], -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, mydb);
-				rc=(*proxy_sqlite3_bind_int64)(statement1, 4, atoi(r->fields[2])); ASSERT_SQLITE_OK(rc, mydb);
-				SAFE_SQLITE3_STEP2(statement1);
-				rc=(*proxy_sqlite3_clear_bindings)(statement1); ASSERT_SQLITE_OK(rc, mydb);
-				rc=(*proxy_sqlite3_reset)(statement1); ASSERT_SQLITE_OK(rc, mydb);
-				if (mysrvc->gtid_port) {
-					// this server has gtid_port configured, we set use_gtid
-					proxy_debug(PROXY_DEBUG_MYSQL_CONNPOOL, 6, "Server %u:%s:%d has gtid_port enabled, setting use_gitd=true if not already set\n", mysrvc->myhgc->hid , mysrvc->address, mysrvc->port);
-					use_gtid = true;
-				}
-			} else {
-				bool run_update=false;
-				MySrvC *mysrvc=(MySrvC *)ptr;
-				// carefully increase the 2nd index by 1 for every new column added
-				if (atoi(r->fields[3])!=atoi(r->fields[13])) {
-					if (GloMTH->variables.hostgroup_manager_verbose)
-						proxy_info("Changing gtid_port for server %u:%s:%d (%s:%d) from %d (%d) to %d\n" , mysrvc->myhgc->hid , mysrvc->address, mysrvc->port, r->fields[1], atoi(r->fields[2]), atoi(r->fields[3]) , mysrvc->gtid_port , atoi(r->fields[13]));
-					mysrvc->gtid_port=atoi(r->fields[13]);
-				}
 
-				if (atoi(r->fields[4])!=atoi(r->fields[14])) {
-					if (GloMTH->variables.hostgroup_manager_verbose)
-						proxy_debug(PROXY_DEBUG_MYSQL_CONNPOOL, 5, "Changing weight for server %d:%s:%d (%s:%d) from %d (%ld) to %d\n" , mysrvc->myhgc->hid , mysrvc->address, mysrvc->port, r->fields[1], atoi(r->fields[2]), atoi(r->fields[4]) , mysrvc->weight , atoi(r->fields[14]));
-					mysrvc->weight=atoi(r->fields[14]);
-				}
-				if (atoi(r->fields[5])!=atoi(r->fields[15])) {
-					bool change_server_status = true;
-					if (GloMTH->variables.evaluate_replication_lag_on_servers_load == 1) {
-						if (mysrvc->get_status() == MYSQL_SERVER_STATUS_SHUNNED_REPLICATION_LAG && // currently server is shunned due to replication lag
-							(MySerStatus)atoi(r->fields[15]) == MYSQL_SERVER_STATUS_ONLINE) { // new server status is online
-							if (mysrvc->cur_replication_lag != -2) { // Master server? Seconds_Behind_Master column is not present
-								const unsigned int new_max_repl_lag = atoi(r->fields[18]);
-								if (mysrvc->cur_replication_lag < 0 ||
-									(new_max_repl_lag > 0 &&
-									((unsigned int)mysrvc->cur_replication_lag > new_max_repl_lag))) { // we check if current replication lag is greater than new max_replication_lag
-									change_server_status = false;
-								}
-							}
-						}
-					}
-					if (change_server_status == true) {
-						if (GloMTH->variables.hostgroup_manager_verbose)
-							proxy_info("Changing status for server %d:%s:%d (%s:%d) from %d (%d) to %d\n", mysrvc->myhgc->hid, mysrvc->address, mysrvc->port, r->fields[1], atoi(r->fields[2]), atoi(r->fields[5]), (int)mysrvc->get_status(), atoi(r->fields[15]));
-						mysrvc->set_status((MySerStatus)atoi(r->fields[15]));
-					}
-					if (mysrvc->get_status() == MYSQL_SERVER_STATUS_SHUNNED) {
-						mysrvc->shunned_automatic=false;
-					}
-				}
-				if (atoi(r->fields[6])!=atoi(r->fields[16])) {
-					if (GloMTH->variables.hostgroup_manager_verbose)
-						proxy_info("Changing compression for server %d:%s:%d (%s:%d) from %d (%d) to %d\n" , mysrvc->myhgc->hid , mysrvc->address, mysrvc->port, r->fields[1], atoi(r->fields[2]), atoi(r->fields[6]) , mysrvc->compression , atoi(r->fields[16]));
-					mysrvc->compression=atoi(r->fields[16]);
-				}
-				if (atoi(r->fields[7])!=atoi(r->fields[17])) {
-					if (GloMTH->variables.hostgroup_manager_verbose)
-					proxy_info("Changing max_connections for server %d:%s:%d (%s:%d) from %d (%ld) to %d\n" , mysrvc->myhgc->hid , mysrvc->address, mysrvc->port, r->fields[1], atoi(r->fields[2]), atoi(r->fields[7]) , mysrvc->max_connections , atoi(r->fields[17]));
-					mysrvc->max_connections=atoi(r->fields[17]);
-				}
-				if (atoi(r->fields[8])!=atoi(r->fields[18])) {
-					if (GloMTH->variables.hostgroup_manager_verbose)
-						proxy_info("Changing max_replication_lag for server %u:%s:%d (%s:%d) from %d (%d) to %d\n" , mysrvc->myhgc->hid , mysrvc->address, mysrvc->port, r->fields[1], atoi(r->fields[2]), atoi(r->fields[8]) , mysrvc->max_replication_lag , atoi(r->fields[18]));
-					mysrvc->max_replication_lag=atoi(r->fields[18]);
-					if (mysrvc->max_replication_lag == 0) { // we just changed it to 0
-						if (mysrvc->get_status() == MYSQL_SERVER_STATUS_SHUNNED_REPLICATION_LAG) {
-							// the server is currently shunned due to replication lag
-							// but we reset max_replication_lag to 0
-							// therefore we immediately reset the status too
-							mysrvc->set_status(MYSQL_SERVER_STATUS_ONLINE);
-						}
-					}
-				}
-				if (atoi(r->fields[9])!=atoi(r->fields[19])) {
-					if (GloMTH->variables.hostgroup_manager_verbose)
-						proxy_info("Changing use_ssl for server %d:%s:%d (%s:%d) from %d (%d) to %d\n" , mysrvc->myhgc->hid , mysrvc->address, mysrvc->port, r->fields[1], atoi(r->fields[2]), atoi(r->fields[9]) , mysrvc->use_ssl , atoi(r->fields[19]));
-					mysrvc->use_ssl=atoi(r->fields[19]);
-				}
-				if (atoi(r->fields[10])!=atoi(r->fields[20])) {
-					if (GloMTH->variables.hostgroup_manager_verbose)
-						proxy_info("Changing max_latency_ms for server %d:%s:%d (%s:%d) from %d (%d) to %d\n" , mysrvc->myhgc->hid , mysrvc->address, mysrvc->port, r->fields[1], atoi(r->fields[2]), atoi(r->fields[10]) , mysrvc->max_latency_us/1000 , atoi(r->fields[20]));
-					mysrvc->max_latency_us=1000*atoi(r->fields[20]);
-				}
-				if (strcmp(r->fields[11],r->fields[21])) {
-					if (GloMTH->variables.hostgroup_manager_verbose)
-						proxy_info("Changing comment for server %d:%s:%d (%s:%d) from '%s' to '%s'\n" , mysrvc->myhgc->hid , mysrvc->address, mysrvc->port, r->fields[1], atoi(r->fields[2]), r->fields[11], r->fields[21]);
-					free(mysrvc->comment);
-					mysrvc->comment=strdup(r->fields[21]);
-				}
-				if (run_update) {
-					rc=(*proxy_sqlite3_bind_int64)(statement2, 1, mysrvc->weight); ASSERT_SQLITE_OK(rc, mydb);
-					rc=(*proxy_sqlite3_bind_int64)(statement2, 2, (int)mysrvc->get_status()); ASSERT_SQLITE_OK(rc, mydb);
-					rc=(*proxy_sqlite3_bind_int64)(statement2, 3, mysrvc->compression); ASSERT_SQLITE_OK(rc, mydb);
-					rc=(*proxy_sqlite3_bind_int64)(statement2, 4, mysrvc->max_connections); ASSERT_SQLITE_OK(rc, mydb);
-					rc=(*proxy_sqlite3_bind_int64)(statement2, 5, mysrvc->max_replication_lag); ASSERT_SQLITE_OK(rc, mydb);
-					rc=(*proxy_sqlite3_bind_int64)(statement2, 6, mysrvc->use_ssl); ASSERT_SQLITE_OK(rc, mydb);
-					rc=(*proxy_sqlite3_bind_int64)(statement2, 7, mysrvc->max_latency_us/1000); ASSERT_SQLITE_OK(rc, mydb);
-					rc=(*proxy_sqlite3_bind_text)(statement2, 8,  mysrvc->comment, -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, mydb);
-					rc=(*proxy_sqlite3_bind_int64)(statement2, 9, mysrvc->gtid_port); ASSERT_SQLITE_OK(rc, mydb);
-					rc=(*proxy_sqlite3_bind_int64)(statement2, 10, mysrvc->myhgc->hid); ASSERT_SQLITE_OK(rc, mydb);
-					rc=(*proxy_sqlite3_bind_text)(statement2, 11,  mysrvc->address, -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, mydb);
-					rc=(*proxy_sqlite3_bind_int64)(statement2, 12, mysrvc->port); ASSERT_SQLITE_OK(rc, mydb);
-					SAFE_SQLITE3_STEP2(statement2);
-					rc=(*proxy_sqlite3_clear_bindings)(statement2); ASSERT_SQLITE_OK(rc, mydb);
-					rc=(*proxy_sqlite3_reset)(statement2); ASSERT_SQLITE_OK(rc, mydb);
-				}
-				if (mysrvc->gtid_port) {
-					// this server has gtid_port configured, we set use_gtid
-					proxy_debug(PROXY_DEBUG_MYSQL_CONNPOOL, 6, "Server %u:%s:%d has gtid_port enabled, setting use_gitd=true if not already set\n", mysrvc->myhgc->hid , mysrvc->address, mysrvc->port);
-					use_gtid = true;
-				}
-			}
-		}
-		(*proxy_sqlite3_finalize)(statement1);
-		(*proxy_sqlite3_finalize)(statement2);
-	}
+	// if any server has gtid_port enabled, use_gtid is set to true
+	// and then has_gtid_port is set too
+	bool use_gtid = commit_mysql_servers_incoming();
 	if (use_gtid) {
 		has_gtid_port = true;
 	} else {
 		has_gtid_port = false;
 	}
-	if (resultset) { delete resultset; resultset=NULL; }
 	proxy_debug(PROXY_DEBUG_MYSQL_CONNPOOL, 4, "DELETE FROM mysql_servers_incoming\n");
 	mydb->execute("DELETE FROM mysql_servers_incoming");
 
@@ -1482,6 +1323,7 @@ bool MySQL_HostGroups_Manager::commit(
 			proxy_debug(PROXY_DEBUG_MYSQL_CONNPOOL, 4, "DELETE FROM mysql_replication_hostgroups\n");
 			mydb->execute("DELETE FROM mysql_replication_hostgroups");
 			generate_mysql_replication_hostgroups_table();
+			table_resultset_checksum_stale[HGM_TABLES::MYSQL_REPLICATION_HOSTGROUPS] = true;
 		}
 
 		// group replication
@@ -1489,6 +1331,7 @@ bool MySQL_HostGroups_Manager::commit(
 			proxy_debug(PROXY_DEBUG_MYSQL_CONNPOOL, 4, "DELETE FROM mysql_group_replication_hostgroups\n");
 			mydb->execute("DELETE FROM mysql_group_replication_hostgroups");
 			generate_mysql_group_replication_hostgroups_table();
+			table_resultset_checksum_stale[HGM_TABLES::MYSQL_GROUP_REPLICATION_HOSTGROUPS] = true;
 		}
 
 		// galera
@@ -1496,6 +1339,7 @@ bool MySQL_HostGroups_Manager::commit(
 			proxy_debug(PROXY_DEBUG_MYSQL_CONNPOOL, 4, "DELETE FROM mysql_galera_hostgroups\n");
 			mydb->execute("DELETE FROM mysql_galera_hostgroups");
 			generate_mysql_galera_hostgroups_table();
+			table_resultset_checksum_stale[HGM_TABLES::MYSQL_GALERA_HOSTGROUPS] = true;
 		}
 
 		// AWS Aurora
@@ -1503,6 +1347,7 @@ bool MySQL_HostGroups_Manager::commit(
 			proxy_debug(PROXY_DEBUG_MYSQL_CONNPOOL, 4, "DELETE FROM mysql_aws_aurora_hostgroups\n");
 			mydb->execute("DELETE FROM mysql_aws_aurora_hostgroups");
 			generate_mysql_aws_aurora_hostgroups_table();
+			table_resultset_checksum_stale[HGM_TABLES::MYSQL_AWS_AURORA_HOSTGROUPS] = true;
 		}
 
 		// hostgroup attributes
@@ -1510,6 +1355,7 @@ bool MySQL_HostGroups_Manager::commit(
 			proxy_debug(PROXY_DEBUG_MYSQL_CONNPOOL, 4, "DELETE FROM mysql_hostgroup_attributes\n");
 			mydb->execute("DELETE FROM mysql_hostgroup_attributes");
 			generate_mysql_hostgroup_attributes_table();
+			table_resultset_checksum_stale[HGM_TABLES::MYSQL_HOSTGROUP_ATTRIBUTES] = true;
 		}
 
 		// SSL params
@@ -1517,6 +1363,7 @@ bool MySQL_HostGroups_Manager::commit(
 			proxy_debug(PROXY_DEBUG_MYSQL_CONNPOOL, 4, "DELETE FROM mysql_servers_ssl_params\n");
 			mydb->execute("DELETE FROM mysql_servers_ssl_params");
 			generate_mysql_servers_ssl_params_table();
+			table_resultset_checksum_stale[HGM_TABLES::MYSQL_SERVERS_SSL_PARAMS] = true;
 		}
 
 		uint64_t new_hash = commit_update_checksum_from_mysql_servers_v2(peer_mysql_servers_v2.resultset);
@@ -1635,24 +1482,12 @@ uint64_t MySQL_HostGroups_Manager::get_mysql_servers_checksum(SQLite3_result* ru
  * @return True if the specified GTID exists for the MySQL server connection, false otherwise.
  */
 bool MySQL_HostGroups_Manager::gtid_exists(MySrvC *mysrvc, char * gtid_uuid, uint64_t gtid_trxid) {
-	bool ret = false;
-	pthread_rwlock_rdlock(&gtid_rwlock);
 	std::string s1 = mysrvc->address;
 	s1.append(":");
 	s1.append(std::to_string(mysrvc->port));
-	std::unordered_map <string, GTID_Server_Data *>::iterator it2;
-	it2 = gtid_map.find(s1);
-	GTID_Server_Data *gtid_is=NULL;
-	if (it2!=gtid_map.end()) {
-		gtid_is=it2->second;
-		if (gtid_is) {
-			if (gtid_is->active == true) {
-				ret = gtid_is->gtid_exists(gtid_uuid,gtid_trxid);
-			}
-		}
-	}
+	// no 'gtid_rwlock': the snapshots are published by the GTID thread, see 'GTID_Server_Data::publish_snapshot'
+	bool ret = gtid_snapshots.gtid_exists(s1, gtid_uuid, gtid_trxid);
 	//proxy_info("Checking if server %s has GTID %s:%lu . %s\n", s1.c_str(), gtid_uuid, gtid_trxid, (ret ? "YES" : "NO"));
-	pthread_rwlock_unlock(&gtid_rwlock);
 	return ret;
 }
 
@@ -1728,6 +1563,7 @@ void MySQL_HostGroups_Manager::generate_mysql_gtid_executed_tables() {
 		close(gtid_si->w->fd);
 		free(gtid_si->w);
 		gtid_map.erase(*it3);
+		gtid_snapshots.publish(*it3, nullptr);
 	}
 	pthread_rwlock_unlock(&gtid_rwlock);
 }
@@ -1761,6 +1597,173 @@ void MySQL_HostGroups_Manager::purge_mysql_servers_table() {
 }
 
 
+bool MySQL_HostGroups_Manager::commit_mysql_servers_incoming() {
+	bool use_gtid = false;
+	char *error=NULL;
+	int cols=0;
+	int affected_rows=0;
+	SQLite3_result *resultset=NULL;
+	const char *query=(char *)"SELECT hostgroup_id, hostname, port, gtid_port, weight, status, compression, max_connections, max_replication_lag, use_ssl, max_latency_ms, comment FROM mysql_servers_incoming";
+	proxy_debug(PROXY_DEBUG_MYSQL_CONNPOOL, 4, "%s\n", query);
+	mydb->execute_statement(query, &error , &cols , &affected_rows , &resultset);
+	if (error) {
+		proxy_error("Error on %s : %s\n", query, error);
+		free(error);
+		return has_gtid_port;
+	}
+
+	// index the live servers by 'hostgroup_id:hostname:port', as the PRIMARY KEY of 'mysql_servers'
+	std::unordered_map<std::string, MySrvC *> live_servers {};
+	for (unsigned int i=0; i<MyHostGroups->len; i++) {
+		MyHGC *myhgc=(MyHGC *)MyHostGroups->index(i);
+		for (unsigned int j=0; j<myhgc->mysrvs->servers->len; j++) {
+			MySrvC *mysrvc=myhgc->mysrvs->idx(j);
+			const string key { std::to_string(myhgc->hid) + ":" + mysrvc->address + ":" + std::to_string(mysrvc->port) };
+			live_servers.insert({ key, mysrvc });
+		}
+	}
+
+	unsigned int created=0;
+	unsigned int changed=0;
+	unsigned int removed=0;
+	for (std::vector<SQLite3_row *>::iterator it = resultset->rows.begin() ; it != resultset->rows.end(); ++it) {
+		SQLite3_row *r=*it;
+		const string key { string { r->fields[0] } + ":" + r->fields[1] + ":" + r->fields[2] };
+		auto srv_it = live_servers.find(key);
+		if (srv_it == live_servers.end()) {
+			if (GloMTH->variables.hostgroup_manager_verbose) {
+				proxy_info("Creating new server in HG %d : %s:%d , gtid_port=%d, weight=%d, status=%d\n", atoi(r->fields[0]), r->fields[1], atoi(r->fields[2]), atoi(r->fields[3]), atoi(r->fields[4]), atoi(r->fields[5]));
+			}
+			MySrvC *mysrvc=new MySrvC(r->fields[1], atoi(r->fields[2]), atoi(r->fields[3]), atoi(r->fields[4]), (MySerStatus)atoi(r->fields[5]), atoi(r->fields[6]), atoi(r->fields[7]), atoi(r->fields[8]), atoi(r->fields[9]), atoi(r->fields[10]), r->fields[11]); // add new fields here if adding more columns in mysql_servers
+			proxy_debug(PROXY_DEBUG_MYSQL_CONNPOOL, 5, "Adding new server %s:%d , weight=%d, status=%d, mem_ptr=%p into hostgroup=%d\n", r->fields[1], atoi(r->fields[2]), atoi(r->fields[4]), atoi(r->fields[5]), mysrvc, atoi(r->fields[0]));
+			add(mysrvc,atoi(r->fields[0]));
+			// duplicated rows aren't possible in 'mysql_servers_incoming', but the PRIMARY KEY of 'mysql_servers' is honored anyway
+			live_servers.insert({ key, NULL });
+			created++;
+			if (mysrvc->gtid_port) {
+				// this server has gtid_port configured, we set use_gtid
+				proxy_debug(PROXY_DEBUG_MYSQL_CONNPOOL, 6, "Server %u:%s:%d has gtid_port enabled, setting use_gitd=true if not already set\n", mysrvc->myhgc->hid , mysrvc->address, mysrvc->port);
+				use_gtid = true;
+			}
+			continue;
+		}
+		MySrvC *mysrvc=srv_it->second;
+		if (mysrvc == NULL) {
+			continue;
+		}
+		// the server is kept, anything left in 'live_servers' is removed
+		srv_it->second=NULL;
+		bool srv_changed=false;
+		if (mysrvc->gtid_port!=atoi(r->fields[3])) {
+			if (GloMTH->variables.hostgroup_manager_verbose)
+				proxy_info("Changing gtid_port for server %u:%s:%d (%s:%d) from %d to %d\n" , mysrvc->myhgc->hid , mysrvc->address, mysrvc->port, r->fields[1], atoi(r->fields[2]), mysrvc->gtid_port , atoi(r->fields[3]));
+			mysrvc->gtid_port=atoi(r->fields[3]);
+			srv_changed=true;
+		}
+		if (mysrvc->weight!=atoi(r->fields[4])) {
+			if (GloMTH->variables.hostgroup_manager_verbose)
+				proxy_debug(PROXY_DEBUG_MYSQL_CONNPOOL, 5, "Changing weight for server %d:%s:%d (%s:%d) from %ld to %d\n" , mysrvc->myhgc->hid , mysrvc->address, mysrvc->port, r->fields[1], atoi(r->fields[2]), mysrvc->weight , atoi(r->fields[4]));
+			mysrvc->weight=atoi(r->fields[4]);
+			mysrvc->myhgc->invalidate_selection();
+			srv_changed=true;
+		}
+		if ((int)mysrvc->get_status()!=atoi(r->fields[5])) {
+			bool change_server_status = true;
+			if (GloMTH->variables.evaluate_replication_lag_on_servers_load == 1) {
+				if (mysrvc->get_status() == MYSQL_SERVER_STATUS_SHUNNED_REPLICATION_LAG && // currently server is shunned due to replication lag
+					(MySerStatus)atoi(r->fields[5]) == MYSQL_SERVER_STATUS_ONLINE) { // new server status is online
+					if (mysrvc->cur_replication_lag != -2) { // Master server? Seconds_Behind_Master column is not present
+						const unsigned int new_max_repl_lag = atoi(r->fields[8]);
+						if (mysrvc->cur_replication_lag < 0 ||
+							(new_max_repl_lag > 0 &&
+							((unsigned int)mysrvc->cur_replication_lag > new_max_repl_lag))) { // we check if current replication lag is greater than new max_replication_lag
+							change_server_status = false;
+						}
+					}
+				}
+			}
+			if (change_server_status == true) {
+				if (GloMTH->variables.hostgroup_manager_verbose)
+					proxy_info("Changing status for server %d:%s:%d (%s:%d) from %d to %d\n", mysrvc->myhgc->hid, mysrvc->address, mysrvc->port, r->fields[1], atoi(r->fields[2]), (int)mysrvc->get_status(), atoi(r->fields[5]));
+				mysrvc->set_status((MySerStatus)atoi(r->fields[5]));
+			}
+			if (mysrvc->get_status() == MYSQL_SERVER_STATUS_SHUNNED) {
+				mysrvc->shunned_automatic=false;
+			}
+			srv_changed=true;
+		}
+		if (mysrvc->compression!=(unsigned int)atoi(r->fields[6])) {
+			if (GloMTH->variables.hostgroup_manager_verbose)
+				proxy_info("Changing compression for server %d:%s:%d (%s:%d) from %d to %d\n" , mysrvc->myhgc->hid , mysrvc->address, mysrvc->port, r->fields[1], atoi(r->fields[2]), mysrvc->compression , atoi(r->fields[6]));
+			mysrvc->compression=atoi(r->fields[6]);
+			srv_changed=true;
+		}
+		if (mysrvc->max_connections!=atoi(r->fields[7])) {
+			if (GloMTH->variables.hostgroup_manager_verbose)
+				proxy_info("Changing max_connections for server %d:%s:%d (%s:%d) from %ld to %d\n" , mysrvc->myhgc->hid , mysrvc->address, mysrvc->port, r->fields[1], atoi(r->fields[2]), mysrvc->max_connections , atoi(r->fields[7]));
+			mysrvc->max_connections=atoi(r->fields[7]);
+			srv_changed=true;
+		}
+		if (mysrvc->max_replication_lag!=(unsigned int)atoi(r->fields[8])) {
+			if (GloMTH->variables.hostgroup_manager_verbose)
+				proxy_info("Changing max_replication_lag for server %u:%s:%d (%s:%d) from %d to %d\n" , mysrvc->myhgc->hid , mysrvc->address, mysrvc->port, r->fields[1], atoi(r->fields[2]), mysrvc->max_replication_lag , atoi(r->fields[8]));
+			mysrvc->max_replication_lag=atoi(r->fields[8]);
+			if (mysrvc->max_replication_lag == 0) { // we just changed it to 0
+				if (mysrvc->get_status() == MYSQL_SERVER_STATUS_SHUNNED_REPLICATION_LAG) {
+					// the server is currently shunned due to replication lag
+					// but we reset max_replication_lag to 0
+					// therefore we immediately reset the status too
+					mysrvc->set_status(MYSQL_SERVER_STATUS_ONLINE);
+				}
+			}
+			srv_changed=true;
+		}
+		if (mysrvc->use_ssl!=atoi(r->fields[9])) {
+			if (GloMTH->variables.hostgroup_manager_verbose)
+				proxy_info("Changing use_ssl for server %d:%s:%d (%s:%d) from %d to %d\n" , mysrvc->myhgc->hid , mysrvc->address, mysrvc->port, r->fields[1], atoi(r->fields[2]), mysrvc->use_ssl , atoi(r->fields[9]));
+			mysrvc->use_ssl=atoi(r->fields[9]);
+			srv_changed=true;
+		}
+		if (mysrvc->max_latency_us/1000!=(unsigned int)atoi(r->fields[10])) {
+			if (GloMTH->variables.hostgroup_manager_verbose)
+				proxy_info("Changing max_latency_ms for server %d:%s:%d (%s:%d) from %d to %d\n" , mysrvc->myhgc->hid , mysrvc->address, mysrvc->port, r->fields[1], atoi(r->fields[2]), mysrvc->max_latency_us/1000 , atoi(r->fields[10]));
+			mysrvc->max_latency_us=1000*atoi(r->fields[10]);
+			srv_changed=true;
+		}
+		if (strcmp(mysrvc->comment,r->fields[11])) {
+			if (GloMTH->variables.hostgroup_manager_verbose)
+				proxy_info("Changing comment for server %d:%s:%d (%s:%d) from '%s' to '%s'\n" , mysrvc->myhgc->hid , mysrvc->address, mysrvc->port, r->fields[1], atoi(r->fields[2]), mysrvc->comment, r->fields[11]);
+			free(mysrvc->comment);
+			mysrvc->comment=strdup(r->fields[11]);
+			srv_changed=true;
+		}
+		if (srv_changed) {
+			changed++;
+		}
+		if (mysrvc->gtid_port) {
+			// this server has gtid_port configured, we set use_gtid
+			proxy_debug(PROXY_DEBUG_MYSQL_CONNPOOL, 6, "Server %u:%s:%d has gtid_port enabled, setting use_gitd=true if not already set\n", mysrvc->myhgc->hid , mysrvc->address, mysrvc->port);
+			use_gtid = true;
+		}
+	}
+	delete resultset;
+
+	for (const auto& srv : live_servers) {
+		MySrvC *mysrvc=srv.second;
+		if (mysrvc == NULL || mysrvc->get_status() == MYSQL_SERVER_STATUS_OFFLINE_HARD) {
+			// kept, created, or already removed by a previous commit
+			continue;
+		}
+		proxy_warning("Removed server at address %p, hostgroup %u, address %s port %d. Setting status OFFLINE HARD and immediately dropping all free connections. Used connections will be dropped when trying to use them\n", mysrvc, mysrvc->myhgc->hid, mysrvc->address, mysrvc->port);
+		mysrvc->set_status(MYSQL_SERVER_STATUS_OFFLINE_HARD);
+		mysrvc->ConnectionsFree->drop_all_connections();
+		removed++;
+	}
+
+	proxy_info("MySQL servers changes applied - created: %u, changed: %u, removed: %u\n", created, changed, removed);
+
+	return use_gtid;
+}
 
 void MySQL_HostGroups_Manager::generate_mysql_servers_table(int *_onlyhg) {
 	int rc;
@@ -2315,6 +2318,7 @@ void MySQL_HostGroups_Manager::increase_reset_counter() {
  *
  * @param c The MySQL_Connection object to be pushed back to the pool.
  * @param _lock Boolean flag indicating whether to acquire a lock before performing the operation. Default is true.
+ *  If false, the caller must hold either wrlock() or pool_rdlock() plus the 'pool_mutex' of the hostgroup.
  *
  * @note The method assumes that the provided MySQL_Connection object has a valid parent server (MySrvC).
  * If the parent server is not valid, unexpected behavior may occur.
@@ -2326,20 +2330,20 @@ void MySQL_HostGroups_Manager::push_MyConn_to_pool(MySQL_Connection *c, bool _lo
 	// Ensure that the provided connection has a valid parent server
 	assert(c->parent);
 
-	MySrvC *mysrvc = nullptr; // Pointer to the parent server object
+	// Obtain a pointer to the parent server (MySrvC)
+	MySrvC *mysrvc = static_cast<MySrvC *>(c->parent);
 
-	// Acquire a lock if specified
-	if (_lock)
-		wrlock();
+	// Acquire a lock if specified: the global lock in shared mode, and the lock of the hostgroup
+	if (_lock) {
+		pool_rdlock();
+		pthread_mutex_lock(&mysrvc->myhgc->pool_mutex);
+	}
 
 	// Reset the auto-increment delay token associated with the connection
 	c->auto_increment_delay_token = 0;
 
 	// Increment the counter tracking the number of connections pushed back to the pool
-	status.myconnpoll_push++;
-
-	// Obtain a pointer to the parent server (MySrvC)
-	mysrvc = static_cast<MySrvC *>(c->parent);
+	__sync_fetch_and_add(&status.myconnpoll_push, 1);
 
 	// Log debug information about the connection being returned to the pool
 	proxy_debug(PROXY_DEBUG_MYSQL_CONNPOOL, 7, "Returning MySQL_Connection %p, server %s:%d with status %d\n", c, mysrvc->address, mysrvc->port, (int)mysrvc->get_status());
@@ -2386,8 +2390,10 @@ void MySQL_HostGroups_Manager::push_MyConn_to_pool(MySQL_Connection *c, bool _lo
 
 // Exit point for releasing the lock
 __exit_push_MyConn_to_pool:
-	if (_lock)
-		wrunlock(); // Release the lock if acquired
+	if (_lock) { // Release the locks if acquired
+		pthread_mutex_unlock(&mysrvc->myhgc->pool_mutex);
+		pool_rdunlock();
+	}
 }
 
 /**
@@ -2398,6 +2404,7 @@ __exit_push_MyConn_to_pool:
  * method for each connection without acquiring a lock for each individual push operation.
  *
  * @param ca An array of MySQL_Connection pointers representing the connections to be pushed back to the pool.
+ *  The connections can belong to different hostgroups.
  * @param cnt The number of connections in the array.
  *
  * @note This method assumes that the array of connections is valid and does not contain any nullptr entries.
@@ -2406,13 +2413,22 @@ __exit_push_MyConn_to_pool:
 void MySQL_HostGroups_Manager::push_MyConn_to_pool_array(MySQL_Connection **ca, unsigned int cnt) {
 	unsigned int i=0; // Index variable for iterating through the array
 	MySQL_Connection *c = nullptr; // Pointer to hold the current connection from the array
+	MyHGC *locked_hgc = nullptr; // Hostgroup whose pool_mutex is currently held
 	c=ca[i];
 
-	// Acquire a write lock to perform the operations atomically
-	wrlock();
+	// Acquire the global lock in shared mode once for the whole array
+	pool_rdlock();
 
 	// Iterate through the array of connections
 	while (i<cnt) {
+		// Connections of the same hostgroup are often consecutive, keep its lock while possible
+		MyHGC *myhgc = static_cast<MySrvC *>(c->parent)->myhgc;
+		if (myhgc != locked_hgc) {
+			if (locked_hgc)
+				pthread_mutex_unlock(&locked_hgc->pool_mutex);
+			pthread_mutex_lock(&myhgc->pool_mutex);
+			locked_hgc = myhgc;
+		}
 		// Push the current connection back to the pool without acquiring a lock for each individual push
 		push_MyConn_to_pool(c,false);
 		i++;
@@ -2420,8 +2436,10 @@ void MySQL_HostGroups_Manager::push_MyConn_to_pool_array(MySQL_Connection **ca,
 			c=ca[i];
 	}
 
-	// Release the write lock after processing all connections in the array
-	wrunlock();
+	// Release the locks after processing all connections in the array
+	if (locked_hgc)
+		pthread_mutex_unlock(&locked_hgc->pool_mutex);
+	pool_rdunlock();
 }
 
 void MySQL_HostGroups_Manager::unshun_server_all_hostgroups(const char * address, uint16_t port, time_t t, int max_wait_sec, unsigned int *skip_hid) {
@@ -2443,6 +2461,13 @@ void MySQL_HostGroups_Manager::unshun_server_all_hostgroups(const char * address
 			// if skip_hid is not NULL, we skip that specific hostgroup
 			continue;
 		}
+		// This function can be called from the connection pool hot path, holding only the global lock in
+		// shared mode and the pool_mutex of 'skip_hid'. Waiting for the pool_mutex of another hostgroup
+		// could deadlock, therefore busy hostgroups are skipped: unshunning is only a best effort attempt,
+		// and each hostgroup also tries to recover its own shunned servers.
+		if (pthread_mutex_trylock(&myhgc->pool_mutex)) {
+			continue;
+		}
 		bool found = false; // was this server already found in this hostgroup?
 		for (j=0; found==false && j<(int)myhgc->mysrvs->cnt(); j++) {
 			MySrvC *mysrvc=(MySrvC *)myhgc->mysrvs->servers->index(j);
@@ -2474,6 +2499,7 @@ void MySQL_HostGroups_Manager::unshun_server_all_hostgroups(const char * address
 				}
 			}
 		}
+		pthread_mutex_unlock(&myhgc->pool_mutex);
 	}
 }
 
@@ -2495,20 +2521,31 @@ void MySQL_HostGroups_Manager::unshun_server_all_hostgroups(const char * address
  * @return A pointer to the retrieved MySQL_Connection object if successful, or nullptr if no suitable connection
  *         is available in the pool.
  *
- * @note This method locks the connection pool to ensure thread safety during access. It releases the lock once
- *       the operation is completed.
+ * @note This method acquires the global lock in shared mode and the 'pool_mutex' of the hostgroup, so that
+ *       checkouts from different hostgroups don't serialize. The global lock is acquired in exclusive mode
+ *       only if the hostgroup needs to be created.
  */
 MySQL_Connection * MySQL_HostGroups_Manager::get_MyConn_from_pool(unsigned int _hid, MySQL_Session *sess, bool ff, char * gtid_uuid, uint64_t gtid_trxid, int max_lag_ms) {
 	MySQL_Connection * conn = nullptr; // Pointer to hold the retrieved MySQL_Connection
 
-	// Acquire a write lock to access the connection pool
-	wrlock();
+	// Acquire the global lock in shared mode to access the connection pool
+	pool_rdlock();
 
 	// Increment the counter for connection pool retrieval attempts
-	status.myconnpoll_get++;
+	__sync_fetch_and_add(&status.myconnpoll_get, 1);
 
 	// Look up the hostgroup by ID and retrieve a random MySQL server from it based on specified criteria
-	MyHGC *myhgc=MyHGC_lookup(_hid);
+	MyHGC *myhgc=MyHGC_find(_hid);
+	if (myhgc == NULL) {
+		// creating a hostgroup changes the topology, and requires the exclusive lock.
+		// Hostgroups are never destroyed at runtime, the pointer remains valid.
+		pool_rdunlock();
+		wrlock();
+		myhgc=MyHGC_lookup(_hid);
+		wrunlock();
+		pool_rdlock();
+	}
+	pthread_mutex_lock(&myhgc->pool_mutex);
 	MySrvC *mysrvc = NULL;
 #ifdef TEST_AURORA
 	for (int i=0; i<10; i++)
@@ -2521,13 +2558,21 @@ MySQL_Connection * MySQL_HostGroups_Manager::get_MyConn_from_pool(unsigned int _
 		// If a connection is obtained, mark it as used and update connection pool statistics
 		if (conn) {
 			mysrvc->ConnectionsUsed->add(conn);
-			status.myconnpoll_get_ok++;
+			__sync_fetch_and_add(&status.myconnpoll_get_ok, 1);
 			mysrvc->update_max_connections_used();
+			if (mysql_thread___connection_prewarm_pct) {
+				mysrvc->update_prewarm_used_peak();
+				// pre-opened connections will use the user of the last checkout
+				if (ff == false && sess && sess->client_myds && sess->client_myds->myconn) {
+					myhgc->set_prewarm_user(sess->client_myds->myconn->userinfo);
+				}
+			}
 		}
 	}
 
-	// Release the write lock after accessing the connection pool
-	wrunlock();
+	// Release the locks after accessing the connection pool
+	pthread_mutex_unlock(&myhgc->pool_mutex);
+	pool_rdunlock();
 
 	// Debug message indicating the retrieved MySQL_Connection and its server details
 	proxy_debug(PROXY_DEBUG_MYSQL_CONNPOOL, 7, "Returning MySQL Connection %p, server %s:%d\n", conn, (conn ? conn->parent->address : "") , (conn ? conn->parent->port : 0 ));
@@ -2570,7 +2615,8 @@ void MySQL_HostGroups_Manager::destroy_MyConn_from_pool(MySQL_Connection *c, boo
 					case 1231:
 						break;
 					default:
-					if (c->mysql->thread_id) {
+					// the connect can still be waiting for the resolution of the hostname
+					if (c->mysql && c->mysql->thread_id) {
 						MySQL_Connection_userinfo *ui=c->userinfo;
 						char *auth_password=NULL;
 						if (ui->password) {
@@ -2601,13 +2647,15 @@ void MySQL_HostGroups_Manager::destroy_MyConn_from_pool(MySQL_Connection *c, boo
 	if (to_del) {
 		// we lock only this part of the code because we need to remove the connection from ConnectionsUsed
 		if (_lock) {
-			wrlock();
+			pool_rdlock();
+			pthread_mutex_lock(&mysrvc->myhgc->pool_mutex);
 		}
 		proxy_debug(PROXY_DEBUG_MYSQL_CONNPOOL, 7, "Destroying MySQL_Connection %p, server %s:%d\n", c, mysrvc->address, mysrvc->port);
 		mysrvc->ConnectionsUsed->remove(c);
-		status.myconnpoll_destroy++;
-                if (_lock) {
-			wrunlock();
+		__sync_fetch_and_add(&status.myconnpoll_destroy, 1);
+		if (_lock) {
+			pthread_mutex_unlock(&mysrvc->myhgc->pool_mutex);
+			pool_rdunlock();
 		}
 		delete c;
 	}
@@ -2640,6 +2688,7 @@ void update_hg_attrs_server_defaults(MySrvC* mysrvc, MyHGC* myhgc) {
 			// Same harcoded default as in 'CREATE TABLE mysql_servers ...'
 			mysrvc->weight = 1;
 		}
+		myhgc->invalidate_selection();
 	}
 	if (mysrvc->max_connections == -1) {
 		if (myhgc->servers_defaults.max_connections != -1) {
@@ -2988,6 +3037,24 @@ void MySQL_HostGroups_Manager::drop_all_idle_connections() {
  *   above a certain percentage of the maximal number of connections will be
  *   dropped as well
  */
+int MySQL_HostGroups_Manager::get_prewarm_connections(unsigned long long curtime, MySQL_Connection **conn_list, int num_conn) {
+	unsigned long long last_planning = last_prewarm_planning.load(std::memory_order_relaxed);
+	if (curtime < last_planning + 1000000 || last_prewarm_planning.compare_exchange_strong(last_planning, curtime) == false) {
+		return 0;
+	}
+	int num_conn_current = 0;
+	pool_rdlock();
+	for (unsigned int i = 0; i < MyHostGroups->len; i++) {
+		MyHGC *myhgc = (MyHGC *)MyHostGroups->index(i);
+		// all the hostgroups are planned, even without room for more connections, to track their demand
+		pthread_mutex_lock(&myhgc->pool_mutex);
+		num_conn_current += myhgc->plan_prewarm_connections(curtime, conn_list + num_conn_current, num_conn - num_conn_current);
+		pthread_mutex_unlock(&myhgc->pool_mutex);
+	}
+	pool_rdunlock();
+	return num_conn_current;
+}
+
 int MySQL_HostGroups_Manager::get_multiple_idle_connections(int _hid, unsigned long long _max_last_time_used, MySQL_Connection **conn_list, int num_conn) {
 	wrlock();
 	drop_all_idle_connections();
@@ -4133,7 +4200,10 @@ void MySQL_HostGroups_Manager::set_server_current_latency_us(char *hostname, int
 			for (j=0; j<l; j++) {
 				mysrvc=myhgc->mysrvs->idx(j);
 				if (mysrvc->port==port && strcmp(mysrvc->address,hostname)==0) {
-					mysrvc->current_latency_us=_current_latency_us;
+					mysrvc->ping_latency_us=_current_latency_us;
+					// the latency from live traffic, if more recent and higher, has precedence
+					unsigned int passive_latency_us = mysrvc->passive_health.get_latency_us(monotonic_time());
+					mysrvc->current_latency_us = passive_latency_us > _current_latency_us ? passive_latency_us : _current_latency_us;
 				}
 			}
 		}
@@ -6238,6 +6308,7 @@ bool AWS_Aurora_Info::update(int r, int _port, char *_end_addr, int maxl, int al
  * @details Input verification is performed in the supplied 'hostgroup_settings'. It's expected to be a valid
  *  JSON that may contain the following fields:
  *   - handle_warnings: Value must be >= 0.
+ *   - server_selection: '0' for weighted random selection (default), '1' for power-of-two-choices.
  *
  *  In case input verification fails for a field, supplied 'MyHGC' is NOT updated for that field. An error
  *  message is logged specifying the source of the error.
@@ -6260,6 +6331,10 @@ void init_myhgc_hostgroup_settings(const char* hostgroup_settings, MyHGC* myhgc)
 				{ return (monitor_slave_lag_when_null >= 0 && monitor_slave_lag_when_null <= 604800); };
 			const int32_t monitor_slave_lag_when_null = j_get_srv_default_int_val<int32_t>(j, hid, "monitor_slave_lag_when_null", monitor_slave_lag_when_null_check);
 			myhgc->attributes.monitor_slave_lag_when_null = monitor_slave_lag_when_null;
+
+			const auto server_selection_check = [](int8_t server_selection) -> bool { return server_selection == 0 || server_selection == 1; };
+			const int8_t server_selection = j_get_srv_default_int_val<int8_t>(j, hid, "server_selection", server_selection_check);
+			myhgc->attributes.server_selection = server_selection;
 		}
 		catch (const json::exception& e) {
 			proxy_error(
@@ -7413,7 +7488,7 @@ void MySQL_HostGroups_Manager::add_discovered_servers_to_mysql_servers_and_repli
 
 			CUCFT1(
 				rep_hgs_hash, init, "mysql_replication_hostgroups", "writer_hostgroup",
-				table_resultset_checksum[HGM_TABLES::MYSQL_REPLICATION_HOSTGROUPS]
+				HGM_TABLES::MYSQL_REPLICATION_HOSTGROUPS
 			);
 
 			proxy_info("Checksum for table %s is %s\n", "mysql_servers", mysrvs_checksum.c_str());
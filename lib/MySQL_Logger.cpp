@@ -9,6 +9,8 @@
 
 #include <dirent.h>
 #include <libgen.h>
+#include <zlib.h>
+#include <set>
 
 #include "../deps/json/json.hpp"
 using json = nlohmann::json;
@@ -22,6 +24,171 @@ using json = nlohmann::json;
 
 extern MySQL_Logger *GloMyLogger;
 
+#define MYSQL_LOGGER_WRITER_IDLE_US	10000	// sleep time of the events writer thread when there are no events to write
+#define MYSQL_LOGGER_BUFFER_FULL_US	100	// sleep time of a worker waiting for space in its buffer, with eventslog_buffer_full_policy=1
+#define MYSQL_LOGGER_BLOCK_MAGIC	0x31425350	// "PSB1", start of every block of events log format 3
+#define MYSQL_LOGGER_BLOCK_ZLIB	0x1	// flag of blocks with a payload compressed with zlib
+#define MYSQL_LOGGER_BLOCK_SIZE	(256*1024)	// events log format 3 blocks are written when they exceed this size ...
+#define MYSQL_LOGGER_BLOCK_MAX_AGE_US	1000000	// ... or when their first event is older than this
+
+/**
+ * @brief Byte stream appended to a 'std::string', used to render events without allocating a new buffer per event.
+ */
+class MySQL_Events_Strbuf : public std::streambuf {
+	public:
+	std::string data;
+	protected:
+	int_type overflow(int_type c) override {
+		if (c != traits_type::eof()) {
+			data.push_back((char)c);
+		}
+		return c;
+	}
+	std::streamsize xsputn(const char *p, std::streamsize n) override {
+		data.append(p, n);
+		return n;
+	}
+};
+
+/**
+ * @brief Header of every event stored in a MySQL_Events_Buffer.
+ * @details Worker threads render events with their own 'mysql-eventslog_format', that can differ from the
+ *  format of the events log while a new value is being loaded: the format is stored with the event.
+ */
+struct MySQL_Events_Buffer_Hdr {
+	uint32_t len; // length of the rendered event that follows the header
+	int32_t format; // events log format the event was rendered in
+};
+
+/**
+ * @brief Single producer, single consumer ring buffer of rendered events.
+ * @details The producer is the worker thread owning the buffer. The consumer is whoever holds the
+ *  logger's write lock: normally the events writer thread. Every event is stored as a
+ *  MySQL_Events_Buffer_Hdr followed by the bytes to write in the events log, and it is either stored
+ *  completely or not at all.
+ */
+class MySQL_Events_Buffer {
+	public:
+	char *data;
+	uint64_t size;
+	std::atomic<uint64_t> head; // bytes ever written, updated only by the producer
+	std::atomic<uint64_t> tail; // bytes ever consumed, updated only by the consumer
+	std::atomic<bool> orphan; // the producer thread exited, the buffer can be freed once drained
+	MySQL_Events_Strbuf strbuf;
+	std::ostream os;
+	MySQL_Events_Buffer(uint64_t _size) : size(_size), head(0), tail(0), orphan(false), os(&strbuf) {
+		data = (char *)malloc(size);
+	}
+	~MySQL_Events_Buffer() {
+		free(data);
+	}
+	/**
+	 * @brief Appends 'len' bytes to the buffer.
+	 * @param block If true, waits until there is enough space, otherwise the event is discarded.
+	 * @return False if the event was discarded.
+	 */
+	bool push(const char *p, uint64_t len, bool block) {
+		if (len > size) {
+			return false;
+		}
+		uint64_t h = head.load(std::memory_order_relaxed);
+		while (size - (h - tail.load(std::memory_order_acquire)) < len) {
+			if (block == false) {
+				return false;
+			}
+			usleep(MYSQL_LOGGER_BUFFER_FULL_US);
+		}
+		uint64_t offset = h % size;
+		uint64_t first = (len < size - offset ? len : size - offset);
+		memcpy(data + offset, p, first);
+		if (len > first) {
+			memcpy(data, p + first, len - first);
+		}
+		head.store(h + len, std::memory_order_release);
+		return true;
+	}
+	/**
+	 * @brief Moves all the events in the buffer into 'out'.
+	 * @return The number of bytes consumed.
+	 */
+	uint64_t drain(std::string& out) {
+		uint64_t t = tail.load(std::memory_order_relaxed);
+		uint64_t h = head.load(std::memory_order_acquire);
+		uint64_t len = h - t;
+		if (len == 0) {
+			return 0;
+		}
+		uint64_t offset = t % size;
+		uint64_t first = (len < size - offset ? len : size - offset);
+		out.append(data + offset, first);
+		if (len > first) {
+			out.append(data, len - first);
+		}
+		tail.store(h, std::memory_order_release);
+		return len;
+	}
+};
+
+/**
+ * @brief Block of events of the events log format 3.
+ * @details Format 3 groups format 1 records into blocks, optionally compressed with zlib. Every block
+ *  is written as:
+ *  - header, 6 x uint32_t : MYSQL_LOGGER_BLOCK_MAGIC, payload length, raw length, footer length,
+ *    number of events, flags (MYSQL_LOGGER_BLOCK_ZLIB)
+ *  - payload : the format 1 records of the block, compressed if MYSQL_LOGGER_BLOCK_ZLIB is set
+ *  - footer (index) : min and max start time as uint64_t, the number of digests as uint32_t followed by
+ *    the sorted digests as uint64_t, the number of users as uint32_t followed by every username as
+ *    uint32_t length and bytes
+ *  Readers can skip the payload of blocks whose index doesn't match, see tools/eventslog_block_reader.cpp .
+ *  Events are passed to the block prefixed with their index fields (see MySQL_Event::write_query_format_3()),
+ *  that are removed before the record is appended.
+ */
+class MySQL_Events_Block {
+	public:
+	std::string raw;
+	std::vector<uint64_t> digests;
+	std::set<std::string> users;
+	uint64_t min_start_time;
+	uint64_t max_start_time;
+	uint32_t n_events;
+	unsigned long long first_event; // monotonic time when the first event was appended
+	MySQL_Events_Strbuf scratch; // used to render events when the events log is not asynchronous
+	std::ostream scratch_os;
+	MySQL_Events_Block() : scratch_os(&scratch) {
+		reset();
+	}
+	void reset() {
+		raw.clear();
+		digests.clear();
+		users.clear();
+		min_start_time = UINT64_MAX;
+		max_start_time = 0;
+		n_events = 0;
+		first_event = 0;
+	}
+};
+
+static __thread MySQL_Events_Buffer *events_thr_buffer = NULL;
+static pthread_key_t events_buffer_key;
+static pthread_once_t events_buffer_key_once = PTHREAD_ONCE_INIT;
+
+static void events_buffer_thread_exit(void *arg) {
+	MySQL_Events_Buffer *buf = (MySQL_Events_Buffer *)arg;
+	events_thr_buffer = NULL;
+	buf->orphan = true;
+}
+
+static void events_buffer_key_init() {
+	pthread_key_create(&events_buffer_key, events_buffer_thread_exit);
+}
+
+static void * events_writer_thread(void *arg) {
+	set_thread_name("MyEventsLog");
+	MySQL_Logger *logger = (MySQL_Logger *)arg;
+	logger->events_writer_loop();
+	return NULL;
+}
+
 static uint8_t mysql_encode_length(uint64_t len, unsigned char *hd) {
 	if (len < 251) return 1;
 	if (len < 65536) { if (hd) { *hd=0xfc; }; return 3; }
@@ -62,6 +229,15 @@ MySQL_Event::MySQL_Event (log_event_type _et, uint32_t _thread_id, char * _usern
 	rows_sent=0;
 	client_stmt_id=0;
 	gtid = NULL;
+	format=mysql_thread___eventslog_format;
+}
+
+void MySQL_Event::set_format(int _format) {
+	format=_format;
+}
+
+int MySQL_Event::get_format() {
+	return format;
 }
 
 void MySQL_Event::set_client_stmt_id(uint32_t client_stmt_id) {
@@ -105,14 +281,16 @@ void MySQL_Event::set_server(int _hid, const char *ptr, int len) {
 	hid=_hid;
 }
 
-uint64_t MySQL_Event::write(std::fstream *f, MySQL_Session *sess) {
+uint64_t MySQL_Event::write(std::ostream *f, MySQL_Session *sess) {
 	uint64_t total_bytes=0;
 	switch (et) {
 		case PROXYSQL_COM_QUERY:
 		case PROXYSQL_COM_STMT_EXECUTE:
 		case PROXYSQL_COM_STMT_PREPARE:
-			if (mysql_thread___eventslog_format==1) { // format 1 , binary
+			if (format==1) { // format 1 , binary
 				total_bytes=write_query_format_1(f);
+			} else if (format==3) { // format 3 , indexed blocks of format 1
+				total_bytes=write_query_format_3(f);
 			} else { // format 2 , json
 				total_bytes=write_query_format_2_json(f);
 			}
@@ -138,7 +316,7 @@ uint64_t MySQL_Event::write(std::fstream *f, MySQL_Session *sess) {
 	return total_bytes;
 }
 
-void MySQL_Event::write_auth(std::fstream *f, MySQL_Session *sess) {
+void MySQL_Event::write_auth(std::ostream *f, MySQL_Session *sess) {
 	json j = {};
 	j["timestamp"] = start_time/1000;
 	{
@@ -259,7 +437,7 @@ void MySQL_Event::write_auth(std::fstream *f, MySQL_Session *sess) {
 	*f << j.dump(-1, ' ', false, json::error_handler_t::replace) << std::endl;
 }
 
-uint64_t MySQL_Event::write_query_format_1(std::fstream *f) {
+uint64_t MySQL_Event::write_query_format_1(std::ostream *f) {
 	uint64_t total_bytes=0;
 	total_bytes+=1; // et
 	total_bytes+=mysql_encode_length(thread_id, NULL);
@@ -277,7 +455,9 @@ uint64_t MySQL_Event::write_query_format_1(std::fstream *f) {
 
 	total_bytes+=mysql_encode_length(start_time,NULL);
 	total_bytes+=mysql_encode_length(end_time,NULL);
-	total_bytes+=mysql_encode_length(client_stmt_id,NULL);
+	if (et == PROXYSQL_COM_STMT_PREPARE || et == PROXYSQL_COM_STMT_EXECUTE) {
+		total_bytes+=mysql_encode_length(client_stmt_id,NULL);
+	}
 	total_bytes+=mysql_encode_length(affected_rows,NULL);
 	total_bytes+=mysql_encode_length(last_insert_id,NULL); // as in MySQL Protocol, last_insert_id is immediately after affected_rows
 	total_bytes+=mysql_encode_length(rows_sent,NULL);
@@ -368,7 +548,21 @@ uint64_t MySQL_Event::write_query_format_1(std::fstream *f) {
 	return total_bytes;
 }
 
-uint64_t MySQL_Event::write_query_format_2_json(std::fstream *f) {
+/**
+ * @brief Writes the index fields of the event (start time, digest and username) followed by its format 1 record.
+ * @details The index fields are consumed by MySQL_Logger::events_block_append_unlocked(), and they are
+ *  not part of the events log.
+ */
+uint64_t MySQL_Event::write_query_format_3(std::ostream *f) {
+	uint32_t ul=strlen(username);
+	f->write((const char *)&start_time,sizeof(uint64_t));
+	f->write((const char *)&query_digest,sizeof(uint64_t));
+	f->write((const char *)&ul,sizeof(uint32_t));
+	f->write(username,ul);
+	return write_query_format_1(f);
+}
+
+uint64_t MySQL_Event::write_query_format_2_json(std::ostream *f) {
 	json j = {};
 	uint64_t total_bytes=0;
 	if (hid!=UINT64_MAX) {
@@ -484,12 +678,26 @@ MySQL_Logger::MySQL_Logger() {
 	events.logfile=NULL;
 	events.log_file_id=0;
 	events.max_log_file_size=100*1024*1024;
+	events.format=1;
+	events.block=new MySQL_Events_Block();
 	audit.logfile=NULL;
 	audit.log_file_id=0;
 	audit.max_log_file_size=100*1024*1024;
+	pthread_mutex_init(&async.mutex,NULL);
+	async.writer_started=false;
+	async.shutdown=false;
+	async.dropped=0;
 };
 
 MySQL_Logger::~MySQL_Logger() {
+	if (async.writer_started) {
+		async.shutdown=true;
+		pthread_join(async.writer, NULL);
+	}
+	for (MySQL_Events_Buffer *buf : async.buffers) {
+		delete buf;
+	}
+	delete events.block;
 	if (events.datadir) {
 		free(events.datadir);
 	}
@@ -527,6 +735,15 @@ void MySQL_Logger::flush_log() {
 
 void MySQL_Logger::events_close_log_unlocked() {
 	if (events.logfile) {
+		// events already buffered belong to the current file
+		std::string data;
+		pthread_mutex_lock(&async.mutex);
+		for (MySQL_Events_Buffer *buf : async.buffers) {
+			buf->drain(data);
+		}
+		pthread_mutex_unlock(&async.mutex);
+		events_write_buffered_unlocked(data, false);
+		events_block_write_unlocked(true);
 		events.logfile->flush();
 		events.logfile->close();
 		delete events.logfile;
@@ -617,6 +834,7 @@ void MySQL_Logger::events_set_base_filename() {
 	// if filename is the same, return
 	wrlock();
 	events.max_log_file_size=mysql_thread___eventslog_filesize;
+	events.format=mysql_thread___eventslog_format;
 	if (strcmp(events.base_filename,mysql_thread___eventslog_filename)==0) {
 		wrunlock();
 		return;
@@ -787,6 +1005,9 @@ void MySQL_Logger::log_request(MySQL_Session *sess, MySQL_Data_Stream *myds) {
 		me.set_server(hid,sa,sl);
 	}
 
+	if (mysql_thread___eventslog_buffer_size) {
+		events_write_async(me, sess);
+	} else {
 	// for performance reason, we are moving the write lock
 	// right before the write to disk
 	//wrlock();
@@ -794,7 +1015,18 @@ void MySQL_Logger::log_request(MySQL_Session *sess, MySQL_Data_Stream *myds) {
 	//add a mutex lock in a multithreaded environment, avoid to get a null pointer of events.logfile that leads to the program coredump
         GloMyLogger->wrlock();
 
-	me.write(events.logfile, sess);
+	// render the event in the format of the events log, that can differ from the one of the thread
+	// while a new 'mysql-eventslog_format' is being loaded
+	me.set_format(events.format);
+	if (events.format==3) {
+		events.block->scratch.data.clear();
+		me.write(&events.block->scratch_os, sess);
+		if (events.logfile) {
+			events_block_append_unlocked(events.block->scratch.data.data(), events.block->scratch.data.size());
+		}
+	} else {
+		me.write(events.logfile, sess);
+	}
 
 
 	unsigned long curpos=events.logfile->tellp();
@@ -802,6 +1034,7 @@ void MySQL_Logger::log_request(MySQL_Session *sess, MySQL_Data_Stream *myds) {
 		events_flush_log_unlocked();
 	}
 	wrunlock();
+	}
 
 	if (cl && sess->client_myds->addr.port) {
 		free(ca);
@@ -960,8 +1193,14 @@ void MySQL_Logger::log_audit_entry(log_event_type _et, MySQL_Session *sess, MySQ
 }
 
 void MySQL_Logger::flush() {
+	bool events_async = mysql_thread___eventslog_buffer_size != 0;
+	if (audit.enabled==false && (events.enabled==false || events_async)) {
+		// nothing to flush, or the events log is flushed by the writer thread
+		return;
+	}
 	wrlock();
-	if (events.logfile) {
+	if (events.logfile && events_async==false) {
+		events_block_write_unlocked(false);
 		events.logfile->flush();
 	}
 	if (audit.logfile) {
@@ -970,6 +1209,251 @@ void MySQL_Logger::flush() {
 	wrunlock();
 }
 
+/**
+ * @brief Returns the events buffer of the calling thread, creating it if needed.
+ * @details The buffer is created with the size of 'mysql-eventslog_buffer_size' at the time of its
+ *  creation, and it is registered in 'async.buffers'. The writer thread is started with the first buffer.
+ */
+MySQL_Events_Buffer * MySQL_Logger::events_get_thread_buffer() {
+	if (events_thr_buffer) {
+		return events_thr_buffer;
+	}
+	pthread_once(&events_buffer_key_once, events_buffer_key_init);
+	MySQL_Events_Buffer *buf = new MySQL_Events_Buffer(mysql_thread___eventslog_buffer_size);
+	if (buf->data == NULL) {
+		// LCOV_EXCL_START
+		proxy_error("Unable to allocate %d bytes for the events log buffer\n", mysql_thread___eventslog_buffer_size);
+		delete buf;
+		return NULL;
+		// LCOV_EXCL_STOP
+	}
+	pthread_mutex_lock(&async.mutex);
+	async.buffers.push_back(buf);
+	if (async.writer_started == false) {
+		if (pthread_create(&async.writer, NULL, events_writer_thread, this) == 0) {
+			async.writer_started = true;
+		} else {
+			// LCOV_EXCL_START
+			proxy_error("Thread creation for the events log writer failed\n");
+			assert(0);
+			// LCOV_EXCL_STOP
+		}
+	}
+	pthread_mutex_unlock(&async.mutex);
+	pthread_setspecific(events_buffer_key, buf);
+	events_thr_buffer = buf;
+	return buf;
+}
+
+/**
+ * @brief Renders the event in the buffer of the calling thread, without taking any lock.
+ * @details If the buffer is full the event is discarded and counted, unless
+ *  'mysql-eventslog_buffer_full_policy' is 1: in that case the thread waits for the writer thread.
+ */
+void MySQL_Logger::events_write_async(MySQL_Event& me, MySQL_Session *sess) {
+	MySQL_Events_Buffer *buf = events_get_thread_buffer();
+	if (buf == NULL) {
+		async.dropped++;
+		return;
+	}
+	MySQL_Events_Buffer_Hdr hdr;
+	buf->strbuf.data.assign(sizeof(hdr), '\0'); // room for the header, filled once the event is rendered
+	me.write(&buf->os, sess);
+	hdr.len = buf->strbuf.data.size() - sizeof(hdr);
+	hdr.format = me.get_format();
+	memcpy(&buf->strbuf.data[0], &hdr, sizeof(hdr));
+	bool block = mysql_thread___eventslog_buffer_full_policy == 1;
+	if (buf->push(buf->strbuf.data.data(), buf->strbuf.data.size(), block) == false) {
+		async.dropped++;
+	}
+}
+
+/**
+ * @brief Writes the content of all the events buffers into the events log, rotating it if needed.
+ * @details Buffers of exited threads are freed once empty.
+ * @return The number of bytes drained.
+ */
+size_t MySQL_Logger::events_drain_buffers() {
+	size_t total = 0;
+	std::vector<MySQL_Events_Buffer *> bufs;
+	pthread_mutex_lock(&async.mutex);
+	bufs = async.buffers;
+	pthread_mutex_unlock(&async.mutex);
+	std::string data;
+	wrlock();
+	for (MySQL_Events_Buffer *buf : bufs) {
+		data.clear();
+		total += buf->drain(data);
+		events_write_buffered_unlocked(data, true);
+	}
+	if (events.logfile) {
+		events_block_write_unlocked(false);
+		if (total) {
+			events.logfile->flush();
+		}
+	}
+	wrunlock();
+	pthread_mutex_lock(&async.mutex);
+	for (auto it = async.buffers.begin(); it != async.buffers.end(); ) {
+		MySQL_Events_Buffer *buf = *it;
+		if (buf->orphan && buf->head == buf->tail) {
+			delete buf;
+			it = async.buffers.erase(it);
+		} else {
+			it++;
+		}
+	}
+	pthread_mutex_unlock(&async.mutex);
+	return total;
+}
+
+/**
+ * @brief Writes events rendered by worker threads into the events log, or discards them if it isn't open.
+ * @param rotate If true, the events log is rotated if it exceeds 'max_log_file_size'.
+ */
+void MySQL_Logger::events_write_unlocked(const char *data, size_t len, bool rotate) {
+	if (events.logfile == NULL || len == 0) {
+		return;
+	}
+	if (events.format == 3) {
+		events_block_append_unlocked(data, len);
+	} else {
+		events.logfile->write(data, len);
+	}
+	if (rotate) {
+		unsigned long curpos=events.logfile->tellp();
+		if (curpos > events.max_log_file_size) {
+			events_flush_log_unlocked();
+		}
+	}
+}
+
+/**
+ * @brief Writes the events drained from MySQL_Events_Buffer, see MySQL_Events_Buffer_Hdr.
+ * @details Events rendered in a format other than the one of the events log are discarded and counted.
+ * @param rotate If true, the events log is rotated if it exceeds 'max_log_file_size'.
+ */
+void MySQL_Logger::events_write_buffered_unlocked(const std::string& data, bool rotate) {
+	MySQL_Events_Buffer_Hdr hdr;
+	for (size_t pos = 0; pos + sizeof(hdr) <= data.size(); pos += sizeof(hdr) + hdr.len) {
+		memcpy(&hdr, data.data() + pos, sizeof(hdr));
+		if (hdr.format != events.format) {
+			// rendered before the events log switched to the new format
+			async.dropped++;
+			continue;
+		}
+		events_write_unlocked(data.data() + pos + sizeof(hdr), hdr.len, rotate);
+	}
+}
+
+/**
+ * @brief Appends events written by MySQL_Event::write_query_format_3() to the current block.
+ * @details The block is written once it reaches MYSQL_LOGGER_BLOCK_SIZE bytes.
+ */
+void MySQL_Logger::events_block_append_unlocked(const char *data, size_t len) {
+	MySQL_Events_Block *b = events.block;
+	size_t off = 0;
+	while (off + sizeof(uint64_t)*2 + sizeof(uint32_t) <= len) {
+		uint64_t start_time;
+		uint64_t digest;
+		uint32_t ul;
+		memcpy(&start_time, data + off, sizeof(uint64_t));
+		memcpy(&digest, data + off + sizeof(uint64_t), sizeof(uint64_t));
+		memcpy(&ul, data + off + sizeof(uint64_t)*2, sizeof(uint32_t));
+		off += sizeof(uint64_t)*2 + sizeof(uint32_t);
+		if (off + ul + sizeof(uint64_t) > len) {
+			// LCOV_EXCL_START
+			proxy_error("Invalid event in events log buffer, discarding %lu bytes\n", len - off);
+			return;
+			// LCOV_EXCL_STOP
+		}
+		std::string username(data + off, ul);
+		off += ul;
+		uint64_t rec_len;
+		memcpy(&rec_len, data + off, sizeof(uint64_t));
+		rec_len += sizeof(uint64_t);
+		if (off + rec_len > len) {
+			// LCOV_EXCL_START
+			proxy_error("Invalid event in events log buffer, discarding %lu bytes\n", len - off);
+			return;
+			// LCOV_EXCL_STOP
+		}
+		if (b->n_events == 0) {
+			b->first_event = monotonic_time();
+		}
+		b->raw.append(data + off, rec_len);
+		off += rec_len;
+		b->n_events++;
+		b->digests.push_back(digest);
+		b->users.insert(username);
+		if (start_time < b->min_start_time) b->min_start_time = start_time;
+		if (start_time > b->max_start_time) b->max_start_time = start_time;
+		if (b->raw.size() >= MYSQL_LOGGER_BLOCK_SIZE) {
+			events_block_write_unlocked(true);
+		}
+	}
+}
+
+/**
+ * @brief Writes the current block into the events log.
+ * @param force If false, the block is written only if its first event is older than MYSQL_LOGGER_BLOCK_MAX_AGE_US.
+ */
+void MySQL_Logger::events_block_write_unlocked(bool force) {
+	MySQL_Events_Block *b = events.block;
+	if (b->n_events == 0 || events.logfile == NULL) {
+		return;
+	}
+	if (force == false && monotonic_time() - b->first_event < MYSQL_LOGGER_BLOCK_MAX_AGE_US) {
+		return;
+	}
+	// footer
+	std::string footer;
+	std::sort(b->digests.begin(), b->digests.end());
+	b->digests.erase(std::unique(b->digests.begin(), b->digests.end()), b->digests.end());
+	uint32_t n = b->digests.size();
+	footer.append((const char *)&b->min_start_time, sizeof(uint64_t));
+	footer.append((const char *)&b->max_start_time, sizeof(uint64_t));
+	footer.append((const char *)&n, sizeof(uint32_t));
+	footer.append((const char *)b->digests.data(), n * sizeof(uint64_t));
+	n = b->users.size();
+	footer.append((const char *)&n, sizeof(uint32_t));
+	for (const std::string& u : b->users) {
+		uint32_t ul = u.size();
+		footer.append((const char *)&ul, sizeof(uint32_t));
+		footer.append(u);
+	}
+	// payload
+	uLongf comp_len = compressBound(b->raw.size());
+	unsigned char *comp = (unsigned char *)malloc(comp_len);
+	uint32_t flags = 0;
+	const char *payload = b->raw.data();
+	uLongf payload_len = b->raw.size();
+	if (comp && compress(comp, &comp_len, (const unsigned char *)b->raw.data(), b->raw.size()) == Z_OK && comp_len < b->raw.size()) {
+		flags |= MYSQL_LOGGER_BLOCK_ZLIB;
+		payload = (const char *)comp;
+		payload_len = comp_len;
+	}
+	uint32_t hdr[6] = { MYSQL_LOGGER_BLOCK_MAGIC, (uint32_t)payload_len, (uint32_t)b->raw.size(), (uint32_t)footer.size(), b->n_events, flags };
+	events.logfile->write((const char *)hdr, sizeof(hdr));
+	events.logfile->write(payload, payload_len);
+	events.logfile->write(footer.data(), footer.size());
+	free(comp);
+	b->reset();
+}
+
+void MySQL_Logger::events_writer_loop() {
+	while (async.shutdown == false) {
+		if (events_drain_buffers() == 0) {
+			usleep(MYSQL_LOGGER_WRITER_IDLE_US);
+		}
+	}
+	events_drain_buffers();
+}
+
+unsigned long long MySQL_Logger::get_events_dropped() {
+	return async.dropped;
+}
+
 unsigned int MySQL_Logger::events_find_next_id() {
 	int maxidx=0;
 	DIR *dir;
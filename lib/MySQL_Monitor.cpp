@@ -715,6 +715,36 @@ void MySQL_Monitor_State_Data::init_async() {
 	}
 }
 
+void MySQL_Monitor_State_Data::init_async_connect() {
+	assert(mysql == NULL);
+
+	mysql = mysql_init(NULL);
+	assert(mysql);
+	mysql_options(mysql, MYSQL_OPT_NONBLOCK, 0);
+	if (use_ssl && port) {
+		MySQLServers_SslParams * ssl_params = MyHGM->get_Server_SSL_Params(hostname, port, mysql_thread___monitor_username);
+		MySQL_Connection::set_ssl_params(mysql,ssl_params);
+		mysql_options(mysql, MARIADB_OPT_SSL_KEYLOG_CALLBACK, (void*)proxysql_keylog_write_line_callback);
+	}
+	unsigned int timeout=mysql_thread___monitor_connect_timeout/1000;
+	if (timeout==0) timeout=1;
+	mysql_options(mysql, MYSQL_OPT_CONNECT_TIMEOUT, &timeout);
+	mysql_options4(mysql, MYSQL_OPT_CONNECT_ATTR_ADD, "program_name", "proxysql_monitor");
+	mysql_options4(mysql, MYSQL_OPT_CONNECT_ATTR_ADD, "_server_host", hostname);
+#if !defined(TEST_AURORA) && !defined(TEST_GALERA) && !defined(TEST_GROUPREP)
+	// connections returned to 'My_Conn_Pool' need the same 'wait_timeout' set by 'set_wait_timeout()'
+	if (mysql_thread___monitor_wait_timeout && task_id_ != MON_CONNECT) {
+		const string init_cmd { "SET wait_timeout=" + std::to_string(mysql_thread___monitor_ping_interval*10/1000) };
+		mysql_options(mysql, MYSQL_INIT_COMMAND, init_cmd.c_str());
+	}
+#endif // !TEST_AURORA && !TEST_GALERA && !TEST_GROUPREP
+	connect_host_ = port ? MySQL_Monitor::dns_lookup(hostname) : "localhost";
+
+	async_state_machine_ = ASYNC_CONNECT_START;
+	task_timeout_ = mysql_thread___monitor_connect_timeout;
+	task_handler_ = &MySQL_Monitor_State_Data::connect_handler;
+}
+
 void MySQL_Monitor_State_Data::mark_task_as_timeout(unsigned long long time) {
 	
 	task_result_ = MySQL_Monitor_State_Data_Task_Result::TASK_RESULT_TIMEOUT;
@@ -723,7 +753,10 @@ void MySQL_Monitor_State_Data::mark_task_as_timeout(unsigned long long time) {
 	if (mysql_error_msg)
 		free(mysql_error_msg);
 
-	if (task_id_ == MON_PING) {
+	if (is_connecting()) {
+		async_state_machine_ = ASYNC_CONNECT_TIMEOUT;
+		mysql_error_msg = strdup("timeout on creating new connection");
+	} else if (task_id_ == MON_PING) {
 		async_state_machine_ = ASYNC_PING_TIMEOUT;
 		mysql_error_msg = strdup("timeout during ping");
 	} else {
@@ -980,6 +1013,12 @@ mon_metrics_map = std::make_tuple(
 			"proxysql_mysql_monitor_dns_cache_record_updated",
 			"Number of dns queried 'dns_cache_record_updated' from 'monitor_dns_resolver_thread'.",
 			metric_tags {}
+		),
+		std::make_tuple(
+			p_mon_counter::mysql_monitor_dns_cache_record_refreshed,
+			"proxysql_mysql_monitor_dns_cache_record_refreshed",
+			"Number of dns records resolved again by 'monitor_dns_resolver_thread' before their TTL expired.",
+			metric_tags {}
 		)
 		// ====================================================================
 	},
@@ -1001,6 +1040,7 @@ mon_metrics_map = std::make_tuple(
 
 MySQL_Monitor::MySQL_Monitor() {
 	dns_cache = std::make_shared<DNS_Cache>();
+	dns_resolver_queue = std::unique_ptr<wqueue<WorkItem<DNS_Resolve_Data>*>>(new wqueue<WorkItem<DNS_Resolve_Data>*>());
 	GloMyMon = this;
 
 	My_Conn_Pool=new MySQL_Monitor_Connection_Pool();
@@ -1074,6 +1114,7 @@ MySQL_Monitor::MySQL_Monitor() {
 	dns_cache_queried = 0;
 	dns_cache_lookup_success = 0;
 	dns_cache_record_updated = 0;
+	dns_cache_record_refreshed = 0;
 	force_dns_cache_update = false;
 
 #ifdef DEBUG
@@ -1142,6 +1183,7 @@ void MySQL_Monitor::p_update_metrics() {
 		p_update_counter(this->metrics.p_counter_array[p_mon_counter::mysql_monitor_dns_cache_queried], GloMyMon->dns_cache_queried);
 		p_update_counter(this->metrics.p_counter_array[p_mon_counter::mysql_monitor_dns_cache_lookup_success], GloMyMon->dns_cache_lookup_success);
 		p_update_counter(this->metrics.p_counter_array[p_mon_counter::mysql_monitor_dns_cache_record_updated], GloMyMon->dns_cache_record_updated);
+		p_update_counter(this->metrics.p_counter_array[p_mon_counter::mysql_monitor_dns_cache_record_refreshed], GloMyMon->dns_cache_record_refreshed);
 	}
 }
 
@@ -1301,6 +1343,33 @@ void MySQL_Monitor::update_monitor_proxysql_servers(SQLite3_result* resultset) {
 	pthread_mutex_unlock(&GloMyMon->proxysql_servers_mutex);
 }
 
+/**
+ * @brief Whether a ping error counts towards 'mysql-monitor_ping_max_failures'.
+ * @details Authentication errors don't: the server is responding.
+ */
+static bool monitor_ping_error_is_failure(const char *error) {
+	if (error == NULL) {
+		return false;
+	}
+	if (
+		(strncmp(error,"Access denied for user",strlen("Access denied for user"))==0)
+		||
+		(strncmp(error,"ProxySQL Error: Access denied for user",strlen("ProxySQL Error: Access denied for user"))==0)
+		||
+		(strncmp(error,"Your password has expired.",strlen("Your password has expired."))==0)
+	) {
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Whether a read_only check counts towards 'mysql-monitor_read_only_max_timeout_count'.
+ */
+static bool monitor_read_only_error_is_timeout(bool has_value, const char *error) {
+	return (has_value == false && error && strncmp(error,"timeout",7)==0);
+}
+
 void * monitor_connect_thread(void *arg) {
 	mysql_close(mysql_init(NULL));
 	MySQL_Monitor_State_Data *mmsd=(MySQL_Monitor_State_Data *)arg;
@@ -1316,25 +1385,12 @@ void * monitor_connect_thread(void *arg) {
 	mmsd->t1=start_time;
 	mmsd->t2=monotonic_time();
 
-	sqlite3_stmt *statement=NULL;
-	//sqlite3 *mondb=mmsd->mondb->get_db();
-	int rc;
-	char *query=NULL;
-	query=(char *)"INSERT OR REPLACE INTO mysql_server_connect_log VALUES (?1 , ?2 , ?3 , ?4 , ?5)";
-	//rc=(*proxy_sqlite3_prepare_v2)(mondb, query, -1, &statement, 0);
-	rc = mmsd->mondb->prepare_v2(query, &statement);
-	ASSERT_SQLITE_OK(rc, mmsd->mondb);
-	rc=(*proxy_sqlite3_bind_text)(statement, 1, mmsd->hostname, -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-	rc=(*proxy_sqlite3_bind_int)(statement, 2, mmsd->port); ASSERT_SQLITE_OK(rc, mmsd->mondb);
 	unsigned long long time_now=realtime_time();
 	time_now=time_now-(mmsd->t2 - start_time);
-	rc=(*proxy_sqlite3_bind_int64)(statement, 3, time_now); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-	rc=(*proxy_sqlite3_bind_int64)(statement, 4, (mmsd->mysql_error_msg ? 0 : mmsd->t2-mmsd->t1)); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-	rc=(*proxy_sqlite3_bind_text)(statement, 5, mmsd->mysql_error_msg, -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-	SAFE_SQLITE3_STEP2(statement);
-	rc=(*proxy_sqlite3_clear_bindings)(statement); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-	rc=(*proxy_sqlite3_reset)(statement); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-	(*proxy_sqlite3_finalize)(statement);
+	GloMyMon->connect_log.add_entry(
+		mmsd->hostname, mmsd->port, time_now, (mmsd->mysql_error_msg ? 0 : mmsd->t2-mmsd->t1), false, 0,
+		mmsd->mysql_error_msg, (mmsd->mysql_error_msg != NULL)
+	);
 	if (mmsd->mysql_error_msg) {
 		if (
 			(strncmp(mmsd->mysql_error_msg,"Access denied for user",strlen("Access denied for user"))==0)
@@ -1427,28 +1483,15 @@ void * monitor_ping_thread(void *arg) {
 __exit_monitor_ping_thread:
 	mmsd->t2=monotonic_time();
 	{
-		sqlite3_stmt *statement=NULL;
-		//sqlite3 *mondb=mmsd->mondb->get_db();
-		int rc;
 #ifdef TEST_AURORA
 //		if ((rand() % 10) ==0) {
 #endif // TEST_AURORA
-		char *query=NULL;
-		query=(char *)"INSERT OR REPLACE INTO mysql_server_ping_log VALUES (?1 , ?2 , ?3 , ?4 , ?5)";
-		//rc=(*proxy_sqlite3_prepare_v2)(mondb, query, -1, &statement, 0);
-		rc = mmsd->mondb->prepare_v2(query, &statement);
-		ASSERT_SQLITE_OK(rc, mmsd->mondb);
-		rc=(*proxy_sqlite3_bind_text)(statement, 1, mmsd->hostname, -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-		rc=(*proxy_sqlite3_bind_int)(statement, 2, mmsd->port); ASSERT_SQLITE_OK(rc, mmsd->mondb);
 		unsigned long long time_now=realtime_time();
 		time_now=time_now-(mmsd->t2 - start_time);
-		rc=(*proxy_sqlite3_bind_int64)(statement, 3, time_now); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-		rc=(*proxy_sqlite3_bind_int64)(statement, 4, (mmsd->mysql_error_msg ? 0 : mmsd->t2-mmsd->t1)); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-		rc=(*proxy_sqlite3_bind_text)(statement, 5, mmsd->mysql_error_msg, -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-		SAFE_SQLITE3_STEP2(statement);
-		rc=(*proxy_sqlite3_clear_bindings)(statement); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-		rc=(*proxy_sqlite3_reset)(statement); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-		(*proxy_sqlite3_finalize)(statement);
+		GloMyMon->ping_log.add_entry(
+			mmsd->hostname, mmsd->port, time_now, (mmsd->mysql_error_msg ? 0 : mmsd->t2-mmsd->t1), false, 0,
+			mmsd->mysql_error_msg, monitor_ping_error_is_failure(mmsd->mysql_error_msg)
+		);
 		if (mmsd->mysql_error_msg == NULL) {
 			ping_success = true;
 		}
@@ -1724,21 +1767,10 @@ void * monitor_read_only_thread(void *arg) {
 __exit_monitor_read_only_thread:
 	mmsd->t2=monotonic_time();
 	{
-		sqlite3_stmt *statement=NULL;
-		//sqlite3 *mondb=mmsd->mondb->get_db();
-		int rc;
-		char *query=NULL;
-		query=(char *)"INSERT OR REPLACE INTO mysql_server_read_only_log VALUES (?1 , ?2 , ?3 , ?4 , ?5 , ?6)";
-		//rc=(*proxy_sqlite3_prepare_v2)(mondb, query, -1, &statement, 0);
-		rc = mmsd->mondb->prepare_v2(query, &statement);
-		ASSERT_SQLITE_OK(rc, mmsd->mondb);
 		int read_only=1; // as a safety mechanism , read_only=1 is the default
-		rc=(*proxy_sqlite3_bind_text)(statement, 1, mmsd->hostname, -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-		rc=(*proxy_sqlite3_bind_int)(statement, 2, mmsd->port); ASSERT_SQLITE_OK(rc, mmsd->mondb);
+		bool has_read_only=false;
 		unsigned long long time_now=realtime_time();
 		time_now=time_now-(mmsd->t2 - start_time);
-		rc=(*proxy_sqlite3_bind_int64)(statement, 3, time_now); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-		rc=(*proxy_sqlite3_bind_int64)(statement, 4, (mmsd->mysql_error_msg ? 0 : mmsd->t2-mmsd->t1)); ASSERT_SQLITE_OK(rc, mmsd->mondb);
 		if (mmsd->interr == 0 && mmsd->result) {
 			int num_fields=0;
 			int k=0;
@@ -1763,30 +1795,22 @@ VALGRIND_DISABLE_ERROR_REPORTING;
 VALGRIND_ENABLE_ERROR_REPORTING;
 					}
 				}
-//					if (repl_lag>=0) {
-				rc=(*proxy_sqlite3_bind_int64)(statement, 5, read_only); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-//					} else {
-//						rc=(*proxy_sqlite3_bind_null)(statement, 5); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-//					}
+				has_read_only=true;
 			} else {
 				proxy_error("mysql_fetch_fields returns NULL, or mysql_num_fields is incorrect. Server %s:%d . See bug #1994\n", mmsd->hostname, mmsd->port);
-				rc=(*proxy_sqlite3_bind_null)(statement, 5); ASSERT_SQLITE_OK(rc, mmsd->mondb);
 			}
 			mysql_free_result(mmsd->result);
 			mmsd->result=NULL;
-		} else {
-			rc=(*proxy_sqlite3_bind_null)(statement, 5); ASSERT_SQLITE_OK(rc, mmsd->mondb);
 		}
 		if (mmsd->result) {
 			// make sure it is clear
 			mysql_free_result(mmsd->result);
 			mmsd->result=NULL;
 		}
-		rc=(*proxy_sqlite3_bind_text)(statement, 6, mmsd->mysql_error_msg, -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-		SAFE_SQLITE3_STEP2(statement);
-		rc=(*proxy_sqlite3_clear_bindings)(statement); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-		rc=(*proxy_sqlite3_reset)(statement); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-		(*proxy_sqlite3_finalize)(statement);
+		GloMyMon->read_only_log.add_entry(
+			mmsd->hostname, mmsd->port, time_now, (mmsd->mysql_error_msg ? 0 : mmsd->t2-mmsd->t1), has_read_only, read_only,
+			mmsd->mysql_error_msg, monitor_read_only_error_is_timeout(has_read_only, mmsd->mysql_error_msg)
+		);
 
 		if (mmsd->mysql_error_msg == NULL) {
 			read_only_success = true;
@@ -1797,34 +1821,15 @@ VALGRIND_ENABLE_ERROR_REPORTING;
 										read_only_server_t { mmsd->hostname, mmsd->port, read_only }
 										} ); // default behavior
 		} else {
-			char *error=NULL;
-			int cols=0;
-			int affected_rows=0;
-			SQLite3_result *resultset=NULL;
-			char *new_query=NULL;
-			SQLite3DB *mondb=mmsd->mondb;
-			new_query=(char *)"SELECT 1 FROM (SELECT hostname,port,read_only,error FROM mysql_server_read_only_log WHERE hostname='%s' AND port='%d' ORDER BY time_start_us DESC LIMIT %d) a WHERE read_only IS NULL AND SUBSTR(error,1,7) = 'timeout' GROUP BY hostname,port HAVING COUNT(*)=%d";
-			char *buff=(char *)malloc(strlen(new_query)+strlen(mmsd->hostname)+32);
 			int max_failures=mysql_thread___monitor_read_only_max_timeout_count;
-			sprintf(buff,new_query, mmsd->hostname, mmsd->port, max_failures, max_failures);
-			mondb->execute_statement(buff, &error , &cols , &affected_rows , &resultset);
-			if (!error) {
-				if (resultset) {
-					if (resultset->rows_count) {
-						// disable host
-						proxy_error("Server %s:%d missed %d read_only checks. Assuming read_only=1\n", mmsd->hostname, mmsd->port, max_failures);
-						MyHGM->p_update_mysql_error_counter(p_mysql_error_type::proxysql, mmsd->hostgroup_id, mmsd->hostname, mmsd->port, ER_PROXYSQL_READ_ONLY_CHECKS_MISSED);
-						MyHGM->read_only_action_v2( std::list<read_only_server_t> {
-													read_only_server_t { mmsd->hostname, mmsd->port, read_only }
-													} ); // N timeouts reached
-					}
-					delete resultset;
-					resultset=NULL;
-				}
-			} else {
-				proxy_error("Error on %s : %s\n", buff, error);
+			if (GloMyMon->read_only_log.get_consecutive_failures(mmsd->hostname, mmsd->port) >= (unsigned int)max_failures) {
+				// disable host
+				proxy_error("Server %s:%d missed %d read_only checks. Assuming read_only=1\n", mmsd->hostname, mmsd->port, max_failures);
+				MyHGM->p_update_mysql_error_counter(p_mysql_error_type::proxysql, mmsd->hostgroup_id, mmsd->hostname, mmsd->port, ER_PROXYSQL_READ_ONLY_CHECKS_MISSED);
+				MyHGM->read_only_action_v2( std::list<read_only_server_t> {
+											read_only_server_t { mmsd->hostname, mmsd->port, read_only }
+											} ); // N timeouts reached
 			}
-			free(buff);
 		}
 	}
 	if (mmsd->interr || mmsd->mysql_error_msg) { // check failed
@@ -2765,24 +2770,11 @@ void * monitor_replication_lag_thread(void *arg) {
 __exit_monitor_replication_lag_thread:
 	mmsd->t2=monotonic_time();
 	{
-		sqlite3_stmt *statement=NULL;
-		//sqlite3 *mondb=mmsd->mondb->get_db();
-		int rc;
-		char *query=NULL;
-
-			query=(char *)"INSERT OR REPLACE INTO mysql_server_replication_lag_log VALUES (?1 , ?2 , ?3 , ?4 , ?5 , ?6)";
-			//rc=(*proxy_sqlite3_prepare_v2)(mondb, query, -1, &statement, 0);
-			rc = mmsd->mondb->prepare_v2(query, &statement);
-			ASSERT_SQLITE_OK(rc, mmsd->mondb);
 				// 'replication_lag' to be feed to 'replication_lag_action'
 				int repl_lag=-2;
 				bool override_repl_lag = true;
-				rc=(*proxy_sqlite3_bind_text)(statement, 1, mmsd->hostname, -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-				rc=(*proxy_sqlite3_bind_int)(statement, 2, mmsd->port); ASSERT_SQLITE_OK(rc, mmsd->mondb);
 				unsigned long long time_now=realtime_time();
 				time_now=time_now-(mmsd->t2 - start_time);
-				rc=(*proxy_sqlite3_bind_int64)(statement, 3, time_now); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-				rc=(*proxy_sqlite3_bind_int64)(statement, 4, (mmsd->mysql_error_msg ? 0 : mmsd->t2-mmsd->t1)); ASSERT_SQLITE_OK(rc, mmsd->mondb);
 				if (mmsd->interr == 0 && mmsd->result) {
 					int num_fields=0;
 					int k=0;
@@ -2822,30 +2814,22 @@ __exit_monitor_replication_lag_thread:
 								}
 							}
 						}
-						if (/*repl_lag >= 0 ||*/ override_repl_lag == false) {
-							rc=(*proxy_sqlite3_bind_int64)(statement, 5, repl_lag); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-						} else {
-							rc=(*proxy_sqlite3_bind_null)(statement, 5); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-						}
 					} else {
 							proxy_error("mysql_fetch_fields returns NULL, or mysql_num_fields is incorrect. Server %s:%d . See bug #1994\n", mmsd->hostname, mmsd->port);
-							rc=(*proxy_sqlite3_bind_null)(statement, 5); ASSERT_SQLITE_OK(rc, mmsd->mondb);
 					}
 					mysql_free_result(mmsd->result);
 					mmsd->result=NULL;
 				} else {
-					rc=(*proxy_sqlite3_bind_null)(statement, 5); ASSERT_SQLITE_OK(rc, mmsd->mondb);
 					// 'replication_lag_check' timed out, we set 'repl_lag' to '-3' to avoid server to be 're-enabled'.
 					repl_lag=-3;
 				}
-				rc=(*proxy_sqlite3_bind_text)(statement, 6, mmsd->mysql_error_msg, -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-				SAFE_SQLITE3_STEP2(statement);
-				rc=(*proxy_sqlite3_clear_bindings)(statement); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-				rc=(*proxy_sqlite3_reset)(statement); ASSERT_SQLITE_OK(rc, mmsd->mondb);
+				GloMyMon->replication_lag_log.add_entry(
+					mmsd->hostname, mmsd->port, time_now, (mmsd->mysql_error_msg ? 0 : mmsd->t2-mmsd->t1),
+					(override_repl_lag == false), repl_lag, mmsd->mysql_error_msg, (mmsd->mysql_error_msg != NULL)
+				);
 				MyHGM->replication_lag_action( std::list<replication_lag_server_t> {
 												replication_lag_server_t {mmsd->hostgroup_id, mmsd->hostname, mmsd->port, repl_lag, override_repl_lag }
 												} );
-			(*proxy_sqlite3_finalize)(statement);
 			if (mmsd->mysql_error_msg == NULL) {
 				replication_lag_success = true;
 			}
@@ -2975,56 +2959,19 @@ void * MySQL_Monitor::monitor_connect() {
 			if (resultset->rows_count==0) {
 				goto __end_monitor_connect_loop;
 			}
-			int us=100;
-			if (resultset->rows_count) {
-				us=mysql_thread___monitor_connect_interval/2/resultset->rows_count;
-				us*=40;
-				if (us > 1000000 || us <= 0) {
-					us = 10000;
-				}
-				us = us + rand()%us;
-				if (resultset->rows_count==1) {
-					// only 1 server, sleep also before creating the job
-					usleep(us);
-				}
-			}
-			for (std::vector<SQLite3_row *>::iterator it = resultset->rows.begin() ; it != resultset->rows.end(); ++it) {
-				SQLite3_row *r=*it;
-				bool rc_ping = true;
-				rc_ping = server_responds_to_ping(r->fields[0],atoi(r->fields[1]));
-				if (rc_ping) { // only if server is responding to pings
-					MySQL_Monitor_State_Data *mmsd=new MySQL_Monitor_State_Data(MON_CONNECT, r->fields[0],atoi(r->fields[1]), atoi(r->fields[2]));
-					mmsd->mondb=monitordb;
-					WorkItem<MySQL_Monitor_State_Data>* item;
-					item=new WorkItem<MySQL_Monitor_State_Data>(mmsd,monitor_connect_thread);
-					GloMyMon->queue->add(item);
-					usleep(us);
-				}
-				if (GloMyMon->shutdown) return NULL;
-			}
+			monitor_connect_async(resultset);
+			if (GloMyMon->shutdown) return NULL;
 		}
 
 
 __end_monitor_connect_loop:
 		if (mysql_thread___monitor_enabled==true) {
-			sqlite3_stmt *statement=NULL;
-			//sqlite3 *mondb=monitordb->get_db();
-			int rc;
-			char *query=NULL;
-			query=(char *)"DELETE FROM mysql_server_connect_log WHERE time_start_us < ?1";
-			//rc=(*proxy_sqlite3_prepare_v2)(mondb, query, -1, &statement, 0);
-			rc = monitordb->prepare_v2(query, &statement);
-			ASSERT_SQLITE_OK(rc, monitordb);
 			if (mysql_thread___monitor_history < mysql_thread___monitor_ping_interval * (mysql_thread___monitor_ping_max_failures + 1 )) { // issue #626
 				if (mysql_thread___monitor_ping_interval < 3600000)
 					mysql_thread___monitor_history = mysql_thread___monitor_ping_interval * (mysql_thread___monitor_ping_max_failures + 1 );
 			}
 			unsigned long long time_now=realtime_time();
-			rc=(*proxy_sqlite3_bind_int64)(statement, 1, time_now-(unsigned long long)mysql_thread___monitor_history*1000); ASSERT_SQLITE_OK(rc, monitordb);
-			SAFE_SQLITE3_STEP2(statement);
-			rc=(*proxy_sqlite3_clear_bindings)(statement); ASSERT_SQLITE_OK(rc, monitordb);
-			rc=(*proxy_sqlite3_reset)(statement); ASSERT_SQLITE_OK(rc, monitordb);
-			(*proxy_sqlite3_finalize)(statement);
+			connect_log.purge(time_now-(unsigned long long)mysql_thread___monitor_history*1000);
 		}
 		if (resultset)
 			delete resultset;
@@ -3111,147 +3058,39 @@ void * MySQL_Monitor::monitor_ping() {
 
 __end_monitor_ping_loop:
 		if (mysql_thread___monitor_enabled==true) {
-			sqlite3_stmt *statement=NULL;
-			//sqlite3 *mondb=monitordb->get_db();
-			int rc;
-			char *query=NULL;
-			query=(char *)"DELETE FROM mysql_server_ping_log WHERE time_start_us < ?1";
-			//rc=(*proxy_sqlite3_prepare_v2)(mondb, query, -1, &statement, 0);
-			rc = monitordb->prepare_v2(query, &statement);
-			ASSERT_SQLITE_OK(rc, monitordb);
 			if (mysql_thread___monitor_history < mysql_thread___monitor_ping_interval * (mysql_thread___monitor_ping_max_failures + 1 )) { // issue #626
 				if (mysql_thread___monitor_ping_interval < 3600000)
 					mysql_thread___monitor_history = mysql_thread___monitor_ping_interval * (mysql_thread___monitor_ping_max_failures + 1 );
 			}
 			unsigned long long time_now=realtime_time();
-			rc=(*proxy_sqlite3_bind_int64)(statement, 1, time_now-(unsigned long long)mysql_thread___monitor_history*1000); ASSERT_SQLITE_OK(rc, monitordb);
-			SAFE_SQLITE3_STEP2(statement);
-			rc=(*proxy_sqlite3_clear_bindings)(statement); ASSERT_SQLITE_OK(rc, monitordb);
-			rc=(*proxy_sqlite3_reset)(statement); ASSERT_SQLITE_OK(rc, monitordb);
-			(*proxy_sqlite3_finalize)(statement);
+			ping_log.purge(time_now-(unsigned long long)mysql_thread___monitor_history*1000);
+			// servers not checked for two of their longest intervals are not monitored anymore
+			ping_schedule.purge(monotonic_time(), 2000ULL * mysql_thread___monitor_ping_interval * mysql_thread___monitor_adaptive_interval_max_factor);
 		}
 
 		if (resultset) {
-			delete resultset;
-			resultset=NULL;
-		}
-
-		// now it is time to shun all problematic hosts
-		query=(char *)"SELECT DISTINCT a.hostname, a.port FROM monitor_internal.mysql_servers a JOIN monitor.mysql_server_ping_log b ON a.hostname=b.hostname WHERE b.ping_error IS NOT NULL AND b.ping_error NOT LIKE 'Access denied for user\%'";
-		proxy_debug(PROXY_DEBUG_ADMIN, 4, "%s\n", query);
-// we disable valgrind here. Probably a bug in SQLite3
-VALGRIND_DISABLE_ERROR_REPORTING;
-		admindb->execute_statement(query, &error , &cols , &affected_rows , &resultset);
-VALGRIND_ENABLE_ERROR_REPORTING;
-		if (error) {
-			proxy_error("Error on %s : %s\n", query, error);
-		} else {
-			// get all addresses and ports
-			int i=0;
-			int j=0;
-			char **addresses=(char **)malloc(resultset->rows_count * sizeof(char *));
-			char **ports=(char **)malloc(resultset->rows_count * sizeof(char *));
+			// now it is time to shun all problematic hosts, and to update current_lantency_ms
+			int max_failures=mysql_thread___monitor_ping_max_failures;
 			for (std::vector<SQLite3_row *>::iterator it = resultset->rows.begin() ; it != resultset->rows.end(); ++it) {
 				SQLite3_row *r=*it;
-				addresses[i]=strdup(r->fields[0]);
-				ports[i]=strdup(r->fields[1]);
-				i++;
-			}
-			if (resultset) {
-				delete resultset;
-				resultset=NULL;
-			}
-			char *new_query=NULL;
-			new_query=(char *)"SELECT 1 FROM (SELECT hostname,port,ping_error FROM mysql_server_ping_log WHERE hostname='%s' AND port='%s' ORDER BY time_start_us DESC LIMIT %d) a WHERE ping_error IS NOT NULL AND ping_error NOT LIKE 'Access denied for user%%' AND ping_error NOT LIKE 'ProxySQL Error: Access denied for user%%' AND ping_error NOT LIKE 'Your password has expired.%%' GROUP BY hostname,port HAVING COUNT(*)=%d";
-			for (j=0;j<i;j++) {
-				char *buff=(char *)malloc(strlen(new_query)+strlen(addresses[j])+strlen(ports[j])+16);
-				int max_failures=mysql_thread___monitor_ping_max_failures;
-				sprintf(buff,new_query,addresses[j],ports[j],max_failures,max_failures);
-				monitordb->execute_statement(buff, &error , &cols , &affected_rows , &resultset);
-				if (!error) {
-					if (resultset) {
-						if (resultset->rows_count) {
-							// disable host
-							bool rc_shun = false;
-							rc_shun = MyHGM->shun_and_killall(addresses[j],atoi(ports[j]));
-							if (rc_shun) {
-								proxy_error("Server %s:%s missed %d heartbeats, shunning it and killing all the connections. Disabling other checks until the node comes back online.\n", addresses[j], ports[j], max_failures);
-							}
-						}
-						delete resultset;
-						resultset=NULL;
+				char *address=r->fields[0];
+				int port=atoi(r->fields[1]);
+				if (ping_log.get_consecutive_failures(address, port) >= (unsigned int)max_failures) {
+					// disable host
+					bool rc_shun = false;
+					rc_shun = MyHGM->shun_and_killall(address, port);
+					if (rc_shun) {
+						proxy_error("Server %s:%s missed %d heartbeats, shunning it and killing all the connections. Disabling other checks until the node comes back online.\n", address, r->fields[1], max_failures);
 					}
-				} else {
-					proxy_error("Error on %s : %s\n", query, error);
 				}
-				free(buff);
-			}
-
-			while (i) { // now free all the addresses/ports
-				i--;
-				free(addresses[i]);
-				free(ports[i]);
-			}
-			free(addresses);
-			free(ports);
-		}
-
-
-		// now it is time to update current_lantency_ms
-		query=(char *)"SELECT DISTINCT a.hostname, a.port FROM monitor_internal.mysql_servers a JOIN monitor.mysql_server_ping_log b ON a.hostname=b.hostname WHERE b.ping_error IS NULL";
-		proxy_debug(PROXY_DEBUG_ADMIN, 4, "%s\n", query);
-VALGRIND_DISABLE_ERROR_REPORTING;
-		admindb->execute_statement(query, &error , &cols , &affected_rows , &resultset);
-VALGRIND_ENABLE_ERROR_REPORTING;
-		if (error) {
-			proxy_error("Error on %s : %s\n", query, error);
-		} else {
-			// get all addresses and ports
-			int i=0;
-			int j=0;
-			char **addresses=(char **)malloc(resultset->rows_count * sizeof(char *));
-			char **ports=(char **)malloc(resultset->rows_count * sizeof(char *));
-			for (std::vector<SQLite3_row *>::iterator it = resultset->rows.begin() ; it != resultset->rows.end(); ++it) {
-				SQLite3_row *r=*it;
-				addresses[i]=strdup(r->fields[0]);
-				ports[i]=strdup(r->fields[1]);
-				i++;
-			}
-			if (resultset) {
-				delete resultset;
-				resultset=NULL;
-			}
-			char *new_query=NULL;
-
-			new_query=(char *)"SELECT hostname,port,COALESCE(CAST(AVG(ping_success_time_us) AS INTEGER),10000) FROM (SELECT hostname,port,ping_success_time_us,ping_error FROM mysql_server_ping_log WHERE hostname='%s' AND port='%s' ORDER BY time_start_us DESC LIMIT 3) a WHERE ping_error IS NULL GROUP BY hostname,port";
-			for (j=0;j<i;j++) {
-				char *buff=(char *)malloc(strlen(new_query)+strlen(addresses[j])+strlen(ports[j])+16);
-				sprintf(buff,new_query,addresses[j],ports[j]);
-				monitordb->execute_statement(buff, &error , &cols , &affected_rows , &resultset);
-				if (!error) {
-					if (resultset) {
-						if (resultset->rows_count) {
-							for (std::vector<SQLite3_row *>::iterator it = resultset->rows.begin() ; it != resultset->rows.end(); ++it) {
-								SQLite3_row *r=*it; // this should be called just once, but we create a generic for loop
-								// update current_latency_ms
-								MyHGM->set_server_current_latency_us(addresses[j],atoi(ports[j]), atoi(r->fields[2]));
-							}
-						}
-						delete resultset;
-						resultset=NULL;
-					}
-				} else {
-					proxy_error("Error on %s : %s\n", query, error);
+				long long latency_us = ping_log.get_avg_success_time(address, port, 3);
+				if (latency_us >= 0) {
+					// update current_latency_ms
+					MyHGM->set_server_current_latency_us(address, port, latency_us);
 				}
-				free(buff);
-			}
-			while (i) { // now free all the addresses/ports
-				i--;
-				free(addresses[i]);
-				free(ports[i]);
 			}
-			free(addresses);
-			free(ports);
+			delete resultset;
+			resultset=NULL;
 		}
 
 __sleep_monitor_ping_loop:
@@ -3279,36 +3118,7 @@ __sleep_monitor_ping_loop:
 
 
 bool MySQL_Monitor::server_responds_to_ping(char *address, int port) {
-	bool ret = true; // default
-	char *error=NULL;
-	int cols=0;
-	int affected_rows=0;
-	SQLite3_result *resultset=NULL;
-	char *new_query=NULL;
-	new_query=(char *)"SELECT 1 FROM (SELECT hostname,port,ping_error FROM mysql_server_ping_log WHERE hostname='%s' AND port=%d ORDER BY time_start_us DESC LIMIT %d) a WHERE ping_error IS NOT NULL AND ping_error NOT LIKE 'Access denied for user%%' GROUP BY hostname,port HAVING COUNT(*)=%d";
-	char *buff=(char *)malloc(strlen(new_query)+strlen(address)+32);
-	int max_failures = mysql_thread___monitor_ping_max_failures;
-	sprintf(buff,new_query,address,port,max_failures,max_failures);
-VALGRIND_DISABLE_ERROR_REPORTING;
-	monitordb->execute_statement(buff, &error , &cols , &affected_rows , &resultset);
-VALGRIND_ENABLE_ERROR_REPORTING;
-	if (!error) {
-		if (resultset) {
-			if (resultset->rows_count) {
-				ret = false;
-			}
-			delete resultset;
-			resultset=NULL;
-		}
-	} else {
-		proxy_error("Error on %s : %s\n", buff, error);
-	}
-	if (resultset) {
-		delete resultset;
-		resultset=NULL;
-	}
-	free(buff);
-	return ret;
+	return ping_log.get_consecutive_failures(address, port) < (unsigned int)mysql_thread___monitor_ping_max_failures;
 }
 
 /**
@@ -3467,24 +3277,14 @@ void * MySQL_Monitor::monitor_read_only() {
 
 __end_monitor_read_only_loop:
 		if (mysql_thread___monitor_enabled==true) {
-			sqlite3_stmt *statement=NULL;
-			//sqlite3 *mondb=monitordb->get_db();
-			int rc;
-			char *query=NULL;
-			query=(char *)"DELETE FROM mysql_server_read_only_log WHERE time_start_us < ?1";
-			//rc=(*proxy_sqlite3_prepare_v2)(mondb, query, -1, &statement, 0);
-			rc = monitordb->prepare_v2(query, &statement);
-			ASSERT_SQLITE_OK(rc, monitordb);
 			if (mysql_thread___monitor_history < mysql_thread___monitor_read_only_interval * (mysql_thread___monitor_read_only_max_timeout_count + 1 )) { // issue #626
 				if (mysql_thread___monitor_read_only_interval < 3600000)
 					mysql_thread___monitor_history = mysql_thread___monitor_read_only_interval * (mysql_thread___monitor_read_only_max_timeout_count + 1 );
 			}
 			unsigned long long time_now=realtime_time();
-			rc=(*proxy_sqlite3_bind_int64)(statement, 1, time_now-(unsigned long long)mysql_thread___monitor_history*1000); ASSERT_SQLITE_OK(rc, monitordb);
-			SAFE_SQLITE3_STEP2(statement);
-			rc=(*proxy_sqlite3_clear_bindings)(statement); ASSERT_SQLITE_OK(rc, monitordb);
-			rc=(*proxy_sqlite3_reset)(statement); ASSERT_SQLITE_OK(rc, monitordb);
-			(*proxy_sqlite3_finalize)(statement);
+			read_only_log.purge(time_now-(unsigned long long)mysql_thread___monitor_history*1000);
+			// servers not checked for two of their longest intervals are not monitored anymore
+			read_only_schedule.purge(monotonic_time(), 2000ULL * mysql_thread___monitor_read_only_interval * mysql_thread___monitor_adaptive_interval_max_factor);
 		}
 
 		if (resultset)
@@ -4512,24 +4312,14 @@ void * MySQL_Monitor::monitor_replication_lag() {
 
 __end_monitor_replication_lag_loop:
 		if (mysql_thread___monitor_enabled==true) {
-			sqlite3_stmt *statement=NULL;
-			//sqlite3 *mondb=monitordb->get_db();
-			int rc;
-			char *query=NULL;
-			query=(char *)"DELETE FROM mysql_server_replication_lag_log WHERE time_start_us < ?1";
-			//rc=(*proxy_sqlite3_prepare_v2)(mondb, query, -1, &statement, 0);
-			rc = monitordb->prepare_v2(query, &statement);
-			ASSERT_SQLITE_OK(rc, monitordb);
 			if (mysql_thread___monitor_history < mysql_thread___monitor_ping_interval * (mysql_thread___monitor_ping_max_failures + 1 )) { // issue #626
 				if (mysql_thread___monitor_ping_interval < 3600000)
 					mysql_thread___monitor_history = mysql_thread___monitor_ping_interval * (mysql_thread___monitor_ping_max_failures + 1 );
 			}
 			unsigned long long time_now=realtime_time();
-			rc=(*proxy_sqlite3_bind_int64)(statement, 1, time_now-(unsigned long long)mysql_thread___monitor_history*1000); ASSERT_SQLITE_OK(rc, monitordb);
-			SAFE_SQLITE3_STEP2(statement);
-			rc=(*proxy_sqlite3_clear_bindings)(statement); ASSERT_SQLITE_OK(rc, monitordb);
-			rc=(*proxy_sqlite3_reset)(statement); ASSERT_SQLITE_OK(rc, monitordb);
-			(*proxy_sqlite3_finalize)(statement);
+			replication_lag_log.purge(time_now-(unsigned long long)mysql_thread___monitor_history*1000);
+			// servers not checked for two of their longest intervals are not monitored anymore
+			replication_lag_schedule.purge(monotonic_time(), 2000ULL * mysql_thread___monitor_replication_lag_interval * mysql_thread___monitor_adaptive_interval_max_factor);
 		}
 
 		if (resultset)
@@ -4678,6 +4468,9 @@ void* monitor_dns_resolver_thread(void* args) {
 			} 
 
 			if (!dns_resolve_data->cached_ips.empty()) {
+				// a record renewed ahead of its expiration, see 'monitor_dns_cache'
+				if (GloMyMon)
+					__sync_fetch_and_add(&GloMyMon->dns_cache_record_refreshed, 1);
 
 				if (dns_resolve_data->cached_ips.size() == ips.size()) {
 					for (const std::string& ip : ips) {
@@ -4702,7 +4495,12 @@ void* monitor_dns_resolver_thread(void* args) {
 
 			if (to_update_cache) {
 				dns_resolve_data->result.set_value(std::make_tuple<>(true, DNS_Cache_Record(dns_resolve_data->hostname, ips, monotonic_time() + (1000 * cache_ttl))));
-				dns_resolve_data->dns_cache->add(dns_resolve_data->hostname, std::move(ips));
+				if (dns_resolve_data->batch) {
+					std::lock_guard<std::mutex> lock(dns_resolve_data->batch->mutex);
+					dns_resolve_data->batch->records.emplace_back(dns_resolve_data->hostname, std::move(ips));
+				} else {
+					dns_resolve_data->dns_cache->add(dns_resolve_data->hostname, std::move(ips));
+				}
 			}
 
 			return NULL;
@@ -4716,6 +4514,17 @@ void* monitor_dns_resolver_thread(void* args) {
 	}
 
 __error:	
+	// cached for a short time: the connects to the hostname fail fast, without flooding the DNS server
+	{
+		const unsigned long long negative_until =
+			monotonic_time() + 1000ULL * std::min(dns_resolve_data->refresh_intv, static_cast<unsigned int>(DNS_CACHE_NEGATIVE_TTL));
+		if (dns_resolve_data->batch) {
+			std::lock_guard<std::mutex> lock(dns_resolve_data->batch->mutex);
+			dns_resolve_data->batch->negative_records.emplace_back(dns_resolve_data->hostname, negative_until);
+		} else {
+			dns_resolve_data->dns_cache->add_negative(dns_resolve_data->hostname, negative_until);
+		}
+	}
 	dns_resolve_data->result.set_value(std::make_tuple<>(false, DNS_Cache_Record()));
 
 	return NULL;
@@ -4848,6 +4657,8 @@ void* MySQL_Monitor::monitor_dns_cache() {
 			}
 
 			std::list<std::future<std::tuple<bool, DNS_Cache_Record>>> dns_resolve_result;
+			// all the changes of this refresh are published at once, after all the resolutions
+			std::shared_ptr<DNS_Cache_Batch> dns_cache_batch = std::make_shared<DNS_Cache_Batch>();
 
 			int delay_us = 100;
 			if (hostnames.empty() == false) {
@@ -4867,21 +4678,22 @@ void* MySQL_Monitor::monitor_dns_cache() {
 					itr != dns_records_bookkeeping.end();) {
 					// remove orphaned records
 					if (hostnames.find(itr->hostname_) == hostnames.end()) {
-						dns_cache->remove(itr->hostname_);
+						dns_cache_batch->removed.push_back(itr->hostname_);
 						proxy_debug(PROXY_DEBUG_MYSQL_CONNECTION, 5, "Removing orphaned DNS record from bookkeeper. (Hostname:[%s] IP:[%s])\n", itr->hostname_.c_str(), debug_iplisttostring(itr->ips_).c_str());					
 						itr = dns_records_bookkeeping.erase(itr);
 					}
 					else {
 						hostnames.erase(itr->hostname_);
 
-						// Renew dns records if expired
-						if (current_time > itr->ttl_) {
+						// Renew dns records expiring before the next loop, so that they never expire in the cache
+						if (current_time + (1000ULL * mysql_thread___monitor_local_dns_cache_refresh_interval) > itr->ttl_) {
 							std::unique_ptr<DNS_Resolve_Data> dns_resolve_data(new DNS_Resolve_Data());
 							dns_resolve_data->hostname = std::move(itr->hostname_);
 							dns_resolve_data->cached_ips = std::move(itr->ips_);
 							dns_resolve_data->ttl = mysql_thread___monitor_local_dns_cache_ttl;
 							dns_resolve_data->refresh_intv = mysql_thread___monitor_local_dns_cache_refresh_interval;
 							dns_resolve_data->dns_cache = dns_cache;
+							dns_resolve_data->batch = dns_cache_batch;
 							dns_resolve_result.emplace_back(dns_resolve_data->result.get_future());
 
 							proxy_debug(PROXY_DEBUG_MYSQL_CONNECTION, 5, "Removing expired DNS record from bookkeeper. (Hostname:[%s] IP:[%s])\n", itr->hostname_.c_str(), debug_iplisttostring(dns_resolve_data->cached_ips).c_str());
@@ -4932,6 +4744,7 @@ void* MySQL_Monitor::monitor_dns_cache() {
 					dns_resolve_data->ttl = mysql_thread___monitor_local_dns_cache_ttl;
 					dns_resolve_data->refresh_intv = mysql_thread___monitor_local_dns_cache_refresh_interval;
 					dns_resolve_data->dns_cache = dns_cache;
+					dns_resolve_data->batch = dns_cache_batch;
 					dns_resolve_result.emplace_back(dns_resolve_data->result.get_future());
 					dns_resolver_queue.add(new WorkItem<DNS_Resolve_Data>(dns_resolve_data.release(), monitor_dns_resolver_thread));
 					usleep(delay_us);
@@ -4984,6 +4797,7 @@ void* MySQL_Monitor::monitor_dns_cache() {
 					dns_records_bookkeeping.emplace_back(std::move(dns_record));
 				}
 			}
+			dns_cache->update(*dns_cache_batch);
 		
 			for (DNSResolverThread* const dns_resolver_thread : dns_resolver_threads) {
 				dns_resolver_thread->join();
@@ -5041,6 +4855,16 @@ void * MySQL_Monitor::run() {
 		assert(0);
 		// LCOV_EXCL_STOP
 	}
+	// resolve the hostnames missing from the DNS cache for the backend connects. More than one, so that a
+	// hostname slow to resolve doesn't delay the others
+	constexpr unsigned int num_dns_async_resolver_threads = 4;
+	std::vector<DNSResolverThread*> dns_async_resolver_threads(num_dns_async_resolver_threads);
+	for (unsigned int i = 0; i < num_dns_async_resolver_threads; i++) {
+		char thread_name[16];
+		snprintf(thread_name, sizeof(thread_name), "MonDNSAsync%u", i);
+		dns_async_resolver_threads[i] = new DNSResolverThread(*dns_resolver_queue, 0, thread_name);
+		dns_async_resolver_threads[i]->start(2048, false);
+	}
 
 __monitor_run:
 	while (queue->size()) { // this is a clean up in case Monitor was restarted
@@ -5224,6 +5048,20 @@ __monitor_run:
 
 	pthread_join(monitor_dns_cache_thread, NULL);
 
+	for (size_t i = 0; i < dns_async_resolver_threads.size(); i++)
+		dns_resolver_queue->add(NULL);
+	for (DNSResolverThread* const dns_resolver_thread : dns_async_resolver_threads) {
+		dns_resolver_thread->join();
+		delete dns_resolver_thread;
+	}
+	while (dns_resolver_queue->size()) {
+		WorkItem<DNS_Resolve_Data>* item = dns_resolver_queue->remove();
+		if (item) {
+			delete item->data;
+			delete item;
+		}
+	}
+
 	if (mysql_thr) {
 		delete mysql_thr;
 		mysql_thr=NULL;
@@ -5424,75 +5262,352 @@ void AWS_Aurora_status_entry::add_host_status(AWS_Aurora_replica_host_status_ent
 	host_statuses->push_back(hs);
 }
 
-Galera_monitor_node::Galera_monitor_node(char *_a, int _p, int _whg) {
-	addr=NULL;
-	if (_a) {
-		addr=strdup(_a);
-	}
-	port=_p;
+Monitor_check_node::Monitor_check_node() {
 	idx_last_entry=-1;
-	writer_hostgroup=_whg;
-	int i;
-	for (i=0;i<Galera_Nentries;i++) {
+	consecutive_failures=0;
+	for (int i=0; i<Monitor_check_Nentries; i++) {
+		last_entries[i].time_start_us=0;
 		last_entries[i].error=NULL;
-		last_entries[i].start_time=0;
 	}
 }
 
-Galera_monitor_node::~Galera_monitor_node() {
-	if (addr) {
-		free(addr);
+Monitor_check_node::~Monitor_check_node() {
+	for (int i=0; i<Monitor_check_Nentries; i++) {
+		if (last_entries[i].error) {
+			free(last_entries[i].error);
+		}
 	}
 }
 
-// return true if status changed
-bool Galera_monitor_node::add_entry(unsigned long long _st, unsigned long long _ct, long long _tb, bool _pp, bool _ro, int _local_state, bool _desync, bool _reject, bool _sst_donor_reject, bool _pxc_maint_mode, char *_error) {
-	bool ret=false;
-	if (idx_last_entry==-1) ret=true;
-	int prev_last_entry=idx_last_entry;
+void Monitor_check_node::add_entry(unsigned long long _st, unsigned long long _ct, bool _has_value, long long _value, const char *_error, bool _failure) {
 	idx_last_entry++;
-	if (idx_last_entry>=Galera_Nentries) {
+	if (idx_last_entry>=Monitor_check_Nentries) {
 		idx_last_entry=0;
 	}
-	last_entries[idx_last_entry].start_time=_st;
-	last_entries[idx_last_entry].check_time=_ct;
-	last_entries[idx_last_entry].wsrep_local_recv_queue=_tb;
-	last_entries[idx_last_entry].primary_partition=_pp;
-	last_entries[idx_last_entry].read_only=_ro;
-	last_entries[idx_last_entry].wsrep_local_state = _local_state;
-	last_entries[idx_last_entry].wsrep_desync = _desync;
-	last_entries[idx_last_entry].wsrep_reject_queries = _reject;
-	last_entries[idx_last_entry].wsrep_sst_donor_rejects_queries = _sst_donor_reject;
-	last_entries[idx_last_entry].pxc_maint_mode = _pxc_maint_mode;
-	if (last_entries[idx_last_entry].error) {
-		free(last_entries[idx_last_entry].error);
-		last_entries[idx_last_entry].error=NULL;
+	Monitor_check_entry_t *entry=&last_entries[idx_last_entry];
+	entry->time_start_us=_st;
+	entry->success_time_us=_ct;
+	entry->has_value=_has_value;
+	entry->value=_value;
+	if (entry->error) {
+		free(entry->error);
+		entry->error=NULL;
 	}
 	if (_error) {
-		last_entries[idx_last_entry].error=strdup(_error);	// we always copy
+		entry->error=strdup(_error);	// we always copy
 	}
-	if (ret==false) {
-		if (last_entries[idx_last_entry].primary_partition != last_entries[prev_last_entry].primary_partition) {
-			ret=true;
-		}
-		if (last_entries[idx_last_entry].read_only != last_entries[prev_last_entry].read_only) {
-			ret=true;
+	if (_failure) {
+		consecutive_failures++;
+	} else {
+		consecutive_failures=0;
+	}
+}
+
+unsigned int Monitor_check_node::purge(unsigned long long min_time_start_us) {
+	unsigned int entries=0;
+	for (int i=0; i<Monitor_check_Nentries; i++) {
+		Monitor_check_entry_t *entry=&last_entries[i];
+		if (entry->time_start_us == 0) continue;
+		if (entry->time_start_us < min_time_start_us) {
+			entry->time_start_us=0;
+			if (entry->error) {
+				free(entry->error);
+				entry->error=NULL;
+			}
+		} else {
+			entries++;
 		}
-		if (
-			(last_entries[idx_last_entry].error && last_entries[prev_last_entry].error==NULL)
-			||
-			(last_entries[idx_last_entry].error==NULL && last_entries[prev_last_entry].error)
-			||
-			(last_entries[idx_last_entry].error && last_entries[prev_last_entry].error && strcmp(last_entries[idx_last_entry].error,last_entries[prev_last_entry].error))
-		) {
-			ret=true;
+	}
+	return entries;
+}
+
+long long Monitor_check_node::get_avg_success_time(unsigned int n) {
+	unsigned long long tot=0;
+	unsigned int cnt=0;
+	int idx=idx_last_entry;
+	for (unsigned int i=0; idx>=0 && i<n && i<Monitor_check_Nentries; i++) {
+		Monitor_check_entry_t *entry=&last_entries[idx];
+		if (entry->time_start_us == 0) break; // purged, so are the older ones
+		if (entry->error == NULL) {
+			tot+=entry->success_time_us;
+			cnt++;
 		}
+		idx = (idx == 0 ? Monitor_check_Nentries - 1 : idx - 1);
+	}
+	return (cnt ? (long long)(tot/cnt) : -1);
+}
+
+bool Monitor_check_node::get_last_value(long long& value) {
+	if (idx_last_entry < 0) {
+		return false;
+	}
+	Monitor_check_entry_t *entry=&last_entries[idx_last_entry];
+	if (entry->time_start_us == 0 || entry->has_value == false) {
+		return false;
+	}
+	value=entry->value;
+	return true;
+}
+
+Monitor_check_log::Monitor_check_log(const char *_table_name, bool _has_value_column) {
+	pthread_mutex_init(&mutex, NULL);
+	table_name=_table_name;
+	has_value_column=_has_value_column;
+}
+
+Monitor_check_log::~Monitor_check_log() {
+	for (auto& it : nodes) {
+		delete it.second;
+	}
+	nodes.clear();
+	pthread_mutex_destroy(&mutex);
+}
+
+void Monitor_check_log::add_entry(const char *hostname, int port, unsigned long long time_start_us, unsigned long long success_time_us, bool has_value, long long value, const char *error, bool failure) {
+	std::string s = std::string(hostname) + ":" + std::to_string(port);
+	pthread_mutex_lock(&mutex);
+	Monitor_check_node *node=NULL;
+	std::map<std::string, Monitor_check_node *>::iterator it = nodes.find(s);
+	if (it != nodes.end()) {
+		node=it->second;
+	} else {
+		node=new Monitor_check_node();
+		nodes.insert(std::make_pair(s, node));
+	}
+	node->add_entry(time_start_us, success_time_us, has_value, value, error, failure);
+	pthread_mutex_unlock(&mutex);
+}
+
+unsigned int Monitor_check_log::get_consecutive_failures(const char *hostname, int port) {
+	unsigned int ret=0;
+	std::string s = std::string(hostname) + ":" + std::to_string(port);
+	pthread_mutex_lock(&mutex);
+	std::map<std::string, Monitor_check_node *>::iterator it = nodes.find(s);
+	if (it != nodes.end()) {
+		ret=it->second->consecutive_failures;
 	}
+	pthread_mutex_unlock(&mutex);
 	return ret;
 }
 
-void MySQL_Monitor::populate_monitor_mysql_server_group_replication_log() {
-	//sqlite3 *mondb=monitordb->get_db();
+long long Monitor_check_log::get_avg_success_time(const char *hostname, int port, unsigned int n) {
+	long long ret=-1;
+	std::string s = std::string(hostname) + ":" + std::to_string(port);
+	pthread_mutex_lock(&mutex);
+	std::map<std::string, Monitor_check_node *>::iterator it = nodes.find(s);
+	if (it != nodes.end()) {
+		ret=it->second->get_avg_success_time(n);
+	}
+	pthread_mutex_unlock(&mutex);
+	return ret;
+}
+
+bool Monitor_check_log::get_last_value(const char *hostname, int port, long long& value) {
+	bool ret=false;
+	std::string s = std::string(hostname) + ":" + std::to_string(port);
+	pthread_mutex_lock(&mutex);
+	std::map<std::string, Monitor_check_node *>::iterator it = nodes.find(s);
+	if (it != nodes.end()) {
+		ret=it->second->get_last_value(value);
+	}
+	pthread_mutex_unlock(&mutex);
+	return ret;
+}
+
+void Monitor_check_log::purge(unsigned long long min_time_start_us) {
+	pthread_mutex_lock(&mutex);
+	for (std::map<std::string, Monitor_check_node *>::iterator it = nodes.begin(); it != nodes.end(); ) {
+		if (it->second->purge(min_time_start_us) == 0) {
+			// server not checked anymore
+			delete it->second;
+			it = nodes.erase(it);
+		} else {
+			++it;
+		}
+	}
+	pthread_mutex_unlock(&mutex);
+}
+
+void Monitor_check_log::populate_table(SQLite3DB *db) {
+	int rc;
+	char query[128];
+	sqlite3_stmt *statement1=NULL;
+	pthread_mutex_lock(&mutex);
+	snprintf(query, sizeof(query), "DELETE FROM %s", table_name);
+	db->execute(query);
+	snprintf(query, sizeof(query), "INSERT OR IGNORE INTO %s VALUES (?1 , ?2 , ?3 , ?4 , ?5%s)", table_name, (has_value_column ? " , ?6" : ""));
+	rc = db->prepare_v2(query, &statement1);
+	ASSERT_SQLITE_OK(rc, db);
+	int error_idx = (has_value_column ? 6 : 5);
+	for (std::map<std::string, Monitor_check_node *>::iterator it = nodes.begin(); it != nodes.end(); ++it) {
+		const std::string& s=it->first;
+		Monitor_check_node *node=it->second;
+		std::size_t found=s.find_last_of(":");
+		std::string host=s.substr(0,found);
+		std::string port=s.substr(found+1);
+		for (int i=0; i<Monitor_check_Nentries; i++) {
+			Monitor_check_entry_t *entry=&node->last_entries[i];
+			if (entry->time_start_us == 0) continue;
+			rc=(*proxy_sqlite3_bind_text)(statement1, 1, host.c_str(), -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, db);
+			rc=(*proxy_sqlite3_bind_int64)(statement1, 2, atoi(port.c_str())); ASSERT_SQLITE_OK(rc, db);
+			rc=(*proxy_sqlite3_bind_int64)(statement1, 3, entry->time_start_us); ASSERT_SQLITE_OK(rc, db);
+			rc=(*proxy_sqlite3_bind_int64)(statement1, 4, entry->success_time_us); ASSERT_SQLITE_OK(rc, db);
+			if (has_value_column) {
+				if (entry->has_value) {
+					rc=(*proxy_sqlite3_bind_int64)(statement1, 5, entry->value); ASSERT_SQLITE_OK(rc, db);
+				} else {
+					rc=(*proxy_sqlite3_bind_null)(statement1, 5); ASSERT_SQLITE_OK(rc, db);
+				}
+			}
+			rc=(*proxy_sqlite3_bind_text)(statement1, error_idx, entry->error, -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, db);
+			SAFE_SQLITE3_STEP2(statement1);
+			rc=(*proxy_sqlite3_clear_bindings)(statement1); ASSERT_SQLITE_OK(rc, db);
+			rc=(*proxy_sqlite3_reset)(statement1); ASSERT_SQLITE_OK(rc, db);
+		}
+	}
+	(*proxy_sqlite3_finalize)(statement1);
+	pthread_mutex_unlock(&mutex);
+}
+
+Monitor_check_schedule::Monitor_check_schedule() {
+	pthread_mutex_init(&mutex, NULL);
+}
+
+Monitor_check_schedule::~Monitor_check_schedule() {
+	pthread_mutex_destroy(&mutex);
+}
+
+bool Monitor_check_schedule::is_due(const char *hostname, int port, unsigned long long now) {
+	bool ret=true;
+	std::string s = std::string(hostname) + ":" + std::to_string(port);
+	pthread_mutex_lock(&mutex);
+	std::unordered_map<std::string, server_schedule_t>::iterator it = servers.find(s);
+	if (it != servers.end()) {
+		ret = (now >= it->second.next_check_at);
+	}
+	pthread_mutex_unlock(&mutex);
+	return ret;
+}
+
+void Monitor_check_schedule::update(const char *hostname, int port, unsigned long long now, unsigned int interval_ms, bool stable) {
+	unsigned int max_factor = mysql_thread___monitor_adaptive_interval_max_factor > 1 ? mysql_thread___monitor_adaptive_interval_max_factor : 1;
+	std::string s = std::string(hostname) + ":" + std::to_string(port);
+	pthread_mutex_lock(&mutex);
+	server_schedule_t& srv = servers[s];
+	if (stable && srv.factor) {
+		srv.factor = (srv.factor * 2 > max_factor ? max_factor : srv.factor * 2);
+	} else {
+		srv.factor = 1;
+	}
+	if (srv.factor == 1) {
+		// checked at every loop
+		srv.next_check_at = 0;
+	} else {
+		// the loop of the check runs every 'interval_ms': half an interval of margin for the start jitter
+		srv.next_check_at = now + ((unsigned long long)interval_ms * srv.factor - interval_ms / 2) * 1000;
+	}
+	srv.last_update = now;
+	pthread_mutex_unlock(&mutex);
+}
+
+void Monitor_check_schedule::expedite(const char *hostname, int port) {
+	std::string s = std::string(hostname) + ":" + std::to_string(port);
+	pthread_mutex_lock(&mutex);
+	std::unordered_map<std::string, server_schedule_t>::iterator it = servers.find(s);
+	if (it != servers.end()) {
+		it->second.factor = 1;
+		it->second.next_check_at = 0;
+	}
+	pthread_mutex_unlock(&mutex);
+}
+
+void Monitor_check_schedule::purge(unsigned long long now, unsigned long long max_age) {
+	pthread_mutex_lock(&mutex);
+	for (std::unordered_map<std::string, server_schedule_t>::iterator it = servers.begin(); it != servers.end(); ) {
+		if (now - it->second.last_update > max_age) {
+			it = servers.erase(it);
+		} else {
+			++it;
+		}
+	}
+	pthread_mutex_unlock(&mutex);
+}
+
+void MySQL_Monitor::expedite_checks(const char *hostname, int port) {
+	ping_schedule.expedite(hostname, port);
+	read_only_schedule.expedite(hostname, port);
+	replication_lag_schedule.expedite(hostname, port);
+}
+
+Galera_monitor_node::Galera_monitor_node(char *_a, int _p, int _whg) {
+	addr=NULL;
+	if (_a) {
+		addr=strdup(_a);
+	}
+	port=_p;
+	idx_last_entry=-1;
+	writer_hostgroup=_whg;
+	int i;
+	for (i=0;i<Galera_Nentries;i++) {
+		last_entries[i].error=NULL;
+		last_entries[i].start_time=0;
+	}
+}
+
+Galera_monitor_node::~Galera_monitor_node() {
+	if (addr) {
+		free(addr);
+	}
+}
+
+// return true if status changed
+bool Galera_monitor_node::add_entry(unsigned long long _st, unsigned long long _ct, long long _tb, bool _pp, bool _ro, int _local_state, bool _desync, bool _reject, bool _sst_donor_reject, bool _pxc_maint_mode, char *_error) {
+	bool ret=false;
+	if (idx_last_entry==-1) ret=true;
+	int prev_last_entry=idx_last_entry;
+	idx_last_entry++;
+	if (idx_last_entry>=Galera_Nentries) {
+		idx_last_entry=0;
+	}
+	last_entries[idx_last_entry].start_time=_st;
+	last_entries[idx_last_entry].check_time=_ct;
+	last_entries[idx_last_entry].wsrep_local_recv_queue=_tb;
+	last_entries[idx_last_entry].primary_partition=_pp;
+	last_entries[idx_last_entry].read_only=_ro;
+	last_entries[idx_last_entry].wsrep_local_state = _local_state;
+	last_entries[idx_last_entry].wsrep_desync = _desync;
+	last_entries[idx_last_entry].wsrep_reject_queries = _reject;
+	last_entries[idx_last_entry].wsrep_sst_donor_rejects_queries = _sst_donor_reject;
+	last_entries[idx_last_entry].pxc_maint_mode = _pxc_maint_mode;
+	if (last_entries[idx_last_entry].error) {
+		free(last_entries[idx_last_entry].error);
+		last_entries[idx_last_entry].error=NULL;
+	}
+	if (_error) {
+		last_entries[idx_last_entry].error=strdup(_error);	// we always copy
+	}
+	if (ret==false) {
+		if (last_entries[idx_last_entry].primary_partition != last_entries[prev_last_entry].primary_partition) {
+			ret=true;
+		}
+		if (last_entries[idx_last_entry].read_only != last_entries[prev_last_entry].read_only) {
+			ret=true;
+		}
+		if (
+			(last_entries[idx_last_entry].error && last_entries[prev_last_entry].error==NULL)
+			||
+			(last_entries[idx_last_entry].error==NULL && last_entries[prev_last_entry].error)
+			||
+			(last_entries[idx_last_entry].error && last_entries[prev_last_entry].error && strcmp(last_entries[idx_last_entry].error,last_entries[prev_last_entry].error))
+		) {
+			ret=true;
+		}
+	}
+	return ret;
+}
+
+void MySQL_Monitor::populate_monitor_mysql_server_group_replication_log() {
+	//sqlite3 *mondb=monitordb->get_db();
 	int rc;
 	//char *query=NULL;
 	char *query1=NULL;
@@ -6739,18 +6854,101 @@ void MySQL_Monitor::trigger_dns_cache_update() {
 	}
 }
 
+DNS_RESOLVE_STATUS MySQL_Monitor::dns_lookup_async(const char* hostname, int port) {
+	static thread_local std::shared_ptr<DNS_Cache> dns_cache_thread;
+
+	// UNIX socket, or IP provided
+	if (port == 0 || hostname == NULL || hostname[0] == '\0' || validate_ip(hostname))
+		return DNS_RESOLVE_READY;
+
+	if (!dns_cache_thread && GloMyMon)
+		dns_cache_thread = GloMyMon->dns_cache;
+
+	// without the DNS cache, the hostname is resolved by the client library
+	if (!dns_cache_thread || dns_cache_thread->is_enabled() == false)
+		return DNS_RESOLVE_READY;
+
+	const std::string& host = trim(hostname);
+	switch (dns_cache_thread->find(host)) {
+		case DNS_Cache::HIT:
+			// counted by 'lookup', when the connect starts
+			return DNS_RESOLVE_READY;
+		case DNS_Cache::NEGATIVE:
+			if (GloMyMon)
+				__sync_fetch_and_add(&GloMyMon->dns_cache_queried, 1);
+			return DNS_RESOLVE_FAILED;
+		default:
+			break;
+	}
+
+	if (GloMyMon && dns_cache_thread->set_pending(host)) {
+		__sync_fetch_and_add(&GloMyMon->dns_cache_queried, 1);
+		proxy_debug(PROXY_DEBUG_MYSQL_CONNECTION, 5, "DNS cache lookup was a miss, resolving asynchronously. (Hostname:[%s])\n", host.c_str());
+		DNS_Resolve_Data* dns_resolve_data = new DNS_Resolve_Data();
+		dns_resolve_data->hostname = host;
+		dns_resolve_data->ttl = mysql_thread___monitor_local_dns_cache_ttl;
+		dns_resolve_data->refresh_intv = mysql_thread___monitor_local_dns_cache_refresh_interval;
+		dns_resolve_data->dns_cache = dns_cache_thread;
+		GloMyMon->dns_resolver_queue->add(new WorkItem<DNS_Resolve_Data>(dns_resolve_data, monitor_dns_resolver_thread));
+	}
+
+	return DNS_RESOLVE_PENDING;
+}
+
+DNS_Cache::DNS_Cache() : enabled(false) {
+	records = new records_t();
+}
+
+DNS_Cache::~DNS_Cache() {
+	delete records.load();
+}
+
+DNS_Cache::records_t* DNS_Cache::copy_records() const {
+	// 'writers_mutex' must be held. Expired negative records are dropped
+	const unsigned long long curtime = monotonic_time();
+	const records_t* cur = records.load();
+	records_t* next = new records_t();
+	next->reserve(cur->size() + 1);
+	for (auto it = cur->begin(); it != cur->end(); ++it) {
+		if (it->second->negative_until == 0 || it->second->negative_until > curtime) {
+			next->emplace(it->first, it->second);
+		}
+	}
+	return next;
+}
+
+void DNS_Cache::publish(records_t* next) {
+	// 'writers_mutex' must be held
+	records_t* prev = records.load();
+	records.store(next);
+	readers.synchronize();
+	delete prev;
+}
+
+void DNS_Cache::clear_pending(const std::string& hostname) {
+	std::lock_guard<std::mutex> lock(pending_mutex);
+	pending.erase(hostname);
+}
+
+bool DNS_Cache::set_pending(const std::string& hostname) {
+	std::lock_guard<std::mutex> lock(pending_mutex);
+	return pending.insert(hostname).second;
+}
+
 bool DNS_Cache::add(const std::string& hostname, std::vector<std::string>&& ips) {
 
 	if (!enabled) return false;
 
 	proxy_debug(PROXY_DEBUG_MYSQL_CONNECTION, 5, "Updating DNS cache. (Hostname:[%s] IP:[%s])\n", hostname.c_str(), debug_iplisttostring(ips).c_str());
-	int rc = pthread_rwlock_wrlock(&rwlock_);
-	assert(rc == 0);
-	auto& ip_addr = records[hostname];
-	ip_addr.ips = std::move(ips);
-	__sync_fetch_and_and(&ip_addr.counter, 0);
-	rc = pthread_rwlock_unlock(&rwlock_);
-	assert(rc == 0);
+	std::shared_ptr<IP_ADDR> ip_addr = std::make_shared<IP_ADDR>();
+	ip_addr->ips = std::move(ips);
+	{
+		std::lock_guard<std::mutex> lock(writers_mutex);
+		records_t* next = copy_records();
+		(*next)[hostname] = std::move(ip_addr);
+		publish(next);
+	}
+	clear_pending(hostname);
 
 	if (GloMyMon)
 		__sync_fetch_and_add(&GloMyMon->dns_cache_record_updated, 1);
@@ -6760,31 +6958,55 @@ bool DNS_Cache::add(const std::string& hostname, std::vector<std::string>&& ips)
 
 bool DNS_Cache::add_if_not_exist(const std::string& hostname, std::vector<std::string>&& ips) {
 	if (!enabled) return false;
+	// called after every successful connect: the common case, an existing record, doesn't take the lock
+	if (find(hostname) == HIT) return true;
 	bool item_added = false;
-	int rc = pthread_rwlock_wrlock(&rwlock_);
-	assert(rc == 0);
-	if (records.find(hostname) == records.end()) {
-		proxy_debug(PROXY_DEBUG_MYSQL_CONNECTION, 5, "Updating DNS cache. (Hostname:[%s] IP:[%s])\n", hostname.c_str(), debug_iplisttostring(ips).c_str());
-		auto& ip_addr = records[hostname];
-		ip_addr.ips = std::move(ips);
-		__sync_fetch_and_and(&ip_addr.counter, 0);
-		item_added = true;
-	}
-	rc = pthread_rwlock_unlock(&rwlock_);
-	assert(rc == 0);
-
-	if (item_added && GloMyMon)
-		__sync_fetch_and_add(&GloMyMon->dns_cache_record_updated, 1);
+	{
+		std::lock_guard<std::mutex> lock(writers_mutex);
+		auto itr = records.load()->find(hostname);
+		if (itr == records.load()->end() || itr->second->negative_until) {
+			proxy_debug(PROXY_DEBUG_MYSQL_CONNECTION, 5, "Updating DNS cache. (Hostname:[%s] IP:[%s])\n", hostname.c_str(), debug_iplisttostring(ips).c_str());
+			std::shared_ptr<IP_ADDR> ip_addr = std::make_shared<IP_ADDR>();
+			ip_addr->ips = std::move(ips);
+			records_t* next = copy_records();
+			(*next)[hostname] = std::move(ip_addr);
+			publish(next);
+			item_added = true;
+		}
+	}
+
+	if (item_added) {
+		clear_pending(hostname);
+		if (GloMyMon)
+			__sync_fetch_and_add(&GloMyMon->dns_cache_record_updated, 1);
+	}
 
 	return true;
 }
 
+void DNS_Cache::add_negative(const std::string& hostname, unsigned long long expire_at) {
+	if (enabled) {
+		std::lock_guard<std::mutex> lock(writers_mutex);
+		auto itr = records.load()->find(hostname);
+		if (itr == records.load()->end() || itr->second->negative_until) {
+			proxy_debug(PROXY_DEBUG_MYSQL_CONNECTION, 5, "Caching failed DNS resolution. (Hostname:[%s])\n", hostname.c_str());
+			std::shared_ptr<IP_ADDR> ip_addr = std::make_shared<IP_ADDR>();
+			ip_addr->negative_until = expire_at;
+			records_t* next = copy_records();
+			(*next)[hostname] = std::move(ip_addr);
+			publish(next);
+		}
+	}
+	// also when the record wasn't replaced, the resolution isn't pending anymore
+	clear_pending(hostname);
+}
+
 std::string DNS_Cache::get_next_ip(const IP_ADDR& ip_addr) const {
 
 	if (ip_addr.ips.empty())
 		return "";
 
-	const auto counter_val = __sync_fetch_and_add(const_cast<unsigned long*>(&ip_addr.counter), 1);
+	const auto counter_val = ip_addr.counter.fetch_add(1, std::memory_order_relaxed);
 
 	return ip_addr.ips[counter_val%ip_addr.ips.size()];
 }
@@ -6796,15 +7018,16 @@ std::string DNS_Cache::lookup(const std::string& hostname, size_t* ip_count) con
 	
 	__sync_fetch_and_add(&GloMyMon->dns_cache_queried, 1);
 
-	int rc = pthread_rwlock_rdlock(&rwlock_);
-	assert(rc == 0);
-	auto itr = records.find(hostname);
+	std::atomic<unsigned int>& count = readers.read_begin();
+	const records_t* cur = records.load();
+	auto itr = cur->find(hostname);
 
-	if (itr != records.end()) {
-		ip = get_next_ip(itr->second);
+	// negative records have no IPs, they are misses for the callers of 'lookup'
+	if (itr != cur->end() && itr->second->ips.empty() == false) {
+		ip = get_next_ip(*itr->second);
 
 		if (ip_count)
-			*ip_count = itr->second.ips.size();
+			*ip_count = itr->second->ips.size();
 
 		proxy_debug(PROXY_DEBUG_MYSQL_CONNECTION, 5, "DNS cache lookup success. (Hostname:[%s] IP returned:[%s])\n", hostname.c_str(), ip.c_str());
 	}
@@ -6812,8 +7035,7 @@ std::string DNS_Cache::lookup(const std::string& hostname, size_t* ip_count) con
 		if (ip_count) 
 			*ip_count = 0;
 	}
-	rc = pthread_rwlock_unlock(&rwlock_);
-	assert(rc == 0);
+	Epoch_Readers::read_end(count);
 
 	if (!ip.empty() && GloMyMon) {
 		__sync_fetch_and_add(&GloMyMon->dns_cache_lookup_success, 1);
@@ -6822,48 +7044,102 @@ std::string DNS_Cache::lookup(const std::string& hostname, size_t* ip_count) con
 	return ip;
 }
 
+DNS_Cache::lookup_result DNS_Cache::find(const std::string& hostname) const {
+	lookup_result ret = MISS;
+
+	std::atomic<unsigned int>& count = readers.read_begin();
+	const records_t* cur = records.load();
+	auto itr = cur->find(hostname);
+	if (itr != cur->end()) {
+		if (itr->second->negative_until == 0) {
+			ret = HIT;
+		} else if (itr->second->negative_until > monotonic_time()) {
+			ret = NEGATIVE;
+		}
+	}
+	Epoch_Readers::read_end(count);
+
+	return ret;
+}
+
 void DNS_Cache::remove(const std::string& hostname) {
 	bool item_removed = false;
 
-	int rc = pthread_rwlock_wrlock(&rwlock_);
-	assert(rc == 0);
-	auto itr = records.find(hostname);
-	if (itr != records.end()) {
-		proxy_debug(PROXY_DEBUG_MYSQL_CONNECTION, 5, "Removing DNS cache record. (Hostname:[%s] IP:[%s])\n", hostname.c_str(), debug_iplisttostring(itr->second.ips).c_str());
-		records.erase(itr);
-		item_removed = true;
+	// called after connect errors: most of the times the record was already removed
+	if (find(hostname) != MISS) {
+		std::lock_guard<std::mutex> lock(writers_mutex);
+		auto itr = records.load()->find(hostname);
+		if (itr != records.load()->end()) {
+			proxy_debug(PROXY_DEBUG_MYSQL_CONNECTION, 5, "Removing DNS cache record. (Hostname:[%s] IP:[%s])\n", hostname.c_str(), debug_iplisttostring(itr->second->ips).c_str());
+			records_t* next = copy_records();
+			next->erase(hostname);
+			publish(next);
+			item_removed = true;
+		}
 	}
-	rc = pthread_rwlock_unlock(&rwlock_);
 
 	if (item_removed && GloMyMon)
 		__sync_fetch_and_add(&GloMyMon->dns_cache_record_updated, 1);
+}
 
-	assert(rc == 0);
-
-	
+void DNS_Cache::update(DNS_Cache_Batch& batch) {
+	size_t records_updated = 0;
+	if (enabled) {
+		std::lock_guard<std::mutex> lock(writers_mutex);
+		const records_t* cur = records.load();
+		records_t* next = copy_records();
+		for (const std::string& hostname : batch.removed) {
+			records_updated += next->erase(hostname);
+		}
+		for (auto& record : batch.records) {
+			proxy_debug(PROXY_DEBUG_MYSQL_CONNECTION, 5, "Updating DNS cache. (Hostname:[%s] IP:[%s])\n", record.first.c_str(), debug_iplisttostring(record.second).c_str());
+			std::shared_ptr<IP_ADDR> ip_addr = std::make_shared<IP_ADDR>();
+			ip_addr->ips = std::move(record.second);
+			(*next)[record.first] = std::move(ip_addr);
+			records_updated++;
+		}
+		for (const auto& negative_record : batch.negative_records) {
+			// as in 'add_negative()', a hostname that already has IPs keeps them
+			auto itr = cur->find(negative_record.first);
+			if (itr == cur->end() || itr->second->negative_until) {
+				proxy_debug(PROXY_DEBUG_MYSQL_CONNECTION, 5, "Caching failed DNS resolution. (Hostname:[%s])\n", negative_record.first.c_str());
+				std::shared_ptr<IP_ADDR> ip_addr = std::make_shared<IP_ADDR>();
+				ip_addr->negative_until = negative_record.second;
+				(*next)[negative_record.first] = std::move(ip_addr);
+			}
+		}
+		publish(next);
+	}
+	for (const auto& record : batch.records) {
+		clear_pending(record.first);
+	}
+	for (const auto& negative_record : batch.negative_records) {
+		clear_pending(negative_record.first);
+	}
+	if (records_updated && GloMyMon)
+		__sync_fetch_and_add(&GloMyMon->dns_cache_record_updated, records_updated);
 }
 
 void DNS_Cache::clear() {
 	size_t records_removed = 0;
-	int rc = pthread_rwlock_wrlock(&rwlock_);
-	assert(rc == 0);
-	records_removed = records.size();
-	records.clear();
-	rc = pthread_rwlock_unlock(&rwlock_);
-	assert(rc == 0);
+	{
+		std::lock_guard<std::mutex> lock(writers_mutex);
+		records_removed = records.load()->size();
+		publish(new records_t());
+	}
+	{
+		std::lock_guard<std::mutex> lock(pending_mutex);
+		pending.clear();
+	}
 	if (records_removed)
 		__sync_fetch_and_add(&GloMyMon->dns_cache_record_updated, records_removed);
 	proxy_debug(PROXY_DEBUG_MYSQL_CONNECTION, 5, "DNS cache was cleared.\n");
 }
 
 bool DNS_Cache::empty() const {
-	bool result = true;
-
-	int rc = pthread_rwlock_rdlock(&rwlock_);
-	assert(rc == 0);
-	result = records.empty();
-	rc = pthread_rwlock_unlock(&rwlock_);
-	assert(rc == 0);
+	std::atomic<unsigned int>& count = readers.read_begin();
+	const bool result = records.load()->empty();
+	Epoch_Readers::read_end(count);
 
 	return result;
 }
@@ -6908,6 +7184,31 @@ mysql_status(short event) {
 	return status;
 }
 
+/**
+ * @brief Returns 'false' if a check took much longer than the average of the previous ones.
+ * @details Used to bring the server back to fast probing, see 'Monitor_check_schedule'. Small absolute
+ *   variations are ignored, as they are common for fast servers.
+ * @param avg_us Average time of the previous checks, or -1 if unknown.
+ * @param time_us Time of the check.
+ */
+static bool monitor_latency_is_stable(long long avg_us, unsigned long long time_us) {
+	const unsigned long long MIN_SPIKE_US = 1000;
+	if (avg_us < 0) {
+		return true;
+	}
+	return (time_us <= (unsigned long long)avg_us * 3 || time_us <= (unsigned long long)avg_us + MIN_SPIKE_US);
+}
+
+/**
+ * @brief Returns the window, in microseconds, in which the checks of an interval are started.
+ * @details See 'mysql-monitor_checks_jitter'. Spreading the start of the checks over the window avoids
+ *   bursts of new connections and queries towards the servers at every interval.
+ * @param interval_ms The interval of the check, in milliseconds.
+ */
+static unsigned long long monitor_checks_jitter_us(int interval_ms) {
+	return (unsigned long long)interval_ms * 1000 * mysql_thread___monitor_checks_jitter / 100;
+}
+
 class Monitor_Poll {
 public:
 	class Process_Ready_Task_Callback_Args {
@@ -6938,9 +7239,16 @@ public:
 		MySQL_Monitor* mysql_monitor_;
 	};
 
-	Monitor_Poll(unsigned int capacity) {
+	/**
+	 * @param capacity Initial number of tasks that can be polled without reallocating.
+	 * @param max_start_delay_us When not zero, tasks are started at a random time within this window from
+	 *   the call to 'add', instead of immediately. See 'mysql-monitor_checks_jitter'.
+	 */
+	Monitor_Poll(unsigned int capacity, unsigned long long max_start_delay_us = 0) {
 		len_ = 0;
-		capacity_ = capacity;
+		capacity_ = capacity ? capacity : 1;
+		max_start_delay_us_ = max_start_delay_us;
+		ready_at_start_ = false;
 		fds_ = (struct pollfd*)malloc(capacity_ * sizeof(struct pollfd));
 		mmsds_ = (MySQL_Monitor_State_Data**)malloc(capacity_ * sizeof(MySQL_Monitor_State_Data*));
 	}
@@ -6959,21 +7267,19 @@ public:
 		}
 	}
 
+	/**
+	 * @brief Adds a task to the poll, starting it now or within the configured start window.
+	 * @details If 'mmsd' has no connection, a new one is created asynchronously before performing the task.
+	 */
 	void add(short _events, MySQL_Monitor_State_Data* mmsd) {
 		assert(mmsd);
-		assert(mmsd->mysql);
 
-		if (len_ == capacity_) {
-			expand(1);
+		if (max_start_delay_us_ == 0) {
+			start(_events, mmsd);
+		} else {
+			const unsigned long long start_at = monotonic_time() + rand() % max_start_delay_us_;
+			delayed_.push_back({ start_at, _events, mmsd });
 		}
-		fds_[len_].fd = mysql_get_socket(mmsd->mysql);
-		fds_[len_].events = _events;
-		fds_[len_].revents = 0;
-		mmsds_[len_] = mmsd;
-		len_++;
-
-		mmsd->init_async();
-		mmsd->task_handler(-1, _events);
 	}
 
 	void remove_index_fast(unsigned int i) {
@@ -7000,13 +7306,17 @@ public:
 
 	bool event_loop(int poll_timeout_ms, Process_Ready_Task_Callback_Args& process_ready_task_callback_arg) {
 
-		if (len_ == 0)
+		if (len_ == 0 && delayed_.empty())
 			return false;
 
 		int rc = 0;
 
+		// latest start first, so the next task to start is always at the back
+		std::sort(delayed_.begin(), delayed_.end(),
+			[](const delayed_task_t& a, const delayed_task_t& b) { return a.start_at > b.start_at; });
+
 		// number of tasks to process based on provided percentage
-		unsigned int tasks_to_process_count = len_ * process_ready_task_callback_arg.process_task_percentage_;
+		unsigned int tasks_to_process_count = (len_ + delayed_.size()) * process_ready_task_callback_arg.process_task_percentage_;
 
 		// if number of task to process is less than minimum task to process, overwrite it
 		if (tasks_to_process_count < process_ready_task_callback_arg.min_task_to_process_) {
@@ -7016,13 +7326,35 @@ public:
 		std::vector<MySQL_Monitor_State_Data*> ready_tasks;
 		ready_tasks.reserve(tasks_to_process_count);
 
-		while (len_) {
+		while (len_ || !delayed_.empty()) {
 
 			if (GloMyMon->shutdown) {
 				return false;
 			}
 
-			rc = poll(fds_, len_, poll_timeout_ms);
+			int timeout_ms = poll_timeout_ms;
+
+			if (!delayed_.empty()) {
+				const unsigned long long now = monotonic_time();
+
+				while (!delayed_.empty() && delayed_.back().start_at <= now) {
+					start(delayed_.back().events, delayed_.back().mmsd);
+					delayed_.pop_back();
+				}
+				if (!delayed_.empty()) {
+					const int next_start_ms = (delayed_.back().start_at - now) / 1000 + 1;
+					if (next_start_ms < timeout_ms) {
+						timeout_ms = next_start_ms;
+					}
+				}
+			}
+			if (ready_at_start_) {
+				// some tasks were completed while starting them, no need to wait
+				timeout_ms = 0;
+				ready_at_start_ = false;
+			}
+
+			rc = poll(fds_, len_, timeout_ms);
 			
 			if (rc == -1) {
 				if (errno == EINTR) {
@@ -7034,9 +7366,14 @@ public:
 
 			for (unsigned int i = 0; i < len_;) {
 
-				if (mmsds_[i]->task_handler(fds_[i].revents, fds_[i].events) != MySQL_Monitor_State_Data_Task_Result::TASK_RESULT_PENDING) {
+				if (
+					mmsds_[i]->get_task_result() != MySQL_Monitor_State_Data_Task_Result::TASK_RESULT_PENDING ||
+					mmsds_[i]->task_handler(fds_[i].revents, fds_[i].events) != MySQL_Monitor_State_Data_Task_Result::TASK_RESULT_PENDING
+				) {
 #ifdef DEBUG
-					if (mmsds_[i]->get_task_result() != MySQL_Monitor_State_Data_Task_Result::TASK_RESULT_SUCCESS)
+					// connections that failed to be created were never registered
+					if (mmsds_[i]->get_task_result() != MySQL_Monitor_State_Data_Task_Result::TASK_RESULT_SUCCESS
+						&& mmsds_[i]->is_connecting() == false)
 						GloMyMon->My_Conn_Pool->conn_unregister(mmsds_[i]);
 #endif // DEBUG
 					ready_tasks.push_back(mmsds_[i]);
@@ -7052,7 +7389,7 @@ public:
 
 						ready_tasks.clear();
 
-						tasks_to_process_count = len_ * process_ready_task_callback_arg.process_task_percentage_;
+						tasks_to_process_count = (len_ + delayed_.size()) * process_ready_task_callback_arg.process_task_percentage_;
 
 						if (tasks_to_process_count < process_ready_task_callback_arg.min_task_to_process_) {
 							tasks_to_process_count = process_ready_task_callback_arg.min_task_to_process_;
@@ -7061,6 +7398,8 @@ public:
 					continue; 
 				} else {
 					assert(fds_[i].events != 0);
+					// while connecting, the client library can switch to a new socket (e.g. next address)
+					fds_[i].fd = mysql_get_socket(mmsds_[i]->mysql);
 				}
 
 				fds_[i].revents = 0;
@@ -7078,16 +7417,47 @@ public:
 	}
 
 private:
+	struct delayed_task_t {
+		unsigned long long start_at;
+		short events;
+		MySQL_Monitor_State_Data* mmsd;
+	};
+
 	static unsigned int near_pow_2(unsigned int n) {
 		unsigned int i = 1;
 		while (i < n) i <<= 1;
 		return i ? i : n;
 	}
 
+	void start(short _events, MySQL_Monitor_State_Data* mmsd) {
+		if (len_ == capacity_) {
+			expand(1);
+		}
+
+		if (mmsd->mysql) {
+			mmsd->init_async();
+		} else {
+			mmsd->init_async_connect();
+		}
+
+		fds_[len_].events = _events;
+		fds_[len_].revents = 0;
+		mmsds_[len_] = mmsd;
+
+		if (mmsd->task_handler(-1, fds_[len_].events) != MySQL_Monitor_State_Data_Task_Result::TASK_RESULT_PENDING) {
+			ready_at_start_ = true;
+		}
+		fds_[len_].fd = mysql_get_socket(mmsd->mysql);
+		len_++;
+	}
+
 	unsigned int len_;
 	unsigned int capacity_;
 	struct pollfd* fds_;
 	MySQL_Monitor_State_Data** mmsds_;
+	unsigned long long max_start_delay_us_;
+	std::vector<delayed_task_t> delayed_;
+	bool ready_at_start_;
 };
 
 MySQL_Monitor_State_Data_Task_Result MySQL_Monitor_State_Data::task_handler(short event_, short& wait_event) {
@@ -7118,6 +7488,97 @@ MySQL_Monitor_State_Data_Task_Result MySQL_Monitor_State_Data::task_handler(shor
 	return task_result_;
 }
 
+MySQL_Monitor_State_Data_Task_Result MySQL_Monitor_State_Data::connect_handler(short event_, short& wait_event) {
+	MySQL_Monitor_State_Data_Task_Result result = MySQL_Monitor_State_Data_Task_Result::TASK_RESULT_PENDING;
+	MYSQL* ret_mysql = NULL;
+	int status = 0;
+
+__again:
+	proxy_debug(PROXY_DEBUG_MYSQL_PROTOCOL, 6, "async_state_machine=%d\n", async_state_machine_);
+	switch (async_state_machine_) {
+	case ASYNC_CONNECT_START:
+		t1 = monotonic_time();
+		task_expiry_time_ = t1 + (unsigned long long)task_timeout_ * 1000;
+		if (mysql_error_msg) {
+			free(mysql_error_msg);
+			mysql_error_msg = NULL;
+		}
+		if (port) {
+			status = mysql_real_connect_start(&ret_mysql, mysql, connect_host_.c_str(), mysql_thread___monitor_username,
+				mysql_thread___monitor_password, NULL, port, NULL, 0);
+		} else {
+			status = mysql_real_connect_start(&ret_mysql, mysql, connect_host_.c_str(), mysql_thread___monitor_username,
+				mysql_thread___monitor_password, NULL, 0, hostname, 0);
+		}
+		if (status) {
+			wait_event = next_event(ASYNC_CONNECT_CONT, status);
+		} else {
+			NEXT_IMMEDIATE(ASYNC_CONNECT_END);
+		}
+		break;
+	case ASYNC_CONNECT_CONT:
+		status = mysql_real_connect_cont(&ret_mysql, mysql, mysql_status(event_));
+
+		if (status) {
+			wait_event = next_event(ASYNC_CONNECT_CONT, status);
+		} else {
+			NEXT_IMMEDIATE(ASYNC_CONNECT_END);
+		}
+		break;
+	case ASYNC_CONNECT_END:
+		t2 = monotonic_time();
+		if (ret_mysql == NULL) {
+			// port == 0 means we are connecting to a unix socket
+			if (port) {
+				MySQL_Monitor::remove_dns_record_from_dns_cache(hostname);
+			}
+			if (task_id_ == MON_CONNECT || task_id_ == MON_PING) {
+				mysql_error_msg = strdup(mysql_error(mysql));
+			} else {
+				// same error reported by the 'monitor_*_thread' checks, see 'monitor_read_only_error_is_timeout'
+				const string err_msg { "timeout on creating new connection: " + string(mysql_error(mysql)) };
+				mysql_error_msg = strdup(err_msg.c_str());
+			}
+			MYSQL_OPENSSL_ERROR_CLEAR(mysql);
+			NEXT_IMMEDIATE(ASYNC_CONNECT_FAILED);
+		} else {
+			// mariadb client library disables NONBLOCK for SSL connections ... re-enable it!
+			mysql_options(mysql, MYSQL_OPT_NONBLOCK, 0);
+			int f=fcntl(mysql->net.fd, F_GETFL);
+#ifdef FD_CLOEXEC
+			// asynchronously set also FD_CLOEXEC , this to prevent then when a fork happens the FD are duplicated to new process
+			fcntl(mysql->net.fd, F_SETFL, f|O_NONBLOCK|FD_CLOEXEC);
+#else
+			fcntl(mysql->net.fd, F_SETFL, f|O_NONBLOCK);
+#endif /* FD_CLOEXEC */
+			MySQL_Monitor::update_dns_cache_from_mysql_conn(mysql);
+			NEXT_IMMEDIATE(ASYNC_CONNECT_SUCCESSFUL);
+		}
+		break;
+	case ASYNC_CONNECT_SUCCESSFUL:
+		if (task_id_ == MON_CONNECT) {
+			result = MySQL_Monitor_State_Data_Task_Result::TASK_RESULT_SUCCESS;
+		} else {
+			// the connection is ready, the task can now be performed on it
+			GloMyMon->My_Conn_Pool->conn_register(this);
+			init_async();
+			return (this->*task_handler_)(event_, wait_event);
+		}
+		break;
+	case ASYNC_CONNECT_FAILED:
+		result = MySQL_Monitor_State_Data_Task_Result::TASK_RESULT_FAILED;
+		break;
+	case ASYNC_CONNECT_TIMEOUT:
+		result = MySQL_Monitor_State_Data_Task_Result::TASK_RESULT_TIMEOUT;
+		break;
+	default:
+		assert(0);
+		break;
+	}
+
+	return result;
+}
+
 MySQL_Monitor_State_Data_Task_Result MySQL_Monitor_State_Data::ping_handler(short event_, short& wait_event) {
 	MySQL_Monitor_State_Data_Task_Result result = MySQL_Monitor_State_Data_Task_Result::TASK_RESULT_PENDING;
 	int status = 0;
@@ -7216,21 +7677,24 @@ bool MySQL_Monitor::monitor_ping_process_ready_tasks(const std::vector<MySQL_Mon
 			return false;
 		}
 
-		sqlite3_stmt* statement = NULL;
-		const char* query = "INSERT OR REPLACE INTO mysql_server_ping_log VALUES (?1 , ?2 , ?3 , ?4 , ?5)";
-		int rc = mmsd->mondb->prepare_v2(query, &statement);
-		ASSERT_SQLITE_OK(rc, mmsd->mondb);
-		rc = (*proxy_sqlite3_bind_text)(statement, 1, mmsd->hostname, -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-		rc = (*proxy_sqlite3_bind_int)(statement, 2, mmsd->port); ASSERT_SQLITE_OK(rc, mmsd->mondb);
+		// a ping much slower than the previous ones is a sign of trouble, as an error is
+		bool stable = (task_result == MySQL_Monitor_State_Data_Task_Result::TASK_RESULT_SUCCESS);
+		if (stable) {
+			long long avg_ping_us = ping_log.get_avg_success_time(mmsd->hostname, mmsd->port, 3);
+			stable = monitor_latency_is_stable(avg_ping_us, mmsd->t2 - mmsd->t1);
+		}
+		ping_schedule.update(mmsd->hostname, mmsd->port, mmsd->t2, mysql_thread___monitor_ping_interval, stable);
+		if (stable == false) {
+			// read_only and replication lag are checked again at the base interval too
+			expedite_checks(mmsd->hostname, mmsd->port);
+		}
+
 		unsigned long long time_now = realtime_time();
 		time_now = time_now - (mmsd->t2 - mmsd->t1);
-		rc = (*proxy_sqlite3_bind_int64)(statement, 3, time_now); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-		rc = (*proxy_sqlite3_bind_int64)(statement, 4, (mmsd->mysql_error_msg ? 0 : mmsd->t2 - mmsd->t1)); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-		rc = (*proxy_sqlite3_bind_text)(statement, 5, mmsd->mysql_error_msg, -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-		SAFE_SQLITE3_STEP2(statement);
-		rc = (*proxy_sqlite3_clear_bindings)(statement); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-		rc = (*proxy_sqlite3_reset)(statement); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-		(*proxy_sqlite3_finalize)(statement);
+		ping_log.add_entry(
+			mmsd->hostname, mmsd->port, time_now, (mmsd->mysql_error_msg ? 0 : mmsd->t2 - mmsd->t1), false, 0,
+			mmsd->mysql_error_msg, monitor_ping_error_is_failure(mmsd->mysql_error_msg)
+		);
 	}
 
 	return true;
@@ -7241,24 +7705,23 @@ void MySQL_Monitor::monitor_ping_async(SQLite3_result* resultset) {
 
 	std::vector<std::unique_ptr<MySQL_Monitor_State_Data>> mmsds;
 	mmsds.reserve(resultset->rows_count);
-	Monitor_Poll monitor_poll(resultset->rows_count);
+	Monitor_Poll monitor_poll(resultset->rows_count, monitor_checks_jitter_us(mysql_thread___monitor_ping_interval));
+	const unsigned long long loop_start = monotonic_time();
 
 	for (std::vector<SQLite3_row*>::iterator it = resultset->rows.begin(); it != resultset->rows.end(); ++it) {
 		const SQLite3_row* r = *it;
+		if (ping_schedule.is_due(r->fields[0], atoi(r->fields[1]), loop_start) == false) {
+			continue;
+		}
 		std::unique_ptr<MySQL_Monitor_State_Data> mmsd(
 			new MySQL_Monitor_State_Data(MON_PING, r->fields[0], atoi(r->fields[1]), atoi(r->fields[2])));
 
 		mmsd->mondb = monitordb;
 		mmsd->mysql = My_Conn_Pool->get_connection(mmsd->hostname, mmsd->port, mmsd.get());
 
-		if (mmsd->mysql) {
-			monitor_poll.add((POLLIN|POLLOUT|POLLPRI), mmsd.get());
-			mmsds.push_back(std::move(mmsd));
-		} else {
-			WorkItem<MySQL_Monitor_State_Data>* item
-				= new WorkItem<MySQL_Monitor_State_Data>(mmsd.release(), monitor_ping_thread);
-			queue->add(item);
-		}
+		// without a pooled connection, a new one is created asynchronously by 'monitor_poll'
+		monitor_poll.add((POLLIN|POLLOUT|POLLPRI), mmsd.get());
+		mmsds.push_back(std::move(mmsd));
 
 		if (shutdown) return;
 	}
@@ -7416,17 +7879,10 @@ bool MySQL_Monitor::monitor_read_only_process_ready_tasks(const std::vector<MySQ
 			return false;
 		}
 
-		sqlite3_stmt* statement = NULL;
-		const char* query = (char*)"INSERT OR REPLACE INTO mysql_server_read_only_log VALUES (?1 , ?2 , ?3 , ?4 , ?5 , ?6)";
-		int rc = mmsd->mondb->prepare_v2(query, &statement);
-		ASSERT_SQLITE_OK(rc, mmsd->mondb);
 		int read_only = 1; // as a safety mechanism , read_only=1 is the default
-		rc = (*proxy_sqlite3_bind_text)(statement, 1, mmsd->hostname, -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-		rc = (*proxy_sqlite3_bind_int)(statement, 2, mmsd->port); ASSERT_SQLITE_OK(rc, mmsd->mondb);
+		bool has_read_only = false;
 		unsigned long long time_now = realtime_time();
 		time_now = time_now - (mmsd->t2 - mmsd->t1);
-		rc = (*proxy_sqlite3_bind_int64)(statement, 3, time_now); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-		rc = (*proxy_sqlite3_bind_int64)(statement, 4, (mmsd->mysql_error_msg ? 0 : mmsd->t2 - mmsd->t1)); ASSERT_SQLITE_OK(rc, mmsd->mondb);
 		if (mmsd->interr == 0 && mmsd->result) {
 			int num_fields = 0;
 			int k = 0;
@@ -7452,7 +7908,7 @@ VALGRIND_ENABLE_ERROR_REPORTING;
 					}
 				}
 
-				rc = (*proxy_sqlite3_bind_int64)(statement, 5, read_only); ASSERT_SQLITE_OK(rc, mmsd->mondb);
+				has_read_only = true;
 			} else if (fields && mmsd->get_task_type() == MON_READ_ONLY__AND__AWS_RDS_TOPOLOGY_DISCOVERY) {
 				// Process the read_only field as above and store the first server
 				vector<MYSQL_ROW> discovered_servers;
@@ -7487,55 +7943,44 @@ VALGRIND_ENABLE_ERROR_REPORTING;
 				}
 			} else {
 				proxy_error("mysql_fetch_fields returns NULL, or mysql_num_fields is incorrect. Server %s:%d . See bug #1994\n", mmsd->hostname, mmsd->port);
-				rc = (*proxy_sqlite3_bind_null)(statement, 5); ASSERT_SQLITE_OK(rc, mmsd->mondb);
 			}
 			mysql_free_result(mmsd->result);
 			mmsd->result = NULL;
-		} else {
-			rc = (*proxy_sqlite3_bind_null)(statement, 5); ASSERT_SQLITE_OK(rc, mmsd->mondb);
 		}
 		if (mmsd->result) {
 			// make sure it is clear
 			mysql_free_result(mmsd->result);
 			mmsd->result = NULL;
 		}
-		rc = (*proxy_sqlite3_bind_text)(statement, 6, mmsd->mysql_error_msg, -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-		SAFE_SQLITE3_STEP2(statement);
-		rc = (*proxy_sqlite3_clear_bindings)(statement); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-		rc = (*proxy_sqlite3_reset)(statement); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-		(*proxy_sqlite3_finalize)(statement);
+		// a check is stable if it succeeded and read_only didn't change: a server switching role is
+		// checked again at the base interval, as the failover may not be complete
+		bool read_only_stable = (has_read_only && mmsd->mysql_error_msg == NULL);
+		if (read_only_stable) {
+			long long prev_read_only = 0;
+			if (read_only_log.get_last_value(mmsd->hostname, mmsd->port, prev_read_only)) {
+				read_only_stable = (prev_read_only == read_only);
+			}
+		}
+		read_only_log.add_entry(
+			mmsd->hostname, mmsd->port, time_now, (mmsd->mysql_error_msg ? 0 : mmsd->t2 - mmsd->t1), has_read_only, read_only,
+			mmsd->mysql_error_msg, monitor_read_only_error_is_timeout(has_read_only, mmsd->mysql_error_msg)
+		);
+		read_only_schedule.update(
+			mmsd->hostname, mmsd->port, mmsd->t2, mysql_thread___monitor_read_only_interval, read_only_stable
+		);
 
 		if (task_result == MySQL_Monitor_State_Data_Task_Result::TASK_RESULT_SUCCESS) {
 			//MyHGM->read_only_action_v2(mmsd->hostname, mmsd->port, read_only); // default behavior
 			mysql_servers.push_back( std::tuple<std::string,int,int> { mmsd->hostname, mmsd->port, read_only });
 		} else {
-			char* error = NULL;
-			int cols = 0;
-			int affected_rows = 0;
-			SQLite3_result* resultset = NULL;
-			char* new_query = NULL;
-			SQLite3DB* mondb = mmsd->mondb;
-			new_query = (char*)"SELECT 1 FROM (SELECT hostname,port,read_only,error FROM mysql_server_read_only_log WHERE hostname='%s' AND port='%d' ORDER BY time_start_us DESC LIMIT %d) a WHERE read_only IS NULL AND SUBSTR(error,1,7) = 'timeout' GROUP BY hostname,port HAVING COUNT(*)=%d";
-			char* buff = (char*)malloc(strlen(new_query) + strlen(mmsd->hostname) + 32);
 			int max_failures = mysql_thread___monitor_read_only_max_timeout_count;
-			sprintf(buff, new_query, mmsd->hostname, mmsd->port, max_failures, max_failures);
-			mondb->execute_statement(buff, &error, &cols, &affected_rows, &resultset);
-			if (!error) {
-				if (resultset) {
-					if (resultset->rows_count) {
-						// disable host
-						proxy_error("Server %s:%d missed %d read_only checks. Assuming read_only=1\n", mmsd->hostname, mmsd->port, max_failures);
-						MyHGM->p_update_mysql_error_counter(p_mysql_error_type::proxysql, mmsd->hostgroup_id, mmsd->hostname, mmsd->port, ER_PROXYSQL_READ_ONLY_CHECKS_MISSED);
-						//MyHGM->read_only_action_v2(mmsd->hostname, mmsd->port, read_only); // N timeouts reached
-						mysql_servers.push_back( std::tuple<std::string,int,int> { mmsd->hostname, mmsd->port, read_only });
-					}
-					delete resultset;
-					resultset = NULL;
-				}
-			} else {
-				proxy_error("Error on %s : %s\n", buff, error);
+			if (read_only_log.get_consecutive_failures(mmsd->hostname, mmsd->port) >= (unsigned int)max_failures) {
+				// disable host
+				proxy_error("Server %s:%d missed %d read_only checks. Assuming read_only=1\n", mmsd->hostname, mmsd->port, max_failures);
+				MyHGM->p_update_mysql_error_counter(p_mysql_error_type::proxysql, mmsd->hostgroup_id, mmsd->hostname, mmsd->port, ER_PROXYSQL_READ_ONLY_CHECKS_MISSED);
+				//MyHGM->read_only_action_v2(mmsd->hostname, mmsd->port, read_only); // N timeouts reached
+				mysql_servers.push_back( std::tuple<std::string,int,int> { mmsd->hostname, mmsd->port, read_only });
 			}
-			free(buff);
 		}
 	}
 
@@ -7550,10 +7995,14 @@ void MySQL_Monitor::monitor_read_only_async(SQLite3_result* resultset, bool do_d
 
 	std::vector<std::unique_ptr<MySQL_Monitor_State_Data>> mmsds;
 	mmsds.reserve(resultset->rows_count);
-	Monitor_Poll monitor_poll(resultset->rows_count);
+	Monitor_Poll monitor_poll(resultset->rows_count, monitor_checks_jitter_us(mysql_thread___monitor_read_only_interval));
+	const unsigned long long loop_start = monotonic_time();
 
 	for (std::vector<SQLite3_row*>::iterator it = resultset->rows.begin(); it != resultset->rows.end(); ++it) {
 		const SQLite3_row* r = *it;
+		if (read_only_schedule.is_due(r->fields[0], atoi(r->fields[1]), loop_start) == false) {
+			continue;
+		}
 		bool rc_ping = server_responds_to_ping(r->fields[0], atoi(r->fields[1]));
 		if (rc_ping) { // only if server is responding to pings
 			MySQL_Monitor_State_Data_Task_Type task_type = MON_READ_ONLY;
@@ -7583,14 +8032,9 @@ void MySQL_Monitor::monitor_read_only_async(SQLite3_result* resultset, bool do_d
 			mmsd->mondb = monitordb;
 			mmsd->mysql = My_Conn_Pool->get_connection(mmsd->hostname, mmsd->port, mmsd.get());
 
-			if (mmsd->mysql) {
-				monitor_poll.add((POLLIN|POLLOUT|POLLPRI), mmsd.get());
-				mmsds.push_back(std::move(mmsd));
-			} else {
-				WorkItem<MySQL_Monitor_State_Data>* item = 
-					new WorkItem<MySQL_Monitor_State_Data>(mmsd.release(), monitor_read_only_thread);
-				queue->add(item);
-			}
+			// without a pooled connection, a new one is created asynchronously by 'monitor_poll'
+			monitor_poll.add((POLLIN|POLLOUT|POLLPRI), mmsd.get());
+			mmsds.push_back(std::move(mmsd));
 		}
 
 		if (shutdown) return;
@@ -7773,7 +8217,7 @@ void MySQL_Monitor::monitor_group_replication_async() {
 	pthread_mutex_lock(&group_replication_mutex);
 	assert(Group_Replication_Hosts_resultset);
 	mmsds.reserve(Group_Replication_Hosts_resultset->rows_count);
-	Monitor_Poll monitor_poll(Group_Replication_Hosts_resultset->rows_count);
+	Monitor_Poll monitor_poll(Group_Replication_Hosts_resultset->rows_count, monitor_checks_jitter_us(mysql_thread___monitor_groupreplication_healthcheck_interval));
 
 	for (std::vector<SQLite3_row*>::iterator it = Group_Replication_Hosts_resultset->rows.begin(); it != Group_Replication_Hosts_resultset->rows.end(); ++it) {
 		const SQLite3_row* r = *it;
@@ -7789,14 +8233,9 @@ void MySQL_Monitor::monitor_group_replication_async() {
 			mmsd->mondb = monitordb;
 			mmsd->mysql = My_Conn_Pool->get_connection(mmsd->hostname, mmsd->port, mmsd.get());
 
-			if (mmsd->mysql) {
-				monitor_poll.add((POLLIN|POLLOUT|POLLPRI), mmsd.get());
-				mmsds.push_back(std::move(mmsd));
-			} else {
-				WorkItem<MySQL_Monitor_State_Data>* item =
-					new WorkItem<MySQL_Monitor_State_Data>(mmsd.release(), monitor_group_replication_thread);
-				queue->add(item);
-			}
+			// without a pooled connection, a new one is created asynchronously by 'monitor_poll'
+			monitor_poll.add((POLLIN|POLLOUT|POLLPRI), mmsd.get());
+			mmsds.push_back(std::move(mmsd));
 		}
 
 		if (shutdown) {
@@ -7881,19 +8320,11 @@ bool MySQL_Monitor::monitor_replication_lag_process_ready_tasks(const std::vecto
 			return false;
 		}
 
-		sqlite3_stmt* statement = NULL;
-		const char* query = (char*)"INSERT OR REPLACE INTO mysql_server_replication_lag_log VALUES (?1 , ?2 , ?3 , ?4 , ?5 , ?6)";
-		int rc = mmsd->mondb->prepare_v2(query, &statement);
-		ASSERT_SQLITE_OK(rc, mmsd->mondb);
 		// 'replication_lag' to be feed to 'replication_lag_action'
 		int repl_lag = -2;
 		bool override_repl_lag = true;
-		rc = (*proxy_sqlite3_bind_text)(statement, 1, mmsd->hostname, -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-		rc = (*proxy_sqlite3_bind_int)(statement, 2, mmsd->port); ASSERT_SQLITE_OK(rc, mmsd->mondb);
 		unsigned long long time_now = realtime_time();
 		time_now = time_now - (mmsd->t2 - mmsd->t1);
-		rc = (*proxy_sqlite3_bind_int64)(statement, 3, time_now); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-		rc = (*proxy_sqlite3_bind_int64)(statement, 4, (mmsd->mysql_error_msg ? 0 : mmsd->t2 - mmsd->t1)); ASSERT_SQLITE_OK(rc, mmsd->mondb);
 		if (mmsd->interr == 0 && mmsd->result) {
 			int num_fields = 0;
 			int k = 0;
@@ -7933,28 +8364,24 @@ bool MySQL_Monitor::monitor_replication_lag_process_ready_tasks(const std::vecto
 						}
 					}
 				}
-				if (/*repl_lag >= 0 ||*/ override_repl_lag == false) {
-					rc = (*proxy_sqlite3_bind_int64)(statement, 5, repl_lag); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-				} else {
-					rc = (*proxy_sqlite3_bind_null)(statement, 5); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-				}
 			} else {
 				proxy_error("mysql_fetch_fields returns NULL, or mysql_num_fields is incorrect. Server %s:%d . See bug #1994\n", mmsd->hostname, mmsd->port);
-				rc = (*proxy_sqlite3_bind_null)(statement, 5); ASSERT_SQLITE_OK(rc, mmsd->mondb);
 			}
 			mysql_free_result(mmsd->result);
 			mmsd->result = NULL;
 		} else {
-			rc = (*proxy_sqlite3_bind_null)(statement, 5); ASSERT_SQLITE_OK(rc, mmsd->mondb);
 			// 'replication_lag_check' timed out, we set 'repl_lag' to '-3' to avoid server to be 're-enabled'.
 			repl_lag = -3;
 		}
-		rc = (*proxy_sqlite3_bind_text)(statement, 6, mmsd->mysql_error_msg, -1, SQLITE_TRANSIENT); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-		SAFE_SQLITE3_STEP2(statement);
-		rc = (*proxy_sqlite3_clear_bindings)(statement); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-		rc = (*proxy_sqlite3_reset)(statement); ASSERT_SQLITE_OK(rc, mmsd->mondb);
-		//MyHGM->replication_lag_action(mmsd->hostgroup_id, mmsd->hostname, mmsd->port, repl_lag);
-		(*proxy_sqlite3_finalize)(statement);
+		replication_lag_log.add_entry(
+			mmsd->hostname, mmsd->port, time_now, (mmsd->mysql_error_msg ? 0 : mmsd->t2 - mmsd->t1),
+			(override_repl_lag == false), repl_lag, mmsd->mysql_error_msg, (mmsd->mysql_error_msg != NULL)
+		);
+		// lagging replicas keep being checked at every interval
+		replication_lag_schedule.update(
+			mmsd->hostname, mmsd->port, mmsd->t2, mysql_thread___monitor_replication_lag_interval,
+			(override_repl_lag == false && repl_lag == 0)
+		);
 		mysql_servers.push_back( replication_lag_server_t { mmsd->hostgroup_id, mmsd->hostname, mmsd->port, repl_lag, override_repl_lag });
 	}
 
@@ -7969,10 +8396,14 @@ void MySQL_Monitor::monitor_replication_lag_async(SQLite3_result* resultset) {
 
 	std::vector<std::unique_ptr<MySQL_Monitor_State_Data>> mmsds;
 	mmsds.reserve(resultset->rows_count);
-	Monitor_Poll monitor_poll(resultset->rows_count);
+	Monitor_Poll monitor_poll(resultset->rows_count, monitor_checks_jitter_us(mysql_thread___monitor_replication_lag_interval));
+	const unsigned long long loop_start = monotonic_time();
 
 	for (std::vector<SQLite3_row*>::iterator it = resultset->rows.begin(); it != resultset->rows.end(); ++it) {
 		const SQLite3_row* r = *it;
+		if (replication_lag_schedule.is_due(r->fields[1], atoi(r->fields[2]), loop_start) == false) {
+			continue;
+		}
 		bool rc_ping = server_responds_to_ping(r->fields[1], atoi(r->fields[2]));
 		if (rc_ping) { // only if server is responding to pings
 
@@ -7983,14 +8414,9 @@ void MySQL_Monitor::monitor_replication_lag_async(SQLite3_result* resultset) {
 			mmsd->mondb = monitordb;
 			mmsd->mysql = My_Conn_Pool->get_connection(mmsd->hostname, mmsd->port, mmsd.get());
 
-			if (mmsd->mysql) {
-				monitor_poll.add((POLLIN|POLLOUT|POLLPRI), mmsd.get());
-				mmsds.push_back(std::move(mmsd));
-			} else {
-				WorkItem<MySQL_Monitor_State_Data>* item =
-					new WorkItem<MySQL_Monitor_State_Data>(mmsd.release(), monitor_replication_lag_thread);
-				queue->add(item);
-			}
+			// without a pooled connection, a new one is created asynchronously by 'monitor_poll'
+			monitor_poll.add((POLLIN|POLLOUT|POLLPRI), mmsd.get());
+			mmsds.push_back(std::move(mmsd));
 		}
 
 		if (shutdown) return;
@@ -8270,7 +8696,7 @@ void MySQL_Monitor::monitor_galera_async() {
 	pthread_mutex_lock(&galera_mutex);
 	assert(Galera_Hosts_resultset);
 	mmsds.reserve(Galera_Hosts_resultset->rows_count);
-	Monitor_Poll monitor_poll(Galera_Hosts_resultset->rows_count);
+	Monitor_Poll monitor_poll(Galera_Hosts_resultset->rows_count, monitor_checks_jitter_us(mysql_thread___monitor_galera_healthcheck_interval));
 
 	for (std::vector<SQLite3_row*>::iterator it = Galera_Hosts_resultset->rows.begin(); it != Galera_Hosts_resultset->rows.end(); ++it) {
 		const SQLite3_row* r = *it;
@@ -8291,14 +8717,9 @@ void MySQL_Monitor::monitor_galera_async() {
 			mmsd->max_transactions_behind = atoi(r->fields[5]);
 			mmsd->mondb = monitordb;
 
-			if (mmsd->mysql) {
-				monitor_poll.add((POLLIN|POLLOUT|POLLPRI), mmsd.get());
-				mmsds.push_back(std::move(mmsd));
-			} else {
-				WorkItem<MySQL_Monitor_State_Data>* item =
-					new WorkItem<MySQL_Monitor_State_Data>(mmsd.release(), monitor_galera_thread);
-				queue->add(item);
-			}
+			// without a pooled connection, a new one is created asynchronously by 'monitor_poll'
+			monitor_poll.add((POLLIN|POLLOUT|POLLPRI), mmsd.get());
+			mmsds.push_back(std::move(mmsd));
 		}
 
 		if (shutdown) {
@@ -8315,5 +8736,78 @@ void MySQL_Monitor::monitor_galera_async() {
 	}
 }
 
+bool MySQL_Monitor::monitor_connect_process_ready_tasks(const std::vector<MySQL_Monitor_State_Data*>& mmsds) {
+
+	for (auto& mmsd : mmsds) {
+
+		const auto task_result = mmsd->get_task_result();
+
+		assert(task_result != MySQL_Monitor_State_Data_Task_Result::TASK_RESULT_PENDING);
+
+		if (task_result == MySQL_Monitor_State_Data_Task_Result::TASK_RESULT_SUCCESS) {
+			__sync_fetch_and_add(&connect_check_OK, 1);
+		} else {
+			__sync_fetch_and_add(&connect_check_ERR, 1);
+			if (task_result == MySQL_Monitor_State_Data_Task_Result::TASK_RESULT_TIMEOUT) {
+				proxy_error("Timeout on connect check for %s:%d after %lldms. If the server is overload, increase mysql-monitor_connect_timeout.\n", mmsd->hostname, mmsd->port, (mmsd->t2 - mmsd->t1) / 1000);
+			} else if (
+				(strncmp(mmsd->mysql_error_msg,"Access denied for user",strlen("Access denied for user"))==0)
+				||
+				(strncmp(mmsd->mysql_error_msg,"ProxySQL Error: Access denied for user",strlen("ProxySQL Error: Access denied for user"))==0)
+			) {
+				proxy_error("Server %s:%d is returning \"Access denied\" for monitoring user\n", mmsd->hostname, mmsd->port);
+			} else if (strncmp(mmsd->mysql_error_msg,"Your password has expired.",strlen("Your password has expired."))==0) {
+				proxy_error("Server %s:%d is returning \"Your password has expired.\" for monitoring user\n", mmsd->hostname, mmsd->port);
+			}
+			MyHGM->p_update_mysql_error_counter(p_mysql_error_type::proxysql, mmsd->hostgroup_id, mmsd->hostname, mmsd->port, mysql_errno(mmsd->mysql));
+		}
+		// the connection was only created for the check
+		mysql_close(mmsd->mysql);
+		mmsd->mysql = NULL;
+
+		if (shutdown == true) {
+			return false;
+		}
+
+		unsigned long long time_now = realtime_time();
+		time_now = time_now - (mmsd->t2 - mmsd->t1);
+		connect_log.add_entry(
+			mmsd->hostname, mmsd->port, time_now, (mmsd->mysql_error_msg ? 0 : mmsd->t2 - mmsd->t1), false, 0,
+			mmsd->mysql_error_msg, (mmsd->mysql_error_msg != NULL)
+		);
+	}
+
+	return true;
+}
+
+void MySQL_Monitor::monitor_connect_async(SQLite3_result* resultset) {
+	assert(resultset);
+
+	std::vector<std::unique_ptr<MySQL_Monitor_State_Data>> mmsds;
+	mmsds.reserve(resultset->rows_count);
+	Monitor_Poll monitor_poll(resultset->rows_count, monitor_checks_jitter_us(mysql_thread___monitor_connect_interval));
+
+	for (std::vector<SQLite3_row*>::iterator it = resultset->rows.begin(); it != resultset->rows.end(); ++it) {
+		const SQLite3_row* r = *it;
+		bool rc_ping = server_responds_to_ping(r->fields[0], atoi(r->fields[1]));
+		if (rc_ping) { // only if server is responding to pings
+			std::unique_ptr<MySQL_Monitor_State_Data> mmsd(
+				new MySQL_Monitor_State_Data(MON_CONNECT, r->fields[0], atoi(r->fields[1]), atoi(r->fields[2])));
+
+			mmsd->mondb = monitordb;
+			monitor_poll.add((POLLIN|POLLOUT|POLLPRI), mmsd.get());
+			mmsds.push_back(std::move(mmsd));
+		}
+
+		if (shutdown) return;
+	}
+
+	Monitor_Poll::Process_Ready_Task_Callback_Args args(5, 50, &MySQL_Monitor::monitor_connect_process_ready_tasks, this);
+
+	if (monitor_poll.event_loop(mysql_thread___monitor_connect_timeout, args) == false) {
+		return;
+	}
+}
+
 template class WorkItem<MySQL_Monitor_State_Data>;
 template class WorkItem<DNS_Resolve_Data>;
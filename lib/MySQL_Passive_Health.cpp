@@ -0,0 +1,153 @@
+#include <cstddef>
+
+#include "MySQL_Passive_Health.h"
+
+// stripe used by the current thread, assigned round-robin on first use
+static std::atomic<unsigned int> passive_health_next_stripe { 0 };
+static __thread int passive_health_stripe = -1;
+
+static inline unsigned int get_stripe() {
+	if (passive_health_stripe == -1) {
+		passive_health_stripe = passive_health_next_stripe.fetch_add(1, std::memory_order_relaxed) % PASSIVE_HEALTH_STRIPES;
+	}
+	return passive_health_stripe;
+}
+
+static inline unsigned int latency_bucket(unsigned long long time_us) {
+	unsigned int b = 0;
+	while (time_us > 1 && b < PASSIVE_HEALTH_LATENCY_BUCKETS - 1) {
+		time_us >>= 1;
+		b++;
+	}
+	return b;
+}
+
+MySQL_Passive_Health::MySQL_Passive_Health() {
+	for (unsigned int s = 0; s < PASSIVE_HEALTH_STRIPES; s++) {
+		for (unsigned int w = 0; w < 2; w++) {
+			window_t& win = stripes[s].windows[w];
+			win.id = 0;
+			win.queries = 0;
+			win.errors = 0;
+			for (unsigned int b = 0; b < PASSIVE_HEALTH_LATENCY_BUCKETS; b++) {
+				win.latency[b] = 0;
+			}
+		}
+	}
+	last_completed_window = 0;
+	latency_us = 0;
+}
+
+MySQL_Passive_Health::window_t& MySQL_Passive_Health::get_window(unsigned long long id) {
+	window_t& win = stripes[get_stripe()].windows[id & 1];
+	if (win.id.load(std::memory_order_relaxed) != id) {
+		// first write of this thread in the window: discard the values of two windows ago
+		win.queries.store(0, std::memory_order_relaxed);
+		win.errors.store(0, std::memory_order_relaxed);
+		for (unsigned int b = 0; b < PASSIVE_HEALTH_LATENCY_BUCKETS; b++) {
+			win.latency[b].store(0, std::memory_order_relaxed);
+		}
+		win.id.store(id, std::memory_order_release);
+	}
+	return win;
+}
+
+void MySQL_Passive_Health::sum_window(unsigned long long id, unsigned int& queries, unsigned int& errors, unsigned int *latency) {
+	queries = 0;
+	errors = 0;
+	for (unsigned int s = 0; s < PASSIVE_HEALTH_STRIPES; s++) {
+		window_t& win = stripes[s].windows[id & 1];
+		if (win.id.load(std::memory_order_acquire) != id) {
+			continue;
+		}
+		queries += win.queries.load(std::memory_order_relaxed);
+		errors += win.errors.load(std::memory_order_relaxed);
+		if (latency) {
+			for (unsigned int b = 0; b < PASSIVE_HEALTH_LATENCY_BUCKETS; b++) {
+				latency[b] += win.latency[b].load(std::memory_order_relaxed);
+			}
+		}
+	}
+}
+
+bool MySQL_Passive_Health::add_query(unsigned long long now, unsigned long long time_us) {
+	const unsigned long long id = now / PASSIVE_HEALTH_WINDOW_US;
+	window_t& win = get_window(id);
+	win.queries.fetch_add(1, std::memory_order_relaxed);
+	win.latency[latency_bucket(time_us)].fetch_add(1, std::memory_order_relaxed);
+	// only one thread gets to evaluate the window that just completed
+	unsigned long long last = last_completed_window.load(std::memory_order_relaxed);
+	return last + 1 < id && last_completed_window.compare_exchange_strong(last, id - 1);
+}
+
+int MySQL_Passive_Health::add_error(unsigned long long now, unsigned int min_queries) {
+	const unsigned long long id = now / PASSIVE_HEALTH_WINDOW_US;
+	window_t& win = get_window(id);
+	win.queries.fetch_add(1, std::memory_order_relaxed);
+	win.errors.fetch_add(1, std::memory_order_relaxed);
+
+	unsigned int queries = 0;
+	unsigned int errors = 0;
+	sum_window(id, queries, errors, NULL);
+	if (queries < min_queries || queries == 0) {
+		return -1;
+	}
+	return (errors * 100) / queries;
+}
+
+unsigned int MySQL_Passive_Health::compute_latency(unsigned long long now, unsigned int percentile) {
+	const unsigned long long id = now / PASSIVE_HEALTH_WINDOW_US;
+	if (id == 0 || percentile == 0) {
+		latency_us.store(0, std::memory_order_relaxed);
+		return 0;
+	}
+	unsigned int queries = 0;
+	unsigned int errors = 0;
+	unsigned int latency[PASSIVE_HEALTH_LATENCY_BUCKETS] = { 0 };
+	sum_window(id - 1, queries, errors, latency);
+
+	unsigned int total = 0;
+	for (unsigned int b = 0; b < PASSIVE_HEALTH_LATENCY_BUCKETS; b++) {
+		total += latency[b];
+	}
+	unsigned int res = 0;
+	if (total) {
+		const unsigned long long target = ((unsigned long long)total * (percentile > 100 ? 100 : percentile) + 99) / 100;
+		unsigned long long count = 0;
+		for (unsigned int b = 0; b < PASSIVE_HEALTH_LATENCY_BUCKETS; b++) {
+			count += latency[b];
+			if (count >= target) {
+				// upper bound of the bucket, conservative for routing
+				res = (b == 0) ? 1 : (1U << (b + 1)) - 1;
+				break;
+			}
+		}
+	}
+	latency_us.store(res, std::memory_order_relaxed);
+	return res;
+}
+
+unsigned int MySQL_Passive_Health::get_latency_us(unsigned long long now) {
+	const unsigned long long id = now / PASSIVE_HEALTH_WINDOW_US;
+	// the value is valid as long as it was computed from the previous window
+	if (last_completed_window.load(std::memory_order_relaxed) + 1 < id) {
+		return 0;
+	}
+	return latency_us.load(std::memory_order_relaxed);
+}
+
+bool MySQL_Passive_Health::is_server_error(int err) {
+	if (err >= 2000 && err < 3000) {
+		// client library errors: lost connection, server gone away, etc.
+		return true;
+	}
+	switch (err) {
+		case 1040: // ER_CON_COUNT_ERROR
+		case 1047: // ER_UNKNOWN_COM_ERROR, i.e. WSREP not ready
+		case 1053: // ER_SERVER_SHUTDOWN
+		case 1927: // ER_CONNECTION_KILLED
+			return true;
+		default:
+			return false;
+	}
+}
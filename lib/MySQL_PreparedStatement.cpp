@@ -63,6 +63,63 @@ void MySQL_STMT_Global_info::compute_hash() {
 	                         query_length);
 }
 
+bool stmt_execute_metadata_t::serialize_binds(uint64_t stmt_hash, std::string& key) const {
+	key.clear();
+	// leading marker, keys for text protocol queries never start with it
+	key.push_back((char)_MYSQL_COM_STMT_EXECUTE);
+	key.append((const char *)&stmt_hash, sizeof(uint64_t));
+	key.append((const char *)&num_params, sizeof(uint16_t));
+	for (uint16_t i=0; i<num_params; i++) {
+		const MYSQL_BIND& bind=binds[i];
+		uint16_t buffer_type=bind.buffer_type;
+		my_bool is_null=(bind.is_null ? *bind.is_null : 0);
+		key.append((const char *)&buffer_type, sizeof(uint16_t));
+		key.push_back((char)bind.is_unsigned);
+		key.push_back((char)is_null);
+		if (is_null) {
+			continue;
+		}
+		if (bind.buffer==NULL) {
+			return false;
+		}
+		uint64_t len=0;
+		switch (bind.buffer_type) {
+			case MYSQL_TYPE_TINY:
+				len=1;
+				break;
+			case MYSQL_TYPE_SHORT:
+			case MYSQL_TYPE_YEAR:
+				len=2;
+				break;
+			case MYSQL_TYPE_FLOAT:
+			case MYSQL_TYPE_LONG:
+			case MYSQL_TYPE_INT24:
+				len=4;
+				break;
+			case MYSQL_TYPE_DOUBLE:
+			case MYSQL_TYPE_LONGLONG:
+				len=8;
+				break;
+			case MYSQL_TYPE_TIME:
+			case MYSQL_TYPE_DATE:
+			case MYSQL_TYPE_TIMESTAMP:
+			case MYSQL_TYPE_DATETIME:
+				// buffers are zeroed MYSQL_TIME structures, see get_binds_from_pkt()
+				len=sizeof(MYSQL_TIME);
+				break;
+			default:
+				if (bind.length==NULL) {
+					return false;
+				}
+				len=*bind.length;
+				key.append((const char *)&len, sizeof(uint64_t));
+				break;
+		}
+		key.append((const char *)bind.buffer, len);
+	}
+	return true;
+}
+
 StmtLongDataHandler::StmtLongDataHandler() { long_datas = new PtrArray(); }
 
 StmtLongDataHandler::~StmtLongDataHandler() {
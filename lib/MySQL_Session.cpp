@@ -23,6 +23,8 @@
 #include "libinjection.h"
 #include "libinjection_sqli.h"
 
+#include <atomic>
+
 #define SELECT_VERSION_COMMENT "select @@version_comment limit 1"
 #define SELECT_VERSION_COMMENT_LEN 32
 #define SELECT_DB_USER "select DATABASE(), USER() limit 1"
@@ -478,11 +480,12 @@ void Query_Info::end() {
 			uint32_t stmt_global_id=0;
 			memcpy(&stmt_global_id,(char *)(stmt_meta->pkt)+5,sizeof(uint32_t));
 			sess->SLDH->reset(stmt_global_id);
-			free(stmt_meta->pkt);
+			l_free(stmt_meta->size,stmt_meta->pkt);
 			stmt_meta->pkt=NULL;
 		}
 		stmt_meta = NULL;
 	}
+	stmt_cache_key.clear();
 }
 
 /**
@@ -689,6 +692,7 @@ void MySQL_Session::set_status(enum session_status e) {
  */
 MySQL_Session::MySQL_Session() {
 	thread_session_id=0;
+	timeout_timer.data=this;
 	//handler_ret = 0;
 	pause_until=0;
 	qpo=new Query_Processor_Output();
@@ -714,6 +718,7 @@ MySQL_Session::MySQL_Session() {
 	handler_function=NULL;
 	client_myds=NULL;
 	to_process=0;
+	queued_to_process=false;
 	mybe=NULL;
 	mirror=false;
 	mirrorPkt.ptr=NULL;
@@ -824,6 +829,11 @@ void MySQL_Session::reset() {
  */
 MySQL_Session::~MySQL_Session() {
 
+	if (status==PREWARMING_SERVER && mybe && mybe->server_myds && mybe->server_myds->myconn) {
+		// the session is destroyed before the pre-opened connection completed, e.g. during
+		// the shutdown of the thread: the connection is no longer being pre-opened
+		__sync_fetch_and_sub(&mybe->server_myds->myconn->parent->prewarm_connecting, 1);
+	}
 	reset(); // we moved this out to allow CHANGE_USER
 
 	if (locked_on_hostgroup >= 0) {
@@ -1052,7 +1062,7 @@ void MySQL_Session::writeout() {
 			}
 			int retbytes=client_myds->write_to_net_poll();
 			total_written+=retbytes;
-			if (retbytes==QUEUE_T_DEFAULT_SIZE) { // optimization to solve memory bloat
+			if (retbytes>=QUEUE_T_DEFAULT_SIZE) { // optimization to solve memory bloat
 				runloop=true;
 			}
 			while (runloop && (disable_throttle || total_written < mwpl)) {
@@ -1067,7 +1077,7 @@ void MySQL_Session::writeout() {
 					if (fds.revents==POLLOUT) {
 						retbytes=client_myds->write_to_net_poll();
 						total_written+=retbytes;
-						if (retbytes==QUEUE_T_DEFAULT_SIZE) { // optimization to solve memory bloat
+						if (retbytes>=QUEUE_T_DEFAULT_SIZE) { // optimization to solve memory bloat
 							runloop=true;
 						}
 					}
@@ -1993,6 +2003,46 @@ int MySQL_Session::handler_again___status_PINGING_SERVER() {
 	return 0;
 }
 
+/**
+ * @brief Handles the connection of a pre-opened backend connection in the PREWARMING_SERVER status.
+ *
+ * Sessions in PREWARMING_SERVER status have no frontend, they are created by
+ * MySQL_Thread::run___prewarm_connections() for the connections planned by
+ * MySQL_HostGroups_Manager::get_prewarm_connections(). Once connected, the connection is returned to the
+ * connection pool, ready to be used by clients. Connection errors are accounted by the connection itself.
+ *
+ * @return -1 if the session should be terminated, 0 otherwise.
+ *
+ * @see MySQL_HostGroups_Manager::get_prewarm_connections()
+ * @see MyHGC::plan_prewarm_connections()
+ */
+int MySQL_Session::handler_again___status_PREWARMING_SERVER() {
+	assert(mybe->server_myds->myconn);
+	MySQL_Data_Stream *myds=mybe->server_myds;
+	MySQL_Connection *myconn=myds->myconn;
+	int rc=myconn->async_connect(myds->revents);
+	if (myds->mypolls==NULL) {
+		// connection yet not in mypolls
+		myds->assign_fd_from_mysql_conn();
+		thread->mypolls.add(POLLIN|POLLOUT, myds->fd, myds, thread->curtime);
+	}
+	if (rc==1) {
+		return 0;
+	}
+	__sync_fetch_and_sub(&myconn->parent->prewarm_connecting, 1);
+	if (rc==0) {
+		myds->DSS=STATE_MARIADB_GENERIC;
+		myds->return_MySQL_Connection_To_Pool();
+	} else {
+		myds->destroy_MySQL_Connection_From_Pool(false);
+		myds->fd=0;
+	}
+	delete mybe->server_myds;
+	mybe->server_myds=NULL;
+	set_status(session_status___NONE);
+	return -1;
+}
+
 /**
  * @brief Handles the process of resetting the connection in the RESETTING_CONNECTION status.
  *
@@ -3235,7 +3285,10 @@ bool MySQL_Session::handler_again___status_CONNECTING_SERVER(int *_rc) {
 				// associated with the socket opened by the library. To prevent this, we need to call
 				// `mysql_real_connect_cont` through `connect_cont`. This way we ensure a proper cleanup of
 				// all the resources when 'mysql_close' is later called. For more context see issue #3404.
-				mybe->server_myds->myconn->connect_cont(MYSQL_WAIT_TIMEOUT);
+				// The connect isn't started yet if the hostname of the server was still being resolved.
+				if (mybe->server_myds->myconn->mysql) {
+					mybe->server_myds->myconn->connect_cont(MYSQL_WAIT_TIMEOUT);
+				}
 				mybe->server_myds->destroy_MySQL_Connection_From_Pool(false);
 				if (mirror) {
 					PROXY_TRACE();
@@ -3285,6 +3338,31 @@ bool MySQL_Session::handler_again___status_CONNECTING_SERVER(int *_rc) {
 		if (mirror) {
 			PROXY_TRACE();
 		}
+		if (myconn->mysql==NULL) {
+			// the connect isn't started yet: the worker thread never waits for the resolution of the hostname
+			switch (MySQL_Monitor::dns_lookup_async(myconn->parent->address, myconn->parent->port)) {
+				case DNS_RESOLVE_PENDING:
+					pause_until=thread->curtime+mysql_thread___connect_retries_delay*1000;
+					*_rc=1;
+					return false;
+				case DNS_RESOLVE_FAILED:
+					{
+						// every connect attempt fails while the failed resolution is cached
+						// shared by all the worker threads: only the thread that updates it logs
+						static std::atomic<time_t> last_dns_error_log { 0 };
+						time_t t = time(NULL);
+						time_t last = last_dns_error_log.load(std::memory_order_relaxed);
+						if (t - last >= 1 && last_dns_error_log.compare_exchange_strong(last, t, std::memory_order_relaxed)) { // log this at most once per second to avoid spamming the logs
+							proxy_error("Failed to resolve hostname of server %u:%s:%d\n", myconn->parent->myhgc->hid, myconn->parent->address, myconn->parent->port);
+						}
+					}
+					myconn->parent->connect_error(2005); // CR_UNKNOWN_HOST
+					rc=-1;
+					goto __handler_again___status_CONNECTING_SERVER_rc;
+				default:
+					break;
+			}
+		}
 		rc=myconn->async_connect(myds->revents);
 		if (myds->mypolls==NULL) {
 			// connection yet not in mypolls
@@ -3294,6 +3372,7 @@ bool MySQL_Session::handler_again___status_CONNECTING_SERVER(int *_rc) {
 				PROXY_TRACE();
 			}
 		}
+__handler_again___status_CONNECTING_SERVER_rc:
 		switch (rc) {
 			case 0:
 				myds->myds_type=MYDS_BACKEND;
@@ -3779,6 +3858,9 @@ void MySQL_Session::handler___status_WAITING_CLIENT_DATA___STATE_SLEEP___MYSQL_C
 		if (rc_break==true) {
 			return;
 		}
+		if (handler___status_WAITING_CLIENT_DATA___STATE_SLEEP___MYSQL_COM_STMT_EXECUTE_QueryCache()) {
+			return;
+		}
 		if (mysql_thread___set_query_lock_on_hostgroup == 1) { // algorithm introduced in 2.0.6
 			if (locked_on_hostgroup < 0) {
 				if (lock_hostgroup) {
@@ -3819,6 +3901,69 @@ void MySQL_Session::handler___status_WAITING_CLIENT_DATA___STATE_SLEEP___MYSQL_C
 	}
 }
 
+/**
+ * @brief Serves a COM_STMT_EXECUTE from the Query Cache, if possible.
+ * @details Binary protocol resultsets are stored in the Query Cache using as
+ *   key the statement global hash plus the serialized bound parameters (see
+ *   'stmt_execute_metadata_t::serialize_binds'). The key is computed only if
+ *   the matching query rule has 'cache_ttl' set, and it is kept in 'CurrentQuery'
+ *   so that 'MySQL_Stmt_Result_to_MySQL_wire' can store the resultset on a miss.
+ *   Executions that open a cursor are never cached.
+ * @return True if the resultset was served from the cache and the request is
+ *   completed, false if the execution needs to be sent to a backend.
+ */
+bool MySQL_Session::handler___status_WAITING_CLIENT_DATA___STATE_SLEEP___MYSQL_COM_STMT_EXECUTE_QueryCache() {
+	stmt_execute_metadata_t *stmt_meta=CurrentQuery.stmt_meta;
+	if (qpo->cache_ttl<=0 || stmt_meta->flags != CURSOR_TYPE_NO_CURSOR) {
+		return false;
+	}
+	if (stmt_meta->serialize_binds(CurrentQuery.stmt_info->hash, CurrentQuery.stmt_cache_key)==false) {
+		CurrentQuery.stmt_cache_key.clear();
+		return false;
+	}
+	bool deprecate_eof_active = client_myds->myconn->options.client_flag & CLIENT_DEPRECATE_EOF;
+	uint32_t resbuf=0;
+	unsigned char *aa=GloQC->get(
+		client_myds->myconn->userinfo->hash,
+		(const unsigned char *)CurrentQuery.stmt_cache_key.data(),
+		CurrentQuery.stmt_cache_key.length(),
+		&resbuf ,
+		thread->curtime/1000 ,
+		qpo->cache_ttl,
+		deprecate_eof_active
+	);
+	if (aa==NULL) {
+		return false;
+	}
+	client_myds->buffer2resultset(aa,resbuf);
+	free(aa);
+	client_myds->PSarrayOUT->copy_add(client_myds->resultset,0,client_myds->resultset->len);
+	while (client_myds->resultset->len) client_myds->resultset->remove_index(client_myds->resultset->len-1,NULL);
+	if (transaction_persistent_hostgroup == -1) {
+		// not active, we can change it
+		current_hostgroup=-1;
+	}
+	// free the buffers allocated by get_binds_from_pkt() , as handler_rc0_PROCESSING_STMT_EXECUTE() would do
+	for (int i = 0; i < stmt_meta->num_params; i++) {
+		enum enum_field_types buffer_type = stmt_meta->binds[i].buffer_type;
+		if (
+			(buffer_type == MYSQL_TYPE_TIME) ||
+			(buffer_type == MYSQL_TYPE_DATE) ||
+			(buffer_type == MYSQL_TYPE_TIMESTAMP) ||
+			(buffer_type == MYSQL_TYPE_DATETIME)
+		) {
+			free(stmt_meta->binds[i].buffer);
+			stmt_meta->binds[i].buffer = NULL;
+		}
+	}
+	// the request is handled as an executed prepared statement: LogQuery()
+	// is called here, and RequestEnd() frees the packet through CurrentQuery.end()
+	status=PROCESSING_STMT_EXECUTE;
+	LogQuery(NULL);
+	RequestEnd(NULL);
+	return true;
+}
+
 // this function was inline inside MySQL_Session::get_pkts_from_client
 // ClickHouse doesn't support COM_INIT_DB , so we replace it
 // with a COM_QUERY running USE
@@ -4792,7 +4937,7 @@ void MySQL_Session::handler_rc0_PROCESSING_STMT_EXECUTE(MySQL_Data_Stream *myds)
 			uint32_t stmt_global_id=0;
 			memcpy(&stmt_global_id,(char *)(CurrentQuery.stmt_meta->pkt)+5,sizeof(uint32_t));
 			SLDH->reset(stmt_global_id);
-			free(CurrentQuery.stmt_meta->pkt);
+			l_free(CurrentQuery.stmt_meta->size,CurrentQuery.stmt_meta->pkt);
 			CurrentQuery.stmt_meta->pkt=NULL;
 		}
 
@@ -5205,12 +5350,30 @@ void MySQL_Session::handler_rc0_RefreshActiveTransactions(MySQL_Connection* myco
 	}
 }
 
+/**
+ * @brief Marks the data streams of the session to be configured again before the next poll.
+ * @details With the epoll backend, MySQL_Thread::ProcessAllMyDS_BeforePoll() only processes the entries in
+ *  'ProxySQL_Poll::dirty': processing the session can change the events each data stream waits for.
+ */
+void MySQL_Session::set_data_streams_dirty() {
+	if (client_myds && client_myds->mypolls) {
+		client_myds->mypolls->set_dirty(client_myds->poll_fds_idx);
+	}
+	for (unsigned int i=0; i<mybes->len; i++) {
+		MySQL_Backend *_mybe=(MySQL_Backend *)mybes->index(i);
+		if (_mybe->server_myds && _mybe->server_myds->mypolls) {
+			_mybe->server_myds->mypolls->set_dirty(_mybe->server_myds->poll_fds_idx);
+		}
+	}
+}
+
 int MySQL_Session::handler() {
 	int handler_ret = 0;
 	bool prepared_stmt_with_no_params = false;
 	bool wrong_pass=false;
 	if (to_process==0) return 0; // this should be redundant if the called does the same check
 	proxy_debug(PROXY_DEBUG_NET,1,"Thread=%p, Session=%p -- Processing session %p\n" , this->thread, this, this);
+	set_data_streams_dirty();
 	//unsigned int j;
 	//unsigned char c;
 
@@ -5278,6 +5441,16 @@ handler_again:
 			}
 			break;
 
+		case PREWARMING_SERVER:
+			{
+				int rc=handler_again___status_PREWARMING_SERVER();
+				if (rc==-1) { // the connection was returned to the pool or destroyed
+					handler_ret = -1;
+					return handler_ret;
+				}
+			}
+			break;
+
 		case RESETTING_CONNECTION:
 			{
 				int rc = handler_again___status_RESETTING_CONNECTION();
@@ -5427,6 +5600,11 @@ handler_again:
 				}
 				gtid_hid = -1;
 				if (rc==0) {
+					// 'start_time' is only set for queries and statements executions, not for prepares
+					if (myconn->query.start_time) {
+						myconn->parent->passive_query_ok(thread->curtime, thread->curtime - myconn->query.start_time);
+						myconn->query.start_time = 0;
+					}
 
 					if (active_transactions != 0) {  // run this only if currently we think there is a transaction
 						handler_rc0_RefreshActiveTransactions(myconn);
@@ -5512,6 +5690,8 @@ handler_again:
 						}
 						MyHGM->p_update_mysql_error_counter(p_mysql_error_type::mysql, myconn->parent->myhgc->hid, myconn->parent->address, myconn->parent->port, myerr);
 						CurrentQuery.mysql_stmt=NULL; // immediately reset mysql_stmt
+						myconn->parent->passive_query_error(thread->curtime, myerr);
+						myconn->query.start_time = 0;
 						int rc1 = handler_ProcessingQueryError_CheckBackendConnectionStatus(myds);
 						if (rc1 == -1) {
 							handler_ret = -1;
@@ -7669,7 +7849,10 @@ void MySQL_Session::handler___client_DSS_QUERY_SENT___server_DSS_NOT_INITIALIZED
 		MySQL_Connection *myconn=mybe->server_myds->myconn;
 		myconn->userinfo->set(client_myds->myconn->userinfo);
 
-		myconn->handler(0);
+		// if the hostname isn't resolved yet, the connect is started by CONNECTING_SERVER once it is
+		if (MySQL_Monitor::dns_lookup_async(myconn->parent->address, myconn->parent->port) == DNS_RESOLVE_READY) {
+			myconn->handler(0);
+		}
 		mybe->server_myds->fd=myconn->fd;
 		mybe->server_myds->DSS=STATE_MARIADB_CONNECTING;
 		status=CONNECTING_SERVER;
@@ -7710,6 +7893,39 @@ void MySQL_Session::MySQL_Stmt_Result_to_MySQL_wire(MYSQL_STMT *stmt, MySQL_Conn
 		bool resultset_completed=MyRS->get_resultset(client_myds->PSarrayOUT);
 		CurrentQuery.rows_sent = MyRS->num_rows;
 		assert(resultset_completed); // the resultset should always be completed if MySQL_Result_to_MySQL_wire is called
+		if (qpo && qpo->cache_ttl>0 && CurrentQuery.stmt_cache_key.length()) { // the binary resultset should be cached
+			if (mysql_stmt_errno(stmt)==0 &&
+				(mysql_warning_count(stmt->mysql)==0 ||
+				 mysql_thread___query_cache_handle_warnings==1)) { // no errors
+				if (
+					(qpo->cache_empty_result==1)
+					|| (
+						(qpo->cache_empty_result == -1)
+						&&
+						(thread->variables.query_cache_stores_empty_result || MyRS->num_rows)
+					)
+				) {
+					client_myds->resultset->copy_add(client_myds->PSarrayOUT,0,client_myds->PSarrayOUT->len);
+					client_myds->resultset_length=MyRS->resultset_size;
+					unsigned char *aa=client_myds->resultset2buffer(false);
+					while (client_myds->resultset->len) client_myds->resultset->remove_index(client_myds->resultset->len-1,NULL);
+					bool deprecate_eof_active = client_myds->myconn->options.client_flag & CLIENT_DEPRECATE_EOF;
+					GloQC->set(
+						client_myds->myconn->userinfo->hash ,
+						(const unsigned char *)CurrentQuery.stmt_cache_key.data(),
+						CurrentQuery.stmt_cache_key.length(),
+						aa ,
+						client_myds->resultset_length ,
+						thread->curtime/1000 ,
+						thread->curtime/1000 ,
+						thread->curtime/1000 + qpo->cache_ttl,
+						deprecate_eof_active
+					);
+					l_free(client_myds->resultset_length,aa);
+					client_myds->resultset_length=0;
+				}
+			}
+		}
 	} else {
 		MYSQL *mysql=stmt->mysql;
 		// no result set
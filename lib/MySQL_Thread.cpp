@@ -1,5 +1,7 @@
 //#define __CLASS_STANDARD_MYSQL_THREAD_H
 
+#include <algorithm>
+#include <climits>
 #include <functional>
 #include <vector>
 
@@ -21,6 +23,7 @@
 #include "MySQL_Logger.hpp"
 
 #include <fcntl.h>
+#include <sched.h>
 
 using std::vector;
 using std::function;
@@ -38,6 +41,11 @@ MySQL_Session *sess_stopat;
 #define PROXYSQL_LISTEN_LEN 1024
 #define MIN_THREADS_FOR_MAINTENANCE 8
 
+// interval at which worker threads check if sessions should be migrated, see mysql-session_migration_threshold
+#define MYSQL_THREAD_SESSION_MIGRATION_INTERVAL_US	1000000
+// max number of sessions migrated by a worker thread every interval
+#define MYSQL_THREAD_SESSION_MIGRATION_MAX	16
+
 /**
  * @brief Helper macro to stringify a macro argument.
  * 
@@ -161,6 +169,11 @@ mythr_st_vars_t MySQL_Thread_status_variables_counter_array[] {
 	{ st_var_max_connect_timeout_err,     p_th_counter::max_connect_timeouts,             (char *)"max_connect_timeouts" },
 	{ st_var_generated_pkt_err,           p_th_counter::generated_error_packets,          (char *)"generated_error_packets" },
 	{ st_var_client_host_error_killed_connections, p_th_counter::client_host_error_killed_connections, (char *)"client_host_error_killed_connections" },
+	{ st_var_sessions_migrated,           p_th_counter::sessions_migrated,                (char *)"Sessions_migrated" },
+	{ st_var_client_connections_numa_local,  p_th_counter::client_connections_numa_local,  (char *)"Client_Connections_numa_local" },
+	{ st_var_client_connections_numa_remote, p_th_counter::client_connections_numa_remote, (char *)"Client_Connections_numa_remote" },
+	{ st_var_poll_entries_processed,      p_th_counter::poll_entries_processed,           (char *)"Poll_entries_processed" },
+	{ st_var_fast_forward_splice_bytes,   p_th_counter::fast_forward_splice_bytes,        (char *)"Fast_forward_splice_bytes" },
 };
 
 mythr_g_st_vars_t MySQL_Thread_status_variables_gauge_array[] {
@@ -333,6 +346,9 @@ void MySQL_Listeners_Manager::del(unsigned int idx) {
 static char * mysql_thread_variables_names[]= {
 	(char *)"shun_on_failures",
 	(char *)"shun_recovery_time_sec",
+	(char *)"passive_health_error_pct",
+	(char *)"passive_health_min_queries",
+	(char *)"passive_health_latency_percentile",
 	(char *)"unshun_algorithm",
 	(char *)"query_retries_on_failure",
 	(char *)"client_host_cache_size",
@@ -350,15 +366,19 @@ static char * mysql_thread_variables_names[]= {
 	(char *)"eventslog_filename",
 	(char *)"eventslog_filesize",
 	(char *)"eventslog_default_log",
+	(char *)"eventslog_buffer_size",
+	(char *)"eventslog_buffer_full_policy",
 	(char *)"eventslog_format",
 	(char *)"auditlog_filename",
 	(char *)"auditlog_filesize",
 	//(char *)"default_charset", // removed in 2.0.13 . Obsoleted previously using MySQL_Variables instead
 	(char *)"handle_unknown_charset",
 	(char *)"free_connections_pct",
+	(char *)"connection_prewarm_pct",
 	(char *)"connection_warming",
 #ifdef IDLE_THREADS
 	(char *)"session_idle_ms",
+	(char *)"session_migration_threshold",
 #endif // IDLE_THREADS
 	(char *)"have_ssl",
 	(char *)"have_compress",
@@ -367,6 +387,8 @@ static char * mysql_thread_variables_names[]= {
 	(char *)"monitor_enabled",
 	(char *)"monitor_history",
 	(char *)"monitor_connect_interval",
+	(char *)"monitor_checks_jitter",
+	(char *)"monitor_adaptive_interval_max_factor",
 	(char *)"monitor_connect_timeout",
 	(char *)"monitor_ping_interval",
 	(char *)"monitor_ping_max_failures",
@@ -420,6 +442,9 @@ static char * mysql_thread_variables_names[]= {
 	(char *)"binlog_reader_connect_retry_msec",
 	(char *)"threshold_query_length",
 	(char *)"threshold_resultset_size",
+	(char *)"fast_forward_splice",
+	(char *)"gather_writes",
+	(char *)"threads_cpu_affinity",
 	(char *)"query_digests_max_digest_length",
 	(char *)"query_digests_max_query_length",
 	(char *)"query_digests_grouping_limit",
@@ -447,10 +472,13 @@ static char * mysql_thread_variables_names[]= {
 	(char *)"query_cache_size_MB",
 	(char *)"query_cache_soft_ttl_pct",
 	(char *)"query_cache_handle_warnings",
+	(char *)"query_cache_persist_interval_sec",
+	(char *)"query_cache_persist_max_age_sec",
 	(char *)"ping_interval_server_msec",
 	(char *)"ping_timeout_server",
 	(char *)"default_schema",
 	(char *)"poll_timeout",
+	(char *)"poll_backend",
 	(char *)"poll_timeout_on_failure",
 	(char *)"server_capabilities",
 	(char *)"server_version",
@@ -795,6 +823,40 @@ th_metrics_map = std::make_tuple(
 			"proxysql_client_host_error_killed_connections",
 			"Killed client connections because address exceeded 'client_host_error_counts'.",
 			metric_tags {}
+		),
+		std::make_tuple (
+			p_th_counter::sessions_migrated,
+			"proxysql_sessions_migrated_total",
+			"Client sessions moved to a less loaded worker thread.",
+			metric_tags {}
+		),
+		std::make_tuple (
+			p_th_counter::client_connections_numa_local,
+			"proxysql_client_connections_numa_total",
+			"Client connections accepted by a pinned worker thread, whose packets arrived on a CPU of the same NUMA node.",
+			metric_tags {
+				{ "locality", "local" }
+			}
+		),
+		std::make_tuple (
+			p_th_counter::client_connections_numa_remote,
+			"proxysql_client_connections_numa_total",
+			"Client connections accepted by a pinned worker thread, whose packets arrived on a CPU of another NUMA node.",
+			metric_tags {
+				{ "locality", "remote" }
+			}
+		),
+		std::make_tuple (
+			p_th_counter::poll_entries_processed,
+			"proxysql_poll_entries_processed_total",
+			"Entries of the poll list processed by the worker threads before and after waiting for events.",
+			metric_tags {}
+		),
+		std::make_tuple (
+			p_th_counter::fast_forward_splice_bytes,
+			"proxysql_fast_forward_splice_bytes_total",
+			"Bytes relayed from backends to clients of fast_forward sessions with splice(), without copying them in userspace.",
+			metric_tags {}
 		)
 	},
 	th_gauge_vector {
@@ -965,6 +1027,9 @@ MySQL_Threads_Handler::MySQL_Threads_Handler() {
 	memset(&variables, 0, sizeof(variables));
 	variables.shun_on_failures=5;
 	variables.shun_recovery_time_sec=10;
+	variables.passive_health_error_pct=0;
+	variables.passive_health_min_queries=20;
+	variables.passive_health_latency_percentile=0;
 	variables.unshun_algorithm=0;
 	variables.query_retries_on_failure=1;
 	variables.client_host_cache_size=0;
@@ -978,10 +1043,13 @@ MySQL_Threads_Handler::MySQL_Threads_Handler() {
 	variables.connect_timeout_server=1000;
 	variables.connect_timeout_server_max=10000;
 	variables.free_connections_pct=10;
+	variables.connection_prewarm_pct=0;
 	variables.connect_retries_delay=1;
 	variables.monitor_enabled=true;
 	variables.monitor_history=7200000; // changed in 2.6.0 : was 600000
 	variables.monitor_connect_interval=120000;
+	variables.monitor_checks_jitter=10;
+	variables.monitor_adaptive_interval_max_factor=1;
 	variables.monitor_connect_timeout=600;
 	variables.monitor_ping_interval=8000;
 	variables.monitor_ping_max_failures=3;
@@ -1029,6 +1097,9 @@ MySQL_Threads_Handler::MySQL_Threads_Handler() {
 	variables.binlog_reader_connect_retry_msec=3000;
 	variables.threshold_query_length=512*1024;
 	variables.threshold_resultset_size=4*1024*1024;
+	variables.fast_forward_splice=0;
+	variables.gather_writes=0;
+	variables.threads_cpu_affinity=0;
 	variables.query_digests_max_digest_length=2*1024;
 	variables.query_digests_max_query_length=65000; // legacy default
 	variables.query_rules_fast_routing_algorithm=1;
@@ -1055,6 +1126,8 @@ MySQL_Threads_Handler::MySQL_Threads_Handler() {
 	variables.query_cache_size_MB=256;
 	variables.query_cache_soft_ttl_pct=0;
 	variables.query_cache_handle_warnings=0;
+	variables.query_cache_persist_interval_sec=0;
+	variables.query_cache_persist_max_age_sec=3600;
 	variables.init_connect=NULL;
 	variables.ldap_user_variable=NULL;
 	variables.add_ldap_user_comment=NULL;
@@ -1071,6 +1144,8 @@ MySQL_Threads_Handler::MySQL_Threads_Handler() {
 	variables.eventslog_filename=strdup((char *)""); // proxysql-mysql-eventslog is recommended
 	variables.eventslog_filesize=100*1024*1024;
 	variables.eventslog_default_log=0;
+	variables.eventslog_buffer_size=0;
+	variables.eventslog_buffer_full_policy=0;
 	variables.eventslog_format=1;
 	variables.auditlog_filename=strdup((char *)"");
 	variables.auditlog_filesize=100*1024*1024;
@@ -1078,6 +1153,7 @@ MySQL_Threads_Handler::MySQL_Threads_Handler() {
 	// major upgrade in 2.0.0
 	variables.server_capabilities = CLIENT_MYSQL | CLIENT_FOUND_ROWS | CLIENT_PROTOCOL_41 | CLIENT_IGNORE_SIGPIPE | CLIENT_TRANSACTIONS | CLIENT_SECURE_CONNECTION | CLIENT_CONNECT_WITH_DB | CLIENT_PLUGIN_AUTH;;
 	variables.poll_timeout=2000;
+	variables.poll_backend=0;
 	variables.poll_timeout_on_failure=100;
 	variables.have_compress=true;
 	variables.have_ssl = true; // changed in 2.6.0 , was false by default for performance reason
@@ -1107,6 +1183,7 @@ MySQL_Threads_Handler::MySQL_Threads_Handler() {
 	variables.sessions_sort=true;
 #ifdef IDLE_THREADS
 	variables.session_idle_ms=1;
+	variables.session_migration_threshold=0;
 	variables.session_idle_show_processlist=true;
 #endif // IDLE_THREADS
 	variables.show_processlist_extended = 0;
@@ -1732,7 +1809,7 @@ bool MySQL_Threads_Handler::set_variable(char *name, const char *value) {	// thi
 	}
 	if (!strcasecmp(name,"eventslog_format")) {
 		int intv=atoi(value);
-		if (intv >= 1 && intv <= 2) {
+		if (intv >= 1 && intv <= 3) {
 			if (variables.eventslog_format!=intv) {
 				// if we are switching format, we need to switch file too
 				if (GloMyLogger) {
@@ -2177,6 +2254,8 @@ char ** MySQL_Threads_Handler::get_variables_list() {
 		VariablesPointers_int["monitor_history"]                     = make_tuple(&variables.monitor_history,                  1000, 7*24*3600*1000, false);
 
 		VariablesPointers_int["monitor_connect_interval"]  = make_tuple(&variables.monitor_connect_interval,  100, 7*24*3600*1000, false);
+		VariablesPointers_int["monitor_checks_jitter"] = make_tuple(&variables.monitor_checks_jitter, 0, 50, false);
+		VariablesPointers_int["monitor_adaptive_interval_max_factor"] = make_tuple(&variables.monitor_adaptive_interval_max_factor, 1, 100, false);
 		VariablesPointers_int["monitor_connect_timeout"]   = make_tuple(&variables.monitor_connect_timeout,   100,       600*1000, false);
 
 		VariablesPointers_int["monitor_ping_interval"]     = make_tuple(&variables.monitor_ping_interval,     100, 7*24*3600*1000, false);
@@ -2241,11 +2320,16 @@ char ** MySQL_Threads_Handler::get_variables_list() {
 		VariablesPointers_int["connpoll_reset_queue_length"] = make_tuple(&variables.connpoll_reset_queue_length, 0,           10000, false);
 		VariablesPointers_int["default_max_latency_ms"]      = make_tuple(&variables.default_max_latency_ms,      0, 20*24*3600*1000, false);
 		VariablesPointers_int["free_connections_pct"]        = make_tuple(&variables.free_connections_pct,        0,             100, false);
+		VariablesPointers_int["connection_prewarm_pct"] = make_tuple(&variables.connection_prewarm_pct, 0, 1000, false);
 		VariablesPointers_int["poll_timeout"]                = make_tuple(&variables.poll_timeout,               10,           20000, false);
+		VariablesPointers_int["poll_backend"]       = make_tuple(&variables.poll_backend, 0, 1, false);
 		VariablesPointers_int["poll_timeout_on_failure"]     = make_tuple(&variables.poll_timeout_on_failure,    10,           20000, false);
 		VariablesPointers_int["reset_connection_algorithm"]  = make_tuple(&variables.reset_connection_algorithm,  1,               2, false);
 		VariablesPointers_int["shun_on_failures"]            = make_tuple(&variables.shun_on_failures,            0,        10000000, false);
 		VariablesPointers_int["shun_recovery_time_sec"]      = make_tuple(&variables.shun_recovery_time_sec,      0,     3600*24*365, false);
+		VariablesPointers_int["passive_health_error_pct"] = make_tuple(&variables.passive_health_error_pct, 0, 100, false);
+		VariablesPointers_int["passive_health_min_queries"] = make_tuple(&variables.passive_health_min_queries, 1, 1000000, false);
+		VariablesPointers_int["passive_health_latency_percentile"] = make_tuple(&variables.passive_health_latency_percentile, 0, 100, false);
 		VariablesPointers_int["unshun_algorithm"]            = make_tuple(&variables.unshun_algorithm,            0,               1, false);
 		VariablesPointers_int["hostgroup_manager_verbose"]   = make_tuple(&variables.hostgroup_manager_verbose,   0,               3, false);
 		VariablesPointers_int["tcp_keepalive_time"]          = make_tuple(&variables.tcp_keepalive_time,          0,            7200, false);
@@ -2271,6 +2355,8 @@ char ** MySQL_Threads_Handler::get_variables_list() {
 		VariablesPointers_int["auditlog_filesize"]     = make_tuple(&variables.auditlog_filesize,    1024*1024, 1*1024*1024*1024, false);
 		VariablesPointers_int["eventslog_filesize"]    = make_tuple(&variables.eventslog_filesize,   1024*1024, 1*1024*1024*1024, false);
 		VariablesPointers_int["eventslog_default_log"] = make_tuple(&variables.eventslog_default_log,        0,                1, false);
+		VariablesPointers_int["eventslog_buffer_size"] = make_tuple(&variables.eventslog_buffer_size,        0,   256*1024*1024, false);
+		VariablesPointers_int["eventslog_buffer_full_policy"] = make_tuple(&variables.eventslog_buffer_full_policy, 0,         1, false);
 		// various
 		VariablesPointers_int["long_query_time"]           = make_tuple(&variables.long_query_time,              0,  20*24*3600*1000, false);
 		VariablesPointers_int["max_allowed_packet"]        = make_tuple(&variables.max_allowed_packet,        8192,   1024*1024*1024, false);
@@ -2282,13 +2368,19 @@ char ** MySQL_Threads_Handler::get_variables_list() {
 		VariablesPointers_int["query_cache_size_mb"]       = make_tuple(&variables.query_cache_size_MB,          0,       1024*10240, false);
 		VariablesPointers_int["query_cache_soft_ttl_pct"]  = make_tuple(&variables.query_cache_soft_ttl_pct,     0,              100, false);
 		VariablesPointers_int["query_cache_handle_warnings"] = make_tuple(&variables.query_cache_handle_warnings,	 0,				   1, false);
+		VariablesPointers_int["query_cache_persist_interval_sec"] = make_tuple(&variables.query_cache_persist_interval_sec, 0, 24*3600, false);
+		VariablesPointers_int["query_cache_persist_max_age_sec"] = make_tuple(&variables.query_cache_persist_max_age_sec, 0, 30*24*3600, false);
 
 #ifdef IDLE_THREADS
 		VariablesPointers_int["session_idle_ms"]           = make_tuple(&variables.session_idle_ms,              1,        3600*1000, false);
+		VariablesPointers_int["session_migration_threshold"] = make_tuple(&variables.session_migration_threshold, 0, 100, false);
 #endif // IDLE_THREADS
 		VariablesPointers_int["show_processlist_extended"] = make_tuple(&variables.show_processlist_extended,    0,                2, false);
 		VariablesPointers_int["threshold_query_length"]    = make_tuple(&variables.threshold_query_length,    1024, 1*1024*1024*1024, false);
 		VariablesPointers_int["threshold_resultset_size"]  = make_tuple(&variables.threshold_resultset_size,  1024, 1*1024*1024*1024, false);
+		VariablesPointers_int["fast_forward_splice"] = make_tuple(&variables.fast_forward_splice, 0, 1, false);
+		VariablesPointers_int["gather_writes"]      = make_tuple(&variables.gather_writes, 0, 1, false);
+		VariablesPointers_int["threads_cpu_affinity"] = make_tuple(&variables.threads_cpu_affinity, 0, 1, false);
 
 		// variables with special variable == true
 		// the input validation for these variables MUST be EXPLICIT
@@ -2395,6 +2487,36 @@ void MySQL_Threads_Handler::init(unsigned int num, size_t stack) {
 	}
 	int rc=pthread_attr_setstacksize(&attr, stacksize);
 	assert(rc==0);
+	cpus_allowed.clear();
+	cpus_numa_node.clear();
+	cpu_set_t cpu_mask;
+	CPU_ZERO(&cpu_mask);
+	if (sched_getaffinity(0, sizeof(cpu_mask), &cpu_mask) == 0) {
+		for (int c = 0; c < CPU_SETSIZE; c++) {
+			if (CPU_ISSET(c, &cpu_mask)) {
+				cpus_allowed.push_back(c);
+			}
+		}
+	}
+	if (cpus_allowed.size()) {
+		// without NUMA support in the kernel all the CPUs belong to node 0
+		cpus_numa_node.assign(cpus_allowed.back() + 1, 0);
+		for (int c : cpus_allowed) {
+			char path[64];
+			snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", c);
+			DIR *dir = opendir(path);
+			if (dir == NULL) continue;
+			struct dirent *ent;
+			while ((ent = readdir(dir)) != NULL) {
+				int node;
+				if (sscanf(ent->d_name, "node%d", &node) == 1) {
+					cpus_numa_node[c] = node;
+					break;
+				}
+			}
+			closedir(dir);
+		}
+	}
 	mysql_threads=(proxysql_mysql_thread_t *)calloc(num_threads,sizeof(proxysql_mysql_thread_t));
 #ifdef IDLE_THREADS
 	if (GloVars.global.idle_threads)
@@ -2417,8 +2539,22 @@ void MySQL_Threads_Handler::init(unsigned int num, size_t stack) {
  */
 proxysql_mysql_thread_t * MySQL_Threads_Handler::create_thread(unsigned int tn, void *(*start_routine) (void *), bool idles) {
 	char thr_name[16];
+	// threads are started already pinned, so that everything they allocate is local to their NUMA node
+	pthread_attr_t *thr_attr = &attr;
+	pthread_attr_t pinned_attr;
+	int thr_cpu = (variables.threads_cpu_affinity ? get_thread_cpu(tn) : -1);
+	if (thr_cpu >= 0) {
+		cpu_set_t cpu_mask;
+		CPU_ZERO(&cpu_mask);
+		CPU_SET(thr_cpu, &cpu_mask);
+		pthread_attr_init(&pinned_attr);
+		pthread_attr_setstacksize(&pinned_attr, stacksize);
+		if (pthread_attr_setaffinity_np(&pinned_attr, sizeof(cpu_mask), &cpu_mask) == 0) {
+			thr_attr = &pinned_attr;
+		}
+	}
 	if (idles==false) {
-		if (pthread_create(&mysql_threads[tn].thread_id, &attr, start_routine , &mysql_threads[tn]) != 0 ) {
+		if (pthread_create(&mysql_threads[tn].thread_id, thr_attr, start_routine , &mysql_threads[tn]) != 0 ) {
 			// LCOV_EXCL_START
 			proxy_error("Thread creation\n");
 			assert(0);
@@ -2429,7 +2565,7 @@ proxysql_mysql_thread_t * MySQL_Threads_Handler::create_thread(unsigned int tn,
 #ifdef IDLE_THREADS
 	} else {
 		if (GloVars.global.idle_threads) {
-			if (pthread_create(&mysql_threads_idles[tn].thread_id, &attr, start_routine , &mysql_threads_idles[tn]) != 0) {
+			if (pthread_create(&mysql_threads_idles[tn].thread_id, thr_attr, start_routine , &mysql_threads_idles[tn]) != 0) {
 				// LCOV_EXCL_START
 				proxy_error("Thread creation\n");
 				assert(0);
@@ -2439,9 +2575,45 @@ proxysql_mysql_thread_t * MySQL_Threads_Handler::create_thread(unsigned int tn,
 		}
 #endif // IDLE_THREADS
 	}
+	if (thr_cpu >= 0) {
+		pthread_attr_destroy(&pinned_attr);
+	}
 	return NULL;
 }
 
+int MySQL_Threads_Handler::get_thread_cpu(unsigned int tn) {
+	if (cpus_allowed.empty()) {
+		return -1;
+	}
+	// threads are assigned round robin to the NUMA nodes, and to the CPUs of every node in ascending order
+	std::map<int, vector<int>> node_cpus {};
+	for (int c : cpus_allowed) {
+		node_cpus[cpus_numa_node[c]].push_back(c);
+	}
+	auto it = node_cpus.begin();
+	std::advance(it, tn % node_cpus.size());
+	const vector<int>& cpus = it->second;
+	return cpus[(tn / node_cpus.size()) % cpus.size()];
+}
+
+int MySQL_Threads_Handler::get_cpu_numa_node(int cpu) {
+	if (cpu < 0 || (unsigned int)cpu >= cpus_numa_node.size()) {
+		return 0;
+	}
+	return cpus_numa_node[cpu];
+}
+
+unsigned int MySQL_Threads_Handler::get_pinned_threads() {
+	if ((__sync_fetch_and_add(&status_variables.threads_initialized, 0) == 0) || this->shutdown_) return 0;
+	unsigned int q=0;
+	for (unsigned int i=0; mysql_threads && i<num_threads; i++) {
+		MySQL_Thread *thr=(MySQL_Thread *)mysql_threads[i].worker;
+		if (thr && __sync_fetch_and_add(&thr->cpu,0) >= 0)
+			q++;
+	}
+	return q;
+}
+
 void MySQL_Threads_Handler::shutdown_threads() {
 	unsigned int i;
 	shutdown_=1;
@@ -2831,14 +3003,23 @@ MySQL_Thread::~MySQL_Thread() {
 				}
 			delete myexchange.idle_mysql_sessions;
 		}
+	}
 
-		if (myexchange.resume_mysql_sessions) {
-			while(myexchange.resume_mysql_sessions->len) {
-				MySQL_Session *sess=(MySQL_Session *)myexchange.resume_mysql_sessions->remove_index_fast(0);
-					delete sess;
-				}
-			delete myexchange.resume_mysql_sessions;
-		}
+	// myexchange.resume_mysql_sessions is also used to migrate sessions between worker threads
+	if (myexchange.resume_mysql_sessions) {
+		while(myexchange.resume_mysql_sessions->len) {
+			MySQL_Session *sess=(MySQL_Session *)myexchange.resume_mysql_sessions->remove_index_fast(0);
+				delete sess;
+			}
+		delete myexchange.resume_mysql_sessions;
+	}
+
+	if (migrate_mysql_sessions) {
+		while(migrate_mysql_sessions->len) {
+			MySQL_Session *sess=(MySQL_Session *)migrate_mysql_sessions->remove_index_fast(0);
+				delete sess;
+			}
+		delete migrate_mysql_sessions;
 	}
 #endif // IDLE_THREADS
 
@@ -3000,12 +3181,15 @@ bool MySQL_Thread::init() {
 		resume_mysql_sessions = new PtrArray();
 
 		myexchange.idle_mysql_sessions = new PtrArray();
-		myexchange.resume_mysql_sessions = new PtrArray();
 		pthread_mutex_init(&myexchange.mutex_idles,NULL);
-		pthread_mutex_init(&myexchange.mutex_resumes,NULL);
 		assert(idle_mysql_sessions);
 		assert(resume_mysql_sessions);
 	}
+	// worker threads exchange sessions through myexchange.resume_mysql_sessions also when
+	// idle threads are disabled, see mysql-session_migration_threshold
+	myexchange.resume_mysql_sessions = new PtrArray();
+	pthread_mutex_init(&myexchange.mutex_resumes,NULL);
+	migrate_mysql_sessions = new PtrArray();
 #endif // IDLE_THREADS
 
 	pthread_mutex_init(&kq.m,NULL);
@@ -3047,6 +3231,77 @@ void MySQL_Thread::poll_listener_add(int sock) {
 
 	proxy_debug(PROXY_DEBUG_NET,1,"Created listener %p for socket %d\n", listener_DS, sock);
 	mypolls.add(POLLIN, sock, listener_DS, monotonic_time());
+	if (cpu >= 0) {
+		set_listener_incoming_cpu(sock);
+	}
+}
+
+/**
+ * @brief Pins the thread to its CPU (see 'MySQL_Threads_Handler::get_thread_cpu()'), or unpins it
+ *   restoring the CPUs of the process, and updates the steering of its listeners accordingly.
+ */
+void MySQL_Thread::set_cpu_affinity(bool pinned) {
+	int tn = -1;
+	for (unsigned int i = 0; i < GloMTH->num_threads && tn < 0; i++) {
+		if (GloMTH->mysql_threads && GloMTH->mysql_threads[i].worker == this) {
+			tn = i;
+		}
+#ifdef IDLE_THREADS
+		if (GloMTH->mysql_threads_idles && GloMTH->mysql_threads_idles[i].worker == this) {
+			tn = i;
+		}
+#endif // IDLE_THREADS
+	}
+	if (tn < 0) {
+		return;
+	}
+	int new_cpu = -1;
+	cpu_set_t cpu_mask;
+	CPU_ZERO(&cpu_mask);
+	if (pinned) {
+		new_cpu = GloMTH->get_thread_cpu(tn);
+		if (new_cpu < 0) {
+			return;
+		}
+		CPU_SET(new_cpu, &cpu_mask);
+	} else {
+		for (int c : GloMTH->cpus_allowed) {
+			CPU_SET(c, &cpu_mask);
+		}
+	}
+	int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpu_mask), &cpu_mask);
+	if (rc) {
+		proxy_warning("Unable to set the CPU affinity of MySQL thread %d: %s\n", tn, strerror(rc));
+		return;
+	}
+	proxy_debug(PROXY_DEBUG_GENERIC, 4, "MySQL thread %d pinned to CPU %d\n", tn, new_cpu);
+	__sync_lock_test_and_set(&cpu, new_cpu);
+	numa_node = (new_cpu >= 0 ? GloMTH->get_cpu_numa_node(new_cpu) : -1);
+	for (unsigned int n = 0; n < mypolls.len; n++) {
+		MySQL_Data_Stream *myds = mypolls.myds[n];
+		if (myds && myds->myds_type == MYDS_LISTENER) {
+			set_listener_incoming_cpu(myds->fd);
+		}
+	}
+}
+
+/**
+ * @brief Asks the kernel to steer to listener 'sock' the connections whose packets are processed by the
+ *   CPU this thread is pinned to, or removes the steering if the thread isn't pinned.
+ * @details Only per-thread listeners (SO_REUSEPORT) can be steered, a shared listener is accepted from by
+ *   all the threads. Steering is effective only if the receive queues of the NICs are processed by the
+ *   CPUs the threads are pinned to (RSS/RPS).
+ */
+void MySQL_Thread::set_listener_incoming_cpu(int sock) {
+#if defined(SO_REUSEPORT) && defined(SO_INCOMING_CPU)
+	if (GloVars.global.reuseport == false) {
+		return;
+	}
+	int val = cpu;
+	if (setsockopt(sock, SOL_SOCKET, SO_INCOMING_CPU, &val, sizeof(val))) {
+		proxy_warning("Unable to set SO_INCOMING_CPU on listener socket %d: %s\n", sock, strerror(errno));
+	}
+#endif // SO_REUSEPORT && SO_INCOMING_CPU
 }
 
 void MySQL_Thread::poll_listener_del(int sock) {
@@ -3072,13 +3327,72 @@ void MySQL_Thread::register_session(MySQL_Session *_sess, bool up_start) {
 	_sess->match_regexes=match_regexes;
 	if (up_start)
 		_sess->start_time=curtime;
+	if (_sess->to_process) {
+		// new mirror sessions, or sessions coming from another thread
+		queue_session_to_process(_sess);
+	}
+#ifdef IDLE_THREADS
+	// idle threads check only 'wait_timeout', see idle_thread_to_kill_idle_sessions()
+	if (epoll_thread==false)
+#endif // IDLE_THREADS
+	{
+		// the client data stream may not be in 'mypolls' yet, the idle time is computed when the timer fires.
+		// New client connections are scheduled again once in CONNECTING_CLIENT, see listener_handle_new_connection()
+		schedule_session_timeout(_sess, 0);
+	}
 	proxy_debug(PROXY_DEBUG_NET,1,"Thread=%p, Session=%p -- Registered new session\n", _sess->thread, _sess);
 }
 
 void MySQL_Thread::unregister_session(int idx) {
 	if (mysql_sessions==NULL) return;
 	proxy_debug(PROXY_DEBUG_NET,1,"Thread=%p, Session=%p -- Unregistered session\n", this, mysql_sessions->index(idx));
-	mysql_sessions->remove_index_fast(idx);
+	MySQL_Session *sess=(MySQL_Session *)mysql_sessions->remove_index_fast(idx);
+	session_timers.cancel(&sess->timeout_timer);
+	dequeue_session_to_process(sess);
+}
+
+/**
+ * @brief Marks the session to be processed by the handler in this loop, see process_all_sessions().
+ */
+void MySQL_Thread::set_session_to_process(MySQL_Session *sess) {
+	sess->to_process=1;
+	queue_session_to_process(sess);
+}
+
+/**
+ * @brief Adds the session to 'sessions_to_process', the only sessions walked by process_all_sessions()
+ *  outside the maintenance loops.
+ * @details A session is queued once per loop, when 'to_process' is set or when it has to be closed. Idle
+ *  threads walk all their sessions, and don't queue them.
+ */
+void MySQL_Thread::queue_session_to_process(MySQL_Session *sess) {
+#ifdef IDLE_THREADS
+	if (epoll_thread) {
+		return;
+	}
+#endif // IDLE_THREADS
+	if (sess->queued_to_process==false) {
+		sess->queued_to_process=true;
+		sessions_to_process.push_back(sess);
+	}
+}
+
+/**
+ * @brief Removes an unregistered session from 'sessions_to_process'.
+ * @details The entry is cleared and not erased, as the session can be unregistered while
+ *  process_queued_sessions() walks 'sessions_to_process'.
+ */
+void MySQL_Thread::dequeue_session_to_process(MySQL_Session *sess) {
+	if (sess->queued_to_process==false) {
+		return;
+	}
+	sess->queued_to_process=false;
+	for (MySQL_Session *&queued : sessions_to_process) {
+		if (queued==sess) {
+			queued=NULL;
+			return;
+		}
+	}
 }
 
 
@@ -3127,7 +3441,50 @@ void MySQL_Thread::run___get_multiple_idle_connections(int& num_idles) {
 	last_processing_idles=curtime;
 }
 
+/**
+ * @brief Connects the connections pre-opened to match the predicted demand of the hostgroups.
+ *
+ * The connections are planned by MyHGM, at most once per second for all the threads, see
+ * 'mysql-connection_prewarm_pct'. As for the idle connections to ping, a session without frontend is
+ * created for each connection, in PREWARMING_SERVER status: once connected, the connection is returned
+ * to the connection pool.
+ */
+void MySQL_Thread::run___prewarm_connections() {
+	MySQL_Connection *prewarm_conns[SESSIONS_FOR_CONNECTIONS_HANDLER];
+	int num_conns=MyHGM->get_prewarm_connections(curtime, prewarm_conns, SESSIONS_FOR_CONNECTIONS_HANDLER);
+	for (int i=0; i<num_conns; i++) {
+		MySQL_Data_Stream *myds;
+		MySQL_Connection *mc=prewarm_conns[i];
+		MySQL_Session *sess=new MySQL_Session();
+		sess->mybe=sess->find_or_create_backend(mc->parent->myhgc->hid);
+
+		myds=sess->mybe->server_myds;
+		myds->attach_connection(mc);
+		myds->myds_type=MYDS_BACKEND;
+
+		sess->to_process=1;
+		myds->wait_until=curtime+mysql_thread___connect_timeout_server*1000;	// max_timeout
+		myds->myprot.init(&myds, myds->myconn->userinfo, NULL);
+		sess->status=PREWARMING_SERVER;
+		myds->DSS=STATE_MARIADB_CONNECTING;
+		register_session_connection_handler(sess,true);
+		int rc=sess->handler();
+		if (rc==-1) {
+			unsigned int sess_idx=mysql_sessions->len-1;
+			unregister_session(sess_idx);
+			delete sess;
+		}
+	}
+}
+
 // this function was inline in MySQL_Thread::run()
+/**
+ * @brief Prepares the data streams before polling: resets 'revents', tunes the poll timeout and configures
+ *  the events to wait for.
+ * @details With the epoll backend only the entries in 'mypolls.dirty' are processed: the other entries didn't
+ *  change since the previous loop. All the entries are processed with the poll backend, during maintenance
+ *  loops, and when sessions may be moved to the idle threads or to other worker threads.
+ */
 void MySQL_Thread::ProcessAllMyDS_BeforePoll() {
 	bool check_if_move_to_idle_thread = false;
 #ifdef IDLE_THREADS
@@ -3137,13 +3494,39 @@ void MySQL_Thread::ProcessAllMyDS_BeforePoll() {
 			check_if_move_to_idle_thread=true;
 		}
 	}
+	unsigned int migration_quota = 0;
+	if (mysql_thread___session_migration_threshold && GloMTH->num_threads > 1) {
+		if (curtime > last_session_migration_time + MYSQL_THREAD_SESSION_MIGRATION_INTERVAL_US) {
+			last_session_migration_time=curtime;
+			migration_target=get_session_migration_target(migration_quota);
+		}
+	}
 #endif
+	unsigned long long processed = 0;
+	bool full_scan = (mypolls.is_epoll()==false || mypolls.full_scan || maintenance_loop || check_if_move_to_idle_thread);
+#ifdef IDLE_THREADS
+	if (migration_quota) {
+		full_scan = true;
+	}
+#endif // IDLE_THREADS
+	if (full_scan == false) {
+		unsigned int n;
+		while (mypolls.dirty.pop(mypolls.len, n)) {
+			ProcessMyDS_BeforePoll(n);
+			processed++;
+		}
+		mypolls.commit_dirty();
+		status_variables.stvar[st_var_poll_entries_processed] += processed;
+		return;
+	}
+	mypolls.full_scan=false;
+	mypolls.dirty.clear();
 	for (unsigned int n = 0; n < mypolls.len; n++) {
 		MySQL_Data_Stream *myds=NULL;
 		myds=mypolls.myds[n];
-		mypolls.fds[n].revents=0;
-		if (myds) {
+		processed++;
 #ifdef IDLE_THREADS
+		if (myds) {
 			if (check_if_move_to_idle_thread == true) {
 				// here we try to move it to the maintenance thread
 				if (myds->myds_type==MYDS_FRONTEND && myds->sess) {
@@ -3155,22 +3538,56 @@ void MySQL_Thread::ProcessAllMyDS_BeforePoll() {
 					}
 				}
 			}
-#endif // IDLE_THREADS
-			if (unlikely(myds->wait_until)) {
-				tune_timeout_for_myds_needs_pause(myds);
-			}
-			if (myds->sess) {
-				if (unlikely(myds->sess->pause_until > 0)) {
-					tune_timeout_for_session_needs_pause(myds);
+			if (migration_quota) {
+				// here we try to move it to a less loaded worker thread
+				if (myds->myds_type==MYDS_FRONTEND && myds->sess) {
+					if (myds->DSS==STATE_SLEEP && myds->sess->status==WAITING_CLIENT_DATA) {
+						if (move_session_to_migrate_mysql_sessions(myds, n)) {
+							migration_quota--;
+							n--;  // compensate mypolls.remove_index_fast(n) and n++ of loop
+							continue;
+						}
+					}
 				}
 			}
-			myds->revents=0;
-			if (myds->myds_type!=MYDS_LISTENER) {
-				configure_pollout(myds, n);
+		}
+#endif // IDLE_THREADS
+		ProcessMyDS_BeforePoll(n);
+	}
+	mypolls.commit_dirty();
+	status_variables.stvar[st_var_poll_entries_processed] += processed;
+}
+
+/**
+ * @brief Prepares the entry 'n' of 'mypolls' before polling, see ProcessAllMyDS_BeforePoll().
+ * @details The entries waiting for a timeout are kept in 'mypolls.dirty', so that they are processed on every
+ *  loop until the timeout is over.
+ */
+void MySQL_Thread::ProcessMyDS_BeforePoll(unsigned int n) {
+	MySQL_Data_Stream *myds=mypolls.myds[n];
+	mypolls.fds[n].revents=0;
+	if (myds) {
+		bool waits_timeout=false;
+		if (unlikely(myds->wait_until)) {
+			tune_timeout_for_myds_needs_pause(myds);
+			waits_timeout=true;
+		}
+		if (myds->sess) {
+			if (unlikely(myds->sess->pause_until > 0)) {
+				tune_timeout_for_session_needs_pause(myds);
+				waits_timeout=true;
 			}
 		}
-		proxy_debug(PROXY_DEBUG_NET,1,"Poll for DataStream=%p will be called with FD=%d and events=%d\n", mypolls.myds[n], mypolls.fds[n].fd, mypolls.fds[n].events);
+		myds->revents=0;
+		if (myds->myds_type!=MYDS_LISTENER) {
+			configure_pollout(myds, n);
+			mypolls.events_changed(n);
+		}
+		if (waits_timeout) {
+			mypolls.keep_dirty(n);
+		}
 	}
+	proxy_debug(PROXY_DEBUG_NET,1,"Poll for DataStream=%p will be called with FD=%d and events=%d\n", mypolls.myds[n], mypolls.fds[n].fd, mypolls.fds[n].events);
 }
 
 
@@ -3185,8 +3602,14 @@ void MySQL_Thread::ProcessAllMyDS_BeforePoll() {
  * If there are events, it checks for invalid file descriptors and handles new connections 
  * for listener type data streams. For other types of data streams, it processes data and 
  * handles any potential errors.
+ * With the epoll backend only the entries with events are processed, see ProcessReadyMyDS_AfterPoll().
  */
 void MySQL_Thread::ProcessAllMyDS_AfterPoll() {
+	if (mypolls.is_epoll()) {
+		ProcessReadyMyDS_AfterPoll();
+		return;
+	}
+	status_variables.stvar[st_var_poll_entries_processed] += mypolls.len;
 	for (unsigned int n = 0; n < mypolls.len; n++) {
 		proxy_debug(PROXY_DEBUG_NET,3, "poll for fd %d events %d revents %d\n", mypolls.fds[n].fd , mypolls.fds[n].events, mypolls.fds[n].revents);
 
@@ -3220,6 +3643,46 @@ void MySQL_Thread::ProcessAllMyDS_AfterPoll() {
 	}
 }
 
+/**
+ * @brief Processes the data streams after epoll: only the entries in 'mypolls.ready' and, if the poll timed
+ *  out, the entries waiting for a timeout, kept in 'mypolls.dirty' by ProcessAllMyDS_BeforePoll().
+ * @details The entries with events are added to 'mypolls.dirty', so that their 'revents' is reset and their
+ *  events configured again before the next poll. Entries removed while processing are tracked by the index
+ *  sets, see ProxySQL_Poll_Index_Set.
+ */
+void MySQL_Thread::ProcessReadyMyDS_AfterPoll() {
+	unsigned long long processed = 0;
+	if (poll_timeout_bool) {
+		for (unsigned int n : mypolls.dirty.idxs) {
+			if (mypolls.dirty.contains(n, mypolls.len)) {
+				check_timing_out_session(n);
+				processed++;
+			}
+		}
+	}
+	unsigned int n;
+	while (mypolls.ready.pop(mypolls.len, n)) {
+		processed++;
+		mypolls.set_dirty(n);
+		proxy_debug(PROXY_DEBUG_NET,3, "poll for fd %d events %d revents %d\n", mypolls.fds[n].fd , mypolls.fds[n].events, mypolls.fds[n].revents);
+
+		MySQL_Data_Stream *myds=mypolls.myds[n];
+		if (myds==NULL) {
+			read_one_byte_from_pipe(n);
+			continue;
+		}
+		check_for_invalid_fd(n); // this is designed to assert in case of failure
+		if (myds->myds_type==MYDS_LISTENER) {
+			// we got a new connection!
+			listener_handle_new_connection(myds,n);
+			continue;
+		}
+		// data on exiting connection, if the data stream is removed the set is updated
+		process_data_on_data_stream(myds, n);
+	}
+	status_variables.stvar[st_var_poll_entries_processed] += processed;
+}
+
 
 // this function was inline in MySQL_Thread::run()
 /**
@@ -3264,6 +3727,15 @@ void MySQL_Thread::run_MoveSessionsBetweenThreads() {
 		MySQL_Thread *thr=GloMTH->mysql_threads_idles[r].worker;
 		worker_thread_assigns_sessions_to_idle_thread(thr);
 		worker_thread_gets_sessions_from_idle_thread();
+	} else if (check_resumed_sessions || maintenance_loop) {
+		// without idle threads, myexchange.resume_mysql_sessions only receives sessions migrated
+		// from other worker threads, that always signal the pipe
+		check_resumed_sessions=false;
+		worker_thread_gets_sessions_from_idle_thread();
+	}
+	if (migrate_mysql_sessions->len) {
+		worker_thread_assigns_sessions_to_worker_thread(migration_target);
+		migration_target=NULL;
 	}
 }
 
@@ -3349,17 +3821,30 @@ void MySQL_Thread::run_StopListener() {
 }
 
 
+/**
+ * @brief Resets 'to_process' for the sessions queued in the previous loop.
+ * @details Only the queued sessions can have 'to_process' set, see set_session_to_process(). The sessions that
+ *  still have to be closed, or whose mirror has completed, stay queued for process_all_sessions().
+ */
 void MySQL_Thread::run_SetAllSession_ToProcess0() {
-	unsigned int n;
 #ifdef IDLE_THREADS
 	// @note: in MySQL_Thread::run we have:  bool idle_maintenance_thread=epoll_thread;
 	// Thus idle_maintenance_thread and epoll_thread are equivalent.
 	if (epoll_thread==false) {
 #endif // IDLE_THREADS
-		for (n=0; n<mysql_sessions->len; n++) {
-			MySQL_Session *_sess=(MySQL_Session *)mysql_sessions->index(n);
+		size_t kept=0;
+		for (MySQL_Session *_sess : sessions_to_process) {
+			if (_sess==NULL) {
+				continue;
+			}
 			_sess->to_process=0;
+			if (unlikely(_sess->healthy==0 || _sess->killed || (_sess->mirror && _sess->status==WAITING_CLIENT_DATA))) {
+				sessions_to_process[kept++]=_sess;
+			} else {
+				_sess->queued_to_process=false;
+			}
 		}
+		sessions_to_process.resize(kept);
 #ifdef IDLE_THREADS
 	}
 #endif // IDLE_THREADS
@@ -3396,6 +3881,7 @@ void MySQL_Thread::run() {
 
 	curtime=monotonic_time();
 	atomic_curtime=curtime;
+	busy_since=curtime;
 
 	pthread_mutex_lock(&thread_mutex);
 	while (shutdown==0) {
@@ -3413,6 +3899,9 @@ void MySQL_Thread::run() {
 	if (processing_idles==false &&  (last_processing_idles < curtime-mysql_thread___ping_interval_server_msec*1000) ) {
 		run___get_multiple_idle_connections(num_idles);
 	}
+	if (mysql_thread___connection_prewarm_pct) {
+		run___prewarm_connections();
+	}
 
 #ifdef IDLE_THREADS
 __run_skip_1:
@@ -3449,7 +3938,10 @@ __run_skip_1:
 		//this is the only portion of code not protected by a global mutex
 		proxy_debug(PROXY_DEBUG_NET,5,"Calling poll with timeout %d\n", ttw );
 		// poll is called with a timeout of mypolls.poll_timeout if set , or mysql_thread___poll_timeout
-		rc=poll(mypolls.fds,mypolls.len, ttw);
+		// mysql-poll_backend selects poll() or epoll , see ProxySQL_Poll::wait()
+		mypolls.set_backend(mysql_thread___poll_backend);
+		busy_time += monotonic_time() - busy_since;
+		rc=mypolls.wait(ttw);
 		proxy_debug(PROXY_DEBUG_NET,5,"%s\n", "Returning poll");
 #ifdef IDLE_THREADS
 		}
@@ -3467,6 +3959,7 @@ __run_skip_1:
 
 		curtime=monotonic_time();
 		atomic_curtime=curtime;
+		busy_since=curtime;
 
 		poll_timeout_bool=false;
 		if (
@@ -3510,6 +4003,7 @@ __run_skip_1:
 			// house keeping
 			run___cleanup_mirror_queue();
 			GloQPro->update_query_processor_stats();
+			update_load();
 		}
 
 			if (rc == -1 && errno == EINTR)
@@ -3778,18 +4272,18 @@ bool MySQL_Thread::process_data_on_data_stream(MySQL_Data_Stream *myds, unsigned
 #endif // IDLE_THREADS
 					mypolls.last_recv[n]=curtime;
 					myds->revents=mypolls.fds[n].revents;
-					myds->sess->to_process=1;
+					set_session_to_process(myds->sess);
 					assert(myds->sess->status!=session_status___NONE);
 				} else {
 					// no events
 					if (myds->wait_until && curtime > myds->wait_until) {
 						// timeout
-						myds->sess->to_process=1;
+						set_session_to_process(myds->sess);
 						assert(myds->sess->status!=session_status___NONE);
 					} else {
 						if (myds->sess->pause_until && curtime > myds->sess->pause_until) {
 							// timeout
-							myds->sess->to_process=1;
+							set_session_to_process(myds->sess);
 						}
 					}
 				}
@@ -3812,7 +4306,10 @@ bool MySQL_Thread::process_data_on_data_stream(MySQL_Data_Stream *myds, unsigned
 					return true;
 				}
 				if (mypolls.fds[n].revents) {
-					if (mypolls.myds[n]->DSS < STATE_MARIADB_BEGIN || mypolls.myds[n]->DSS > STATE_MARIADB_END) {
+					if (myds->myds_type == MYDS_BACKEND && myds->can_splice_to(myds->sess->client_myds)) {
+						// unencrypted fast_forward: relay directly to the client, without copying the data
+						myds->splice_to(myds->sess->client_myds);
+					} else if (mypolls.myds[n]->DSS < STATE_MARIADB_BEGIN || mypolls.myds[n]->DSS > STATE_MARIADB_END) {
 						// only if we aren't using MariaDB Client Library
 						int rb = 0;
 						do {
@@ -3848,15 +4345,12 @@ bool MySQL_Thread::process_data_on_data_stream(MySQL_Data_Stream *myds, unsigned
 										}
 										rb = 0; // exit loop
 									} else { // we are in fast_forward mode and encrypted == false
-										struct pollfd _fds;
-										nfds_t _nfds = 1;
-										_fds.fd = mypolls.fds[n].fd;
-										_fds.events = POLLIN;
-										_fds.revents = 0;
-										int _rc = poll(&_fds, _nfds, 0);
-										if ((_rc > 0) && _fds.revents == POLLIN) {
-											// there is more data
-											myds->revents = _fds.revents;
+										// If recv() didn't fill the buffer the socket was drained, and any data
+										// arriving later is reported by the next poll. Otherwise we read again
+										// directly: recv() fails with EAGAIN if no more data arrived, saving
+										// the poll() previously used to probe the socket at every read.
+										if (myds->recv_buffer_filled && myds->active) {
+											myds->revents = POLLIN;
 										} else {
 											rb = 0; // exit loop
 										}
@@ -3945,6 +4439,22 @@ void MySQL_Thread::ProcessAllSessions_SortingSessions() {
 	}
 }
 
+/**
+ * @brief Sorts 'sessions_to_process' as ProcessAllSessions_SortingSessions() sorts all the sessions: the
+ *  sessions with a backend connection attempt go first, by maximum connection time.
+ */
+void MySQL_Thread::ProcessAllSessions_SortingSessionsToProcess() {
+	const auto max_connect_time = [] (MySQL_Session *sess) -> unsigned long long {
+		if (sess && sess->mybe && sess->mybe->server_myds && sess->mybe->server_myds->max_connect_time) {
+			return sess->mybe->server_myds->max_connect_time;
+		}
+		return ULLONG_MAX;
+	};
+	std::stable_sort(sessions_to_process.begin(), sessions_to_process.end(),
+		[&max_connect_time] (MySQL_Session *a, MySQL_Session *b) { return max_connect_time(a) < max_connect_time(b); }
+	);
+}
+
 // this function was inline in MySQL_Thread::process_all_sessions()
 void MySQL_Thread::ProcessAllSessions_CompletedMirrorSession(unsigned int& n, MySQL_Session *sess) {
 	unregister_session(n);
@@ -3975,72 +4485,17 @@ void MySQL_Thread::ProcessAllSessions_CompletedMirrorSession(unsigned int& n, My
 /**
  * @brief Processes a session in the maintenance loop.
  * 
- * This function performs maintenance tasks for a session within the maintenance loop. It handles checks related to session
- * timeouts, active transactions, and server table version changes. Depending on the conditions, it may kill the session,
+ * This function performs maintenance tasks for a session within the maintenance loop. It handles checks related to
+ * active transactions and server table version changes. Depending on the conditions, it may kill the session,
  * simulate data in failed backend connections, or update expired connections if multiplexing is enabled.
+ * Session timeouts are not checked here, see MySQL_Thread::check_session_timeouts().
  * 
  * @param sess The MySQL session to process.
- * @param sess_time The time elapsed since the session started, in milliseconds.
  * @param total_active_transactions_ Reference to the total number of active transactions across all sessions.
  */
-void MySQL_Thread::ProcessAllSessions_MaintenanceLoop(MySQL_Session *sess, unsigned long long sess_time, unsigned int& total_active_transactions_) {
-	unsigned int numTrx=0;
+void MySQL_Thread::ProcessAllSessions_MaintenanceLoop(MySQL_Session *sess, unsigned int& total_active_transactions_) {
 	total_active_transactions_ += sess->active_transactions;
-	sess->to_process=1;
-	/**
-	 * @brief Handles session timeout conditions and associated actions.
-	 * 
-	 * This block of code evaluates whether the session has exceeded either the maximum transaction idle time
-	 * or the wait timeout duration. If either condition is met, it takes appropriate action:
-	 * 
-	 * - If the session has active transactions, it checks if the maximum transaction time has been exceeded
-	 *   and kills the session if necessary.
-	 * - If the session does not have active transactions, it kills the session if it has been inactive for longer
-	 *   than the wait timeout duration.
-	 * 
-	 * If none of the timeout conditions are met, it continues to evaluate the session's active transactions
-	 * against the maximum transaction time criteria and kills the session if necessary.
-	 * 
-	 * @param sess_time The time elapsed since the session started, in milliseconds.
-	 * @param curtime The current time, in milliseconds.
-	 * @param sess The MySQL session to handle.
-	 */
-	if ( (sess_time/1000 > (unsigned long long)mysql_thread___max_transaction_idle_time) || (sess_time/1000 > (unsigned long long)mysql_thread___wait_timeout) ) {
-		//numTrx = sess->NumActiveTransactions();
-		numTrx = sess->active_transactions;
-		if (numTrx) {
-			// the session has idle transactions, kill it
-			if (sess_time/1000 > (unsigned long long)mysql_thread___max_transaction_idle_time) {
-				sess->killed=true;
-				if (sess->client_myds) {
-					proxy_warning("Killing client connection %s:%d because of (possible) transaction idle for %llums\n",sess->client_myds->addr.addr,sess->client_myds->addr.port, sess_time/1000);
-				}
-			}
-		} else {
-			// the session is idle, kill it
-			if (sess_time/1000 > (unsigned long long)mysql_thread___wait_timeout) {
-				sess->killed=true;
-				if (sess->client_myds) {
-					proxy_warning("Killing client connection %s:%d because inactive for %llums\n",sess->client_myds->addr.addr,sess->client_myds->addr.port, sess_time/1000);
-				}
-			}
-		}
-	} else {
-		if (sess->active_transactions > 0) {
-			// here is all the logic related to max_transaction_time
-			unsigned long long trx_started = sess->transaction_started_at;
-			if (trx_started > 0 && curtime > trx_started) {
-				unsigned long long trx_time = curtime - trx_started;
-				unsigned long long trx_time_ms = trx_time/1000;
-				if (trx_time_ms > (unsigned long long)mysql_thread___max_transaction_time) {
-					sess->killed=true;
-					if (sess->client_myds) {
-						proxy_warning("Killing client connection %s:%d because of (possible) transaction running for %llums\n",sess->client_myds->addr.addr,sess->client_myds->addr.port, trx_time_ms);
-					}
-				}
-			}
-		}
-	}
+	set_session_to_process(sess);
 	/**
 	 * @brief Handles server table version change and its associated actions.
 	 * 
@@ -4065,7 +4520,7 @@ void MySQL_Thread::ProcessAllSessions_MaintenanceLoop(MySQL_Session *sess, unsig
 			// the following 2 lines of code replace the previous 2 lines
 			// instead of killing the sessions, fails the backend connections
 			if (sess->SetEventInOfflineBackends()) {
-				sess->to_process=1;
+				set_session_to_process(sess);
 			}
 		}
 	}
@@ -4103,6 +4558,142 @@ void MySQL_Thread::ProcessAllSessions_MaintenanceLoop(MySQL_Session *sess, unsig
 }
 
 
+/**
+ * @brief Schedules the next check of the timeouts of a session in 'session_timers'.
+ * @details The timer is scheduled at the earliest time any of 'mysql-wait_timeout',
+ *  'mysql-max_transaction_idle_time', 'mysql-max_transaction_time' and 'mysql-connect_timeout_client'
+ *  may expire. The activity of the session doesn't move the timer: when the timer fires the timeouts
+ *  are checked against the current state of the session, and the timer is scheduled again if none expired.
+ *  For the same reason, a transaction that may start later can't expire before 'curtime + max_transaction_time'.
+ *
+ * @param sess The session to schedule.
+ * @param sess_time The idle time of the session, in microseconds, see MySQL_Session::IdleTime().
+ */
+void MySQL_Thread::schedule_session_timeout(MySQL_Session *sess, unsigned long long sess_time) {
+	// timeouts expire once the elapsed milliseconds are greater than the limit
+	unsigned long long idle_base = curtime - sess_time + 1000;
+	unsigned long long idle_limit = (unsigned long long)mysql_thread___wait_timeout;
+	if ((unsigned long long)mysql_thread___max_transaction_idle_time < idle_limit) {
+		idle_limit = (unsigned long long)mysql_thread___max_transaction_idle_time;
+	}
+	unsigned long long deadline = idle_base + idle_limit * 1000;
+	unsigned long long trx_base = curtime + 1000;
+	if (sess->active_transactions > 0 && sess->transaction_started_at > 0 && sess->transaction_started_at < curtime) {
+		trx_base = sess->transaction_started_at + 1000;
+	}
+	unsigned long long trx_deadline = trx_base + (unsigned long long)mysql_thread___max_transaction_time * 1000;
+	if (trx_deadline < deadline) {
+		deadline = trx_deadline;
+	}
+	if (sess->status == CONNECTING_CLIENT) {
+		unsigned long long connect_deadline = idle_base + (unsigned long long)mysql_thread___connect_timeout_client * 1000;
+		if (connect_deadline < deadline) {
+			deadline = connect_deadline;
+		}
+	}
+	session_timers.schedule(&sess->timeout_timer, deadline);
+}
+
+/**
+ * @brief Checks the timeouts of a session whose timer expired, killing it or scheduling the timer again.
+ *
+ * @param sess The session to check.
+ */
+void MySQL_Thread::check_session_timeouts(MySQL_Session *sess) {
+	unsigned int numTrx=0;
+	unsigned long long sess_time = sess->IdleTime();
+	if (sess->status == CONNECTING_CLIENT) {
+		if (sess_time/1000 > (unsigned long long)mysql_thread___connect_timeout_client) {
+			proxy_warning("Closing not established client connection %s:%d after %llums\n",sess->client_myds->addr.addr,sess->client_myds->addr.port, sess_time/1000);
+			sess->healthy = 0;
+			queue_session_to_process(sess);
+			if (mysql_thread___client_host_cache_size) {
+				GloMTH->update_client_host_cache(sess->client_myds->client_addr, true);
+			}
+			return;
+		}
+	}
+	/**
+	 * @brief Handles session timeout conditions and associated actions.
+	 * 
+	 * This block of code evaluates whether the session has exceeded either the maximum transaction idle time
+	 * or the wait timeout duration. If either condition is met, it takes appropriate action:
+	 * 
+	 * - If the session has active transactions, it checks if the maximum transaction time has been exceeded
+	 *   and kills the session if necessary.
+	 * - If the session does not have active transactions, it kills the session if it has been inactive for longer
+	 *   than the wait timeout duration.
+	 * 
+	 * If none of the timeout conditions are met, it continues to evaluate the session's active transactions
+	 * against the maximum transaction time criteria and kills the session if necessary.
+	 */
+	if ( (sess_time/1000 > (unsigned long long)mysql_thread___max_transaction_idle_time) || (sess_time/1000 > (unsigned long long)mysql_thread___wait_timeout) ) {
+		//numTrx = sess->NumActiveTransactions();
+		numTrx = sess->active_transactions;
+		if (numTrx) {
+			// the session has idle transactions, kill it
+			if (sess_time/1000 > (unsigned long long)mysql_thread___max_transaction_idle_time) {
+				sess->killed=true;
+				if (sess->client_myds) {
+					proxy_warning("Killing client connection %s:%d because of (possible) transaction idle for %llums\n",sess->client_myds->addr.addr,sess->client_myds->addr.port, sess_time/1000);
+				}
+			}
+		} else {
+			// the session is idle, kill it
+			if (sess_time/1000 > (unsigned long long)mysql_thread___wait_timeout) {
+				sess->killed=true;
+				if (sess->client_myds) {
+					proxy_warning("Killing client connection %s:%d because inactive for %llums\n",sess->client_myds->addr.addr,sess->client_myds->addr.port, sess_time/1000);
+				}
+			}
+		}
+	} else {
+		if (sess->active_transactions > 0) {
+			// here is all the logic related to max_transaction_time
+			unsigned long long trx_started = sess->transaction_started_at;
+			if (trx_started > 0 && curtime > trx_started) {
+				unsigned long long trx_time = curtime - trx_started;
+				unsigned long long trx_time_ms = trx_time/1000;
+				if (trx_time_ms > (unsigned long long)mysql_thread___max_transaction_time) {
+					sess->killed=true;
+					if (sess->client_myds) {
+						proxy_warning("Killing client connection %s:%d because of (possible) transaction running for %llums\n",sess->client_myds->addr.addr,sess->client_myds->addr.port, trx_time_ms);
+					}
+				}
+			}
+		}
+	}
+	if (sess->killed) {
+		set_session_to_process(sess);
+	} else {
+		schedule_session_timeout(sess, sess_time);
+	}
+}
+
+/**
+ * @brief Checks the timeouts of the sessions whose timer expired since the previous call.
+ * @details Called on every loop: the cost is proportional to the number of expired timers, and not to
+ *  the number of sessions.
+ */
+void MySQL_Thread::process_session_timeouts() {
+	expired_session_timers.clear();
+	session_timers.advance(curtime, expired_session_timers);
+	for (timer_wheel_node *t : expired_session_timers) {
+		check_session_timeouts((MySQL_Session *)t->data);
+	}
+}
+
+void MySQL_Thread::ProcessAllSessions_Close(MySQL_Session *sess, unsigned int& n) {
+	char _buf[1024];
+	if (sess->client_myds && sess->killed)
+		proxy_warning("Closing killed client connection %s:%d\n",sess->client_myds->addr.addr,sess->client_myds->addr.port);
+	sprintf(_buf,"%s:%d:%s()", __FILE__, __LINE__, __func__);
+	GloMyLogger->log_audit_entry(PROXYSQL_MYSQL_AUTH_CLOSE, sess, NULL, _buf);
+	unregister_session(n);
+	n--;
+	delete sess;
+}
+
 void MySQL_Thread::ProcessAllSessions_Healthy0(MySQL_Session *sess, unsigned int& n) {
 	char _buf[1024];
 	if (sess->client_myds) {
@@ -4132,6 +4723,8 @@ void MySQL_Thread::ProcessAllSessions_Healthy0(MySQL_Session *sess, unsigned int
  * 
  * This function iterates through all active sessions within the MySQL thread and performs various actions based on the session state and conditions.
  * 
+ * Outside the maintenance loops only the sessions in 'sessions_to_process' are walked, see process_queued_sessions().
+ * 
  * If the session sorting flag is enabled and there are more than three sessions, it sorts the sessions.
  * 
  * For each session, it performs the following tasks:
@@ -4167,6 +4760,26 @@ void MySQL_Thread::process_all_sessions() {
 		sess_sort=false;
 	}
 #endif // IDLE_THREADS
+#ifdef IDLE_THREADS
+	if (idle_maintenance_thread==false)
+#endif // IDLE_THREADS
+	{
+		process_session_timeouts();
+	}
+	// only the maintenance loops, and the idle threads, walk all the sessions
+	bool walk_all_sessions=maintenance_loop;
+#ifdef IDLE_THREADS
+	if (idle_maintenance_thread) {
+		walk_all_sessions=true;
+	}
+#endif // IDLE_THREADS
+	if (walk_all_sessions==false) {
+		if (sess_sort && sessions_to_process.size() > 3) {
+			ProcessAllSessions_SortingSessionsToProcess();
+		}
+		process_queued_sessions();
+		return;
+	}
 	if (sess_sort && mysql_sessions->len > 3) {
 		ProcessAllSessions_SortingSessions();
 	}
@@ -4183,30 +4796,20 @@ void MySQL_Thread::process_all_sessions() {
 				continue;
 			}
 		}
-		if (sess->status == CONNECTING_CLIENT) {
-			unsigned long long sess_time = sess->IdleTime();
-			if (sess_time/1000 > (unsigned long long)mysql_thread___connect_timeout_client) {
-				proxy_warning("Closing not established client connection %s:%d after %llums\n",sess->client_myds->addr.addr,sess->client_myds->addr.port, sess_time/1000);
-				sess->healthy = 0;
-				if (mysql_thread___client_host_cache_size) {
-					GloMTH->update_client_host_cache(sess->client_myds->client_addr, true);
-				}
-			}
-		}
 		if (maintenance_loop) {
-			unsigned long long sess_time = sess->IdleTime();
 #ifdef IDLE_THREADS
 			if (idle_maintenance_thread==false)
 #endif // IDLE_THREADS
 			{
-				ProcessAllSessions_MaintenanceLoop(sess, sess_time, total_active_transactions_);
+				ProcessAllSessions_MaintenanceLoop(sess, total_active_transactions_);
 			}
 #ifdef IDLE_THREADS
 				else
 			{
+				unsigned long long sess_time = sess->IdleTime();
 				if ( (sess_time/1000 > (unsigned long long)mysql_thread___wait_timeout) ) {
 					sess->killed=true;
-					sess->to_process=1;
+					set_session_to_process(sess);
 					proxy_warning("Killing client connection %s:%d because inactive for %llums\n", sess->client_myds->addr.addr, sess->client_myds->addr.port, sess_time/1000);
 				}
 			}
@@ -4224,28 +4827,14 @@ void MySQL_Thread::process_all_sessions() {
 					rc=sess->handler();
 					//total_active_transactions_+=sess->active_transactions;
 					if (rc==-1 || sess->killed==true) {
-						char _buf[1024];
-						if (sess->client_myds && sess->killed)
-							proxy_warning("Closing killed client connection %s:%d\n",sess->client_myds->addr.addr,sess->client_myds->addr.port);
-						sprintf(_buf,"%s:%d:%s()", __FILE__, __LINE__, __func__);
-						GloMyLogger->log_audit_entry(PROXYSQL_MYSQL_AUTH_CLOSE, sess, NULL, _buf);
-						unregister_session(n);
-						n--;
-						delete sess;
+						ProcessAllSessions_Close(sess, n);
 					}
 				}
 			} else {
 				if (unlikely(sess->killed==true)) {
 					// this is a special cause, if killed the session needs to be executed no matter if paused
 					sess->handler();
-					char _buf[1024];
-					if (sess->client_myds)
-						proxy_warning("Closing killed client connection %s:%d\n",sess->client_myds->addr.addr,sess->client_myds->addr.port);
-					sprintf(_buf,"%s:%d:%s()", __FILE__, __LINE__, __func__);
-					GloMyLogger->log_audit_entry(PROXYSQL_MYSQL_AUTH_CLOSE, sess, NULL, _buf);
-					unregister_session(n);
-					n--;
-					delete sess;
+					ProcessAllSessions_Close(sess, n);
 				}
 			}
 		}
@@ -4257,6 +4846,52 @@ void MySQL_Thread::process_all_sessions() {
 	}
 }
 
+/**
+ * @brief Processes only the sessions in 'sessions_to_process', instead of walking all the sessions.
+ * @details The sessions are queued when their data streams have events or their pause is over (see
+ *  process_data_on_data_stream() and check_timing_out_session()), when their timer expires (see
+ *  check_session_timeouts()), and when they are registered with 'to_process' set. The sessions queued while
+ *  walking, like new mirror sessions, are processed in the same walk. The index in 'mysql_sessions' is only
+ *  looked up to close a session.
+ */
+void MySQL_Thread::process_queued_sessions() {
+	for (size_t i=0; i<sessions_to_process.size(); i++) {
+		MySQL_Session *sess=sessions_to_process[i];
+		if (sess==NULL) { // unregistered after being queued
+			continue;
+		}
+		unsigned int n;
+		if (sess->mirror==true) { // this is a mirror session
+			if (sess->status==WAITING_CLIENT_DATA) { // the mirror session has completed
+				n=find_session_idx_in_mysql_sessions(sess);
+				ProcessAllSessions_CompletedMirrorSession(n, sess);
+				continue;
+			}
+		}
+		if (unlikely(sess->healthy==0)) {
+			n=find_session_idx_in_mysql_sessions(sess);
+			ProcessAllSessions_Healthy0(sess, n);
+		} else {
+			if (sess->to_process==1) {
+				if (sess->pause_until <= curtime) {
+					int rc=sess->handler();
+					if (rc==-1 || sess->killed==true) {
+						n=find_session_idx_in_mysql_sessions(sess);
+						ProcessAllSessions_Close(sess, n);
+					}
+				}
+			} else {
+				if (unlikely(sess->killed==true)) {
+					// this is a special cause, if killed the session needs to be executed no matter if paused
+					sess->handler();
+					n=find_session_idx_in_mysql_sessions(sess);
+					ProcessAllSessions_Close(sess, n);
+				}
+			}
+		}
+	}
+}
+
 
 /**
  * @brief Refreshes MySQL thread variables from global MySQL thread handler.
@@ -4288,6 +4923,9 @@ void MySQL_Thread::refresh_variables() {
 	REFRESH_VARIABLE_INT(max_transaction_time);
 	REFRESH_VARIABLE_INT(threshold_query_length);
 	REFRESH_VARIABLE_INT(threshold_resultset_size);
+	REFRESH_VARIABLE_INT(fast_forward_splice);
+	REFRESH_VARIABLE_INT(gather_writes);
+	REFRESH_VARIABLE_INT(threads_cpu_affinity);
 	REFRESH_VARIABLE_INT(query_digests_max_digest_length);
 	REFRESH_VARIABLE_INT(query_digests_max_query_length);
 	REFRESH_VARIABLE_INT(wait_timeout);
@@ -4312,10 +4950,15 @@ void MySQL_Thread::refresh_variables() {
 	REFRESH_VARIABLE_INT(query_cache_size_MB);
 	REFRESH_VARIABLE_INT(query_cache_soft_ttl_pct);
 	REFRESH_VARIABLE_INT(query_cache_handle_warnings);
+	REFRESH_VARIABLE_INT(query_cache_persist_interval_sec);
+	REFRESH_VARIABLE_INT(query_cache_persist_max_age_sec);
 	REFRESH_VARIABLE_INT(ping_interval_server_msec);
 	REFRESH_VARIABLE_INT(ping_timeout_server);
 	REFRESH_VARIABLE_INT(shun_on_failures);
 	REFRESH_VARIABLE_INT(shun_recovery_time_sec);
+	REFRESH_VARIABLE_INT(passive_health_error_pct);
+	REFRESH_VARIABLE_INT(passive_health_min_queries);
+	REFRESH_VARIABLE_INT(passive_health_latency_percentile);
 	REFRESH_VARIABLE_INT(unshun_algorithm);
 	REFRESH_VARIABLE_INT(query_retries_on_failure);
 	REFRESH_VARIABLE_INT(connect_retries_on_failure);
@@ -4325,8 +4968,10 @@ void MySQL_Thread::refresh_variables() {
 	REFRESH_VARIABLE_INT(connect_timeout_server);
 	REFRESH_VARIABLE_INT(connect_timeout_server_max);
 	REFRESH_VARIABLE_INT(free_connections_pct);
+	REFRESH_VARIABLE_INT(connection_prewarm_pct);
 #ifdef IDLE_THREADS
 	REFRESH_VARIABLE_INT(session_idle_ms);
+	REFRESH_VARIABLE_INT(session_migration_threshold);
 #endif // IDLE_THREADS
 	REFRESH_VARIABLE_INT(connect_retries_delay);
 
@@ -4348,6 +4993,8 @@ void MySQL_Thread::refresh_variables() {
 	REFRESH_VARIABLE_BOOL(monitor_enabled);
 	REFRESH_VARIABLE_INT(monitor_history);
 	REFRESH_VARIABLE_INT(monitor_connect_interval);
+	REFRESH_VARIABLE_INT(monitor_checks_jitter);
+	REFRESH_VARIABLE_INT(monitor_adaptive_interval_max_factor);
 	REFRESH_VARIABLE_INT(monitor_connect_timeout);
 	REFRESH_VARIABLE_INT(monitor_ping_interval);
 	REFRESH_VARIABLE_INT(monitor_ping_max_failures);
@@ -4399,6 +5046,8 @@ void MySQL_Thread::refresh_variables() {
 	REFRESH_VARIABLE_CHAR(server_version);
 	REFRESH_VARIABLE_INT(eventslog_filesize);
 	REFRESH_VARIABLE_INT(eventslog_default_log);
+	REFRESH_VARIABLE_INT(eventslog_buffer_size);
+	REFRESH_VARIABLE_INT(eventslog_buffer_full_policy);
 	REFRESH_VARIABLE_INT(eventslog_format);
 	REFRESH_VARIABLE_CHAR(eventslog_filename);
 	REFRESH_VARIABLE_INT(auditlog_filesize);
@@ -4413,6 +5062,7 @@ void MySQL_Thread::refresh_variables() {
 	mysql_thread___server_capabilities=GloMTH->get_variable_uint16((char *)"server_capabilities");
 	REFRESH_VARIABLE_INT(handle_unknown_charset);
 	REFRESH_VARIABLE_INT(poll_timeout);
+	REFRESH_VARIABLE_INT(poll_backend);
 	REFRESH_VARIABLE_INT(poll_timeout_on_failure);
 	REFRESH_VARIABLE_BOOL(have_compress);
 	REFRESH_VARIABLE_BOOL(have_ssl);
@@ -4462,6 +5112,25 @@ void MySQL_Thread::refresh_variables() {
 #endif /* DEBUG */
 	GloMTH->wrunlock();
 	pthread_mutex_unlock(&GloVars.global.ext_glomth_mutex);
+
+	// timers were scheduled with the previous timeouts
+	const int timeouts_conf[4] = {
+		mysql_thread___wait_timeout, mysql_thread___max_transaction_idle_time,
+		mysql_thread___max_transaction_time, mysql_thread___connect_timeout_client
+	};
+	if (memcmp(timeouts_conf, session_timeouts_conf, sizeof(session_timeouts_conf))) {
+		memcpy(session_timeouts_conf, timeouts_conf, sizeof(session_timeouts_conf));
+		for (unsigned int n = 0; mysql_sessions && n < mysql_sessions->len; n++) {
+			MySQL_Session *sess=(MySQL_Session *)mysql_sessions->index(n);
+			if (sess->timeout_timer.scheduled()) {
+				schedule_session_timeout(sess, sess->IdleTime());
+			}
+		}
+	}
+
+	if ((mysql_thread___threads_cpu_affinity != 0) != (cpu >= 0)) {
+		set_cpu_affinity(mysql_thread___threads_cpu_affinity);
+	}
 }
 
 MySQL_Thread::MySQL_Thread() {
@@ -4479,7 +5148,19 @@ MySQL_Thread::MySQL_Thread() {
 	resume_mysql_sessions=NULL;
 	myexchange.idle_mysql_sessions=NULL;
 	myexchange.resume_mysql_sessions=NULL;
+	migrate_mysql_sessions=NULL;
+	migration_target=NULL;
+	last_session_migration_time=0;
+	check_resumed_sessions=false;
 #endif // IDLE_THREADS
+	memset(session_timeouts_conf, 0, sizeof(session_timeouts_conf));
+	busy_time=0;
+	busy_since=0;
+	load_pct=0;
+	load_sample_time=0;
+	load_sample_busy_time=0;
+	cpu=-1;
+	numa_node=-1;
 	processing_idles=false;
 	last_processing_idles=0;
 	__thread_MySQL_Thread_Variables_version=0;
@@ -4544,6 +5225,9 @@ void MySQL_Thread::register_session_connection_handler(MySQL_Session *_sess, boo
 	_sess->connections_handler=true;
 	assert(_new);
 	mysql_sessions->add(_sess);
+	if (_sess->to_process) {
+		queue_session_to_process(_sess);
+	}
 }
 
 
@@ -4560,7 +5244,8 @@ void MySQL_Thread::register_session_connection_handler(MySQL_Session *_sess, boo
  */
 void MySQL_Thread::unregister_session_connection_handler(int idx, bool _new) {
 	assert(_new);
-	mysql_sessions->remove_index_fast(idx);
+	MySQL_Session *sess=(MySQL_Session *)mysql_sessions->remove_index_fast(idx);
+	dequeue_session_to_process(sess);
 }
 
 void MySQL_Thread::listener_handle_new_connection(MySQL_Data_Stream *myds, unsigned int n) {
@@ -4603,6 +5288,21 @@ void MySQL_Thread::listener_handle_new_connection(MySQL_Data_Stream *myds, unsig
 			}
 		}
 
+#ifdef SO_INCOMING_CPU
+		if (cpu >= 0) {
+			// CPU that processed the packets of the connection
+			int incoming_cpu = -1;
+			socklen_t incoming_cpu_len = sizeof(incoming_cpu);
+			if (getsockopt(c, SOL_SOCKET, SO_INCOMING_CPU, &incoming_cpu, &incoming_cpu_len) == 0 && incoming_cpu >= 0) {
+				if (GloMTH->get_cpu_numa_node(incoming_cpu) == numa_node) {
+					status_variables.stvar[st_var_client_connections_numa_local]++;
+				} else {
+					status_variables.stvar[st_var_client_connections_numa_remote]++;
+				}
+			}
+		}
+#endif // SO_INCOMING_CPU
+
 		// create a new client connection
 		mypolls.fds[n].revents=0;
 		MySQL_Session *sess=create_new_session_and_client_data_stream(c);
@@ -4645,6 +5345,9 @@ void MySQL_Thread::listener_handle_new_connection(MySQL_Data_Stream *myds, unsig
 		ioctl_FIONBIO(sess->client_myds->fd, 1);
 		mypolls.add(POLLIN|POLLOUT, sess->client_myds->fd, sess->client_myds, curtime);
 		proxy_debug(PROXY_DEBUG_NET,1,"Session=%p -- Adding client FD %d\n", sess, sess->client_myds->fd);
+		// the session is now in CONNECTING_CLIENT: the timer scheduled by register_session() didn't
+		// account for 'mysql-connect_timeout_client'
+		schedule_session_timeout(sess, 0);
 
 		// we now enforce sending the 'initial handshake packet' as soon as it's generated. This
 		// is done to prevent situations in which a client sends a packet *before* receiving
@@ -4872,6 +5575,12 @@ SQLite3_result * MySQL_Threads_Handler::SQL3_GlobalStatus(bool _memory) {
 		pta[1]=buf;
 		result->add_row(pta);
 	}
+	{	// Events dropped because the events log buffer was full
+		pta[0]=(char *)"Eventslog_buffer_dropped";
+		sprintf(buf,"%llu",(GloMyLogger ? GloMyLogger->get_events_dropped() : 0));
+		pta[1]=buf;
+		result->add_row(pta);
+	}
 	{	// Queries that are SELECT for update or equivalent
 		pta[0]=(char *)"Selects_for_update__autocommit0";
 		sprintf(buf,"%llu",MyHGM->status.select_for_update_or_equivalent);
@@ -4890,6 +5599,12 @@ SQLite3_result * MySQL_Threads_Handler::SQL3_GlobalStatus(bool _memory) {
 		pta[1]=buf;
 		result->add_row(pta);
 	}
+	{	// MySQL Threads workers pinned to a CPU
+		pta[0]=(char *)"MySQL_Thread_Workers_pinned";
+		sprintf(buf,"%u",get_pinned_threads());
+		pta[1]=buf;
+		result->add_row(pta);
+	}
 	{	// Access_Denied_Wrong_Password
 		pta[0]=(char *)"Access_Denied_Wrong_Password";
 		sprintf(buf,"%llu",MyHGM->status.access_denied_wrong_password);
@@ -4993,6 +5708,12 @@ SQLite3_result * MySQL_Threads_Handler::SQL3_GlobalStatus(bool _memory) {
 			pta[1] = buf;
 			result->add_row(pta);
 		}
+		{
+			pta[0] = (char*)"MySQL_Monitor_dns_cache_record_refreshed";
+			sprintf(buf, "%llu", GloMyMon->dns_cache_record_refreshed);
+			pta[1] = buf;
+			result->add_row(pta);
+		}
 	}
 	free(pta);
 	return result;
@@ -5260,6 +5981,9 @@ SQLite3_result * MySQL_Threads_Handler::SQL3_Processlist() {
 					case PINGING_SERVER:
                                                 pta[11]=strdup("Pinging server");
                                                 break;
+					case PREWARMING_SERVER:
+                                                pta[11]=strdup("Prewarming server");
+                                                break;
 					case WAITING_SERVER_DATA:
                                                 pta[11]=strdup("Waiting server data");
                                                 break;
@@ -5876,11 +6600,12 @@ void MySQL_Thread::Scan_Sessions_to_Kill_All() {
 			Scan_Sessions_to_Kill(myexchange.idle_mysql_sessions);
 			pthread_mutex_unlock(&myexchange.mutex_idles);
 		}
-		if (kq.conn_ids.size() + kq.query_ids.size()) {
-			pthread_mutex_lock(&myexchange.mutex_resumes);
-			Scan_Sessions_to_Kill(myexchange.resume_mysql_sessions);
-			pthread_mutex_unlock(&myexchange.mutex_resumes);
-		}
+	}
+	if (kq.conn_ids.size() + kq.query_ids.size()) {
+		// sessions being migrated between worker threads, or resumed by an idle thread
+		pthread_mutex_lock(&myexchange.mutex_resumes);
+		Scan_Sessions_to_Kill(myexchange.resume_mysql_sessions);
+		pthread_mutex_unlock(&myexchange.mutex_resumes);
 	}
 #endif
 	for (std::vector<thr_id_usr *>::iterator it=kq.conn_ids.begin(); it!=kq.conn_ids.end(); ++it) {
@@ -5983,10 +6708,150 @@ bool MySQL_Thread::move_session_to_idle_mysql_sessions(MySQL_Data_Stream *myds,
 	}
 	return false;
 }
+
+/**
+ * @brief Checks if this worker thread is overloaded compared to the others, and if so selects the worker
+ *   thread that should receive some of its sessions.
+ * @details The load of a worker thread is the percentage of time spent outside poll() during the last
+ *   maintenance interval, see MySQL_Thread::update_load(). Sessions are migrated only if the load of this
+ *   thread is above the average and exceeds the load of the least loaded thread by at least
+ *   'mysql-session_migration_threshold' points. Only sessions with client activity contribute to the
+ *   load, so the number of sessions to migrate is computed from the active ones: enough to bring the two
+ *   threads halfway toward each other, to avoid sessions bouncing between threads.
+ * @param quota Output parameter, number of sessions to migrate.
+ * @return The worker thread receiving the sessions, or NULL if no session should be migrated.
+ */
+MySQL_Thread * MySQL_Thread::get_session_migration_target(unsigned int& quota) {
+	quota = 0;
+	unsigned int my_load = load_pct;
+	unsigned int total_load = 0;
+	unsigned int min_load = UINT_MAX;
+	MySQL_Thread *target = NULL;
+	unsigned int num_threads = GloMTH->num_threads;
+	for (unsigned int i = 0; i < num_threads; i++) {
+		MySQL_Thread *thr = GloMTH->mysql_threads[i].worker;
+		if (thr == NULL) {
+			// threads are still starting
+			return NULL;
+		}
+		unsigned int l = thr->load_pct;
+		total_load += l;
+		if (thr != this && l < min_load) {
+			min_load = l;
+			target = thr;
+		}
+	}
+	if (target == NULL || my_load * num_threads <= total_load) {
+		return NULL;
+	}
+	if (my_load < min_load + (unsigned int)mysql_thread___session_migration_threshold) {
+		return NULL;
+	}
+	unsigned int active_sessions = 0;
+	for (unsigned int n = 0; n < mypolls.len; n++) {
+		MySQL_Data_Stream *myds = mypolls.myds[n];
+		if (myds && myds->myds_type == MYDS_FRONTEND && mypolls.last_recv[n] + MYSQL_THREAD_SESSION_MIGRATION_INTERVAL_US > curtime) {
+			active_sessions++;
+		}
+	}
+	if (active_sessions < 2) {
+		// moving the only active session would just move the load
+		return NULL;
+	}
+	quota = active_sessions * (my_load - min_load) / (2 * my_load);
+	if (quota == 0) {
+		quota = 1;
+	}
+	if (quota > MYSQL_THREAD_SESSION_MIGRATION_MAX) {
+		quota = MYSQL_THREAD_SESSION_MIGRATION_MAX;
+	}
+	proxy_debug(PROXY_DEBUG_NET, 5, "Thread=%p load=%u , migrating up to %u sessions to Thread=%p load=%u\n", this, my_load, quota, target, min_load);
+	return target;
+}
+
+/**
+ * @brief Removes an active session from this worker thread, so it can be migrated to another worker thread.
+ * @details As for idle threads, a session is migrated only at a safe point: waiting for a new request
+ *   from the client, without backend connections and without pending data to send.
+ * @return True if the session was removed from 'mypolls' and 'mysql_sessions'.
+ */
+bool MySQL_Thread::move_session_to_migrate_mysql_sessions(MySQL_Data_Stream *myds, unsigned int n) {
+	if (mypolls.last_recv[n] + MYSQL_THREAD_SESSION_MIGRATION_INTERVAL_US <= curtime) {
+		// inactive sessions don't contribute to the load
+		return false;
+	}
+	if (myds->sess->client_myds == myds && !myds->available_data_out() && myds->sess->pause_until <= curtime && myds->sess->mirror == false) {
+		if (myds->sess->has_any_backend() == false) {
+			mypolls.remove_index_fast(n);
+			myds->mypolls=NULL;
+			unsigned int i = find_session_idx_in_mysql_sessions(myds->sess);
+			myds->sess->thread=NULL;
+			unregister_session(i);
+			migrate_mysql_sessions->add(myds->sess);
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * @brief Hands over the sessions in 'migrate_mysql_sessions' to another worker thread.
+ * @details Sessions are pushed into 'myexchange.resume_mysql_sessions' of the target thread, that
+ *   registers them in worker_thread_gets_sessions_from_idle_thread() as it does for sessions resumed by
+ *   an idle thread. If the target thread is shutting down the sessions are registered again in this thread.
+ * @param thr The worker thread receiving the sessions.
+ */
+void MySQL_Thread::worker_thread_assigns_sessions_to_worker_thread(MySQL_Thread *thr) {
+	bool send_signal = false;
+	pthread_mutex_lock(&thr->myexchange.mutex_resumes);
+	if (shutdown==0 && thr->shutdown==0) {
+		while (migrate_mysql_sessions->len) {
+			MySQL_Session *mysess=(MySQL_Session *)migrate_mysql_sessions->remove_index_fast(0);
+			thr->myexchange.resume_mysql_sessions->add(mysess);
+			status_variables.stvar[st_var_sessions_migrated]++;
+		}
+		send_signal=true;
+	}
+	pthread_mutex_unlock(&thr->myexchange.mutex_resumes);
+	if (send_signal) {
+		unsigned char c=0;
+		int fd=thr->pipefd[1];
+		if (write(fd,&c,1)==-1) {
+			// the pipe is full: the target thread is already signaled
+		}
+	} else {
+		while (migrate_mysql_sessions->len) {
+			MySQL_Session *mysess=(MySQL_Session *)migrate_mysql_sessions->remove_index_fast(0);
+			register_session(mysess, false);
+			MySQL_Data_Stream *myds=mysess->client_myds;
+			mypolls.add(POLLIN, myds->fd, myds, curtime);
+		}
+	}
+}
 #endif // IDLE_THREADS
 
+/**
+ * @brief Computes 'load_pct' from the time spent outside poll() since the previous call.
+ * @details Called by worker threads on every maintenance loop. 'load_pct' is read by the other worker
+ *   threads to decide if sessions should be migrated, see MySQL_Thread::get_session_migration_target().
+ */
+void MySQL_Thread::update_load() {
+	if (load_sample_time && curtime > load_sample_time) {
+		unsigned long long busy = busy_time - load_sample_busy_time;
+		unsigned long long elapsed = curtime - load_sample_time;
+		load_pct = (busy >= elapsed ? 100 : busy * 100 / elapsed);
+	}
+	load_sample_time=curtime;
+	load_sample_busy_time=busy_time;
+}
+
 bool MySQL_Thread::set_backend_to_be_skipped_if_frontend_is_slow(MySQL_Data_Stream *myds, unsigned int n) {
 	if (myds->sess && myds->sess->client_myds && myds->sess->mirror==false) {
+		if (myds->sess->client_myds->splice_pipe_len) {
+			// data relayed with splice() is still waiting to be written to the client
+			mypolls.fds[n].events = 0;
+			return true;
+		}
 		unsigned int buffered_data=0;
 		buffered_data = myds->sess->client_myds->PSarrayOUT->len * RESULTSET_BUFLEN;
 		buffered_data += myds->sess->client_myds->resultset->len * RESULTSET_BUFLEN;
@@ -6105,11 +6970,11 @@ void MySQL_Thread::check_timing_out_session(unsigned int n) {
 	if (_myds && _myds->sess) {
 		if (_myds->wait_until && curtime > _myds->wait_until) {
 			// timeout
-			_myds->sess->to_process=1;
+			set_session_to_process(_myds->sess);
 		} else {
 			if (_myds->sess->pause_until && curtime > _myds->sess->pause_until) {
 				// timeout
-				_myds->sess->to_process=1;
+				set_session_to_process(_myds->sess);
 			}
 		}
 	}
@@ -6147,6 +7012,10 @@ void MySQL_Thread::read_one_byte_from_pipe(unsigned int n) {
 		if (read(mypolls.fds[n].fd, &c, 1)==-1) {// read just one byte
 			proxy_error("Error during read from signal_all_threads()\n");
 		}
+#ifdef IDLE_THREADS
+		// other threads signal the pipe also after pushing sessions into myexchange
+		check_resumed_sessions=true;
+#endif // IDLE_THREADS
 		proxy_debug(PROXY_DEBUG_GENERIC,3, "Got signal from admin , done nothing\n");
 		//fprintf(stderr,"Got signal from admin , done nothing\n"); // FIXME: this is just the skeleton for issue #253
 		if (c) {
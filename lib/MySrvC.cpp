@@ -1,5 +1,7 @@
 #include "MySQL_HostGroups_Manager.h"
 
+extern MySQL_Monitor *GloMyMon;
+
 class MySrvConnList;
 class MySrvC;
 class MySrvList;
@@ -23,6 +25,7 @@ MySrvC::MySrvC(
 	cur_replication_lag_count=0;
 	max_latency_us=_max_latency_ms*1000;
 	current_latency_us=0;
+	ping_latency_us=0;
 	aws_aurora_current_lag_us = 0;
 	connect_OK=0;
 	connect_ERR=0;
@@ -30,6 +33,8 @@ MySrvC::MySrvC(
 	bytes_sent=0;
 	bytes_recv=0;
 	max_connections_used=0;
+	prewarm_used_peak=0;
+	prewarm_connecting=0;
 	queries_gtid_sync=0;
 	time_last_detected_error=0;
 	connect_ERR_at_time_last_detected_error=0;
@@ -39,7 +44,7 @@ MySrvC::MySrvC(
 	myhgc=NULL;
 	comment=strdup(_comment);
 	ConnectionsUsed=new MySrvConnList(this);
-	ConnectionsFree=new MySrvConnList(this);
+	ConnectionsFree=new MySrvConnList(this, true);
 }
 
 void MySrvC::connect_error(int err_num, bool get_mutex) {
@@ -86,6 +91,10 @@ void MySrvC::connect_error(int err_num, bool get_mutex) {
 	if (t > time_last_detected_error) {
 		time_last_detected_error=t;
 		connect_ERR_at_time_last_detected_error=1;
+		// first error in this second: let the monitor check the server at its base intervals
+		if (GloMyMon) {
+			GloMyMon->expedite_checks(address, port);
+		}
 	} else {
 		if (t < time_last_detected_error) {
 			// time_last_detected_error is in the future
@@ -117,6 +126,7 @@ void MySrvC::connect_error(int err_num, bool get_mutex) {
 			if (status==MYSQL_SERVER_STATUS_ONLINE) {
 				status=MYSQL_SERVER_STATUS_SHUNNED;
 				shunned_automatic=true;
+				if (myhgc) myhgc->invalidate_selection();
 				_shu=true;
 			} else {
 				_shu=false;
@@ -130,10 +140,54 @@ void MySrvC::connect_error(int err_num, bool get_mutex) {
 	}
 }
 
+void MySrvC::passive_query_ok(unsigned long long now, unsigned long long time_us) {
+	if (passive_health.add_query(now, time_us) == false) {
+		return;
+	}
+	// first query of a new window: refresh the latency from the window just completed
+	// with 'mysql-passive_health_latency_percentile=0' the latency is reset to '0'
+	unsigned int latency_us = passive_health.compute_latency(now, mysql_thread___passive_health_latency_percentile);
+	// not under mutex, like the updates from the monitor
+	current_latency_us = latency_us > ping_latency_us ? latency_us : ping_latency_us;
+}
+
+void MySrvC::passive_query_error(unsigned long long now, int err) {
+	if (MySQL_Passive_Health::is_server_error(err) == false) {
+		return;
+	}
+	int error_pct = passive_health.add_error(now, mysql_thread___passive_health_min_queries);
+	if (mysql_thread___passive_health_error_pct == 0 || error_pct < mysql_thread___passive_health_error_pct) {
+		return;
+	}
+	// while the error rate stays above the threshold every failed query gets here: check the status
+	// without the mutex first, so that a server already shunned doesn't serialize all the threads on it
+	if (status!=MYSQL_SERVER_STATUS_ONLINE) {
+		return;
+	}
+	bool _shu=false;
+	MyHGM->wrlock();
+	if (status==MYSQL_SERVER_STATUS_ONLINE) { // check again, another thread may have shunned it
+		status=MYSQL_SERVER_STATUS_SHUNNED;
+		shunned_automatic=true;
+		// the server is retried after 'mysql-shun_recovery_time_sec', as for connection errors
+		time_last_detected_error=time(NULL);
+		if (myhgc) myhgc->invalidate_selection();
+		_shu=true;
+	}
+	MyHGM->wrunlock();
+	if (_shu) {
+		proxy_error("Shunning server %s:%d with %d%% of failed queries. Shunning for %u seconds\n", address, port, error_pct, mysql_thread___shun_recovery_time_sec);
+		if (GloMyMon) {
+			GloMyMon->expedite_checks(address, port);
+		}
+	}
+}
+
 void MySrvC::shun_and_killall() {
 	status=MYSQL_SERVER_STATUS_SHUNNED;
 	shunned_automatic=true;
 	shunned_and_kill_all_connections=true;
+	if (myhgc) myhgc->invalidate_selection();
 }
 
 MySrvC::~MySrvC() {
@@ -17,21 +17,105 @@ MySQL_Connection *MySrvConnList::index(unsigned int _k) {
 	return (MySQL_Connection *)conns->index(_k);
 }
 
+int MySrvConnList::find_idx(MySQL_Connection *c) {
+	// 'pool_list_idx' is kept updated by add() and remove() , the scan is only a safeguard
+	if (c->pool_list_idx < conns->len && conns->index(c->pool_list_idx)==c) {
+		return (int)c->pool_list_idx;
+	}
+	//for (unsigned int i=0; i<conns_length(); i++) {
+	for (unsigned int i=0; i<conns->len; i++) {
+		MySQL_Connection *conn = NULL;
+		conn = (MySQL_Connection *)conns->index(i);
+		if (conn==c) {
+			return (unsigned int)i;
+		}
+	}
+	return -1;
+}
+
 MySQL_Connection * MySrvConnList::remove(int _k) {
-	return (MySQL_Connection *)conns->remove_index_fast(_k);
+	MySQL_Connection *c = (MySQL_Connection *)conns->remove_index_fast(_k);
+	if ((unsigned int)_k < conns->len) {
+		// remove_index_fast() moved the last element into the freed slot
+		MySQL_Connection *moved = (MySQL_Connection *)conns->index(_k);
+		moved->pool_list_idx = _k;
+	}
+	if (indexed) {
+		fingerprint_remove(c);
+	}
+	return c;
 }
 
-MySrvConnList::MySrvConnList(MySrvC *_mysrvc) {
+MySrvConnList::MySrvConnList(MySrvC *_mysrvc, bool _indexed) {
 	mysrvc=_mysrvc;
+	indexed=_indexed;
 	conns=new PtrArray();
 }
 
 void MySrvConnList::add(MySQL_Connection *c) {
+	c->pool_list_idx = conns->len;
 	conns->add(c);
+	if (indexed) {
+		// the state of a free connection doesn't change until it is removed from the list
+		c->pool_fingerprint = c->compute_pool_fingerprint();
+		std::vector<MySQL_Connection *>& bucket = fingerprints[c->pool_fingerprint];
+		c->pool_fingerprint_idx = bucket.size();
+		bucket.push_back(c);
+	}
+}
+
+void MySrvConnList::fingerprint_remove(MySQL_Connection *c) {
+	auto it = fingerprints.find(c->pool_fingerprint);
+	// LCOV_EXCL_START
+	assert(it != fingerprints.end());
+	assert(c->pool_fingerprint_idx < it->second.size() && it->second[c->pool_fingerprint_idx] == c);
+	// LCOV_EXCL_STOP
+	std::vector<MySQL_Connection *>& bucket = it->second;
+	// the last connection of the bucket takes the freed slot
+	MySQL_Connection *moved = bucket.back();
+	bucket[c->pool_fingerprint_idx] = moved;
+	moved->pool_fingerprint_idx = c->pool_fingerprint_idx;
+	bucket.pop_back();
+	if (bucket.empty()) {
+		fingerprints.erase(it);
+	}
+}
+
+/**
+ * @brief Looks up, through the fingerprints index, a connection that perfectly matches 'client_conn'.
+ * @details Candidates are verified with the same checks performed by 'get_random_MyConn_inner_search'
+ *  to rule out fingerprint collisions. The search starts from a random connection of the bucket, so
+ *  that the matching connections are used evenly. If found, the connection is removed from the list.
+ * @return The matching connection, or NULL if no connection is a perfect match.
+ */
+MySQL_Connection * MySrvConnList::get_MyConn_by_fingerprint(const MySQL_Connection *client_conn) {
+	uint64_t fp = client_conn->compute_pool_fingerprint();
+	auto it = fingerprints.find(fp);
+	if (it == fingerprints.end()) {
+		return NULL;
+	}
+	const std::vector<MySQL_Connection *>& bucket = it->second;
+	const unsigned int l = bucket.size();
+	const unsigned int start = fastrand() % l;
+	// barring collisions, the first candidate is a match
+	for (unsigned int k = 0; k < l; k++) {
+		MySQL_Connection *conn = bucket[(start + k) % l];
+		if (conn->match_tracked_options(client_conn) == false) continue;
+		if (conn->requires_CHANGE_USER(client_conn) == true) continue;
+		if (strcmp(conn->userinfo->schemaname, client_conn->userinfo->schemaname)) continue;
+		unsigned int not_match = 0;
+		conn->number_of_matching_session_variables(client_conn, not_match);
+		if (not_match) continue;
+		int idx = find_idx(conn);
+		assert(idx >= 0);
+		return remove(idx);
+	}
+	return NULL;
 }
 
 MySrvConnList::~MySrvConnList() {
 	mysrvc=NULL;
+	fingerprints.clear();
 	while (conns_length()) {
 		MySQL_Connection *conn=(MySQL_Connection *)conns->remove_index_fast(0);
 		delete conn;
@@ -41,6 +125,7 @@ MySrvConnList::~MySrvConnList() {
 
 void MySrvConnList::drop_all_connections() {
 	proxy_debug(PROXY_DEBUG_MYSQL_CONNPOOL, 7, "Dropping all connections (%u total) on MySrvConnList %p for server %s:%d , hostgroup=%d , status=%d\n", conns_length(), this, mysrvc->address, mysrvc->port, mysrvc->myhgc->hid, (int)mysrvc->get_status());
+	fingerprints.clear();
 	while (conns_length()) {
 		MySQL_Connection *conn=(MySQL_Connection *)conns->remove_index_fast(0);
 		delete conn;
@@ -147,6 +232,14 @@ MySQL_Connection * MySrvConnList::get_random_MyConn(MySQL_Session *sess, bool ff
 		}
 		if (sess && sess->client_myds && sess->client_myds->myconn && sess->client_myds->myconn->userinfo) {
 			MySQL_Connection * client_conn = sess->client_myds->myconn;
+			if (indexed) {
+				// fast path: a perfect match doesn't require to scan the whole list
+				conn = get_MyConn_by_fingerprint(client_conn);
+				if (conn) {
+					proxy_debug(PROXY_DEBUG_MYSQL_CONNPOOL, 7, "Returning MySQL Connection %p, server %s:%d\n", conn, conn->parent->address, conn->parent->port);
+					return conn;
+				}
+			}
 			get_random_MyConn_inner_search(i, l, conn_found_idx, connection_quality_level, number_of_matching_session_variables, client_conn);
 			if (connection_quality_level !=3 ) { // we didn't find the perfect connection
 				get_random_MyConn_inner_search(0, i, conn_found_idx, connection_quality_level, number_of_matching_session_variables, client_conn);
@@ -204,14 +297,14 @@ MySQL_Connection * MySrvConnList::get_random_MyConn(MySQL_Session *sess, bool ff
 						__sync_fetch_and_add(&MyHGM->status.server_connections_created, 1);
 						proxy_debug(PROXY_DEBUG_MYSQL_CONNPOOL, 7, "Returning MySQL Connection %p, server %s:%d\n", conn, conn->parent->address, conn->parent->port);
 					} else {
-						conn=(MySQL_Connection *)conns->remove_index_fast(conn_found_idx);
+						conn=remove(conn_found_idx);
 					}
 					}
 					break;
 				case 2: // tracked options are OK , CHANGE USER is not required, but some SET statement or INIT_DB needs to be executed
 				case 3: // tracked options are OK , CHANGE USER is not required, and it seems that SET statements or INIT_DB ARE not required
 					// here we return the best connection we have, no matter if connection_quality_level is 2 or 3
-					conn=(MySQL_Connection *)conns->remove_index_fast(conn_found_idx);
+					conn=remove(conn_found_idx);
 					break;
 				default: // this should never happen
 					// LCOV_EXCL_START
@@ -220,7 +313,7 @@ MySQL_Connection * MySrvConnList::get_random_MyConn(MySQL_Session *sess, bool ff
 					// LCOV_EXCL_STOP
 			}
 		} else {
-			conn=(MySQL_Connection *)conns->remove_index_fast(i);
+			conn=remove(i);
 		}
 		proxy_debug(PROXY_DEBUG_MYSQL_CONNPOOL, 7, "Returning MySQL Connection %p, server %s:%d\n", conn, conn->parent->address, conn->parent->port);
 		return conn;
@@ -3193,6 +3193,11 @@ bool ProxySQL_Admin::GenericRefreshStatistics(const char *query_no_space, unsign
 	bool runtime_clickhouse_users = false;
 #endif /* PROXYSQLCLICKHOUSE */
 
+	bool monitor_mysql_server_connect_log=false;
+	bool monitor_mysql_server_ping_log=false;
+	bool monitor_mysql_server_read_only_log=false;
+	bool monitor_mysql_server_replication_lag_log=false;
+
 	bool monitor_mysql_server_group_replication_log=false;
 
 	bool monitor_mysql_server_galera_log=false;
@@ -3352,6 +3357,18 @@ bool ProxySQL_Admin::GenericRefreshStatistics(const char *query_no_space, unsign
 
 		}
 	}
+	if (strstr(query_no_space,"mysql_server_connect_log")) {
+		monitor_mysql_server_connect_log=true; refresh=true;
+	}
+	if (strstr(query_no_space,"mysql_server_ping_log")) {
+		monitor_mysql_server_ping_log=true; refresh=true;
+	}
+	if (strstr(query_no_space,"mysql_server_read_only_log")) {
+		monitor_mysql_server_read_only_log=true; refresh=true;
+	}
+	if (strstr(query_no_space,"mysql_server_replication_lag_log")) {
+		monitor_mysql_server_replication_lag_log=true; refresh=true;
+	}
 	if (strstr(query_no_space,"mysql_server_group_replication_log")) {
 		monitor_mysql_server_group_replication_log=true; refresh=true;
 	}
@@ -3499,6 +3516,26 @@ bool ProxySQL_Admin::GenericRefreshStatistics(const char *query_no_space, unsign
 #endif /* PROXYSQLCLICKHOUSE */
 
 		}
+		if (monitor_mysql_server_connect_log) {
+			if (GloMyMon) {
+				GloMyMon->connect_log.populate_table(GloMyMon->monitordb);
+			}
+		}
+		if (monitor_mysql_server_ping_log) {
+			if (GloMyMon) {
+				GloMyMon->ping_log.populate_table(GloMyMon->monitordb);
+			}
+		}
+		if (monitor_mysql_server_read_only_log) {
+			if (GloMyMon) {
+				GloMyMon->read_only_log.populate_table(GloMyMon->monitordb);
+			}
+		}
+		if (monitor_mysql_server_replication_lag_log) {
+			if (GloMyMon) {
+				GloMyMon->replication_lag_log.populate_table(GloMyMon->monitordb);
+			}
+		}
 		if (monitor_mysql_server_group_replication_log) {
 			if (GloMyMon) {
 				GloMyMon->populate_monitor_mysql_server_group_replication_log();
@@ -4852,9 +4889,9 @@ void admin_session_handler(MySQL_Session *sess, void *_pa, PtrSize_t *pkt) {
 		if (rc) {
 			string *new_query=new std::string(query_no_space);
 			RE2::Replace(new_query,(char *)"^(\\w+)\\s+@@(\\w+)\\s*",(char *)"SELECT variable_value AS '@@max_allowed_packet' FROM global_variables WHERE variable_name='mysql-max_allowed_packet'");
-			free(query);
+			l_free(query_length,query);
 			query_length=new_query->length()+1;
-			query=(char *)malloc(query_length);
+			query=(char *)l_alloc(query_length);
 			memcpy(query,new_query->c_str(),query_length-1);
 			query[query_length-1]='\0';
 			delete new_query;
@@ -4867,9 +4904,9 @@ void admin_session_handler(MySQL_Session *sess, void *_pa, PtrSize_t *pkt) {
 		if (rc) {
 			string *new_query=new std::string(query_no_space);
 			RE2::Replace(new_query,(char *)"^(\\w+)  *@@([0-9A-Za-z_-]+) *",(char *)"SELECT variable_value AS '@@\\2' FROM global_variables WHERE variable_name='\\2' COLLATE NOCASE UNION ALL SELECT variable_value AS '@@\\2' FROM stats.stats_mysql_global WHERE variable_name='\\2' COLLATE NOCASE");
-			free(query);
+			l_free(query_length,query);
 			query_length=new_query->length()+1;
-			query=(char *)malloc(query_length);
+			query=(char *)l_alloc(query_length);
 			memcpy(query,new_query->c_str(),query_length-1);
 			query[query_length-1]='\0';
 			GloAdmin->stats___mysql_global();
@@ -4883,9 +4920,9 @@ void admin_session_handler(MySQL_Session *sess, void *_pa, PtrSize_t *pkt) {
 		if (rc) {
 			string *new_query=new std::string(query_no_space);
 			RE2::Replace(new_query,(char *)"([Ss][Hh][Oo][Ww]\\s+[Vv][Aa][Rr][Ii][Aa][Bb][Ll][Ee][Ss]\\s+[Ww][Hh][Ee][Rr][Ee])",(char *)"SELECT variable_name AS Variable_name, variable_value AS Value FROM global_variables WHERE");
-			free(query);
+			l_free(query_length,query);
 			query_length=new_query->length()+1;
-			query=(char *)malloc(query_length);
+			query=(char *)l_alloc(query_length);
 			memcpy(query,new_query->c_str(),query_length-1);
 			query[query_length-1]='\0';
 			delete new_query;
@@ -4898,9 +4935,9 @@ void admin_session_handler(MySQL_Session *sess, void *_pa, PtrSize_t *pkt) {
 		if (rc) {
 			string *new_query=new std::string(query_no_space);
 			RE2::Replace(new_query,(char *)"([Ss][Hh][Oo][Ww]\\s+[Vv][Aa][Rr][Ii][Aa][Bb][Ll][Ee][Ss]\\s+[Ll][Ii][Kk][Ee])",(char *)"SELECT variable_name AS Variable_name, variable_value AS Value FROM global_variables WHERE variable_name LIKE");
-			free(query);
+			l_free(query_length,query);
 			query_length=new_query->length()+1;
-			query=(char *)malloc(query_length);
+			query=(char *)l_alloc(query_length);
 			memcpy(query,new_query->c_str(),query_length-1);
 			query[query_length-1]='\0';
 			delete new_query;
@@ -5059,9 +5096,9 @@ void admin_session_handler(MySQL_Session *sess, void *_pa, PtrSize_t *pkt) {
 			l_free(query_length,query);
 			char *q=(char *)"SELECT '%s' AS 'table', '%s' AS 'checksum'";
 			char *checksum=(char *)resultset->checksum();
-			query=(char *)malloc(strlen(q)+strlen(tablename)+strlen(checksum)+1);
+			query_length=strlen(q)+strlen(tablename)+strlen(checksum)+1;
+			query=(char *)l_alloc(query_length);
 			sprintf(query,q,tablename,checksum);
-			query_length = strlen(query);
 			free(checksum);
 			delete resultset;
 		}
@@ -9583,6 +9620,17 @@ void ProxySQL_Admin::stats___memory_metrics() {
 		free(query);
 	}
 #endif
+#ifdef PROXYSQL_SLAB_ALLOC
+	{
+		// bytes in the chunks mapped by the l_alloc() slab allocator
+		vn=(char *)"slab_allocated_bytes";
+		sprintf(bu,"%lu",l_slab_get_allocated_bytes());
+		query=(char *)malloc(strlen(a)+strlen(vn)+strlen(bu)+16);
+		sprintf(query,a,vn,bu);
+		statsdb->execute(query);
+		free(query);
+	}
+#endif /* PROXYSQL_SLAB_ALLOC */
 	{
 		if (GloMyAuth) {
 			unsigned long mu = GloMyAuth->memory_usage();
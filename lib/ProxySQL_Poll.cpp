@@ -6,6 +6,7 @@
 #include "ProxySQL_Poll.h"
 #include "proxysql_structs.h"
 #include <poll.h>
+#include <sys/epoll.h>
 #include "cpp.h"
 
 
@@ -30,6 +31,7 @@ void ProxySQL_Poll::shrink() {
 	myds=(MySQL_Data_Stream **)realloc(myds,new_size*sizeof(MySQL_Data_Stream *));
 	last_recv=(unsigned long long *)realloc(last_recv,new_size*sizeof(unsigned long long));
 	last_sent=(unsigned long long *)realloc(last_sent,new_size*sizeof(unsigned long long));
+	resize_sets(new_size);
 	size=new_size;
 }
 
@@ -48,10 +50,22 @@ void ProxySQL_Poll::expand(unsigned int more) {
 		myds=(MySQL_Data_Stream **)realloc(myds,new_size*sizeof(MySQL_Data_Stream *));
 		last_recv=(unsigned long long *)realloc(last_recv,new_size*sizeof(unsigned long long));
 		last_sent=(unsigned long long *)realloc(last_sent,new_size*sizeof(unsigned long long));
+		resize_sets(new_size);
 		size=new_size;
 	}
 }
 
+/**
+ * @brief Resizes the flags of the index sets to 'new_size' entries.
+ *
+ * The entries beyond 'len' are never part of a set, see ProxySQL_Poll_Index_Set::remove().
+ */
+void ProxySQL_Poll::resize_sets(unsigned int new_size) {
+	dirty.flags.resize(new_size, 0);
+	ready.flags.resize(new_size, 0);
+	sync.flags.resize(new_size, 0);
+}
+
 /**
  * @brief Constructs a new ProxySQL_Poll object.
  * 
@@ -69,6 +83,13 @@ ProxySQL_Poll::ProxySQL_Poll() {
 	myds=(MySQL_Data_Stream **)malloc(size*sizeof(MySQL_Data_Stream *));
 	last_recv=(unsigned long long *)malloc(size*sizeof(unsigned long long));
 	last_sent=(unsigned long long *)malloc(size*sizeof(unsigned long long));
+	backend=POLL_BACKEND_POLL;
+	epfd=-1;
+	ep_events=NULL;
+	ep_events_size=0;
+	full_sync=false;
+	full_scan=false;
+	resize_sets(size);
 }
 
 /**
@@ -89,6 +110,10 @@ ProxySQL_Poll::~ProxySQL_Poll() {
 	free(fds);
 	free(last_recv);
 	free(last_sent);
+	free(ep_events);
+	if (epfd >= 0) {
+		close(epfd);
+	}
 	delete loop_counters;
 }
 
@@ -117,6 +142,11 @@ void ProxySQL_Poll::add(uint32_t _events, int _fd, MySQL_Data_Stream *_myds, uns
 	}
 	last_recv[len]=monotonic_time();
 	last_sent[len]=sent_time;
+	fd_ref(_fd, len);
+	if (backend == POLL_BACKEND_EPOLL) {
+		dirty.insert(len);
+		sync.insert(len);
+	}
 	len++;
 }
 
@@ -131,6 +161,7 @@ void ProxySQL_Poll::add(uint32_t _events, int _fd, MySQL_Data_Stream *_myds, uns
 void ProxySQL_Poll::remove_index_fast(unsigned int i) {
 	if ((int)i==-1) return;
 	myds[i]->poll_fds_idx=-1; // this prevents further delete
+	fd_unref(fds[i].fd);
 	if (i != (len-1)) {
 		myds[i]=myds[len-1];
 		fds[i].fd=fds[len-1].fd;
@@ -139,7 +170,13 @@ void ProxySQL_Poll::remove_index_fast(unsigned int i) {
 		myds[i]->poll_fds_idx=i;  // fix a serious bug
 		last_recv[i]=last_recv[len-1];
 		last_sent[i]=last_sent[len-1];
+		if (fds[i].fd >= 0 && fd_states[fds[i].fd].idx == len-1) {
+			fd_states[fds[i].fd].idx = i;
+		}
 	}
+	dirty.remove(i, len-1);
+	ready.remove(i, len-1);
+	sync.remove(i, len-1);
 	len--;
 	if ( ( len>MIN_POLL_LEN ) && ( size > len*MIN_POLL_DELETE_RATIO ) ) {
 		shrink();
@@ -164,3 +201,189 @@ int ProxySQL_Poll::find_index(int fd) {
 	}
 	return -1;
 }
+
+/**
+ * @brief Tracks that an entry with fd number 'fd' was added at index 'idx'.
+ *
+ * If another entry with the same fd number is already present, it must belong to a socket
+ * already closed (that would be reported as POLLNVAL by poll()) and about to be removed: the
+ * registration is verified again by the next epoll_sync().
+ */
+void ProxySQL_Poll::fd_ref(int fd, unsigned int idx) {
+	if (fd < 0) return;
+	if ((unsigned int)fd >= fd_states.size()) {
+		fd_states.resize(l_near_pow_2(fd+1), fd_state_t { 0, 0, 0, false });
+	}
+	fd_state_t& st = fd_states[fd];
+	if (st.refs) {
+		st.registered = false;
+	}
+	st.refs++;
+	st.idx = idx;
+}
+
+/**
+ * @brief Tracks the removal of an entry with fd number 'fd', removing it from the epoll instance if needed.
+ */
+void ProxySQL_Poll::fd_unref(int fd) {
+	if (fd < 0) return;
+	fd_state_t& st = fd_states[fd];
+	st.refs--;
+	if (st.refs) {
+		// the fd number is still in use by another entry, see fd_ref(): its index isn't known
+		st.registered = false;
+		full_sync = true;
+		return;
+	}
+	if (st.registered) {
+		// the fd may be already closed, in which case the kernel already removed it and the error is harmless
+		epoll_ctl(epfd, EPOLL_CTL_DEL, fd, NULL);
+		st.registered = false;
+	}
+}
+
+/**
+ * @brief Selects the kernel interface used by wait().
+ *
+ * Switching to POLL_BACKEND_EPOLL creates the epoll instance, and all the current fds are registered
+ * by the next wait(). 'full_scan' is set, because 'dirty' and 'ready' are maintained only with the
+ * epoll backend. Switching back to POLL_BACKEND_POLL destroys it.
+ *
+ * @param _backend One of PROXYSQL_POLL_BACKEND.
+ */
+void ProxySQL_Poll::set_backend(int _backend) {
+	if (_backend == backend) return;
+	if (_backend == POLL_BACKEND_EPOLL) {
+		epfd = epoll_create1(EPOLL_CLOEXEC);
+		if (epfd == -1) {
+			proxy_error("epoll_create1() failed with error %d , using poll() instead\n", errno);
+			return;
+		}
+	} else {
+		close(epfd);
+		epfd = -1;
+	}
+	for (fd_state_t& st : fd_states) {
+		st.registered = false;
+	}
+	dirty.clear();
+	ready.clear();
+	sync.clear();
+	dirty_next.clear();
+	full_sync = true;
+	full_scan = true;
+	backend = _backend;
+}
+
+/**
+ * @brief Adds to 'dirty' the entries passed to keep_dirty() since the previous call.
+ */
+void ProxySQL_Poll::commit_dirty() {
+	for (unsigned int i : dirty_next) {
+		if (i < len) {
+			dirty.insert(i);
+		}
+	}
+	dirty_next.clear();
+}
+
+/**
+ * @brief Tracks that the callers may have changed 'fds[i].events'.
+ *
+ * The entry is reconciled with the epoll instance by the next wait() only if its events differ from
+ * the registered ones.
+ */
+void ProxySQL_Poll::events_changed(unsigned int i) {
+	if (backend != POLL_BACKEND_EPOLL) return;
+	int fd = fds[i].fd;
+	if (fd < 0) return; // ignored by poll() as well
+	const fd_state_t& st = fd_states[fd];
+	if (st.registered && st.events == fds[i].events) return;
+	sync.insert(i);
+}
+
+/**
+ * @brief Registers the events of entry 'i' in the epoll instance, if they changed.
+ */
+void ProxySQL_Poll::epoll_sync_entry(unsigned int i) {
+	struct epoll_event ev;
+	int fd = fds[i].fd;
+	if (fd < 0) return; // ignored by poll() as well
+	fd_state_t& st = fd_states[fd];
+	if (st.registered && st.events == fds[i].events) return;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = (uint32_t)fds[i].events & (EPOLLIN|EPOLLPRI|EPOLLOUT|EPOLLRDHUP);
+	ev.data.fd = fd;
+	int op = st.registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+	int rc = epoll_ctl(epfd, op, fd, &ev);
+	if (rc == -1) {
+		if (errno == EEXIST) {
+			rc = epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &ev);
+		} else if (errno == ENOENT) {
+			rc = epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+		}
+	}
+	if (rc == -1) {
+		// LCOV_EXCL_START
+		proxy_error("epoll_ctl() failed for FD=%d with error %d\n", fd, errno);
+		return;
+		// LCOV_EXCL_STOP
+	}
+	st.registered = true;
+	st.events = fds[i].events;
+}
+
+/**
+ * @brief Reconciles the fds registered in the epoll instance with the interest list in 'fds'.
+ *
+ * Only the entries in 'sync' are checked: the new ones, and the ones passed to events_changed().
+ * All the entries are checked after a switch of backend, or when the index of an entry isn't known.
+ */
+void ProxySQL_Poll::epoll_sync() {
+	if (full_sync) {
+		for (unsigned int i=0; i<len; i++) {
+			epoll_sync_entry(i);
+		}
+		sync.clear();
+		full_sync = false;
+		return;
+	}
+	unsigned int i;
+	while (sync.pop(len, i)) {
+		epoll_sync_entry(i);
+	}
+}
+
+int ProxySQL_Poll::epoll_wait_events(int timeout) {
+	epoll_sync();
+	if (ep_events_size < len) {
+		ep_events_size = l_near_pow_2(len);
+		ep_events = (struct epoll_event *)realloc(ep_events, ep_events_size*sizeof(struct epoll_event));
+	}
+	int rc = epoll_wait(epfd, ep_events, (len ? len : 1), timeout);
+	for (int i=0; i<rc; i++) {
+		const fd_state_t& st = fd_states[ep_events[i].data.fd];
+		// EPOLL* and POLL* flags have the same values on Linux
+		fds[st.idx].revents = (short)ep_events[i].events;
+		ready.insert(st.idx);
+	}
+	return rc;
+}
+
+/**
+ * @brief Waits for events on the fds, like poll(fds, len, timeout).
+ *
+ * With POLL_BACKEND_EPOLL only the entries with events have 'revents' set, and they are added to
+ * 'ready'. The caller must reset 'revents' of the entries of the previous 'ready' before calling
+ * wait(): MySQL_Thread::ProcessAllMyDS_AfterPoll() adds them to 'dirty', and
+ * MySQL_Thread::ProcessAllMyDS_BeforePoll() resets them.
+ *
+ * @param timeout Timeout in milliseconds.
+ * @return The number of entries with events, or -1 on error.
+ */
+int ProxySQL_Poll::wait(int timeout) {
+	if (backend == POLL_BACKEND_EPOLL) {
+		return epoll_wait_events(timeout);
+	}
+	return poll(fds, len, timeout);
+}
@@ -0,0 +1,118 @@
+#include <cstddef>
+#include <time.h>
+
+#include "ProxySQL_Timer_Wheel.h"
+
+#define TIMER_WHEEL_SLOT_MASK	(TIMER_WHEEL_SLOTS - 1)
+// range of the wheel, in ticks
+#define TIMER_WHEEL_MAX_DELTA	((1ULL << (TIMER_WHEEL_SLOT_BITS * TIMER_WHEEL_LEVELS)) - 1)
+
+ProxySQL_Timer_Wheel::ProxySQL_Timer_Wheel() {
+	for (unsigned int l = 0; l < TIMER_WHEEL_LEVELS; l++) {
+		for (unsigned int s = 0; s < TIMER_WHEEL_SLOTS; s++) {
+			slots[l][s].prev = &slots[l][s];
+			slots[l][s].next = &slots[l][s];
+		}
+	}
+	// same clock as monotonic_time()
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	current_tick = (((unsigned long long) ts.tv_sec) * 1000000 + (ts.tv_nsec / 1000)) / TIMER_WHEEL_TICK_US;
+	count = 0;
+}
+
+/**
+ * @brief Links 'n' in the slot matching its expiration: the lowest level whose range includes it.
+ * @details 'n->expires' must not be older than 'current_tick'.
+ */
+void ProxySQL_Timer_Wheel::link(timer_wheel_node *n) {
+	unsigned long long delta = n->expires - current_tick;
+	unsigned long long t = n->expires;
+	if (delta > TIMER_WHEEL_MAX_DELTA) {
+		// out of range, the timer will be cascaded again from the last level
+		delta = TIMER_WHEEL_MAX_DELTA;
+		t = current_tick + TIMER_WHEEL_MAX_DELTA;
+	}
+	unsigned int level = 0;
+	while (level < TIMER_WHEEL_LEVELS - 1 && delta >= (1ULL << (TIMER_WHEEL_SLOT_BITS * (level + 1)))) {
+		level++;
+	}
+	timer_wheel_node *head = &slots[level][(t >> (TIMER_WHEEL_SLOT_BITS * level)) & TIMER_WHEEL_SLOT_MASK];
+	n->next = head;
+	n->prev = head->prev;
+	head->prev->next = n;
+	head->prev = n;
+}
+
+void ProxySQL_Timer_Wheel::unlink(timer_wheel_node *n) {
+	n->prev->next = n->next;
+	n->next->prev = n->prev;
+	n->prev = NULL;
+	n->next = NULL;
+}
+
+/**
+ * @brief Moves the timers of the current slot of 'level' to the lower levels.
+ */
+void ProxySQL_Timer_Wheel::cascade(unsigned int level) {
+	timer_wheel_node *head = &slots[level][(current_tick >> (TIMER_WHEEL_SLOT_BITS * level)) & TIMER_WHEEL_SLOT_MASK];
+	timer_wheel_node *n = head->next;
+	// detach the whole list first, timers out of range are linked again in this same slot
+	head->prev->next = NULL;
+	head->next = head;
+	head->prev = head;
+	while (n && n != head) {
+		timer_wheel_node *next = n->next;
+		if (n->expires < current_tick) {
+			n->expires = current_tick;
+		}
+		link(n);
+		n = next;
+	}
+}
+
+void ProxySQL_Timer_Wheel::schedule(timer_wheel_node *n, unsigned long long expires_us) {
+	if (n->scheduled()) {
+		unlink(n);
+	} else {
+		count++;
+	}
+	n->expires = expires_us / TIMER_WHEEL_TICK_US;
+	if (n->expires <= current_tick) {
+		// the slot of current_tick was already processed
+		n->expires = current_tick + 1;
+	}
+	link(n);
+}
+
+void ProxySQL_Timer_Wheel::cancel(timer_wheel_node *n) {
+	if (n->scheduled()) {
+		unlink(n);
+		count--;
+	}
+}
+
+void ProxySQL_Timer_Wheel::advance(unsigned long long now_us, std::vector<timer_wheel_node *>& expired) {
+	unsigned long long now_tick = now_us / TIMER_WHEEL_TICK_US;
+	while (current_tick < now_tick) {
+		if (count == 0) {
+			// nothing to cascade or expire
+			current_tick = now_tick;
+			break;
+		}
+		current_tick++;
+		for (unsigned int level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+			if ((current_tick >> (TIMER_WHEEL_SLOT_BITS * (level - 1))) & TIMER_WHEEL_SLOT_MASK) {
+				break;
+			}
+			cascade(level);
+		}
+		timer_wheel_node *head = &slots[0][current_tick & TIMER_WHEEL_SLOT_MASK];
+		while (head->next != head) {
+			timer_wheel_node *n = head->next;
+			unlink(n);
+			count--;
+			expired.push_back(n);
+		}
+	}
+}
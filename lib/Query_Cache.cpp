@@ -8,6 +8,11 @@
 #include "prometheus_helpers.h"
 #include "MySQL_Protocol.h"
 
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <algorithm>
+#include <vector>
+
 #define THR_UPDATE_CNT(__a, __b, __c, __d) \
 	do {\
 		__a+=__c; \
@@ -37,6 +42,64 @@ extern MySQL_Threads_Handler *GloMTH;
 
 typedef btree::btree_map<uint64_t, QC_entry_t *> BtMap_cache;
 
+#define QC_SNAPSHOT_MAGIC 0x3153504E53435150ULL // "PQCSNPS1"
+#define QC_SNAPSHOT_VERSION 1
+
+/**
+ * @brief Header of a Query Cache snapshot file.
+ * @details It is followed by 'num_entries' records, each one made of a
+ *  'QC_snapshot_entry_t' immediately followed by 'length' bytes of resultset.
+ *  Monotonic times are not meaningful across restarts, so all the times stored
+ *  in the snapshot are wall clock times.
+ */
+struct QC_snapshot_header_t {
+	uint64_t magic;
+	uint32_t version;
+	uint32_t num_entries;
+	unsigned long long created_realtime_ms;
+};
+
+struct QC_snapshot_entry_t {
+	uint64_t key;
+	uint32_t length;
+	uint32_t column_eof_pkt_offset;
+	uint32_t row_eof_pkt_offset;
+	uint32_t ok_pkt_offset;
+	unsigned long long create_realtime_ms;
+	unsigned long long expire_realtime_ms;
+};
+
+/**
+ * @brief A snapshot file mapped in memory.
+ * @details Entries restored from a snapshot don't copy their resultset into
+ *  the heap: 'QC_entry_t::value' points inside the mapping. Every restored
+ *  entry holds a reference, and the file is unmapped when the last one is freed.
+ */
+class QC_Snapshot {
+	public:
+	void *addr;
+	size_t size;
+	uint32_t ref_count;
+	QC_Snapshot(void *_addr, size_t _size) : addr(_addr), size(_size), ref_count(1) {}
+	~QC_Snapshot() {
+		munmap(addr, size);
+	}
+	void release() {
+		if (__sync_sub_and_fetch(&ref_count,1)==0) {
+			delete this;
+		}
+	}
+};
+
+static void free_QC_entry(QC_entry_t *qce) {
+	if (qce->snapshot) {
+		qce->snapshot->release();
+	} else {
+		free(qce->value);
+	}
+	free(qce);
+}
+
 class KV_BtreeArray {
 	private:
 #ifdef PROXYSQL_QC_PTHREAD_MUTEX
@@ -58,8 +121,10 @@ class KV_BtreeArray {
 	void purge_some(unsigned long long, bool);
 	int cnt();
 	bool replace(uint64_t key, QC_entry_t *entry);
+	bool restore(uint64_t key, QC_entry_t *entry);
 	QC_entry_t *lookup(uint64_t key);
 	void empty();
+	void get_valid_entries(unsigned long long curtime_ms, std::vector<QC_entry_t *>& entries);
 };
 
 __thread uint64_t __thr_cntSet=0;
@@ -102,8 +167,7 @@ KV_BtreeArray::~KV_BtreeArray() {
 	QC_entry_t *qce=NULL;
 	while (ptrArray->len) {
 		qce=(QC_entry_t *)ptrArray->remove_index_fast(0);
-		free(qce->value);
-		free(qce);
+		free_QC_entry(qce);
 	}
 	delete ptrArray;
 };
@@ -201,8 +265,7 @@ void KV_BtreeArray::purge_some(unsigned long long QCnow_ms, bool aggressive) {
 				i--;
 				freed_memory+=qce->length;
 				removed_entries++;
-				free(qce->value);
-				free(qce);
+				free_QC_entry(qce);
 			}
 		}
 #ifdef PROXYSQL_QC_PTHREAD_MUTEX
@@ -296,6 +359,65 @@ void KV_BtreeArray::empty() {
 #endif
 };
 
+/**
+ * @brief Inserts an entry restored from a snapshot.
+ * @details Unlike 'replace()', the entry isn't accounted as a SET: only the
+ *  number of entries and the size of the values are updated. If the key was
+ *  already cached since the start, the existing entry is kept.
+ * @return True if the entry was inserted, false if the key was already present.
+ */
+bool KV_BtreeArray::restore(uint64_t key, QC_entry_t *entry) {
+	bool rc=false;
+#ifdef PROXYSQL_QC_PTHREAD_MUTEX
+	pthread_rwlock_wrlock(&lock);
+#else
+	spin_wrlock(&lock);
+#endif
+	if (bt_map.find(key) == bt_map.end()) {
+		THR_UPDATE_CNT(__thr_size_values,Glo_size_values,entry->length,1);
+		THR_UPDATE_CNT(__thr_num_entries,Glo_num_entries,1,1);
+		entry->ref_count=1;
+		ptrArray->add(entry);
+		bt_map.insert(std::make_pair(key,entry));
+		rc=true;
+	}
+#ifdef PROXYSQL_QC_PTHREAD_MUTEX
+	pthread_rwlock_unlock(&lock);
+#else
+	spin_wrunlock(&lock);
+#endif
+	return rc;
+}
+
+/**
+ * @brief Collects all the entries that are not expired, to write them into a snapshot.
+ * @details A reference is taken on every entry collected, so that they are not
+ *  purged while the snapshot is written without holding the lock. The caller
+ *  must release them decrementing 'ref_count'.
+ * @param curtime_ms Current monotonic time, in milliseconds.
+ * @param entries The vector the entries are appended to.
+ */
+void KV_BtreeArray::get_valid_entries(unsigned long long curtime_ms, std::vector<QC_entry_t *>& entries) {
+#ifdef PROXYSQL_QC_PTHREAD_MUTEX
+	pthread_rwlock_rdlock(&lock);
+#else
+	spin_rdlock(&lock);
+#endif
+	for (BtMap_cache::iterator it=bt_map.begin(); it!=bt_map.end(); ++it) {
+		QC_entry_t *qce=it->second;
+		if (qce->expire_ms==EXPIRE_DROPIT || qce->expire_ms<=curtime_ms) {
+			continue;
+		}
+		__sync_fetch_and_add(&qce->ref_count,1);
+		entries.push_back(qce);
+	}
+#ifdef PROXYSQL_QC_PTHREAD_MUTEX
+	pthread_rwlock_unlock(&lock);
+#else
+	spin_rdunlock(&lock);
+#endif
+}
+
 using metric_name = std::string;
 using metric_help = std::string;
 using metric_tags = std::map<std::string, std::string>;
@@ -431,6 +553,7 @@ Query_Cache::Query_Cache() {
 	QCnow_ms=monotonic_time()/1000;
 	size=SHARED_QUERY_CACHE_HASH_TABLES;
 	shutdown=0;
+	last_snapshot_ms=0;
 	purge_loop_time=DEFAULT_purge_loop_time;
 	purge_total_time=DEFAULT_purge_total_time;
 	purge_threshold_pct_min=DEFAULT_purge_threshold_pct_min;
@@ -697,6 +820,7 @@ bool Query_Cache::set(uint64_t user_hash, const unsigned char *kp, uint32_t kl,
 	entry->row_eof_pkt_offset=0;
 	entry->ok_pkt_offset=0;
 	entry->refreshing=false;
+	entry->snapshot=NULL;
 
 	// Find the first EOF location
 	unsigned char* it = vp;
@@ -787,6 +911,176 @@ uint64_t Query_Cache::flush() {
 	return total_count;
 };
 
+std::string Query_Cache::snapshot_path() {
+	return std::string(GloVars.datadir) + "/" + QC_SNAPSHOT_FILENAME;
+}
+
+/**
+ * @brief Writes the valid entries into the snapshot file in the datadir.
+ * @details The entries are collected from all the hash tables first, and
+ *  written without holding any lock. The most recently accessed entries are
+ *  written first, and at most 'mysql-query_cache_size_MB' of resultsets are
+ *  written, so that a restart restores the hot part of the cache.
+ *  The snapshot is written to a temporary file that is then renamed, so that a
+ *  snapshot currently mapped in memory is never modified.
+ * @return True if the snapshot was written, false otherwise.
+ */
+bool Query_Cache::save_snapshot() {
+	std::string path=snapshot_path();
+	std::string tmp_path=path + ".tmp";
+	FILE *f=fopen(tmp_path.c_str(), "w");
+	if (f==NULL) {
+		proxy_error("Unable to create Query Cache snapshot %s : %s\n", tmp_path.c_str(), strerror(errno));
+		return false;
+	}
+	QC_snapshot_header_t hdr;
+	hdr.magic=QC_SNAPSHOT_MAGIC;
+	hdr.version=QC_SNAPSHOT_VERSION;
+	hdr.num_entries=0;
+	hdr.created_realtime_ms=realtime_time()/1000;
+	unsigned long long curtime_ms=monotonic_time()/1000;
+	std::vector<QC_entry_t *> entries {};
+	for (int i=0; i<SHARED_QUERY_CACHE_HASH_TABLES; i++) {
+		KVs[i]->get_valid_entries(curtime_ms, entries);
+	}
+	std::sort(entries.begin(), entries.end(),
+		[] (const QC_entry_t *a, const QC_entry_t *b) { return a->access_ms > b->access_ms; }
+	);
+	uint64_t written_size=0;
+	bool rc = (fwrite(&hdr,sizeof(QC_snapshot_header_t),1,f)==1);
+	for (std::vector<QC_entry_t *>::iterator it=entries.begin(); it!=entries.end() && rc; ++it) {
+		QC_entry_t *qce=*it;
+		if (written_size + qce->length > max_memory_size) {
+			break;
+		}
+		QC_snapshot_entry_t se;
+		se.key=qce->key;
+		se.length=qce->length;
+		se.column_eof_pkt_offset=qce->column_eof_pkt_offset;
+		se.row_eof_pkt_offset=qce->row_eof_pkt_offset;
+		se.ok_pkt_offset=qce->ok_pkt_offset;
+		se.create_realtime_ms=hdr.created_realtime_ms - (curtime_ms > qce->create_ms ? curtime_ms - qce->create_ms : 0);
+		se.expire_realtime_ms=hdr.created_realtime_ms + (qce->expire_ms > curtime_ms ? qce->expire_ms - curtime_ms : 0);
+		if (fwrite(&se,sizeof(QC_snapshot_entry_t),1,f)!=1 || fwrite(qce->value,1,qce->length,f)!=qce->length) {
+			rc=false;
+		} else {
+			written_size+=qce->length;
+			hdr.num_entries++;
+		}
+	}
+	for (std::vector<QC_entry_t *>::iterator it=entries.begin(); it!=entries.end(); ++it) {
+		__sync_fetch_and_sub(&(*it)->ref_count,1);
+	}
+	if (rc) {
+		// the header is rewritten with the final number of entries
+		rc = (fseek(f,0,SEEK_SET)==0 && fwrite(&hdr,sizeof(QC_snapshot_header_t),1,f)==1);
+	}
+	if (fclose(f)) {
+		rc=false;
+	}
+	if (rc) {
+		rc = (rename(tmp_path.c_str(), path.c_str())==0);
+	}
+	if (rc==false) {
+		proxy_error("Unable to write Query Cache snapshot %s : %s\n", path.c_str(), strerror(errno));
+		unlink(tmp_path.c_str());
+		return false;
+	}
+	proxy_debug(PROXY_DEBUG_QUERY_CACHE, 3, "Written %u entries into Query Cache snapshot %s\n", hdr.num_entries, path.c_str());
+	return true;
+}
+
+/**
+ * @brief Restores the entries of the snapshot file in the datadir.
+ * @details The file is mapped in memory and only the entries that are still
+ *  valid are inserted in the cache. Their resultsets are not copied: the pages
+ *  of the file are read by the kernel only when an entry is served.
+ *  Snapshots older than 'mysql-query_cache_persist_max_age_sec' are ignored.
+ * @return The number of entries restored.
+ */
+uint64_t Query_Cache::load_snapshot() {
+	uint64_t loaded=0;
+	std::string path=snapshot_path();
+	int fd=open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		if (errno != ENOENT) {
+			proxy_error("Unable to open Query Cache snapshot %s : %s\n", path.c_str(), strerror(errno));
+		}
+		return 0;
+	}
+	struct stat sb;
+	if (fstat(fd, &sb) || (size_t)sb.st_size < sizeof(QC_snapshot_header_t)) {
+		close(fd);
+		return 0;
+	}
+	size_t size=sb.st_size;
+	void *addr=mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (addr==MAP_FAILED) {
+		proxy_error("Unable to map Query Cache snapshot %s : %s\n", path.c_str(), strerror(errno));
+		return 0;
+	}
+	madvise(addr, size, MADV_RANDOM);
+	QC_Snapshot *snap=new QC_Snapshot(addr, size); // this reference is released at the end of the load
+	QC_snapshot_header_t hdr;
+	memcpy(&hdr, addr, sizeof(QC_snapshot_header_t));
+	unsigned long long curtime_ms=monotonic_time()/1000;
+	unsigned long long realtime_ms=realtime_time()/1000;
+	unsigned long long max_age_ms=(unsigned long long)mysql_thread___query_cache_persist_max_age_sec*1000;
+	if (hdr.magic!=QC_SNAPSHOT_MAGIC || hdr.version!=QC_SNAPSHOT_VERSION) {
+		proxy_warning("Ignoring Query Cache snapshot %s : invalid format\n", path.c_str());
+		snap->release();
+		return 0;
+	}
+	if (hdr.created_realtime_ms > realtime_ms || realtime_ms - hdr.created_realtime_ms > max_age_ms) {
+		proxy_info("Ignoring Query Cache snapshot %s : older than mysql-query_cache_persist_max_age_sec\n", path.c_str());
+		snap->release();
+		return 0;
+	}
+	const char *p=(const char *)addr + sizeof(QC_snapshot_header_t);
+	const char *end=(const char *)addr + size;
+	for (uint32_t n=0; n<hdr.num_entries; n++) {
+		QC_snapshot_entry_t se;
+		if ((size_t)(end - p) < sizeof(QC_snapshot_entry_t)) break;
+		memcpy(&se, p, sizeof(QC_snapshot_entry_t));
+		p+=sizeof(QC_snapshot_entry_t);
+		if ((size_t)(end - p) < se.length) break;
+		const char *value=p;
+		p+=se.length;
+		if (se.expire_realtime_ms <= realtime_ms) {
+			continue; // expired while proxysql was down
+		}
+		unsigned long long age_ms = (realtime_ms > se.create_realtime_ms ? realtime_ms - se.create_realtime_ms : 0);
+		if (age_ms >= curtime_ms) {
+			continue; // the entry can't be represented in monotonic time
+		}
+		QC_entry_t *entry=(QC_entry_t *)malloc(sizeof(QC_entry_t));
+		entry->key=se.key;
+		entry->value=(char *)value;
+		entry->snapshot=snap;
+		__sync_fetch_and_add(&snap->ref_count,1);
+		entry->self=entry;
+		entry->klen=0;
+		entry->length=se.length;
+		entry->create_ms=curtime_ms - age_ms;
+		entry->expire_ms=curtime_ms + (se.expire_realtime_ms - realtime_ms);
+		entry->access_ms=curtime_ms;
+		entry->refreshing=false;
+		entry->column_eof_pkt_offset=se.column_eof_pkt_offset;
+		entry->row_eof_pkt_offset=se.row_eof_pkt_offset;
+		entry->ok_pkt_offset=se.ok_pkt_offset;
+		entry->ref_count=0;
+		if (KVs[se.key%SHARED_QUERY_CACHE_HASH_TABLES]->restore(se.key, entry)) {
+			loaded++;
+		} else {
+			free_QC_entry(entry);
+		}
+	}
+	snap->release();
+	proxy_info("Loaded %lu entries from Query Cache snapshot %s\n", loaded, path.c_str());
+	return loaded;
+}
+
 void * Query_Cache::purgeHash_thread(void *) {
 	unsigned int i;
 	unsigned int MySQL_Monitor__thread_MySQL_Thread_Variables_version;
@@ -795,6 +1089,10 @@ void * Query_Cache::purgeHash_thread(void *) {
 	set_thread_name("QueryCachePurge");
 	mysql_thr->refresh_variables();
 	max_memory_size = (uint64_t) mysql_thread___query_cache_size_MB*1024*1024;
+	if (mysql_thread___query_cache_persist_interval_sec) {
+		load_snapshot();
+	}
+	last_snapshot_ms=monotonic_time()/1000;
 	while (shutdown==0) {
 		usleep(purge_loop_time);
 		unsigned long long t=monotonic_time()/1000;
@@ -807,12 +1105,21 @@ void * Query_Cache::purgeHash_thread(void *) {
 				max_memory_size = (uint64_t) mysql_thread___query_cache_size_MB*1024*1024;
 			}
 		}
+		if (mysql_thread___query_cache_persist_interval_sec) {
+			if (t > last_snapshot_ms + (unsigned long long)mysql_thread___query_cache_persist_interval_sec*1000) {
+				save_snapshot();
+				last_snapshot_ms=t;
+			}
+		}
 		unsigned int curr_pct=current_used_memory_pct();
 		if (curr_pct < purge_threshold_pct_min ) continue;
 		for (i=0; i<SHARED_QUERY_CACHE_HASH_TABLES; i++) {
 			KVs[i]->purge_some(QCnow_ms, (curr_pct > purge_threshold_pct_max));
 		}
 	}
+	if (mysql_thread___query_cache_persist_interval_sec) {
+		save_snapshot();
+	}
 	delete mysql_thr;
 	return NULL;
 };
@@ -183,7 +183,11 @@ PtrSizeArray::~PtrSizeArray() {
 void PtrSizeArray::shrink() {
 	unsigned int new_size=l_near_pow_2(len+1);
 	//pdata=(PtrSize_t *)realloc(pdata,new_size*sizeof(PtrSize_t));
-	pdata=(PtrSize_t *)realloc(pdata,new_size*sizeof(PtrSize_t));
+	// pdata comes from l_alloc(): it can't be passed to realloc()
+	PtrSize_t *new_pdata=(PtrSize_t *)l_alloc(new_size*sizeof(PtrSize_t));
+	memcpy(new_pdata,pdata,len*sizeof(PtrSize_t));
+	l_free(size*sizeof(PtrSize_t),pdata);
+	pdata=new_pdata;
 	size=new_size;
 }
 
@@ -427,6 +427,9 @@ MySQL_Connection::MySQL_Connection() {
 	inserted_into_pool=0;
 	reusable=false;
 	parent=NULL;
+	pool_list_idx=0;
+	pool_fingerprint=0;
+	pool_fingerprint_idx=0;
 	userinfo=new MySQL_Connection_userinfo();
 	fd=-1;
 	status_flags=0;
@@ -458,6 +461,7 @@ MySQL_Connection::MySQL_Connection() {
 	query.stmt=NULL;
 	query.stmt_meta=NULL;
 	query.stmt_result=NULL;
+	query.start_time=0;
 	largest_query_length=0;
 	warning_count=0;
 	multiplex_delayed=false;
@@ -740,6 +744,44 @@ bool MySQL_Connection::match_tracked_options(const MySQL_Connection *c) {
 	return false;
 }
 
+/**
+ * @brief Computes a fingerprint of the connection state relevant for connection pooling.
+ * @details The fingerprint covers the tracked client flags (see 'match_tracked_options'),
+ *  username, schema, and the session variables compared by 'number_of_matching_session_variables':
+ *  the variables that are set, excluding SQL_CHARACTER_ACTION. A backend connection and a client
+ *  connection with the same fingerprint are a perfect match for 'MySrvConnList::get_random_MyConn' ,
+ *  barring hash collisions. A backend connection with more variables set than the client can still
+ *  be a perfect match, found by the scan.
+ * @return The fingerprint of the connection.
+ */
+uint64_t MySQL_Connection::compute_pool_fingerprint() const {
+	SpookyHash sh;
+	sh.Init(0,0);
+	uint32_t cf = options.client_flag & (CLIENT_FOUND_ROWS | CLIENT_MULTI_STATEMENTS | CLIENT_MULTI_RESULTS | CLIENT_IGNORE_SPACE);
+	sh.Update(&cf, sizeof(cf));
+	// the NULL terminators are hashed as well, acting as delimiters
+	if (userinfo->username) {
+		sh.Update(userinfo->username, strlen(userinfo->username)+1);
+	}
+	if (userinfo->schemaname) {
+		sh.Update(userinfo->schemaname, strlen(userinfo->schemaname)+1);
+	}
+	for (uint32_t idx = 0; idx < SQL_NAME_LAST_LOW_WM; idx++) {
+		if (var_hash[idx] && idx != SQL_CHARACTER_ACTION) {
+			sh.Update(&idx, sizeof(uint32_t));
+			sh.Update(&var_hash[idx], sizeof(uint32_t));
+		}
+	}
+	for (std::vector<uint32_t>::const_iterator it = dynamic_variables_idx.begin(); it != dynamic_variables_idx.end(); it++) {
+		uint32_t idx = *it;
+		sh.Update(&idx, sizeof(uint32_t));
+		sh.Update(&var_hash[idx], sizeof(uint32_t));
+	}
+	uint64_t hash1, hash2;
+	sh.Final(&hash1, &hash2);
+	return hash1;
+}
+
 void MySQL_Connection::connect_start_SetAttributes() {
 	mysql_options4(mysql, MYSQL_OPT_CONNECT_ATTR_ADD, "program_name", "proxysql");
 	mysql_options4(mysql, MYSQL_OPT_CONNECT_ATTR_ADD, "_server_host", parent->address);
@@ -769,8 +811,9 @@ void MySQL_Connection::connect_start_SetAttributes() {
 
 void MySQL_Connection::connect_start_SetCharset() {
 	const char *csname = NULL;
-	/* Take client character set and use it to connect to backend */
-	if (myds && myds->sess) {
+	/* Take client character set and use it to connect to backend.
+	 * Pre-opened connections have no client: the default character set is used */
+	if (myds && myds->sess && myds->sess->client_myds) {
 		csname = mysql_variables.client_get_value(myds->sess, SQL_CHARACTER_SET);
 	}
 
@@ -1368,6 +1411,7 @@ handler_again:
 		case ASYNC_PING_TIMEOUT:
 			break;
 		case ASYNC_QUERY_START:
+			query.start_time=myds->sess->thread->curtime;
 			real_query_start();
 			__sync_fetch_and_add(&parent->queries_sent,1);
 			__sync_fetch_and_add(&parent->bytes_sent,query.length);
@@ -1437,6 +1481,7 @@ handler_again:
 
 		case ASYNC_STMT_EXECUTE_START:
 			PROXY_TRACE2();
+			query.start_time=myds->sess->thread->curtime;
 			stmt_execute_start();
 			__sync_fetch_and_add(&parent->queries_sent,1);
 			__sync_fetch_and_add(&parent->bytes_sent,query.stmt_meta->size);
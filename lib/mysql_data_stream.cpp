@@ -1,6 +1,8 @@
 #include "proxysql.h"
 #include "cpp.h"
 #include <zlib.h>
+#include <fcntl.h>
+#include <sys/uio.h>
 #ifndef UNIX_PATH_MAX
 #define UNIX_PATH_MAX    108
 #endif 
@@ -349,6 +351,11 @@ MySQL_Data_Stream::MySQL_Data_Stream() {
 	ssl_write_len = 0;
 	ssl_write_buf = NULL;
 	net_failure=false;
+	recv_buffer_filled=false;
+	splice_pipe[0]=-1;
+	splice_pipe[1]=-1;
+	splice_pipe_len=0;
+	gather_partial=0;
 	CompPktIN.pkt.ptr=NULL;
 	CompPktIN.pkt.size=0;
 	CompPktIN.partial=0;
@@ -417,6 +424,10 @@ MySQL_Data_Stream::~MySQL_Data_Stream() {
 		}
 	delete resultset;
 	}
+	if (splice_pipe[0] >= 0) {
+		close(splice_pipe[0]);
+		close(splice_pipe[1]);
+	}
 	if (mypolls) mypolls->remove_index_fast(poll_fds_idx);
 
 
@@ -576,10 +587,13 @@ int MySQL_Data_Stream::read_from_net() {
 
 	int r=0;
 	int s=queue_available(queueIN);
+	recv_buffer_filled=false;
 
 	if (encrypted == false) {
 		if (pkts_recv) {
 			r = recv(fd, queue_w_ptr(queueIN), s, 0);
+			// a short read means the socket receive queue was drained
+			recv_buffer_filled = (r == s);
 		} else {
 			if (queueIN.partial == 0) {
 				// we are reading the very first packet
@@ -718,8 +732,18 @@ int MySQL_Data_Stream::read_from_net() {
 
 int MySQL_Data_Stream::write_to_net() {
     int bytes_io=0;
+	if (splice_pipe_len) {
+		// data relayed with splice_to() precedes anything in queueOUT
+		bytes_io = splice_flush();
+		if (bytes_io < 0 || splice_pipe_len) {
+			return bytes_io;
+		}
+	}
 	int s = queue_data(queueOUT);
 	int n;
+	if (s==0 && can_gather_out()) {
+		return gather_to_net();
+	}
 	if (encrypted) {
 		//proxy_info("Data in write buffer: %d bytes\n", s);
 	}
@@ -827,14 +851,209 @@ int MySQL_Data_Stream::write_to_net() {
 	return bytes_io;
 }
 
+/**
+ * @brief Checks if the packets in PSarrayOUT can be sent with gather_to_net() instead of being copied into queueOUT.
+ * @details Only unencrypted and uncompressed data streams qualify, and only if queueOUT is empty. Once a
+ *  packet was partially sent by gather_to_net(), the rest of it must be sent by gather_to_net() as well.
+ *  During STATE_CLIENT_AUTH_OK array2buffer() is still used, as it enables compression after the last packet.
+ */
+bool MySQL_Data_Stream::can_gather_out() {
+	if (gather_partial) return true;
+	if (mysql_thread___gather_writes == 0) return false;
+	if (encrypted || PSarrayOUT->len == 0) return false;
+	if (queue_data(queueOUT) || queueOUT.partial) return false;
+	if (sess == NULL || sess->mirror == true) return false;
+	if (DSS == STATE_CLIENT_AUTH_OK) return false;
+	if (myconn && myconn->get_status(STATUS_MYSQL_CONNECTION_COMPRESSION) == true) return false;
+	return true;
+}
+
+/**
+ * @brief Sends the packets in PSarrayOUT with a single sendmsg(), without copying them into queueOUT.
+ * @details At most GATHER_OUT_MAX_IOV packets or GATHER_OUT_MAX_BYTES bytes are sent per call. Packets
+ *  completely sent are removed from PSarrayOUT, while the bytes already sent of the first packet not
+ *  completely sent are tracked in 'gather_partial'.
+ * @return The number of bytes sent, or the return value of sendmsg() in case of error.
+ */
+int MySQL_Data_Stream::gather_to_net() {
+	struct iovec iov[GATHER_OUT_MAX_IOV];
+	unsigned int niov=0;
+	size_t total=0;
+	while (niov < PSarrayOUT->len && niov < GATHER_OUT_MAX_IOV && total < GATHER_OUT_MAX_BYTES) {
+		PtrSize_t *pkt=PSarrayOUT->index(niov);
+		unsigned int offset = (niov == 0 ? gather_partial : 0);
+		iov[niov].iov_base=(unsigned char *)pkt->ptr + offset;
+		iov[niov].iov_len=pkt->size - offset;
+		total+=iov[niov].iov_len;
+		niov++;
+	}
+	if (niov == 0) {
+		return 0;
+	}
+	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov=iov;
+	msg.msg_iovlen=niov;
+#ifdef __APPLE__
+	int bytes_io = sendmsg(fd, &msg, 0);
+#else
+	int bytes_io = sendmsg(fd, &msg, MSG_NOSIGNAL);
+#endif
+	proxy_debug(PROXY_DEBUG_NET, 7, "Session=%p, Datastream=%p: sendmsg() wrote %d bytes out of %lu from %u packets in FD %d\n", sess, this, bytes_io, total, niov, fd);
+	if (bytes_io < 0) {
+		if ((poll_fds_idx < 0) || (mypolls->fds[poll_fds_idx].revents & POLLOUT)) {
+			shut_soft();
+		}
+		return bytes_io;
+	}
+	// release the packets completely sent
+	size_t left=bytes_io;
+	unsigned int idx=0;
+	while (idx < niov && left >= iov[idx].iov_len) {
+		left-=iov[idx].iov_len;
+		PtrSize_t *pkt=PSarrayOUT->index(idx);
+#ifdef DEBUG
+		{ __dump_pkt(__func__,(unsigned char *)pkt->ptr,pkt->size); }
+#endif
+		add_to_data_packet_history_without_alloc(data_packets_history_OUT,pkt->ptr,pkt->size);
+		idx++;
+	}
+	if (idx) {
+		PSarrayOUT->remove_index_range(0,idx);
+		pkts_sent+=idx;
+		gather_partial=0;
+	}
+	gather_partial+=left;
+	if (mypolls) mypolls->last_sent[poll_fds_idx]=sess->thread->curtime;
+	bytes_info.bytes_sent+=bytes_io;
+	if (bytes_io > 0) {
+		if (myds_type == MYDS_FRONTEND) {
+			if (sess) {
+				if (sess->thread) {
+					sess->thread->status_variables.stvar[st_var_queries_frontends_bytes_sent] += bytes_io;
+				}
+			}
+		}
+	}
+	return bytes_io;
+}
+
 bool MySQL_Data_Stream::available_data_out() {
 	int buflen=queue_data(queueOUT);
-	if (buflen || PSarrayOUT->len) {
+	if (buflen || PSarrayOUT->len || splice_pipe_len) {
 		return true;
 	}
 	return false;
 }
 
+/**
+ * @brief Checks if data received on this data stream can be relayed to 'dst' with splice_to().
+ * @details Only unencrypted fast_forward sessions qualify, and only if no data is buffered in
+ *  userspace on either side, as it must be delivered before any data relayed with splice().
+ */
+bool MySQL_Data_Stream::can_splice_to(MySQL_Data_Stream *dst) {
+	if (mysql_thread___fast_forward_splice == 0) return false;
+	if (sess == NULL || sess->session_fast_forward == false || sess->status != FAST_FORWARD) return false;
+	if (dst == NULL || dst->active == 0 || dst->fd < 0) return false;
+	if (encrypted || dst->encrypted) return false;
+	if (queue_data(queueIN) || PSarrayIN->len) return false;
+	if (queue_data(dst->queueOUT) || dst->PSarrayOUT->len) return false;
+	return true;
+}
+
+/**
+ * @brief Relays the data available on this data stream to 'dst' using splice(), without copying it in userspace.
+ * @details Data moves from the socket to 'dst->splice_pipe', and from there to the socket of 'dst'.
+ *  Data that can't be written immediately remains in the pipe, and it is written by 'dst->write_to_net()'.
+ *  On EOF the data stream is shut down only once 'dst' has drained the pipe, like data in 'queueOUT' is
+ *  written before closing: until then the backend isn't polled for POLLIN, see
+ *  MySQL_Thread::set_backend_to_be_skipped_if_frontend_is_slow(), and the EOF is read again once the pipe
+ *  is empty.
+ * @return The number of bytes read, 0 if no data was available, or -1 if the data stream was shut down.
+ */
+int MySQL_Data_Stream::splice_to(MySQL_Data_Stream *dst) {
+	if ( (revents & POLLHUP) && ((revents & POLLIN)==0) ) {
+		// POLLHUP is reported even if no events are requested: retry the flush at every loop
+		if (dst->splice_pipe_len && dst->splice_flush() >= 0 && dst->splice_pipe_len) {
+			return 0;
+		}
+		shut_soft();
+		return -1;
+	}
+	if ((revents & POLLIN)==0) return 0;
+	if (dst->splice_pipe[0] < 0) {
+		if (pipe2(dst->splice_pipe, O_NONBLOCK | O_CLOEXEC)) {
+			proxy_error("Session=%p, DataStream=%p -- pipe2() failed with error %d\n", sess, this, errno);
+			dst->splice_pipe[0] = -1;
+			dst->splice_pipe[1] = -1;
+			return 0;
+		}
+	}
+	ssize_t r = splice(fd, NULL, dst->splice_pipe[1], NULL, QUEUE_T_DEFAULT_SIZE, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+	proxy_debug(PROXY_DEBUG_NET, 5, "Session=%p: splice() read %ld bytes from fd %d\n", sess, r, fd);
+	if (r == 0) {
+		if (dst->splice_pipe_len && dst->splice_flush() >= 0 && dst->splice_pipe_len) {
+			proxy_debug(PROXY_DEBUG_NET, 5, "Session=%p: EOF on fd %d deferred, %u bytes left in the pipe\n", sess, fd, dst->splice_pipe_len);
+			return 0;
+		}
+		shut_soft();
+		return -1;
+	}
+	if (r < 0) {
+		if (errno != EINTR && errno != EAGAIN) {
+			shut_soft();
+			return -1;
+		}
+		return 0;
+	}
+	dst->splice_pipe_len += r;
+	bytes_info.bytes_recv += r;
+	if (myconn) {
+		// the data bypasses MySQL_Connection: account it as the connection would
+		myconn->bytes_info.bytes_recv += r;
+		if (myconn->parent) {
+			__sync_fetch_and_add(&myconn->parent->bytes_recv, r);
+		}
+	}
+	if (sess->thread) {
+		sess->thread->status_variables.stvar[st_var_queries_backends_bytes_recv] += r;
+		sess->thread->status_variables.stvar[st_var_fast_forward_splice_bytes] += r;
+	}
+	if (mypolls) mypolls->last_recv[poll_fds_idx]=sess->thread->curtime;
+	dst->splice_flush();
+	return r;
+}
+
+/**
+ * @brief Writes the data relayed by splice_to() to the socket.
+ * @return The number of bytes written, or -1 if the data stream was shut down.
+ */
+int MySQL_Data_Stream::splice_flush() {
+	int bytes_io = 0;
+	while (splice_pipe_len) {
+		ssize_t w = splice(splice_pipe[0], NULL, fd, NULL, splice_pipe_len, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+		proxy_debug(PROXY_DEBUG_NET, 5, "Session=%p: splice() wrote %ld bytes into fd %d\n", sess, w, fd);
+		if (w > 0) {
+			splice_pipe_len -= w;
+			bytes_io += w;
+		} else {
+			if (w == 0 || (errno != EINTR && errno != EAGAIN)) {
+				shut_soft();
+				return -1;
+			}
+			break; // POLLOUT is requested by set_pollout() , see available_data_out()
+		}
+	}
+	if (bytes_io) {
+		if (mypolls) mypolls->last_sent[poll_fds_idx]=sess->thread->curtime;
+		bytes_info.bytes_sent+=bytes_io;
+		if (myds_type == MYDS_FRONTEND && sess->thread) {
+			sess->thread->status_variables.stvar[st_var_queries_frontends_bytes_sent] += bytes_io;
+		}
+	}
+	return bytes_io;
+}
+
 void MySQL_Data_Stream::remove_pollout() {
 	struct pollfd *_pollfd;
 	_pollfd=&mypolls->fds[poll_fds_idx];
@@ -946,7 +1165,7 @@ int MySQL_Data_Stream::write_to_net_poll() {
 	}
 	proxy_debug(PROXY_DEBUG_NET,1,"Session=%p, DataStream=%p --\n", sess, this);
 	bool call_write_to_net = false;
-	if (queue_data(queueOUT)) {
+	if (queue_data(queueOUT) || splice_pipe_len || can_gather_out()) {
 		call_write_to_net = true;
 	}
 	if (call_write_to_net == false) {
@@ -1529,6 +1748,10 @@ void MySQL_Data_Stream::buffer2resultset(unsigned char *ptr, unsigned int size)
 int MySQL_Data_Stream::array2buffer_full() {
 	int rc=0;
 	int r=0;
+	if (can_gather_out()) {
+		// packets are sent directly from PSarrayOUT by write_to_net()
+		return rc;
+	}
 	while((r=array2buffer())) rc+=r;
 	return rc; 
 }
@@ -1545,7 +1768,10 @@ void MySQL_Data_Stream::unplug_backend() {
 	DSS=STATE_NOT_INITIALIZED;
 	myconn=NULL;
 	myds_type=MYDS_BACKEND_NOT_CONNECTED;
-  mypolls->remove_index_fast(poll_fds_idx);
+	// not in mypolls if the connect never started, e.g. while resolving the hostname of the server
+	if (mypolls) {
+		mypolls->remove_index_fast(poll_fds_idx);
+	}
   mypolls=NULL;
   fd=0;
 }
@@ -0,0 +1,145 @@
+#include <string.h>
+
+#include <algorithm>
+#include <iterator>
+
+#include "proxysql_gtid.h"
+
+void addGtidInterval(const std::string& uuid, int64_t from, int64_t to, gtid_set_t& gtid_executed) {
+	std::list<gtid_interval_t>& intervals = gtid_executed[uuid];
+	// most of the times new trxids extend the last interval
+	if (intervals.empty() == false && intervals.back().first <= from) {
+		gtid_interval_t& last = intervals.back();
+		if (from <= last.second + 1) {
+			last.second = std::max(last.second, to);
+		} else {
+			intervals.emplace_back(from, to);
+		}
+		return;
+	}
+	auto it = intervals.begin();
+	while (it != intervals.end() && it->second + 1 < from) {
+		++it;
+	}
+	if (it == intervals.end() || to + 1 < it->first) {
+		intervals.emplace(it, from, to);
+		return;
+	}
+	it->first = std::min(it->first, from);
+	it->second = std::max(it->second, to);
+	auto next = std::next(it);
+	while (next != intervals.end() && next->first <= it->second + 1) {
+		it->second = std::max(it->second, next->second);
+		next = intervals.erase(next);
+	}
+}
+
+static inline int64_t parse_trxid(const char *p, const char *end, const char **endptr) {
+	int64_t v = 0;
+	while (p < end && *p >= '0' && *p <= '9') {
+		v = v * 10 + (*p - '0');
+		p++;
+	}
+	*endptr = p;
+	return v;
+}
+
+void GTID_Stream_Parser::parse_bootstrap(const char *data, size_t len, gtid_set_t& gtid_executed) {
+	const char *end = data + len;
+	const char *p = data;
+	while (p < end) {
+		const char *token_end = (const char *)memchr(p, ',', end - p);
+		if (token_end == NULL) {
+			token_end = end;
+		}
+		while (p < token_end && *p == ' ') {
+			p++;
+		}
+		// '<uuid>:<from>-<to>[:<from>-<to>...]', the uuid is stored without dashes
+		const char *colon = (const char *)memchr(p, ':', token_end - p);
+		if (colon) {
+			uuid.clear();
+			for (const char *c = p; c < colon; c++) {
+				if (*c != '-') {
+					uuid.push_back(*c);
+				}
+			}
+			p = colon + 1;
+			while (p < token_end) {
+				const char *q = NULL;
+				int64_t trx_from = parse_trxid(p, token_end, &q);
+				int64_t trx_to = trx_from;
+				if (q < token_end && *q == '-') {
+					trx_to = parse_trxid(q + 1, token_end, &q);
+				}
+				if (q > p) {
+					addGtidInterval(uuid, trx_from, trx_to, gtid_executed);
+				}
+				p = (q < token_end && *q == ':') ? q + 1 : token_end;
+			}
+		}
+		p = token_end + 1;
+	}
+}
+
+size_t GTID_Stream_Parser::parse(const char *data, size_t len, gtid_set_t& gtid_executed, unsigned long long& events, bool& changed) {
+	size_t pos = 0;
+	// run of consecutive trxids of 'uuid' not yet added to 'gtid_executed'
+	bool run = false;
+	int64_t run_from = 0;
+	int64_t run_to = 0;
+	while (pos < len) {
+		const char *line = data + pos;
+		const char *nl = (const char *)memchr(line, '\n', len - pos);
+		if (nl == NULL) {
+			break;
+		}
+		const size_t l = nl - line;
+		pos += l + 1;
+		if (l < 3) {
+			continue;
+		}
+		if (strncmp(line, "ST=", 3) == 0) {
+			if (run) {
+				addGtidInterval(uuid, run_from, run_to, gtid_executed);
+				run = false;
+			}
+			parse_bootstrap(line + 3, l - 3, gtid_executed);
+			changed = true;
+		} else if (line[0] == 'I' && (line[1] == '1' || line[1] == '2')) {
+			const char *p = line + 3;
+			if (line[1] == '1') {
+				const char *colon = (const char *)memchr(p, ':', nl - p);
+				if (colon == NULL) {
+					continue;
+				}
+				const size_t ul = colon - p;
+				if (ul != uuid.size() || memcmp(uuid.data(), p, ul) != 0) {
+					if (run) {
+						addGtidInterval(uuid, run_from, run_to, gtid_executed);
+						run = false;
+					}
+					uuid.assign(p, ul);
+				}
+				p = colon + 1;
+			}
+			const int64_t trxid = parse_trxid(p, nl, &p);
+			if (run && trxid == run_to + 1) {
+				run_to = trxid;
+			} else {
+				if (run) {
+					addGtidInterval(uuid, run_from, run_to, gtid_executed);
+				}
+				run = true;
+				run_from = trxid;
+				run_to = trxid;
+			}
+			events++;
+			changed = true;
+		}
+	}
+	if (run) {
+		addGtidInterval(uuid, run_from, run_to, gtid_executed);
+	}
+	return pos;
+}
@@ -0,0 +1,237 @@
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include "proxysql_mem.h"
+
+/**
+ * @file proxysql_mem.cpp
+ * @brief Per-thread size-class slab allocator used by 'l_alloc()'/'l_free()' when ProxySQL is built
+ *   with 'WITHSLABALLOC=1'.
+ * @details Objects up to L_SLAB_MAX_ELEM_SIZE bytes are carved out of L_SLAB_CHUNK_SIZE chunks. Every
+ *   chunk holds objects of a single size class and belongs to the cache of the thread that allocated it.
+ *   - Objects freed by the owner thread are pushed into the local free list of their size class.
+ *   - Objects freed by any other thread (e.g. a session moved to another thread) are pushed into the
+ *     lock-free 'remote' list of the owner cache, that the owner drains when its local list is empty.
+ *   - Caches of terminated threads are never released: they are adopted by the next new thread, as
+ *     objects allocated from them may still be in use.
+ *   Chunks are tracked by a two-level page map, so 'l_slab_free()' can identify pointers not allocated
+ *   by the slab allocator (larger objects, or buffers allocated with 'malloc()') and pass them to 'free()'.
+ */
+
+#define L_SLAB_CHUNK_SHIFT	18
+#define L_SLAB_CHUNK_SIZE	(1UL << L_SLAB_CHUNK_SHIFT)
+#define L_SLAB_MIN_ELEM_SHIFT	4
+#define L_SLAB_MAX_ELEM_SHIFT	14
+#define L_SLAB_MAX_ELEM_SIZE	(1UL << L_SLAB_MAX_ELEM_SHIFT)
+#define L_SLAB_CLASSES	(L_SLAB_MAX_ELEM_SHIFT - L_SLAB_MIN_ELEM_SHIFT + 1)
+#define L_SLAB_ADDR_BITS	48
+#define L_SLAB_MAP_BITS	((L_SLAB_ADDR_BITS - L_SLAB_CHUNK_SHIFT) / 2)
+#define L_SLAB_MAP_LEN	(1UL << L_SLAB_MAP_BITS)
+
+typedef struct _l_slab_cache_t l_slab_cache;
+
+typedef struct _l_slab_chunk_t {
+	l_slab_cache *owner;
+	unsigned int cls;
+} l_slab_chunk;
+
+typedef struct _l_slab_class_t {
+	l_stack *local;
+	std::atomic<l_stack *> remote;
+	char *bump;
+	char *bump_end;
+} l_slab_class;
+
+struct _l_slab_cache_t {
+	l_slab_class cls[L_SLAB_CLASSES];
+	l_slab_cache *next_orphan;
+};
+
+typedef std::atomic<l_slab_chunk *> l_slab_map_leaf[L_SLAB_MAP_LEN];
+
+static std::atomic<l_slab_map_leaf *> l_slab_map[L_SLAB_MAP_LEN];
+static std::atomic<size_t> l_slab_chunks_bytes(0);
+
+static pthread_once_t l_slab_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t l_slab_key;
+static pthread_mutex_t l_slab_orphans_mutex = PTHREAD_MUTEX_INITIALIZER;
+static l_slab_cache *l_slab_orphans = NULL;
+
+static __thread l_slab_cache *l_slab_thr_cache = NULL;
+
+static inline unsigned int l_slab_class_idx(size_t s) {
+	if (s <= (1UL << L_SLAB_MIN_ELEM_SHIFT)) {
+		return 0;
+	}
+	return (64 - __builtin_clzl(s - 1)) - L_SLAB_MIN_ELEM_SHIFT;
+}
+
+static inline l_slab_chunk * l_slab_map_get(const void *p) {
+	uintptr_t addr = (uintptr_t)p;
+	if (addr >> L_SLAB_ADDR_BITS) {
+		return NULL;
+	}
+	uintptr_t idx = addr >> L_SLAB_CHUNK_SHIFT;
+	l_slab_map_leaf *leaf = l_slab_map[idx >> L_SLAB_MAP_BITS].load(std::memory_order_acquire);
+	if (leaf == NULL) {
+		return NULL;
+	}
+	return (*leaf)[idx & (L_SLAB_MAP_LEN - 1)].load(std::memory_order_acquire);
+}
+
+static bool l_slab_map_set(const void *p, l_slab_chunk *chunk) {
+	uintptr_t addr = (uintptr_t)p;
+	if (addr >> L_SLAB_ADDR_BITS) {
+		return false;
+	}
+	uintptr_t idx = addr >> L_SLAB_CHUNK_SHIFT;
+	std::atomic<l_slab_map_leaf *>& root = l_slab_map[idx >> L_SLAB_MAP_BITS];
+	l_slab_map_leaf *leaf = root.load(std::memory_order_acquire);
+	if (leaf == NULL) {
+		l_slab_map_leaf *new_leaf = (l_slab_map_leaf *)calloc(1, sizeof(l_slab_map_leaf));
+		if (new_leaf == NULL) {
+			return false;
+		}
+		if (root.compare_exchange_strong(leaf, new_leaf, std::memory_order_acq_rel)) {
+			leaf = new_leaf;
+		} else {
+			// another thread installed the leaf first, 'leaf' now points to it
+			free(new_leaf);
+		}
+	}
+	(*leaf)[idx & (L_SLAB_MAP_LEN - 1)].store(chunk, std::memory_order_release);
+	return true;
+}
+
+static void l_slab_thread_exit(void *arg) {
+	l_slab_cache *cache = (l_slab_cache *)arg;
+	l_slab_thr_cache = NULL;
+	pthread_mutex_lock(&l_slab_orphans_mutex);
+	cache->next_orphan = l_slab_orphans;
+	l_slab_orphans = cache;
+	pthread_mutex_unlock(&l_slab_orphans_mutex);
+}
+
+static void l_slab_key_init() {
+	pthread_key_create(&l_slab_key, l_slab_thread_exit);
+}
+
+static l_slab_cache * l_slab_thread_cache() {
+	if (l_slab_thr_cache) {
+		return l_slab_thr_cache;
+	}
+	pthread_once(&l_slab_key_once, l_slab_key_init);
+	pthread_mutex_lock(&l_slab_orphans_mutex);
+	l_slab_cache *cache = l_slab_orphans;
+	if (cache) {
+		l_slab_orphans = cache->next_orphan;
+	}
+	pthread_mutex_unlock(&l_slab_orphans_mutex);
+	if (cache == NULL) {
+		cache = (l_slab_cache *)calloc(1, sizeof(l_slab_cache));
+		if (cache == NULL) {
+			return NULL;
+		}
+	}
+	cache->next_orphan = NULL;
+	pthread_setspecific(l_slab_key, cache);
+	l_slab_thr_cache = cache;
+	return cache;
+}
+
+/**
+ * @brief Assigns a new chunk to the size class 'cls' of 'cache'.
+ * @return False if the chunk couldn't be allocated.
+ */
+static bool l_slab_new_chunk(l_slab_cache *cache, unsigned int cls) {
+	// map twice the size to get a chunk aligned to L_SLAB_CHUNK_SIZE, and release the excess
+	size_t map_size = L_SLAB_CHUNK_SIZE * 2;
+	char *m = (char *)mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (m == MAP_FAILED) {
+		return false;
+	}
+	char *base = (char *)(((uintptr_t)m + L_SLAB_CHUNK_SIZE - 1) & ~(L_SLAB_CHUNK_SIZE - 1));
+	if (base > m) {
+		munmap(m, base - m);
+	}
+	if (base + L_SLAB_CHUNK_SIZE < m + map_size) {
+		munmap(base + L_SLAB_CHUNK_SIZE, (m + map_size) - (base + L_SLAB_CHUNK_SIZE));
+	}
+	l_slab_chunk *chunk = (l_slab_chunk *)malloc(sizeof(l_slab_chunk));
+	if (chunk == NULL) {
+		munmap(base, L_SLAB_CHUNK_SIZE);
+		return false;
+	}
+	chunk->owner = cache;
+	chunk->cls = cls;
+	if (l_slab_map_set(base, chunk) == false) {
+		free(chunk);
+		munmap(base, L_SLAB_CHUNK_SIZE);
+		return false;
+	}
+	cache->cls[cls].bump = base;
+	cache->cls[cls].bump_end = base + L_SLAB_CHUNK_SIZE;
+	l_slab_chunks_bytes.fetch_add(L_SLAB_CHUNK_SIZE, std::memory_order_relaxed);
+	return true;
+}
+
+void * l_slab_alloc(size_t s) {
+	if (s > L_SLAB_MAX_ELEM_SIZE) {
+		return malloc(s);
+	}
+	l_slab_cache *cache = l_slab_thread_cache();
+	if (cache == NULL) {
+		return malloc(s);
+	}
+	unsigned int cls = l_slab_class_idx(s);
+	l_slab_class *sc = &cache->cls[cls];
+	void *p = l_stack_pop(&sc->local);
+	if (p) {
+		return p;
+	}
+	if (sc->remote.load(std::memory_order_relaxed)) {
+		sc->local = sc->remote.exchange(NULL, std::memory_order_acquire);
+		p = l_stack_pop(&sc->local);
+		if (p) {
+			return p;
+		}
+	}
+	if (sc->bump == sc->bump_end) {
+		if (l_slab_new_chunk(cache, cls) == false) {
+			return malloc(s);
+		}
+	}
+	p = sc->bump;
+	sc->bump += (1UL << (cls + L_SLAB_MIN_ELEM_SHIFT));
+	return p;
+}
+
+void l_slab_free(void *p) {
+	if (p == NULL) {
+		return;
+	}
+	l_slab_chunk *chunk = l_slab_map_get(p);
+	if (chunk == NULL) {
+		// not allocated by l_slab_alloc()
+		free(p);
+		return;
+	}
+	l_slab_class *sc = &chunk->owner->cls[chunk->cls];
+	if (chunk->owner == l_slab_thr_cache) {
+		l_stack_push(&sc->local, p);
+		return;
+	}
+	l_stack *d = (l_stack *)p;
+	l_stack *head = sc->remote.load(std::memory_order_relaxed);
+	do {
+		d->n = head;
+	} while (sc->remote.compare_exchange_weak(head, d, std::memory_order_release, std::memory_order_relaxed) == false);
+}
+
+size_t l_slab_get_allocated_bytes() {
+	return l_slab_chunks_bytes.load(std::memory_order_relaxed);
+}
@@ -1,6 +1,8 @@
 #include <cstdio>
 #include <cstdlib>
 #include <iostream>
+#include <algorithm>
+#include <vector>
 
 __thread unsigned int g_seed;
 
@@ -127,5 +129,30 @@ int main(int argc, char** argv) {
 		}
 		std::cerr << "DOUBLE test ran in \t";
 	}
+	{
+		// MyHGC::get_random_MySrvC_precomputed() : cumulative weights are computed
+		// only when servers change, at pick time only the picked server is checked
+		cpu_timer c;
+		std::vector<unsigned long long> cumulative_weights;
+		unsigned long long total = 0;
+		for (int j=0; j<N; j++) {
+			total += weights[j];
+			cumulative_weights.push_back(total);
+		}
+		unsigned int found = 0;
+		for (int i=0; i<NLOOP; i++) {
+			unsigned long long k;
+			if (total > 32768) {
+				k = rand() % total;
+			} else {
+				k = fastrand() % total;
+			}
+			unsigned int j = std::upper_bound(cumulative_weights.begin(), cumulative_weights.end(), k) - cumulative_weights.begin();
+			if (usedConns[j] < 1000) { // max_connections
+				found++;
+			}
+		}
+		std::cerr << "PRECOMPUTED test (" << found << " picks) ran in \t";
+	}
 	}
 }
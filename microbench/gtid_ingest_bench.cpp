@@ -0,0 +1,218 @@
+// Compares the ingestion of the proxysql_binlog_reader stream line by line, adding trxids one at a time
+// (as GTID_Server_Data did before), with the batched GTID_Stream_Parser, and measures the lookups on the
+// published GTID_Snapshot.
+// Build with:
+//   g++ -O2 -std=c++17 -I../include gtid_ingest_bench.cpp ../lib/proxysql_gtid.cpp ../lib/GTID_Snapshot.cpp ../lib/Epoch_Readers.cpp -o gtid_ingest_bench -lpthread
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <string>
+
+#include "proxysql_gtid.h"
+#include "GTID_Snapshot.h"
+
+__thread unsigned int g_seed;
+
+inline int fastrand() {
+	g_seed = (214013*g_seed+2531011);
+	return (g_seed>>16)&0x7FFF;
+}
+
+inline unsigned long long monotonic_time() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (((unsigned long long) ts.tv_sec) * 1000000) + (ts.tv_nsec / 1000);
+}
+
+#define NGTIDS	5000000
+#define NUUIDS	3
+#define NLOOKUPS	10000000
+// size of the chunks the stream is read in, like the reads from the socket
+#define CHUNK_SIZE	65536
+
+struct cpu_timer
+{
+	cpu_timer(unsigned long long _events) : events(_events) {
+		begin = monotonic_time();
+	}
+	~cpu_timer()
+	{
+		unsigned long long end = monotonic_time();
+		double secs = double( end - begin ) / 1000000;
+		std::cerr << secs << " secs, " << (unsigned long long)(events / secs) << " GTIDs/sec.\n" ;
+	};
+	unsigned long long begin;
+	unsigned long long events;
+};
+
+// as sent by the binlog reader, without dashes
+const char *uuids[NUUIDS] = {
+	"3E11FA4771CA11E19E33C80AA9429562",
+	"4F22AB5882DB22F2AF44D91BB0530673",
+	"5A33BC6993EC33A3BA55EA2CC1641784",
+};
+
+// mostly consecutive trxids from a primary, with a few writes from the other uuids and some gaps
+std::string generate_stream() {
+	std::string stream = "ST=" + std::string(uuids[0]) + ":1-1000\n";
+	int64_t trxids[NUUIDS] = { 1000, 0, 0 };
+	int cur = -1;
+	char line[128];
+	for (int i = 0; i < NGTIDS; i++) {
+		int u = (fastrand() % 100 < 98) ? 0 : 1 + fastrand() % (NUUIDS - 1);
+		trxids[u] += (fastrand() % 20000 == 0) ? 2 : 1;
+		if (u != cur) {
+			snprintf(line, sizeof(line), "I1=%s:%ld\n", uuids[u], trxids[u]);
+			cur = u;
+		} else {
+			snprintf(line, sizeof(line), "I2=%ld\n", trxids[u]);
+		}
+		stream += line;
+	}
+	return stream;
+}
+
+// the previous per-event insertion, from GTID_Server_Data.cpp
+void addGtid(const gtid_t& gtid, gtid_set_t& gtid_executed) {
+	auto it = gtid_executed.find(gtid.first);
+	if (it == gtid_executed.end())
+	{
+		gtid_executed[gtid.first].emplace_back(gtid.second, gtid.second);
+		return;
+	}
+
+	bool flag = true;
+	for (auto itr = it->second.begin(); itr != it->second.end(); ++itr)
+	{
+		if (gtid.second >= itr->first && gtid.second <= itr->second)
+			return;
+		if (gtid.second + 1 == itr->first)
+		{
+			--itr->first;
+			flag = false;
+			break;
+		}
+		else if (gtid.second == itr->second + 1)
+		{
+			++itr->second;
+			flag = false;
+			break;
+		}
+		else if (gtid.second < itr->first)
+		{
+			it->second.emplace(itr, gtid.second, gtid.second);
+			return;
+		}
+	}
+
+	if (flag)
+		it->second.emplace_back(gtid.second, gtid.second);
+
+	for (auto itr = it->second.begin(); itr != it->second.end(); ++itr)
+	{
+		auto next_itr = std::next(itr);
+		if (next_itr != it->second.end() && itr->second + 1 == next_itr->first)
+		{
+			itr->second = next_itr->second;
+			it->second.erase(next_itr);
+			break;
+		}
+	}
+}
+
+// the previous line by line parser, bootstrap excluded
+size_t per_event_ingest(const std::string& stream, gtid_set_t& gtid_executed) {
+	char uuid_server[64] = { 0 };
+	size_t pos = 0;
+	size_t events = 0;
+	while (pos < stream.size()) {
+		const char *line = stream.data() + pos;
+		const char *nl = (const char *)memchr(line, '\n', stream.size() - pos);
+		int l = nl - line;
+		char rec_msg[80];
+		strncpy(rec_msg, line, l);
+		rec_msg[l] = 0;
+		pos += l + 1;
+		if (rec_msg[0] == 'I') {
+			uint64_t rec_trxid = 0;
+			if (rec_msg[1] == '1') {
+				char *a = strchr(rec_msg+3, ':');
+				int ul = a-rec_msg-3;
+				strncpy(uuid_server, rec_msg+3, ul);
+				uuid_server[ul] = 0;
+				rec_trxid = atoll(a+1);
+			} else {
+				rec_trxid = atoll(rec_msg+3);
+			}
+			std::string s = uuid_server;
+			gtid_t new_gtid = std::make_pair(s, rec_trxid);
+			addGtid(new_gtid, gtid_executed);
+			events++;
+		}
+	}
+	return events;
+}
+
+// the batched parser, fed with chunks of the stream like 'GTID_Server_Data::readall' does
+unsigned long long batched_ingest(const std::string& stream, gtid_set_t& gtid_executed, unsigned int& publishes) {
+	GTID_Stream_Parser parser;
+	unsigned long long events = 0;
+	std::string buf;
+	size_t read_pos = 0;
+	while (read_pos < stream.size()) {
+		size_t n = std::min((size_t)CHUNK_SIZE, stream.size() - read_pos);
+		buf.append(stream, read_pos, n);
+		read_pos += n;
+		bool changed = false;
+		size_t consumed = parser.parse(buf.data(), buf.size(), gtid_executed, events, changed);
+		buf.erase(0, consumed);
+		if (changed) {
+			// one snapshot per batch, as 'GTID_Server_Data::dump' does
+			std::make_shared<const GTID_Snapshot>(gtid_executed);
+			publishes++;
+		}
+	}
+	return events;
+}
+
+int main(int argc, char** argv) {
+	g_seed = 1;
+	const std::string stream = generate_stream();
+	std::cerr << "Stream of " << NGTIDS << " GTIDs, " << stream.size() << " bytes" << std::endl;
+
+	gtid_set_t per_event_set;
+	addGtidInterval(uuids[0], 1, 1000, per_event_set); // the bootstrap
+	{
+		cpu_timer c(NGTIDS);
+		per_event_ingest(stream.substr(stream.find('\n') + 1), per_event_set);
+		std::cerr << "PER EVENT ingestion ran in \t";
+	}
+
+	gtid_set_t batched_set;
+	unsigned int publishes = 0;
+	{
+		cpu_timer c(NGTIDS);
+		batched_ingest(stream, batched_set, publishes);
+		std::cerr << "BATCHED ingestion (" << publishes << " snapshots) ran in \t";
+	}
+
+	std::cerr << "GTID sets match: " << (per_event_set == batched_set ? "yes" : "NO") << std::endl;
+
+	GTID_Snapshots snapshots;
+	snapshots.publish("127.0.0.1:3306", std::make_shared<const GTID_Snapshot>(batched_set));
+	const std::string server = "127.0.0.1:3306";
+	unsigned long long found = 0;
+	{
+		cpu_timer c(NLOOKUPS);
+		for (int i = 0; i < NLOOKUPS; i++) {
+			found += snapshots.gtid_exists(server, uuids[0], fastrand() * 128);
+		}
+		std::cerr << "SNAPSHOT lookups ran in \t";
+	}
+	std::cerr << "Lookups found: " << found << " of " << NLOOKUPS << std::endl;
+}
@@ -0,0 +1,158 @@
+// Compares malloc()/free() with the per-thread slab allocator used by l_alloc()/l_free() when
+// ProxySQL is built with WITHSLABALLOC=1 .
+// Build with:
+//   g++ -O2 -std=c++11 -I../include slab_alloc_bench.cpp ../lib/proxysql_mem.cpp -o slab_alloc_bench -lpthread
+// To compare against jemalloc, link it as well, e.g. '-L../deps/jemalloc/jemalloc/lib -l:libjemalloc.a -ldl'
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <atomic>
+
+#include "proxysql_mem.h"
+
+__thread unsigned int g_seed;
+
+inline int fastrand() {
+	g_seed = (214013*g_seed+2531011);
+	return (g_seed>>16)&0x7FFF;
+}
+
+inline unsigned long long monotonic_time() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (((unsigned long long) ts.tv_sec) * 1000000) + (ts.tv_nsec / 1000);
+}
+
+#define NLOOP	2000
+#define NROWS	2000
+#define NQUERIES	2000000
+#define NTHREADS	4
+
+struct cpu_timer
+{
+	cpu_timer() {
+		begin = monotonic_time();
+	}
+	~cpu_timer()
+	{
+		unsigned long long end = monotonic_time();
+		std::cerr << double( end - begin ) / 1000000 << " secs.\n" ;
+		begin=end-begin; // here only to make compiler happy
+	};
+	unsigned long long begin;
+};
+
+struct malloc_allocator {
+	static void * alloc(size_t s) { return malloc(s); }
+	static void release(void *p) { free(p); }
+};
+
+struct slab_allocator {
+	static void * alloc(size_t s) { return l_slab_alloc(s); }
+	static void release(void *p) { l_slab_free(p); }
+};
+
+// many small rows: a resultset of NROWS packets of 20-200 bytes is buffered and then released
+template<typename A>
+void small_rows() {
+	std::vector<void *> rows(NROWS);
+	for (int i=0; i<NLOOP; i++) {
+		for (int j=0; j<NROWS; j++) {
+			size_t s = 20 + fastrand() % 180;
+			rows[j] = A::alloc(s);
+			memset(rows[j], 0, 4);
+		}
+		for (int j=0; j<NROWS; j++) {
+			A::release(rows[j]);
+		}
+	}
+}
+
+// pointers are stored here to prevent the compiler from eliding allocations
+void * volatile g_sink;
+
+// many small queries: every query allocates a few short lived buffers (query packet, digest, OK packet)
+template<typename A>
+void small_queries() {
+	for (int i=0; i<NQUERIES; i++) {
+		void *q = A::alloc(30 + fastrand() % 100);
+		void *d = A::alloc(64);
+		g_sink = q;
+		g_sink = d;
+		void *ok = A::alloc(11);
+		g_sink = ok;
+		A::release(d);
+		A::release(q);
+		A::release(ok);
+	}
+}
+
+// sessions moving between threads: packets allocated by one thread are released by another one
+template<typename A>
+void cross_thread() {
+	std::vector<std::thread> threads;
+	std::vector<std::vector<void *>> bufs(NTHREADS, std::vector<void *>(NROWS));
+	std::atomic<int> phase(0);
+	for (int t=0; t<NTHREADS; t++) {
+		threads.push_back(std::thread([t, &bufs, &phase]() {
+			g_seed = t + 1;
+			for (int i=0; i<NLOOP/4; i++) {
+				for (int j=0; j<NROWS; j++) {
+					bufs[t][j] = A::alloc(20 + fastrand() % 180);
+				}
+				// wait for all the threads, then release the buffers of the next thread
+				int target = (i * 2 + 1) * NTHREADS;
+				phase++;
+				while (phase.load() < target) { std::this_thread::yield(); }
+				std::vector<void *>& other = bufs[(t+1)%NTHREADS];
+				for (int j=0; j<NROWS; j++) {
+					A::release(other[j]);
+				}
+				phase++;
+				while (phase.load() < target + NTHREADS) { std::this_thread::yield(); }
+			}
+		}));
+	}
+	for (auto& th : threads) {
+		th.join();
+	}
+}
+
+int main(int argc, char** argv) {
+	g_seed = monotonic_time();
+	{
+		cpu_timer c;
+		small_rows<malloc_allocator>();
+		std::cerr << "SMALL ROWS malloc test ran in \t";
+	}
+	{
+		cpu_timer c;
+		small_rows<slab_allocator>();
+		std::cerr << "SMALL ROWS slab test ran in \t";
+	}
+	{
+		cpu_timer c;
+		small_queries<malloc_allocator>();
+		std::cerr << "SMALL QUERIES malloc test ran in \t";
+	}
+	{
+		cpu_timer c;
+		small_queries<slab_allocator>();
+		std::cerr << "SMALL QUERIES slab test ran in \t";
+	}
+	{
+		cpu_timer c;
+		cross_thread<malloc_allocator>();
+		std::cerr << "CROSS THREAD malloc test ran in \t";
+	}
+	{
+		cpu_timer c;
+		cross_thread<slab_allocator>();
+		std::cerr << "CROSS THREAD slab test ran in \t";
+	}
+	std::cerr << "Memory reserved by the slab allocator: " << l_slab_get_allocated_bytes() << " bytes" << std::endl;
+}
@@ -1156,6 +1156,21 @@ cleanup:
 	return res;
 }
 
+ext_val_t<int64_t> get_stats_mysql_global(MYSQL* proxysql_admin, const string& variable_name) {
+	const string query {
+		"SELECT Variable_Value FROM stats_mysql_global WHERE Variable_Name='" + variable_name + "'"
+	};
+	ext_val_t<int64_t> ext_val { mysql_query_ext_val(proxysql_admin, query, int64_t(-1)) };
+
+	if (ext_val.err) {
+		diag("Failed to fetch '%s' from 'stats_mysql_global': %s",
+			variable_name.c_str(), get_ext_val_err(proxysql_admin, ext_val).c_str()
+		);
+	}
+
+	return ext_val;
+}
+
 vector<vector<bool>> get_all_bin_vec(size_t tg_size) {
 	vector<vector<bool>> all_bin_strs {};
 	vector<bool> bin_vec(tg_size, 0);
@@ -427,6 +427,14 @@ int get_variable_value(
 	MYSQL* proxysql_admin, const std::string& variable_name, std::string& variable_value, bool runtime=false
 );
 
+/**
+ * @brief Fetches the value of a counter from 'stats_mysql_global'.
+ * @param proxysql_admin An already opened connection to ProxySQL Admin.
+ * @param variable_name The 'Variable_Name' of the counter.
+ * @return An 'ext_val_t<int64_t>' holding the value, or '-1' in case of error; see 'get_ext_val_err'.
+ */
+ext_val_t<int64_t> get_stats_mysql_global(MYSQL* proxysql_admin, const std::string& variable_name);
+
 /**
  * @brief Returns all the possible permutations of the supplied generic 'std::vector<T>'.
  *   This methods holds as long as the generic <T> holds the type requirements for
@@ -0,0 +1,119 @@
+/**
+ * @file test_connection_prewarm-t.cpp
+ * @brief This test checks 'mysql-connection_prewarm_pct', that pre-opens connections to the servers of a
+ *   hostgroup according to its recent demand.
+ * @details The test enables the pre-warming, keeps several backend connections of the default hostgroup of
+ *   the user in use at the same time, and checks that:
+ *   1. The transactions holding the connections succeed.
+ *   2. Once the clients are gone, the connection pool of the hostgroup holds at least the demand increased
+ *      by 'mysql-connection_prewarm_pct'.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "mysql.h"
+
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+
+using std::string;
+using std::vector;
+
+const int NUM_CLIENTS = 5;
+const int PREWARM_PCT = 300;
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return EXIT_FAILURE;
+	}
+
+	plan(2);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return EXIT_FAILURE;
+	}
+
+	MYSQL_QUERY(
+		admin,
+		string { "SELECT default_hostgroup FROM runtime_mysql_users WHERE username='" + string(cl.username) + "' LIMIT 1" }.c_str()
+	);
+	MYSQL_RES* res = mysql_store_result(admin);
+	MYSQL_ROW row = mysql_fetch_row(res);
+	const string hg { row ? row[0] : "0" };
+	mysql_free_result(res);
+
+	MYSQL_QUERY(admin, "SELECT variable_value FROM global_variables WHERE variable_name='mysql-connection_prewarm_pct'");
+	res = mysql_store_result(admin);
+	row = mysql_fetch_row(res);
+	const string orig_prewarm_pct { row ? row[0] : "0" };
+	mysql_free_result(res);
+
+	MYSQL_QUERY(admin, string { "SET mysql-connection_prewarm_pct=" + std::to_string(PREWARM_PCT) }.c_str());
+	MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	// every client holds a backend connection with an open transaction
+	vector<MYSQL*> clients {};
+	int failed_queries = 0;
+	for (int i = 0; i < NUM_CLIENTS; i++) {
+		MYSQL* proxy = mysql_init(NULL);
+		if (!mysql_real_connect(proxy, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+			diag("Connection failed: %s", mysql_error(proxy));
+			failed_queries++;
+			mysql_close(proxy);
+			continue;
+		}
+		if (mysql_query(proxy, "BEGIN") || mysql_query(proxy, "SELECT 1")) {
+			diag("Query failed: %s", mysql_error(proxy));
+			failed_queries++;
+		} else {
+			mysql_free_result(mysql_store_result(proxy));
+		}
+		clients.push_back(proxy);
+	}
+	for (MYSQL* proxy : clients) {
+		if (mysql_query(proxy, "COMMIT")) {
+			diag("Query failed: %s", mysql_error(proxy));
+			failed_queries++;
+		}
+		mysql_close(proxy);
+	}
+	ok(failed_queries == 0, "All queries should succeed - Failed:%d", failed_queries);
+
+	// the planning runs once per second
+	sleep(3);
+
+	MYSQL_QUERY(
+		admin,
+		string {
+			"SELECT SUM(ConnUsed + ConnFree) FROM stats_mysql_connection_pool WHERE hostgroup=" + hg +
+				" AND status='ONLINE'"
+		}.c_str()
+	);
+	res = mysql_store_result(admin);
+	row = mysql_fetch_row(res);
+	const int pool_conns = (row && row[0]) ? atoi(row[0]) : 0;
+	mysql_free_result(res);
+	const int exp_conns = NUM_CLIENTS * PREWARM_PCT / 100;
+	ok(
+		pool_conns >= exp_conns,
+		"Connection pool should hold the predicted demand - Exp:'>=%d', Act:'%d'", exp_conns, pool_conns
+	);
+
+	MYSQL_QUERY(admin, string { "SET mysql-connection_prewarm_pct=" + orig_prewarm_pct }.c_str());
+	MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	mysql_close(admin);
+
+	return exit_status();
+}
@@ -0,0 +1,360 @@
+/**
+ * @file test_dns_cache_async-t.cpp
+ * @brief This test checks the asynchronous resolution of backend hostnames through the DNS cache: negative
+ *   caching of failed resolutions, off-thread resolution of cache misses, and refresh-ahead of the records.
+ * @details The test looks for a hostname, not an IP, resolving to addresses where the backend of the test
+ *   accepts connections, and routes a query to a server with that hostname. It checks that:
+ *   1. The query succeeds.
+ *   2. 'MySQL_Monitor_dns_cache_queried' and 'MySQL_Monitor_dns_cache_lookup_success' increased: the
+ *      hostname was resolved by the DNS cache, not by the client library.
+ *   It then routes queries to a hostgroup whose only server has a hostname that can't be resolved, with
+ *   'mysql-connect_retries_on_failure=0', and checks that:
+ *   3. The query fails, once the asynchronous resolution of the hostname failed.
+ *   4. The failed resolutions are reported as connection errors of the server.
+ *   5. While the failed resolution is cached, the next query fails fast, without waiting for a resolution.
+ *   6. Once the negative record expired, after 'DNS_CACHE_NEGATIVE_TTL', the hostname is resolved again:
+ *      the session waits at least 'mysql-connect_retries_delay' for the resolution.
+ *   7. The queries to the other hostgroups keep succeeding.
+ *   Finally, with a TTL shorter than the test duration, it checks that:
+ *   8. 'MySQL_Monitor_dns_cache_record_refreshed' increases: the record is resolved again before it expires.
+ *   9. 'MySQL_Monitor_dns_cache_record_updated' doesn't change: renewing unchanged records doesn't publish a
+ *      new cache.
+ *   The original configuration is restored at the end.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <chrono>
+
+#include <string>
+#include <vector>
+
+#include "mysql.h"
+
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+
+using std::string;
+using std::vector;
+
+const int DNS_TEST_HG = 1999;
+const int DNS_TEST_RESOLVABLE_HG = 2000;
+const int DNS_TEST_RULE_ID = 1999;
+const int DNS_TEST_RESOLVABLE_RULE_ID = 2000;
+// see 'DNS_CACHE_NEGATIVE_TTL' in 'MySQL_Monitor.hpp'
+const int DNS_CACHE_NEGATIVE_TTL_MS = 5000;
+const int CONNECT_RETRIES_DELAY_MS = 1000;
+const int REFRESH_AHEAD_TTL_MS = 2000;
+
+const vector<string> saved_variables {
+	"mysql-monitor_local_dns_cache_ttl",
+	"mysql-monitor_local_dns_cache_refresh_interval",
+	"mysql-connect_retries_on_failure",
+	"mysql-connect_retries_delay",
+};
+
+/**
+ * @brief Returns the addresses 'hostname' resolves to, as the DNS cache resolves them.
+ */
+vector<struct sockaddr_storage> resolve(const string& hostname) {
+	vector<struct sockaddr_storage> addrs {};
+	struct addrinfo hints;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_protocol = IPPROTO_TCP;
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_ADDRCONFIG;
+
+	struct addrinfo* res = NULL;
+	if (getaddrinfo(hostname.c_str(), NULL, &hints, &res) == 0) {
+		for (struct addrinfo* p = res; p != NULL; p = p->ai_next) {
+			struct sockaddr_storage addr;
+			memset(&addr, 0, sizeof(addr));
+			memcpy(&addr, p->ai_addr, p->ai_addrlen);
+			addrs.push_back(addr);
+		}
+		freeaddrinfo(res);
+	}
+	return addrs;
+}
+
+/**
+ * @brief Checks that a TCP connection to 'port' can be opened on every address in 'addrs'.
+ */
+bool all_reachable(vector<struct sockaddr_storage>& addrs, int port) {
+	for (struct sockaddr_storage& addr : addrs) {
+		socklen_t len = sizeof(struct sockaddr_in);
+		if (addr.ss_family == AF_INET) {
+			reinterpret_cast<struct sockaddr_in*>(&addr)->sin_port = htons(port);
+		} else {
+			reinterpret_cast<struct sockaddr_in6*>(&addr)->sin6_port = htons(port);
+			len = sizeof(struct sockaddr_in6);
+		}
+		int fd = socket(addr.ss_family, SOCK_STREAM, 0);
+		if (fd < 0) {
+			return false;
+		}
+		const int rc = connect(fd, reinterpret_cast<struct sockaddr*>(&addr), len);
+		close(fd);
+		if (rc) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Looks for a hostname resolving to addresses where the backend accepts connections.
+ * @param reachable Set to 'true' if the backend can be reached on all the addresses of the hostname.
+ * @return The hostname, or an empty string if no candidate can be resolved.
+ */
+string find_resolvable_hostname(const CommandLine& cl, bool& reachable) {
+	vector<string> candidates { "localhost" };
+	char hostname[256] = { 0 };
+	if (gethostname(hostname, sizeof(hostname) - 1) == 0 && strlen(hostname)) {
+		candidates.push_back(hostname);
+	}
+
+	string resolvable {};
+	reachable = false;
+	for (const string& candidate : candidates) {
+		vector<struct sockaddr_storage> addrs { resolve(candidate) };
+		if (addrs.empty()) {
+			continue;
+		}
+		if (resolvable.empty()) {
+			resolvable = candidate;
+		}
+		if (all_reachable(addrs, cl.mysql_port)) {
+			reachable = true;
+			return candidate;
+		}
+	}
+	return resolvable;
+}
+
+/**
+ * @brief Runs 'query', and returns its error code. The elapsed time is returned in 'elapsed_ms'.
+ */
+int timed_query(MYSQL* proxy, const char* query, long long& elapsed_ms) {
+	const auto start = std::chrono::steady_clock::now();
+	int rc = mysql_query(proxy, query);
+	if (rc == 0) {
+		mysql_free_result(mysql_store_result(proxy));
+	} else {
+		diag("Query '%s' failed: %d, %s", query, mysql_errno(proxy), mysql_error(proxy));
+	}
+	const auto end = std::chrono::steady_clock::now();
+	elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+	return rc;
+}
+
+int add_routed_server(MYSQL* admin, int hg, int rule_id, const string& hostname, int port, const string& pattern) {
+	const string s_hg { std::to_string(hg) };
+	const string s_rule_id { std::to_string(rule_id) };
+	MYSQL_QUERY(admin, string { "DELETE FROM mysql_servers WHERE hostgroup_id=" + s_hg }.c_str());
+	MYSQL_QUERY(
+		admin,
+		string {
+			"INSERT INTO mysql_servers (hostgroup_id,hostname,port,comment) VALUES (" + s_hg + ",'" + hostname +
+				"'," + std::to_string(port) + ",'test_dns_cache_async')"
+		}.c_str()
+	);
+	MYSQL_QUERY(admin, string { "DELETE FROM mysql_query_rules WHERE rule_id=" + s_rule_id }.c_str());
+	MYSQL_QUERY(
+		admin,
+		string {
+			"INSERT INTO mysql_query_rules (rule_id,active,match_pattern,destination_hostgroup,apply) VALUES (" +
+				s_rule_id + ",1,'" + pattern + "'," + s_hg + ",1)"
+		}.c_str()
+	);
+	return EXIT_SUCCESS;
+}
+
+int remove_routed_servers(MYSQL* admin) {
+	for (int rule_id : { DNS_TEST_RULE_ID, DNS_TEST_RESOLVABLE_RULE_ID }) {
+		MYSQL_QUERY(admin, string { "DELETE FROM mysql_query_rules WHERE rule_id=" + std::to_string(rule_id) }.c_str());
+	}
+	for (int hg : { DNS_TEST_HG, DNS_TEST_RESOLVABLE_HG }) {
+		MYSQL_QUERY(admin, string { "DELETE FROM mysql_servers WHERE hostgroup_id=" + std::to_string(hg) }.c_str());
+	}
+	MYSQL_QUERY(admin, "LOAD MYSQL QUERY RULES TO RUNTIME");
+	MYSQL_QUERY(admin, "LOAD MYSQL SERVERS TO RUNTIME");
+	return EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return EXIT_FAILURE;
+	}
+
+	plan(9);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return EXIT_FAILURE;
+	}
+
+	vector<string> orig_values {};
+	for (const string& name : saved_variables) {
+		string value {};
+		if (get_variable_value(admin, name, value)) {
+			return EXIT_FAILURE;
+		}
+		orig_values.push_back(value);
+	}
+
+	// the monitor refreshes the cache only when the servers are loaded: the negative records aren't renewed
+	MYSQL_QUERY(admin, "SET mysql-monitor_local_dns_cache_ttl=300000");
+	MYSQL_QUERY(admin, "SET mysql-monitor_local_dns_cache_refresh_interval=60000");
+	MYSQL_QUERY(admin, "SET mysql-connect_retries_on_failure=0");
+	MYSQL_QUERY(admin, string { "SET mysql-connect_retries_delay=" + std::to_string(CONNECT_RETRIES_DELAY_MS) }.c_str());
+	MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	bool reachable = false;
+	const string resolvable_host { find_resolvable_hostname(cl, reachable) };
+	diag("Resolvable hostname: '%s', backend reachable: %d", resolvable_host.c_str(), reachable);
+
+	if (
+		add_routed_server(
+			admin, DNS_TEST_HG, DNS_TEST_RULE_ID, "proxysql-dns-cache-test.invalid", 3306, "dns_cache_async_test"
+		)
+	) {
+		return EXIT_FAILURE;
+	}
+	if (reachable) {
+		if (
+			add_routed_server(
+				admin, DNS_TEST_RESOLVABLE_HG, DNS_TEST_RESOLVABLE_RULE_ID, resolvable_host, cl.mysql_port,
+				"dns_cache_async_resolvable"
+			)
+		) {
+			return EXIT_FAILURE;
+		}
+	}
+	const int64_t queried_before = get_stats_mysql_global(admin, "MySQL_Monitor_dns_cache_queried").val;
+	const int64_t success_before = get_stats_mysql_global(admin, "MySQL_Monitor_dns_cache_lookup_success").val;
+	MYSQL_QUERY(admin, "LOAD MYSQL QUERY RULES TO RUNTIME");
+	MYSQL_QUERY(admin, "LOAD MYSQL SERVERS TO RUNTIME");
+
+	MYSQL* proxy = mysql_init(NULL);
+	if (!mysql_real_connect(proxy, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(proxy));
+		return EXIT_FAILURE;
+	}
+
+	// uncached hostnames are resolved off-thread, while the session waits
+	long long elapsed_ms = 0;
+	if (reachable) {
+		int rc = timed_query(proxy, "SELECT 'dns_cache_async_resolvable'", elapsed_ms);
+		ok(rc == 0, "Query to the server with a resolvable hostname should succeed - Elapsed:'%lldms'", elapsed_ms);
+
+		const int64_t queried = get_stats_mysql_global(admin, "MySQL_Monitor_dns_cache_queried").val - queried_before;
+		const int64_t success =
+			get_stats_mysql_global(admin, "MySQL_Monitor_dns_cache_lookup_success").val - success_before;
+		ok(
+			queried_before >= 0 && queried >= 1 && success >= 1,
+			"The hostname should be resolved through the DNS cache - Queried:'%ld', Success:'%ld'", queried, success
+		);
+	} else {
+		skip(2, "No hostname resolves to addresses where the backend is reachable");
+	}
+
+	int rc = timed_query(proxy, "SELECT 'dns_cache_async_test'", elapsed_ms);
+	ok(rc != 0, "Query to the unresolvable server should fail - Elapsed:'%lldms'", elapsed_ms);
+
+	const string hg { std::to_string(DNS_TEST_HG) };
+	const ext_val_t<int32_t> conn_err {
+		mysql_query_ext_val(
+			admin, "SELECT ConnERR FROM stats_mysql_connection_pool WHERE hostgroup=" + hg, int32_t(0)
+		)
+	};
+	ok(conn_err.val > 0, "Failed resolutions should be reported as connection errors - ConnERR:'%d'", conn_err.val);
+
+	// the failed resolution is cached: the connect fails without waiting for a resolution
+	rc = timed_query(proxy, "SELECT 'dns_cache_async_test'", elapsed_ms);
+	ok(
+		rc != 0 && elapsed_ms < CONNECT_RETRIES_DELAY_MS / 2,
+		"Query to the unresolvable server should fail fast while cached - Elapsed:'%lldms'", elapsed_ms
+	);
+
+	diag("Waiting for the negative record to expire");
+	usleep((DNS_CACHE_NEGATIVE_TTL_MS + 1000) * 1000);
+	rc = timed_query(proxy, "SELECT 'dns_cache_async_test'", elapsed_ms);
+	ok(
+		rc != 0 && elapsed_ms >= CONNECT_RETRIES_DELAY_MS,
+		"Query to the unresolvable server should wait for a new resolution once expired - Elapsed:'%lldms'",
+		elapsed_ms
+	);
+
+	rc = timed_query(proxy, "SELECT 1", elapsed_ms);
+	ok(rc == 0, "Queries to the default hostgroup should succeed");
+
+	mysql_close(proxy);
+
+	if (remove_routed_servers(admin)) {
+		return EXIT_FAILURE;
+	}
+
+	// the records are renewed by the monitor before they expire, see 'monitor_dns_cache'
+	if (resolvable_host.empty() == false) {
+		// disabling the cache drops the records and their TTLs, the hostname is resolved again with the new TTL
+		MYSQL_QUERY(admin, "SET mysql-monitor_local_dns_cache_ttl=0");
+		MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+		sleep(1);
+		MYSQL_QUERY(admin, string { "SET mysql-monitor_local_dns_cache_ttl=" + std::to_string(REFRESH_AHEAD_TTL_MS) }.c_str());
+		MYSQL_QUERY(admin, "SET mysql-monitor_local_dns_cache_refresh_interval=1000");
+		MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+		MYSQL_QUERY(
+			admin,
+			string {
+				"INSERT INTO mysql_servers (hostgroup_id,hostname,port,comment) VALUES (" +
+					std::to_string(DNS_TEST_RESOLVABLE_HG) + ",'" + resolvable_host + "'," +
+					std::to_string(cl.mysql_port) + ",'test_dns_cache_async')"
+			}.c_str()
+		);
+		MYSQL_QUERY(admin, "LOAD MYSQL SERVERS TO RUNTIME");
+		// the first resolution of the hostname
+		sleep(2);
+
+		const int64_t refreshed_before = get_stats_mysql_global(admin, "MySQL_Monitor_dns_cache_record_refreshed").val;
+		const int64_t updated_before = get_stats_mysql_global(admin, "MySQL_Monitor_dns_cache_record_updated").val;
+		usleep(3 * REFRESH_AHEAD_TTL_MS * 1000);
+		const int64_t refreshed =
+			get_stats_mysql_global(admin, "MySQL_Monitor_dns_cache_record_refreshed").val - refreshed_before;
+		const int64_t updated =
+			get_stats_mysql_global(admin, "MySQL_Monitor_dns_cache_record_updated").val - updated_before;
+
+		ok(
+			refreshed_before >= 0 && refreshed >= 2,
+			"The record should be renewed before its TTL expires - Refreshed:'%ld'", refreshed
+		);
+		ok(
+			updated_before >= 0 && updated == 0,
+			"Renewing a record with unchanged IPs shouldn't update the cache - Updated:'%ld'", updated
+		);
+
+		if (remove_routed_servers(admin)) {
+			return EXIT_FAILURE;
+		}
+	} else {
+		skip(2, "No resolvable hostname available");
+	}
+
+	for (size_t i = 0; i < saved_variables.size(); i++) {
+		MYSQL_QUERY(admin, string { "SET " + saved_variables[i] + "=" + orig_values[i] }.c_str());
+	}
+	MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	mysql_close(admin);
+
+	return exit_status();
+}
@@ -0,0 +1,141 @@
+/**
+ * @file test_eventslog_async-t.cpp
+ * @brief This test checks that query events are logged when 'mysql-eventslog_buffer_size' is enabled,
+ *   i.e. when events are written in the events log by the writer thread.
+ * @details The test enables the events log in JSON format with 'mysql-eventslog_buffer_full_policy=1',
+ *   so that no event can be dropped, and runs a number of queries. It then checks:
+ *   1. All the queries are found in the events log, in the same order they were executed.
+ *   2. 'Eventslog_buffer_dropped' in 'stats_mysql_global' is 0.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <dirent.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "mysql.h"
+
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+
+#include "json.hpp"
+
+using std::string;
+using std::vector;
+using nlohmann::json;
+
+const char* LOG_FILENAME = "eventslog_async.log";
+const int NUM_QUERIES = 500;
+
+/**
+ * @brief Returns the path of the most recent events log file in 'datadir'.
+ */
+string get_last_log_file(const string& datadir) {
+	string last {};
+	DIR* dir = opendir(datadir.c_str());
+	if (dir == NULL) {
+		return last;
+	}
+	struct dirent* ent = NULL;
+	while ((ent = readdir(dir)) != NULL) {
+		if (strncmp(ent->d_name, LOG_FILENAME, strlen(LOG_FILENAME)) == 0) {
+			if (string(ent->d_name) > last) {
+				last = ent->d_name;
+			}
+		}
+	}
+	closedir(dir);
+	return last.empty() ? last : datadir + "/" + last;
+}
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return EXIT_FAILURE;
+	}
+
+	const char* datadir = getenv("REGULAR_INFRA_DATADIR");
+	if (datadir == NULL) {
+		diag("ERROR: Missing REGULAR_INFRA_DATADIR");
+		return EXIT_FAILURE;
+	}
+
+	plan(2);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return EXIT_FAILURE;
+	}
+
+	const string set_filename { "SET mysql-eventslog_filename='" + string(LOG_FILENAME) + "'" };
+	MYSQL_QUERY(admin, set_filename.c_str());
+	MYSQL_QUERY(admin, "SET mysql-eventslog_default_log=1");
+	MYSQL_QUERY(admin, "SET mysql-eventslog_format=2");
+	MYSQL_QUERY(admin, "SET mysql-eventslog_buffer_size=1048576");
+	MYSQL_QUERY(admin, "SET mysql-eventslog_buffer_full_policy=1");
+	MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	MYSQL* proxy = mysql_init(NULL);
+	if (!mysql_real_connect(proxy, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(proxy));
+		return EXIT_FAILURE;
+	}
+
+	for (int i = 0; i < NUM_QUERIES; i++) {
+		const string q { "SELECT /* test_eventslog_async */ " + std::to_string(i) };
+		MYSQL_QUERY(proxy, q.c_str());
+		mysql_free_result(mysql_store_result(proxy));
+	}
+	mysql_close(proxy);
+
+	// give time to the writer thread to drain the buffers
+	sleep(2);
+
+	const string f_path { get_last_log_file(datadir) };
+	diag("Reading events log %s", f_path.c_str());
+	std::ifstream eventslog(f_path);
+	int found = 0;
+	bool ordered = true;
+	string line;
+	while (getline(eventslog, line)) {
+		json j = json::parse(line, nullptr, false);
+		if (j.is_discarded() || j.find("query") == j.end()) {
+			continue;
+		}
+		const string query = j["query"];
+		if (query.find("test_eventslog_async") == string::npos) {
+			continue;
+		}
+		const string exp_query { "SELECT /* test_eventslog_async */ " + std::to_string(found) };
+		if (query != exp_query) {
+			ordered = false;
+		}
+		found++;
+	}
+	ok(found == NUM_QUERIES && ordered, "All queries should be logged in order - Exp:%d, Act:%d, ordered:%d", NUM_QUERIES, found, ordered);
+
+	MYSQL_QUERY(admin, "SELECT Variable_Value FROM stats_mysql_global WHERE Variable_Name='Eventslog_buffer_dropped'");
+	MYSQL_RES* res = mysql_store_result(admin);
+	MYSQL_ROW row = mysql_fetch_row(res);
+	int dropped = (row && row[0]) ? atoi(row[0]) : -1;
+	mysql_free_result(res);
+	ok(dropped == 0, "No events should be dropped - Exp:0, Act:%d", dropped);
+
+	MYSQL_QUERY(admin, "SET mysql-eventslog_buffer_size=0");
+	MYSQL_QUERY(admin, "SET mysql-eventslog_buffer_full_policy=0");
+	MYSQL_QUERY(admin, "SET mysql-eventslog_default_log=0");
+	MYSQL_QUERY(admin, "SET mysql-eventslog_filename=''");
+	MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	mysql_close(admin);
+
+	return exit_status();
+}
@@ -0,0 +1,166 @@
+/**
+ * @file test_eventslog_block_reader-t.cpp
+ * @brief This test checks the events log format 3 (blocks of events) written by the events writer thread,
+ *   reading it back with 'tools/eventslog_block_reader'.
+ * @details The test enables the events log with 'mysql-eventslog_format=3' and 'mysql-eventslog_buffer_size',
+ *   so that events are rendered by the worker threads and written in blocks by the writer thread, and runs a
+ *   number of queries. It then reads the events log with 'eventslog_block_reader' and checks that:
+ *   1. All the queries are found, in the same order they were executed.
+ *   2. Filtering by the username of the queries returns all of them.
+ *   3. Filtering by another username skips all the blocks.
+ *   4. 'Eventslog_buffer_dropped' in 'stats_mysql_global' is 0.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <dirent.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "mysql.h"
+
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+
+using std::string;
+using std::vector;
+
+const char* LOG_FILENAME = "eventslog_block_reader.log";
+const char* QUERY_MARKER = "test_eventslog_block_reader";
+const int NUM_QUERIES = 500;
+
+/**
+ * @brief Returns the path of the most recent events log file in 'datadir'.
+ */
+string get_last_log_file(const string& datadir) {
+	string last {};
+	DIR* dir = opendir(datadir.c_str());
+	if (dir == NULL) {
+		return last;
+	}
+	struct dirent* ent = NULL;
+	while ((ent = readdir(dir)) != NULL) {
+		if (strncmp(ent->d_name, LOG_FILENAME, strlen(LOG_FILENAME)) == 0) {
+			if (string(ent->d_name) > last) {
+				last = ent->d_name;
+			}
+		}
+	}
+	closedir(dir);
+	return last.empty() ? last : datadir + "/" + last;
+}
+
+/**
+ * @brief Runs 'eventslog_block_reader' on the events log, and returns the queries of the test found, in order.
+ */
+vector<string> read_queries(const string& reader, const string& args, const string& f_path) {
+	vector<string> queries {};
+	string output {};
+	const string cmd { reader + " " + args + " " + f_path };
+	diag("Running: %s", cmd.c_str());
+	if (exec(cmd, output)) {
+		diag("Failed to run '%s'", cmd.c_str());
+		return queries;
+	}
+	std::istringstream is(output);
+	string line;
+	while (getline(is, line)) {
+		const size_t pos = line.find("SELECT /* " + string(QUERY_MARKER) + " */ ");
+		if (pos != string::npos) {
+			queries.push_back(line.substr(pos));
+		}
+	}
+	return queries;
+}
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return EXIT_FAILURE;
+	}
+
+	const char* datadir = getenv("REGULAR_INFRA_DATADIR");
+	if (datadir == NULL) {
+		diag("ERROR: Missing REGULAR_INFRA_DATADIR");
+		return EXIT_FAILURE;
+	}
+
+	plan(4);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return EXIT_FAILURE;
+	}
+
+	const string set_filename { "SET mysql-eventslog_filename='" + string(LOG_FILENAME) + "'" };
+	MYSQL_QUERY(admin, set_filename.c_str());
+	MYSQL_QUERY(admin, "SET mysql-eventslog_default_log=1");
+	MYSQL_QUERY(admin, "SET mysql-eventslog_format=3");
+	MYSQL_QUERY(admin, "SET mysql-eventslog_buffer_size=1048576");
+	MYSQL_QUERY(admin, "SET mysql-eventslog_buffer_full_policy=1");
+	MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	MYSQL* proxy = mysql_init(NULL);
+	if (!mysql_real_connect(proxy, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(proxy));
+		return EXIT_FAILURE;
+	}
+
+	vector<string> exp_queries {};
+	for (int i = 0; i < NUM_QUERIES; i++) {
+		const string q { "SELECT /* " + string(QUERY_MARKER) + " */ " + std::to_string(i) };
+		MYSQL_QUERY(proxy, q.c_str());
+		mysql_free_result(mysql_store_result(proxy));
+		exp_queries.push_back(q);
+	}
+	mysql_close(proxy);
+
+	// give time to the writer thread to drain the buffers, and to write the last block
+	sleep(3);
+
+	const string f_path { get_last_log_file(datadir) };
+	const string reader { string(cl.workdir) + "eventslog_block_reader" };
+
+	const vector<string> queries { read_queries(reader, "", f_path) };
+	ok(
+		queries == exp_queries, "All queries should be read back in order - Exp:%d, Act:%lu",
+		NUM_QUERIES, queries.size()
+	);
+
+	const vector<string> user_queries { read_queries(reader, "-u " + string(cl.username), f_path) };
+	ok(
+		user_queries == exp_queries, "Filtering by username should return all the queries - Exp:%d, Act:%lu",
+		NUM_QUERIES, user_queries.size()
+	);
+
+	const vector<string> other_user_queries { read_queries(reader, "-u no_such_user_block_reader", f_path) };
+	ok(
+		other_user_queries.empty(), "Filtering by another username should return no query - Exp:0, Act:%lu",
+		other_user_queries.size()
+	);
+
+	MYSQL_QUERY(admin, "SELECT Variable_Value FROM stats_mysql_global WHERE Variable_Name='Eventslog_buffer_dropped'");
+	MYSQL_RES* res = mysql_store_result(admin);
+	MYSQL_ROW row = mysql_fetch_row(res);
+	int dropped = (row && row[0]) ? atoi(row[0]) : -1;
+	mysql_free_result(res);
+	ok(dropped == 0, "No events should be dropped - Exp:0, Act:%d", dropped);
+
+	MYSQL_QUERY(admin, "SET mysql-eventslog_buffer_size=0");
+	MYSQL_QUERY(admin, "SET mysql-eventslog_buffer_full_policy=0");
+	MYSQL_QUERY(admin, "SET mysql-eventslog_format=1");
+	MYSQL_QUERY(admin, "SET mysql-eventslog_default_log=0");
+	MYSQL_QUERY(admin, "SET mysql-eventslog_filename=''");
+	MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	mysql_close(admin);
+
+	return exit_status();
+}
@@ -0,0 +1,176 @@
+/**
+ * @file test_fast_forward_splice-t.cpp
+ * @brief This test checks that resultsets of 'fast_forward' sessions are correctly relayed
+ *   when 'mysql-fast_forward_splice' is enabled.
+ * @details The test configures a 'fast_forward' user against the SQLite3 Server, and runs the
+ *   same queries with 'mysql-fast_forward_splice' disabled and enabled, checking that the
+ *   number of rows and the content of the resultsets are the same. It also checks, through
+ *   'Fast_forward_splice_bytes', that the data is relayed with splice() only when it is enabled, and that with
+ *   splice enabled the relayed bytes are accounted in 'Queries_backends_bytes_recv'.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include <vector>
+#include <string>
+#include "mysql.h"
+
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+
+using std::string;
+using std::vector;
+
+const char* username = "user_ff_splice";
+const char* password = "pass_ff_splice";
+
+const vector<string> admin_setup {
+	"DELETE FROM mysql_servers WHERE hostgroup_id = 1461",
+	"INSERT INTO mysql_servers (hostgroup_id, hostname, port, use_ssl) VALUES (1461, '127.0.0.1', 6030, 0)",
+	"LOAD MYSQL SERVERS TO RUNTIME",
+	"DELETE FROM mysql_users WHERE username = '" + string(username) + "'",
+	"INSERT INTO mysql_users (username,password,fast_forward,default_hostgroup) VALUES ('" + string(username) + "','" + string(password) + "',1,1461)",
+	"LOAD MYSQL USERS TO RUNTIME",
+};
+
+const vector<unsigned int> limits { 1, 10, 512, 1033, 4096 };
+
+int run_queries(MYSQL* my, const vector<string>& queries) {
+	for (const auto& q : queries) {
+		diag("Running: %s", q.c_str());
+		MYSQL_QUERY(my, q.c_str());
+	}
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Runs 'SELECT * FROM tbl_ff_splice LIMIT N' for every limit and checks the resultsets.
+ */
+int check_resultsets(MYSQL* proxy, int splice) {
+	for (unsigned int limit : limits) {
+		const string q { "SELECT id, i1, i2 FROM tbl_ff_splice ORDER BY id LIMIT " + std::to_string(limit) };
+		MYSQL_QUERY(proxy, q.c_str());
+		MYSQL_RES* res = mysql_store_result(proxy);
+		unsigned int rows = 0;
+		bool content_ok = true;
+		MYSQL_ROW row;
+		while ((row = mysql_fetch_row(res))) {
+			rows++;
+			// see how the table is populated: i1 and i2 are derived from id
+			if (row[0] == NULL || row[1] == NULL || row[2] == NULL || atoi(row[2]) - atoi(row[1]) != 1) {
+				content_ok = false;
+			}
+		}
+		mysql_free_result(res);
+		ok(
+			rows == limit && content_ok, "Resultset should be complete - splice:%d, Exp rows:%u, Act rows:%u, content_ok:%d",
+			splice, limit, rows, content_ok
+		);
+	}
+	return EXIT_SUCCESS;
+}
+
+const string q_backends_bytes_recv {
+	"SELECT Variable_Value FROM stats_mysql_global WHERE Variable_Name='Queries_backends_bytes_recv'"
+};
+const string q_splice_bytes {
+	"SELECT Variable_Value FROM stats_mysql_global WHERE Variable_Name='Fast_forward_splice_bytes'"
+};
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return EXIT_FAILURE;
+	}
+
+	plan(2 * limits.size() + 3);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return EXIT_FAILURE;
+	}
+	if (run_queries(admin, admin_setup)) {
+		return EXIT_FAILURE;
+	}
+
+	for (int splice = 0; splice <= 1; splice++) {
+		const string set_splice { "SET mysql-fast_forward_splice=" + std::to_string(splice) };
+		if (run_queries(admin, { set_splice, "LOAD MYSQL VARIABLES TO RUNTIME" })) {
+			return EXIT_FAILURE;
+		}
+
+		MYSQL* proxy = mysql_init(NULL);
+		if (!mysql_real_connect(proxy, cl.host, username, password, NULL, cl.port, NULL, 0)) {
+			fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(proxy));
+			return EXIT_FAILURE;
+		}
+
+		if (splice == 0) {
+			vector<string> populate {
+				"DROP TABLE IF EXISTS tbl_ff_splice",
+				"CREATE TABLE tbl_ff_splice (id INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL , i1 INTEGER , i2 INTEGER)",
+				"INSERT INTO tbl_ff_splice VALUES (NULL, 1, 2)",
+			};
+			// 2^12 rows
+			for (int i = 0; i < 12; i++) {
+				populate.push_back("INSERT INTO tbl_ff_splice SELECT NULL , i1 + id, i2 + id FROM tbl_ff_splice");
+			}
+			if (run_queries(proxy, populate)) {
+				return EXIT_FAILURE;
+			}
+		}
+
+		const ext_val_t<int64_t> bytes_recv_before { mysql_query_ext_val(admin, q_backends_bytes_recv, int64_t(-1)) };
+		const ext_val_t<int64_t> splice_bytes_before { mysql_query_ext_val(admin, q_splice_bytes, int64_t(-1)) };
+		if (bytes_recv_before.err || splice_bytes_before.err) {
+			diag("Failed to fetch the stats: '%s'", get_ext_val_err(admin, bytes_recv_before.err ? bytes_recv_before : splice_bytes_before).c_str());
+			return EXIT_FAILURE;
+		}
+		if (check_resultsets(proxy, splice)) {
+			return EXIT_FAILURE;
+		}
+		const ext_val_t<int64_t> bytes_recv_after { mysql_query_ext_val(admin, q_backends_bytes_recv, int64_t(-1)) };
+		const ext_val_t<int64_t> splice_bytes_after { mysql_query_ext_val(admin, q_splice_bytes, int64_t(-1)) };
+		const int64_t bytes_recv = bytes_recv_after.val - bytes_recv_before.val;
+		const int64_t splice_bytes = splice_bytes_after.val - splice_bytes_before.val;
+
+		// every row carries at least 3 values of 1 byte plus their lengths
+		int64_t min_bytes = 0;
+		for (unsigned int limit : limits) {
+			min_bytes += 6 * limit;
+		}
+		if (splice == 0) {
+			ok(
+				splice_bytes_after.err == 0 && splice_bytes == 0,
+				"No bytes should be relayed with splice() when disabled - Act:'%ld'", splice_bytes
+			);
+		} else {
+			ok(
+				splice_bytes_after.err == 0 && splice_bytes >= min_bytes,
+				"The resultsets should be relayed with splice() when enabled - Exp:'>=%ld', Act:'%ld'",
+				min_bytes, splice_bytes
+			);
+			ok(
+				bytes_recv_after.err == 0 && bytes_recv >= min_bytes,
+				"Relayed bytes should be accounted as backend bytes - Exp:'>=%ld', Act:'%ld'", min_bytes, bytes_recv
+			);
+		}
+
+		if (splice == 1) {
+			MYSQL_QUERY(proxy, "DROP TABLE IF EXISTS tbl_ff_splice");
+		}
+		mysql_close(proxy);
+	}
+
+	MYSQL_QUERY(admin, "SET mysql-fast_forward_splice=0");
+	MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	mysql_close(admin);
+
+	return exit_status();
+}
@@ -0,0 +1,100 @@
+/**
+ * @file test_gather_writes-t.cpp
+ * @brief This test checks that resultsets are correctly sent to clients when 'mysql-gather_writes'
+ *   is enabled.
+ * @details The test runs the same queries with 'mysql-gather_writes' disabled and enabled, with both
+ *   small and large resultsets, checking that the number of rows and their content are the same.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include <vector>
+#include <string>
+#include "mysql.h"
+
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+
+using std::string;
+using std::vector;
+
+// row sizes, in bytes, for 'REPEAT()'. The largest ones exceed the size of 'queueOUT'.
+const vector<unsigned int> row_sizes { 1, 100, 32768, 100000, 3000000 };
+const unsigned int num_rows = 200;
+
+/**
+ * @brief Runs 'num_rows' rows of 'REPEAT('a', size)' for every size, and checks the resultsets.
+ */
+int check_resultsets(MYSQL* proxy, int gather) {
+	for (unsigned int size : row_sizes) {
+		// big rows are retrieved only once, to keep the test fast
+		unsigned int exp_rows = size > 1000000 ? 1 : num_rows;
+		const string q {
+			"SELECT /* test_gather_writes */ REPEAT('a', " + std::to_string(size) + ") FROM"
+			" (SELECT 1 FROM information_schema.COLUMNS LIMIT " + std::to_string(exp_rows) + ") t"
+		};
+		MYSQL_QUERY(proxy, q.c_str());
+		MYSQL_RES* res = mysql_use_result(proxy);
+		unsigned int rows = 0;
+		bool content_ok = true;
+		MYSQL_ROW row;
+		while ((row = mysql_fetch_row(res))) {
+			unsigned long* lengths = mysql_fetch_lengths(res);
+			rows++;
+			if (row[0] == NULL || lengths[0] != size || row[0][0] != 'a' || row[0][size - 1] != 'a') {
+				content_ok = false;
+			}
+		}
+		mysql_free_result(res);
+		ok(
+			rows == exp_rows && content_ok, "Resultset should be complete - gather:%d, size:%u, Exp rows:%u, Act rows:%u, content_ok:%d",
+			gather, size, exp_rows, rows, content_ok
+		);
+	}
+	return EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return EXIT_FAILURE;
+	}
+
+	plan(2 * row_sizes.size());
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return EXIT_FAILURE;
+	}
+
+	for (int gather = 0; gather <= 1; gather++) {
+		const string set_gather { "SET mysql-gather_writes=" + std::to_string(gather) };
+		diag("Running: %s", set_gather.c_str());
+		MYSQL_QUERY(admin, set_gather.c_str());
+		MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+		MYSQL* proxy = mysql_init(NULL);
+		if (!mysql_real_connect(proxy, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+			fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(proxy));
+			return EXIT_FAILURE;
+		}
+
+		if (check_resultsets(proxy, gather)) {
+			return EXIT_FAILURE;
+		}
+
+		mysql_close(proxy);
+	}
+
+	MYSQL_QUERY(admin, "SET mysql-gather_writes=0");
+	MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	mysql_close(admin);
+
+	return exit_status();
+}
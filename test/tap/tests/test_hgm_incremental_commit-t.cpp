@@ -0,0 +1,100 @@
+/**
+ * @file test_hgm_incremental_commit-t.cpp
+ * @brief This test checks that 'LOAD MYSQL SERVERS TO RUNTIME' applies additions, changes and removals of
+ *   servers, now that 'MySQL_HostGroups_Manager::commit()' only applies the differences with the current
+ *   servers.
+ * @details The test uses a dedicated hostgroup, and:
+ *   1. Adds a server: it should be reported in 'runtime_mysql_servers'.
+ *   2. Changes the weight and the comment of the server: the new values should be reported.
+ *   3. Loads the same configuration again: the checksum of 'mysql_servers' should not change.
+ *   4. Removes the server: it should not be reported anymore.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include <string>
+
+#include "mysql.h"
+
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+
+using std::string;
+
+const int TEST_HG = 1942;
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return EXIT_FAILURE;
+	}
+
+	plan(5);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return EXIT_FAILURE;
+	}
+
+	const string hg { std::to_string(TEST_HG) };
+	const string runtime_srv_q {
+		"SELECT weight || ':' || comment FROM runtime_mysql_servers WHERE hostgroup_id=" + hg +
+			" AND hostname='127.0.0.1' AND port=13306"
+	};
+	string value {};
+
+	MYSQL_QUERY(admin, string { "DELETE FROM mysql_servers WHERE hostgroup_id=" + hg }.c_str());
+	MYSQL_QUERY(
+		admin,
+		string {
+			"INSERT INTO mysql_servers (hostgroup_id, hostname, port, weight, comment) VALUES"
+				" (" + hg + ", '127.0.0.1', 13306, 10, 'incremental_commit')"
+		}.c_str()
+	);
+	MYSQL_QUERY(admin, "LOAD MYSQL SERVERS TO RUNTIME");
+
+	value = mysql_query_ext_val(admin, runtime_srv_q, string()).val;
+	ok(value == "10:incremental_commit", "New server should be in runtime - Exp:'10:incremental_commit', Act:'%s'", value.c_str());
+
+	MYSQL_QUERY(
+		admin,
+		string { "UPDATE mysql_servers SET weight=20, comment='incremental_commit_2' WHERE hostgroup_id=" + hg }.c_str()
+	);
+	MYSQL_QUERY(admin, "LOAD MYSQL SERVERS TO RUNTIME");
+
+	value = mysql_query_ext_val(admin, runtime_srv_q, string()).val;
+	ok(value == "20:incremental_commit_2", "Server changes should be in runtime - Exp:'20:incremental_commit_2', Act:'%s'", value.c_str());
+
+	const string checksum_q { "SELECT checksum FROM runtime_checksums_values WHERE name='mysql_servers'" };
+	string checksum_before {};
+	string checksum_after {};
+	checksum_before = mysql_query_ext_val(admin, checksum_q, string()).val;
+	MYSQL_QUERY(admin, "LOAD MYSQL SERVERS TO RUNTIME");
+	checksum_after = mysql_query_ext_val(admin, checksum_q, string()).val;
+	ok(
+		!checksum_before.empty() && checksum_before == checksum_after,
+		"Checksum should not change for the same config - Exp:'%s', Act:'%s'", checksum_before.c_str(), checksum_after.c_str()
+	);
+
+	MYSQL_QUERY(admin, string { "DELETE FROM mysql_servers WHERE hostgroup_id=" + hg }.c_str());
+	MYSQL_QUERY(admin, "LOAD MYSQL SERVERS TO RUNTIME");
+
+	value = mysql_query_ext_val(admin, runtime_srv_q, string()).val;
+	ok(value.empty(), "Removed server should not be in runtime - Act:'%s'", value.c_str());
+
+	checksum_after = mysql_query_ext_val(admin, checksum_q, string()).val;
+	ok(
+		checksum_before != checksum_after,
+		"Checksum should change after removing a server - Old:'%s', New:'%s'", checksum_before.c_str(), checksum_after.c_str()
+	);
+
+	mysql_close(admin);
+
+	return exit_status();
+}
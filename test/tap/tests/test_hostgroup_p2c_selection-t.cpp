@@ -0,0 +1,297 @@
+/**
+ * @file test_hostgroup_p2c_selection-t.cpp
+ * @brief This test checks the 'server_selection' field of 'mysql_hostgroup_attributes.hostgroup_settings',
+ *   that enables the power-of-two-choices server selection for a hostgroup.
+ * @details The test creates a hostgroup with two servers of the same weight, and keeps several connections
+ *   in use on the first one (the "loaded" server), through a query rule that disables multiplexing. It then
+ *   runs the same queries with weighted random selection and with power-of-two-choices, and checks that:
+ *   1. The setting is accepted and reported in 'runtime_mysql_hostgroup_attributes'.
+ *   2. All the queries succeed.
+ *   3. With power-of-two-choices the loaded server serves a minority of the queries: it's used only when
+ *      it's drawn twice, about 1/4 of the times, while weighted random selection uses it about 1/2 of the
+ *      times, whatever the load.
+ *   4. The loaded server serves fewer queries with power-of-two-choices than with weighted random selection.
+ *   The original 'mysql_hostgroup_attributes' row of the hostgroup, if any, is restored at the end.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include <string>
+#include <vector>
+
+#include "mysql.h"
+
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+
+using std::string;
+using std::vector;
+
+const int P2C_TEST_HG = 1463;
+const int P2C_PIN_RULE_ID = 1463;
+const int P2C_QUERY_RULE_ID = 1464;
+const int NUM_PINNED_CONNS = 10;
+const int NUM_QUERIES = 300;
+
+/**
+ * @brief Returns the 'INSERT' statements that recreate the current rows of 'table' for the test hostgroup.
+ */
+int backup_rows(MYSQL* admin, const string& table, vector<string>& inserts) {
+	const string q { "SELECT * FROM " + table + " WHERE hostgroup_id=" + std::to_string(P2C_TEST_HG) };
+	MYSQL_QUERY(admin, q.c_str());
+	MYSQL_RES* res = mysql_store_result(admin);
+	unsigned int num_fields = mysql_num_fields(res);
+	MYSQL_ROW row;
+	while ((row = mysql_fetch_row(res))) {
+		string insert { "INSERT INTO " + table + " VALUES (" };
+		for (unsigned int i = 0; i < num_fields; i++) {
+			if (i) {
+				insert += ",";
+			}
+			if (row[i] == NULL) {
+				insert += "NULL";
+			} else {
+				string value { row[i] };
+				size_t pos = 0;
+				while ((pos = value.find('\'', pos)) != string::npos) {
+					value.insert(pos, "'");
+					pos += 2;
+				}
+				insert += "'" + value + "'";
+			}
+		}
+		insert += ")";
+		inserts.push_back(insert);
+	}
+	mysql_free_result(res);
+	return EXIT_SUCCESS;
+}
+
+int set_server_selection(MYSQL* admin, int server_selection) {
+	const string hg { std::to_string(P2C_TEST_HG) };
+	MYSQL_QUERY(admin, string { "DELETE FROM mysql_hostgroup_attributes WHERE hostgroup_id=" + hg }.c_str());
+	MYSQL_QUERY(
+		admin,
+		string {
+			"INSERT INTO mysql_hostgroup_attributes (hostgroup_id, hostgroup_settings) VALUES"
+				" (" + hg + ", '{\"server_selection\":" + std::to_string(server_selection) + "}')"
+		}.c_str()
+	);
+	MYSQL_QUERY(admin, "LOAD MYSQL SERVERS TO RUNTIME");
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Runs 'NUM_QUERIES' queries routed to the test hostgroup, and returns the share of them served by
+ *   the loaded server, or -1 in case of error.
+ */
+double run_queries(MYSQL* admin, MYSQL* proxy, const string& loaded_host, const string& loaded_port, int& failed) {
+	if (mysql_query(admin, "SELECT * FROM stats_mysql_connection_pool_reset")) {
+		diag("Failed to reset the connection pool stats: %s", mysql_error(admin));
+		return -1;
+	}
+	mysql_free_result(mysql_store_result(admin));
+
+	for (int i = 0; i < NUM_QUERIES; i++) {
+		if (mysql_query(proxy, "SELECT 'p2c_selection_test'")) {
+			diag("Query failed: %s", mysql_error(proxy));
+			failed++;
+		} else {
+			mysql_free_result(mysql_store_result(proxy));
+		}
+	}
+
+	const string q {
+		"SELECT srv_host, srv_port, Queries FROM stats_mysql_connection_pool WHERE hostgroup=" +
+			std::to_string(P2C_TEST_HG)
+	};
+	if (mysql_query(admin, q.c_str())) {
+		diag("Failed to get the connection pool stats: %s", mysql_error(admin));
+		return -1;
+	}
+	MYSQL_RES* res = mysql_store_result(admin);
+	long total = 0;
+	long loaded = 0;
+	MYSQL_ROW row;
+	while ((row = mysql_fetch_row(res))) {
+		const long queries = row[2] ? atol(row[2]) : 0;
+		total += queries;
+		if (loaded_host == row[0] && loaded_port == row[1]) {
+			loaded += queries;
+		}
+	}
+	mysql_free_result(res);
+	diag("Queries served by the loaded server: %ld of %ld", loaded, total);
+
+	return total ? (double)loaded / total : -1;
+}
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return EXIT_FAILURE;
+	}
+
+	plan(5);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return EXIT_FAILURE;
+	}
+
+	// two distinct backends: the first one is loaded, the second one is idle
+	MYSQL_QUERY(
+		admin,
+		"SELECT DISTINCT hostname, port FROM runtime_mysql_servers WHERE status='ONLINE' AND port!=6030"
+			" ORDER BY hostname, port LIMIT 2"
+	);
+	MYSQL_RES* res = mysql_store_result(admin);
+	vector<std::pair<string,string>> servers {};
+	MYSQL_ROW row;
+	while ((row = mysql_fetch_row(res))) {
+		servers.push_back({ row[0], row[1] });
+	}
+	mysql_free_result(res);
+	if (servers.size() < 2) {
+		skip(5, "At least two ONLINE servers are required - Found:%lu", servers.size());
+		mysql_close(admin);
+		return exit_status();
+	}
+	const string& loaded_host = servers[0].first;
+	const string& loaded_port = servers[0].second;
+
+	vector<string> orig_attributes {};
+	if (backup_rows(admin, "mysql_hostgroup_attributes", orig_attributes)) {
+		return EXIT_FAILURE;
+	}
+
+	const string hg { std::to_string(P2C_TEST_HG) };
+	const string pin_rule_id { std::to_string(P2C_PIN_RULE_ID) };
+	const string query_rule_id { std::to_string(P2C_QUERY_RULE_ID) };
+	MYSQL_QUERY(admin, string { "DELETE FROM mysql_servers WHERE hostgroup_id=" + hg }.c_str());
+	MYSQL_QUERY(
+		admin,
+		string {
+			"INSERT INTO mysql_servers (hostgroup_id,hostname,port,weight) VALUES"
+				" (" + hg + ",'" + loaded_host + "'," + loaded_port + ",1)"
+		}.c_str()
+	);
+	MYSQL_QUERY(
+		admin,
+		string {
+			"DELETE FROM mysql_query_rules WHERE rule_id IN (" + pin_rule_id + "," + query_rule_id + ")"
+		}.c_str()
+	);
+	// the connections used by 'p2c_selection_pin' stay attached to their sessions
+	MYSQL_QUERY(
+		admin,
+		string {
+			"INSERT INTO mysql_query_rules (rule_id,active,match_pattern,destination_hostgroup,multiplex,apply)"
+				" VALUES (" + pin_rule_id + ",1,'p2c_selection_pin'," + hg + ",0,1)"
+		}.c_str()
+	);
+	MYSQL_QUERY(
+		admin,
+		string {
+			"INSERT INTO mysql_query_rules (rule_id,active,match_pattern,destination_hostgroup,apply)"
+				" VALUES (" + query_rule_id + ",1,'p2c_selection_test'," + hg + ",1)"
+		}.c_str()
+	);
+	MYSQL_QUERY(admin, "LOAD MYSQL QUERY RULES TO RUNTIME");
+	if (set_server_selection(admin, 1)) {
+		return EXIT_FAILURE;
+	}
+
+	MYSQL_QUERY(
+		admin,
+		string { "SELECT hostgroup_settings FROM runtime_mysql_hostgroup_attributes WHERE hostgroup_id=" + hg }.c_str()
+	);
+	res = mysql_store_result(admin);
+	row = mysql_fetch_row(res);
+	const string settings { (row && row[0]) ? row[0] : "" };
+	mysql_free_result(res);
+	ok(
+		settings.find("server_selection") != string::npos,
+		"'server_selection' should be in runtime - Act:'%s'", settings.c_str()
+	);
+
+	// while the loaded server is the only one of the hostgroup, pin connections to it
+	vector<MYSQL*> pinned {};
+	for (int i = 0; i < NUM_PINNED_CONNS; i++) {
+		MYSQL* proxy = mysql_init(NULL);
+		if (!mysql_real_connect(proxy, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+			fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(proxy));
+			return EXIT_FAILURE;
+		}
+		MYSQL_QUERY(proxy, "SELECT 'p2c_selection_pin'");
+		mysql_free_result(mysql_store_result(proxy));
+		pinned.push_back(proxy);
+	}
+
+	MYSQL_QUERY(
+		admin,
+		string {
+			"INSERT INTO mysql_servers (hostgroup_id,hostname,port,weight) VALUES"
+				" (" + hg + ",'" + servers[1].first + "'," + servers[1].second + ",1)"
+		}.c_str()
+	);
+	MYSQL_QUERY(admin, "LOAD MYSQL SERVERS TO RUNTIME");
+
+	MYSQL* proxy = mysql_init(NULL);
+	if (!mysql_real_connect(proxy, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(proxy));
+		return EXIT_FAILURE;
+	}
+
+	int failed_queries = 0;
+	diag("Running queries with power-of-two-choices selection");
+	const double p2c_share = run_queries(admin, proxy, loaded_host, loaded_port, failed_queries);
+
+	if (set_server_selection(admin, 0)) {
+		return EXIT_FAILURE;
+	}
+	diag("Running queries with weighted random selection");
+	const double random_share = run_queries(admin, proxy, loaded_host, loaded_port, failed_queries);
+
+	ok(failed_queries == 0, "All queries should succeed - Failed:%d", failed_queries);
+	ok(
+		p2c_share >= 0 && p2c_share < 0.4,
+		"The loaded server should serve a minority of the queries with p2c - Share:%.2f", p2c_share
+	);
+	ok(
+		random_share > 0.4,
+		"The loaded server should serve about half of the queries with weighted random - Share:%.2f", random_share
+	);
+	ok(
+		p2c_share >= 0 && random_share > p2c_share,
+		"p2c should send fewer queries to the loaded server - p2c:%.2f, Random:%.2f", p2c_share, random_share
+	);
+
+	mysql_close(proxy);
+	for (MYSQL* p : pinned) {
+		mysql_close(p);
+	}
+
+	MYSQL_QUERY(
+		admin,
+		string {
+			"DELETE FROM mysql_query_rules WHERE rule_id IN (" + pin_rule_id + "," + query_rule_id + ")"
+		}.c_str()
+	);
+	MYSQL_QUERY(admin, "LOAD MYSQL QUERY RULES TO RUNTIME");
+	MYSQL_QUERY(admin, string { "DELETE FROM mysql_servers WHERE hostgroup_id=" + hg }.c_str());
+	MYSQL_QUERY(admin, string { "DELETE FROM mysql_hostgroup_attributes WHERE hostgroup_id=" + hg }.c_str());
+	for (const string& insert : orig_attributes) {
+		MYSQL_QUERY(admin, insert.c_str());
+	}
+	MYSQL_QUERY(admin, "LOAD MYSQL SERVERS TO RUNTIME");
+	mysql_close(admin);
+
+	return exit_status();
+}
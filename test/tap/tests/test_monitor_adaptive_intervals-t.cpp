@@ -0,0 +1,102 @@
+/**
+ * @file test_monitor_adaptive_intervals-t.cpp
+ * @brief This test checks that 'mysql-monitor_adaptive_interval_max_factor' reduces the number of ping
+ *   checks performed on healthy servers.
+ * @details The test lowers 'mysql-monitor_ping_interval' and counts the ping checks performed over a few
+ *   seconds, first with fixed intervals (factor '1') and then with adaptive intervals, once the servers
+ *   had the time to back off. Less checks should be performed with adaptive intervals.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+#include <string>
+
+#include "mysql.h"
+
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+
+using std::string;
+
+const int PING_INTERVAL_MS = 500;
+const int MAX_FACTOR = 8;
+const int MEASURE_TIME_S = 6;
+
+long long get_ping_checks(MYSQL* admin) {
+	const char* q {
+		"SELECT SUM(Variable_Value) FROM stats_mysql_global WHERE Variable_Name IN"
+			" ('MySQL_Monitor_ping_check_OK','MySQL_Monitor_ping_check_ERR')"
+	};
+	const ext_val_t<int64_t> checks { mysql_query_ext_val(admin, q, int64_t(-1)) };
+	if (checks.err) {
+		diag("Query '%s' failed: %s", q, get_ext_val_err(admin, checks).c_str());
+	}
+	return checks.val;
+}
+
+long long count_ping_checks(MYSQL* admin, int seconds) {
+	const long long before = get_ping_checks(admin);
+	sleep(seconds);
+	const long long after = get_ping_checks(admin);
+	return (before < 0 || after < 0) ? -1 : after - before;
+}
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return EXIT_FAILURE;
+	}
+
+	plan(2);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return EXIT_FAILURE;
+	}
+
+	MYSQL_QUERY(
+		admin,
+		"SELECT variable_value FROM global_variables WHERE variable_name IN"
+			" ('mysql-monitor_adaptive_interval_max_factor','mysql-monitor_ping_interval') ORDER BY variable_name"
+	);
+	MYSQL_RES* res = mysql_store_result(admin);
+	MYSQL_ROW row = mysql_fetch_row(res);
+	const string max_factor { row[0] };
+	row = mysql_fetch_row(res);
+	const string ping_interval { row[0] };
+	mysql_free_result(res);
+
+	MYSQL_QUERY(admin, string { "SET mysql-monitor_ping_interval=" + std::to_string(PING_INTERVAL_MS) }.c_str());
+	MYSQL_QUERY(admin, "SET mysql-monitor_adaptive_interval_max_factor=1");
+	MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	sleep(2);
+
+	const long long fixed_checks = count_ping_checks(admin, MEASURE_TIME_S);
+	ok(fixed_checks > 0, "Ping checks should be performed with fixed intervals - Act:%lld", fixed_checks);
+
+	MYSQL_QUERY(admin, string { "SET mysql-monitor_adaptive_interval_max_factor=" + std::to_string(MAX_FACTOR) }.c_str());
+	MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	// time for the servers to back off to the max interval
+	sleep(2 * MAX_FACTOR * PING_INTERVAL_MS / 1000);
+
+	const long long adaptive_checks = count_ping_checks(admin, MEASURE_TIME_S);
+	ok(
+		adaptive_checks >= 0 && adaptive_checks < fixed_checks,
+		"Less ping checks should be performed with adaptive intervals - Fixed:%lld, Adaptive:%lld",
+		fixed_checks, adaptive_checks
+	);
+
+	MYSQL_QUERY(admin, string { "SET mysql-monitor_adaptive_interval_max_factor=" + max_factor }.c_str());
+	MYSQL_QUERY(admin, string { "SET mysql-monitor_ping_interval=" + ping_interval }.c_str());
+	MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	mysql_close(admin);
+
+	return exit_status();
+}
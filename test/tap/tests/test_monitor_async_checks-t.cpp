@@ -0,0 +1,100 @@
+/**
+ * @file test_monitor_async_checks-t.cpp
+ * @brief This test checks that the connect and ping checks keep running when performed on the monitor
+ *   event loops, with their start spread by 'mysql-monitor_checks_jitter'.
+ * @details The test lowers the check intervals, enables the maximum jitter and, after a few intervals,
+ *   checks that:
+ *   1. 'MySQL_Monitor_connect_check_OK' increased: new connections are created without worker threads.
+ *   2. 'MySQL_Monitor_ping_check_OK' increased.
+ *   3. 'monitor.mysql_server_connect_log' reports entries with a connect time for the servers.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+#include <string>
+
+#include "mysql.h"
+
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+
+using std::string;
+
+const int CHECK_INTERVAL_MS = 1000;
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return EXIT_FAILURE;
+	}
+
+	plan(3);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return EXIT_FAILURE;
+	}
+
+	MYSQL_QUERY(
+		admin,
+		"SELECT variable_value FROM global_variables WHERE variable_name IN"
+			" ('mysql-monitor_checks_jitter','mysql-monitor_connect_interval','mysql-monitor_ping_interval')"
+			" ORDER BY variable_name"
+	);
+	MYSQL_RES* res = mysql_store_result(admin);
+	MYSQL_ROW row = mysql_fetch_row(res);
+	const string checks_jitter { row[0] };
+	row = mysql_fetch_row(res);
+	const string connect_interval { row[0] };
+	row = mysql_fetch_row(res);
+	const string ping_interval { row[0] };
+	mysql_free_result(res);
+
+	const string interval { std::to_string(CHECK_INTERVAL_MS) };
+	MYSQL_QUERY(admin, "SET mysql-monitor_checks_jitter=50");
+	MYSQL_QUERY(admin, string { "SET mysql-monitor_connect_interval=" + interval }.c_str());
+	MYSQL_QUERY(admin, string { "SET mysql-monitor_ping_interval=" + interval }.c_str());
+	MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	const long long connect_ok_before = get_stats_mysql_global(admin, "MySQL_Monitor_connect_check_OK").val;
+	const long long ping_ok_before = get_stats_mysql_global(admin, "MySQL_Monitor_ping_check_OK").val;
+
+	sleep(5 * CHECK_INTERVAL_MS / 1000);
+
+	const long long connect_ok_after = get_stats_mysql_global(admin, "MySQL_Monitor_connect_check_OK").val;
+	const long long ping_ok_after = get_stats_mysql_global(admin, "MySQL_Monitor_ping_check_OK").val;
+
+	ok(
+		connect_ok_before >= 0 && connect_ok_after > connect_ok_before,
+		"Connect checks should succeed - Before:%lld, After:%lld", connect_ok_before, connect_ok_after
+	);
+	ok(
+		ping_ok_before >= 0 && ping_ok_after > ping_ok_before,
+		"Ping checks should succeed - Before:%lld, After:%lld", ping_ok_before, ping_ok_after
+	);
+
+	MYSQL_QUERY(
+		admin,
+		"SELECT COUNT(*) FROM monitor.mysql_server_connect_log WHERE connect_error IS NULL AND connect_success_time_us > 0"
+	);
+	res = mysql_store_result(admin);
+	row = mysql_fetch_row(res);
+	int entries = atoi(row[0]);
+	mysql_free_result(res);
+	ok(entries > 0, "'mysql_server_connect_log' should report successful connects - Act:%d", entries);
+
+	MYSQL_QUERY(admin, string { "SET mysql-monitor_checks_jitter=" + checks_jitter }.c_str());
+	MYSQL_QUERY(admin, string { "SET mysql-monitor_connect_interval=" + connect_interval }.c_str());
+	MYSQL_QUERY(admin, string { "SET mysql-monitor_ping_interval=" + ping_interval }.c_str());
+	MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	mysql_close(admin);
+
+	return exit_status();
+}
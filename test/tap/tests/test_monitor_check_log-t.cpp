@@ -0,0 +1,90 @@
+/**
+ * @file test_monitor_check_log-t.cpp
+ * @brief This test checks that the results of the monitor checks kept in memory are exposed through the
+ *   'monitor.mysql_server_*_log' tables when queried from Admin.
+ * @details The test lowers 'mysql-monitor_ping_interval' and 'mysql-monitor_connect_interval', waits a few
+ *   intervals and checks that:
+ *   1. 'mysql_server_ping_log' and 'mysql_server_connect_log' report entries for the configured servers.
+ *   2. No server reports more entries than the ones kept in memory (100 per server).
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+#include <string>
+
+#include "mysql.h"
+
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+
+using std::string;
+
+const int CHECK_INTERVAL_MS = 500;
+const int MAX_ENTRIES_PER_SERVER = 100;
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return EXIT_FAILURE;
+	}
+
+	plan(4);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return EXIT_FAILURE;
+	}
+
+	MYSQL_QUERY(
+		admin,
+		"SELECT variable_value FROM global_variables WHERE variable_name IN"
+			" ('mysql-monitor_connect_interval','mysql-monitor_ping_interval') ORDER BY variable_name"
+	);
+	MYSQL_RES* res = mysql_store_result(admin);
+	MYSQL_ROW row = mysql_fetch_row(res);
+	const string connect_interval { row[0] };
+	row = mysql_fetch_row(res);
+	const string ping_interval { row[0] };
+	mysql_free_result(res);
+
+	const string set_ping { "SET mysql-monitor_ping_interval=" + std::to_string(CHECK_INTERVAL_MS) };
+	const string set_connect { "SET mysql-monitor_connect_interval=" + std::to_string(CHECK_INTERVAL_MS) };
+	MYSQL_QUERY(admin, set_ping.c_str());
+	MYSQL_QUERY(admin, set_connect.c_str());
+	MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	sleep(5);
+
+	for (const char* table : { "mysql_server_ping_log", "mysql_server_connect_log" }) {
+		const string q {
+			"SELECT COUNT(*), COALESCE(MAX(cnt),0) FROM (SELECT hostname, port, COUNT(*) cnt FROM monitor." +
+			string(table) + " GROUP BY hostname, port)"
+		};
+		MYSQL_QUERY(admin, q.c_str());
+		res = mysql_store_result(admin);
+		row = mysql_fetch_row(res);
+		int servers = atoi(row[0]);
+		int max_entries = atoi(row[1]);
+		mysql_free_result(res);
+
+		ok(servers > 0, "'%s' should report entries - Servers:%d", table, servers);
+		ok(
+			max_entries <= MAX_ENTRIES_PER_SERVER,
+			"'%s' entries per server should be bounded - Max:%d, Act:%d", table, MAX_ENTRIES_PER_SERVER, max_entries
+		);
+	}
+
+	MYSQL_QUERY(admin, string { "SET mysql-monitor_ping_interval=" + ping_interval }.c_str());
+	MYSQL_QUERY(admin, string { "SET mysql-monitor_connect_interval=" + connect_interval }.c_str());
+	MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	mysql_close(admin);
+
+	return exit_status();
+}
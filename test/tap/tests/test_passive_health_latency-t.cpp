@@ -0,0 +1,106 @@
+/**
+ * @file test_passive_health_latency-t.cpp
+ * @brief This test checks that 'mysql-passive_health_latency_percentile' makes the latency of the servers
+ *   reported in 'stats_mysql_connection_pool' follow the latency of the queries sent by the clients.
+ * @details The test enables the passive latency, sends slow queries through ProxySQL for a few seconds and
+ *   checks that the highest 'Latency_us' in 'stats_mysql_connection_pool' is at least the query time. Then
+ *   disables the passive latency and checks that the latency reported by the monitor is restored.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+#include <string>
+
+#include "mysql.h"
+
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+
+using std::string;
+
+// 'SLEEP(0.2)'
+const long long QUERY_TIME_US = 200000;
+const int TRAFFIC_TIME_S = 3;
+
+long long get_max_latency_us(MYSQL* admin) {
+	const char* q { "SELECT MAX(Latency_us) FROM stats_mysql_connection_pool WHERE status='ONLINE'" };
+	const ext_val_t<int64_t> latency { mysql_query_ext_val(admin, q, int64_t(-1)) };
+	if (latency.err) {
+		diag("Query '%s' failed: %s", q, get_ext_val_err(admin, latency).c_str());
+	}
+	return latency.val;
+}
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return EXIT_FAILURE;
+	}
+
+	plan(2);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return EXIT_FAILURE;
+	}
+
+	MYSQL* proxy = mysql_init(NULL);
+	if (!mysql_real_connect(proxy, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(proxy));
+		return EXIT_FAILURE;
+	}
+
+	MYSQL_QUERY(
+		admin, "SELECT variable_value FROM global_variables WHERE variable_name='mysql-passive_health_latency_percentile'"
+	);
+	MYSQL_RES* res = mysql_store_result(admin);
+	MYSQL_ROW row = mysql_fetch_row(res);
+	const string latency_percentile { row[0] };
+	mysql_free_result(res);
+
+	MYSQL_QUERY(admin, "SET mysql-passive_health_latency_percentile=90");
+	MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	// queries are needed in the next window to compute the latency of the previous one
+	for (int i = 0; i < TRAFFIC_TIME_S * 1000000 / QUERY_TIME_US; i++) {
+		MYSQL_QUERY(proxy, "SELECT SLEEP(0.2)");
+		mysql_free_result(mysql_store_result(proxy));
+	}
+
+	const long long passive_latency = get_max_latency_us(admin);
+	ok(
+		passive_latency >= QUERY_TIME_US,
+		"Latency should follow the queries time - Exp:>=%lld, Act:%lld", QUERY_TIME_US, passive_latency
+	);
+
+	MYSQL_QUERY(admin, "SET mysql-passive_health_latency_percentile=0");
+	MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	// the latency computed from the traffic expires, the next pings restore the latency from the monitor
+	MYSQL_QUERY(admin, "SELECT variable_value FROM global_variables WHERE variable_name='mysql-monitor_ping_interval'");
+	res = mysql_store_result(admin);
+	row = mysql_fetch_row(res);
+	const int ping_interval_ms = atoi(row[0]);
+	mysql_free_result(res);
+	sleep(2 + 2 * ping_interval_ms / 1000);
+
+	const long long ping_latency = get_max_latency_us(admin);
+	ok(
+		ping_latency >= 0 && ping_latency < QUERY_TIME_US,
+		"Latency should be the one from the monitor - Exp:<%lld, Act:%lld", QUERY_TIME_US, ping_latency
+	);
+
+	MYSQL_QUERY(admin, string { "SET mysql-passive_health_latency_percentile=" + latency_percentile }.c_str());
+	MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	mysql_close(proxy);
+	mysql_close(admin);
+
+	return exit_status();
+}
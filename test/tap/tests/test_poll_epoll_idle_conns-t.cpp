@@ -0,0 +1,143 @@
+/**
+ * @file test_poll_epoll_idle_conns-t.cpp
+ * @brief This test checks that, with 'mysql-poll_backend=1' (epoll), the poll entries processed by the worker
+ *   threads for each query don't grow with the number of idle client connections.
+ * @details The test runs the same queries on a single connection, first with few client connections, then
+ *   with many idle client connections, and computes the average increase of 'Poll_entries_processed' in
+ *   'stats_mysql_global' per query. It checks that:
+ *   1. All the connections are established and all the queries succeed.
+ *   2. With epoll, the entries processed per query with many idle connections stay close to the ones with
+ *      few connections: only the entries with events, or whose events changed, are processed.
+ *   3. With poll, the entries processed per query grow with the idle connections, since every entry is
+ *      walked on every loop. This checks that the metric does measure the walks.
+ *   The original 'mysql-poll_backend' is restored at the end.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "mysql.h"
+
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+
+using std::string;
+using std::vector;
+
+const int NUM_IDLE_CONNS = 500;
+const int NUM_QUERIES = 500;
+
+int set_poll_backend(MYSQL* admin, const string& backend) {
+	MYSQL_QUERY(admin, string { "SET mysql-poll_backend=" + backend }.c_str());
+	MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	// the worker threads switch backend in their next loop, and process all the entries once
+	sleep(2);
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Runs 'NUM_QUERIES' queries, and returns the average increase of 'Poll_entries_processed' per query,
+ *   or -1 in case of error.
+ */
+double run_queries(MYSQL* admin, MYSQL* proxy, int& failed) {
+	const long long processed_before = get_stats_mysql_global(admin, "Poll_entries_processed").val;
+	for (int i = 0; i < NUM_QUERIES; i++) {
+		if (mysql_query(proxy, "SELECT /* test_poll_epoll_idle_conns */ 1")) {
+			diag("Query failed: %s", mysql_error(proxy));
+			failed++;
+		} else {
+			mysql_free_result(mysql_store_result(proxy));
+		}
+	}
+	const long long processed_after = get_stats_mysql_global(admin, "Poll_entries_processed").val;
+	diag("'Poll_entries_processed' - Before:%lld, After:%lld", processed_before, processed_after);
+	if (processed_before < 0 || processed_after < processed_before) {
+		return -1;
+	}
+	return (double)(processed_after - processed_before) / NUM_QUERIES;
+}
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return EXIT_FAILURE;
+	}
+
+	plan(3);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return EXIT_FAILURE;
+	}
+
+	string orig_poll_backend {};
+	if (get_variable_value(admin, "mysql-poll_backend", orig_poll_backend)) {
+		return EXIT_FAILURE;
+	}
+
+	MYSQL* proxy = mysql_init(NULL);
+	if (!mysql_real_connect(proxy, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(proxy));
+		return EXIT_FAILURE;
+	}
+
+	int failed = 0;
+	if (set_poll_backend(admin, "1")) {
+		return EXIT_FAILURE;
+	}
+	diag("Running queries with epoll and few connections");
+	const double epoll_few = run_queries(admin, proxy, failed);
+
+	vector<MYSQL*> idle_conns {};
+	for (int i = 0; i < NUM_IDLE_CONNS; i++) {
+		MYSQL* conn = mysql_init(NULL);
+		if (!mysql_real_connect(conn, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+			diag("Failed to open idle connection %d: %s", i, mysql_error(conn));
+			mysql_close(conn);
+			failed++;
+			break;
+		}
+		idle_conns.push_back(conn);
+	}
+
+	diag("Running queries with epoll and %lu idle connections", idle_conns.size());
+	const double epoll_many = run_queries(admin, proxy, failed);
+
+	if (set_poll_backend(admin, "0")) {
+		return EXIT_FAILURE;
+	}
+	diag("Running queries with poll and %lu idle connections", idle_conns.size());
+	const double poll_many = run_queries(admin, proxy, failed);
+
+	ok(failed == 0, "All the connections and queries should succeed - Failed:%d", failed);
+	ok(
+		epoll_few > 0 && epoll_many > 0 && epoll_many < 2 * epoll_few,
+		"With epoll the entries processed per query should not grow with idle connections - Few:%.2f, Many:%.2f",
+		epoll_few, epoll_many
+	);
+	ok(
+		epoll_many > 0 && poll_many > 2 * epoll_many,
+		"With poll the entries processed per query should grow with idle connections - poll:%.2f, epoll:%.2f",
+		poll_many, epoll_many
+	);
+
+	for (MYSQL* conn : idle_conns) {
+		mysql_close(conn);
+	}
+	mysql_close(proxy);
+
+	MYSQL_QUERY(admin, string { "SET mysql-poll_backend=" + orig_poll_backend }.c_str());
+	MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	mysql_close(admin);
+
+	return exit_status();
+}
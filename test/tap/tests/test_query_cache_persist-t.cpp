@@ -0,0 +1,148 @@
+/**
+ * @file test_query_cache_persist-t.cpp
+ * @brief This test checks that the Query Cache entries are restored after a restart when
+ *   'mysql-query_cache_persist_interval_sec' is enabled.
+ * @details The test enables the snapshots of the Query Cache, and caches a query through a query rule with
+ *   'cache_ttl'. The configuration is saved to disk, since it's reloaded from disk by 'PROXYSQL RESTART'.
+ *   It then restarts ProxySQL and checks that:
+ *   1. The query is a cache hit before the restart.
+ *   2. ProxySQL is back after 'PROXYSQL RESTART'.
+ *   3. 'Query_Cache_Entries' isn't 0 after the restart, and 'Query_Cache_count_SET' didn't change: the
+ *      restored entries are not accounted as SET.
+ *   4. The query is a cache hit after the restart, and returns the expected resultset.
+ *   The original configuration is restored at the end.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+#include <string>
+
+#include "mysql.h"
+
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+
+using std::string;
+
+const int QC_PERSIST_RULE_ID = 2027;
+const char* QC_PERSIST_QUERY = "SELECT /* test_query_cache_persist */ 2027";
+const int RESTART_TIMEOUT_SEC = 30;
+
+/**
+ * @brief Runs the test query, and returns if it was served by the Query Cache, or -1 in case of error.
+ */
+int run_cached_query(MYSQL* admin, MYSQL* proxy) {
+	const long long get_ok_before = get_stats_mysql_global(admin, "Query_Cache_count_GET_OK").val;
+	if (mysql_query(proxy, QC_PERSIST_QUERY)) {
+		diag("Query failed: %s", mysql_error(proxy));
+		return -1;
+	}
+	MYSQL_RES* res = mysql_store_result(proxy);
+	MYSQL_ROW row = res ? mysql_fetch_row(res) : NULL;
+	const bool valid = row && row[0] && strcmp(row[0], "2027") == 0;
+	mysql_free_result(res);
+	if (valid == false) {
+		diag("Unexpected resultset for query '%s'", QC_PERSIST_QUERY);
+		return -1;
+	}
+	const long long get_ok_after = get_stats_mysql_global(admin, "Query_Cache_count_GET_OK").val;
+	diag("'Query_Cache_count_GET_OK' - Before:%lld, After:%lld", get_ok_before, get_ok_after);
+	return get_ok_before >= 0 && get_ok_after > get_ok_before;
+}
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return EXIT_FAILURE;
+	}
+
+	plan(4);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return EXIT_FAILURE;
+	}
+
+	string orig_persist_intv {};
+	if (get_variable_value(admin, "mysql-query_cache_persist_interval_sec", orig_persist_intv)) {
+		return EXIT_FAILURE;
+	}
+	const string rule_id { std::to_string(QC_PERSIST_RULE_ID) };
+
+	MYSQL_QUERY(admin, "SET mysql-query_cache_persist_interval_sec=1");
+	MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	MYSQL_QUERY(admin, "SAVE MYSQL VARIABLES TO DISK");
+	MYSQL_QUERY(admin, string { "DELETE FROM mysql_query_rules WHERE rule_id=" + rule_id }.c_str());
+	MYSQL_QUERY(
+		admin,
+		string {
+			"INSERT INTO mysql_query_rules (rule_id,active,match_digest,cache_ttl,apply) VALUES (" + rule_id +
+				",1,'test_query_cache_persist',600000,1)"
+		}.c_str()
+	);
+	MYSQL_QUERY(admin, "LOAD MYSQL QUERY RULES TO RUNTIME");
+	MYSQL_QUERY(admin, "SAVE MYSQL QUERY RULES TO DISK");
+	MYSQL_QUERY(admin, "PROXYSQL FLUSH QUERY CACHE");
+
+	MYSQL* proxy = mysql_init(NULL);
+	if (!mysql_real_connect(proxy, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(proxy));
+		return EXIT_FAILURE;
+	}
+	// the first execution populates the cache, the second one is served by it
+	run_cached_query(admin, proxy);
+	const int hit_before = run_cached_query(admin, proxy);
+	ok(hit_before == 1, "The query should be a cache hit before the restart - Act:%d", hit_before);
+	mysql_close(proxy);
+	const long long sets_before = get_stats_mysql_global(admin, "Query_Cache_count_SET").val;
+
+	// the snapshot is also written at shutdown, the sleep covers the periodic one too
+	sleep(2);
+	diag("Running: PROXYSQL RESTART");
+	mysql_query(admin, "PROXYSQL RESTART");
+	mysql_close(admin);
+	sleep(2);
+
+	const conn_opts_t admin_opts { cl.host, cl.admin_username, cl.admin_password, cl.admin_port };
+	admin = wait_for_proxysql(admin_opts, RESTART_TIMEOUT_SEC);
+	ok(admin != nullptr, "ProxySQL should be back after the restart");
+	if (admin == nullptr) {
+		skip(2, "ProxySQL didn't restart");
+		return exit_status();
+	}
+
+	const long long entries = get_stats_mysql_global(admin, "Query_Cache_Entries").val;
+	const long long sets_after = get_stats_mysql_global(admin, "Query_Cache_count_SET").val;
+	ok(
+		entries > 0 && sets_after == sets_before,
+		"The entries should be restored without being accounted as SET - Entries:%lld, SET before:%lld, SET after:%lld",
+		entries, sets_before, sets_after
+	);
+
+	proxy = mysql_init(NULL);
+	if (!mysql_real_connect(proxy, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(proxy));
+		return EXIT_FAILURE;
+	}
+	const int hit_after = run_cached_query(admin, proxy);
+	ok(hit_after == 1, "The query should be a cache hit after the restart - Act:%d", hit_after);
+	mysql_close(proxy);
+
+	MYSQL_QUERY(admin, string { "DELETE FROM mysql_query_rules WHERE rule_id=" + rule_id }.c_str());
+	MYSQL_QUERY(admin, "LOAD MYSQL QUERY RULES TO RUNTIME");
+	MYSQL_QUERY(admin, "SAVE MYSQL QUERY RULES TO DISK");
+	MYSQL_QUERY(admin, string { "SET mysql-query_cache_persist_interval_sec=" + orig_persist_intv }.c_str());
+	MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	MYSQL_QUERY(admin, "SAVE MYSQL VARIABLES TO DISK");
+	MYSQL_QUERY(admin, "PROXYSQL FLUSH QUERY CACHE");
+	mysql_close(admin);
+
+	return exit_status();
+}
@@ -0,0 +1,156 @@
+/**
+ * @file test_query_cache_stmt_execute-t.cpp
+ * @brief This test checks that the Query Cache serves binary resultsets for
+ *   'COM_STMT_EXECUTE' when a query rule with 'cache_ttl' matches the prepared
+ *   statement.
+ * @details The test configures a caching query rule, prepares 'SELECT ?' and
+ *   executes it several times with different parameters. It then checks:
+ *   1. Executions with already seen parameters are served from the cache,
+ *      looking at 'Query_Cache_count_GET_OK' in 'stats_mysql_global'.
+ *   2. Executions with new parameters are NOT served from the cache.
+ *   3. Resultsets served from the cache hold the value bound for the execution.
+ */
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "mysql.h"
+
+#include "proxysql_utils.h"
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+
+using std::string;
+using std::vector;
+
+const char* STMT_QUERY = "SELECT /* test_query_cache_stmt_execute */ ?";
+
+int get_qc_get_ok(MYSQL* proxy_admin) {
+	int res = -1;
+	const char* q = "SELECT Variable_Value FROM stats_mysql_global WHERE Variable_Name='Query_Cache_count_GET_OK'";
+	if (mysql_query(proxy_admin, q)) {
+		diag("Failed to execute query '%s': %s", q, mysql_error(proxy_admin));
+		return res;
+	}
+	MYSQL_RES* myres = mysql_store_result(proxy_admin);
+	MYSQL_ROW row = mysql_fetch_row(myres);
+	if (row && row[0]) {
+		res = atoi(row[0]);
+	}
+	mysql_free_result(myres);
+	return res;
+}
+
+/**
+ * @brief Executes the prepared statement binding 'param' and returns the fetched value.
+ * @return The value of the single row returned, or '-1' in case of error.
+ */
+int64_t execute_stmt(MYSQL_STMT* stmt, int64_t param) {
+	MYSQL_BIND bind_param;
+	memset(&bind_param, 0, sizeof(MYSQL_BIND));
+	bind_param.buffer_type = MYSQL_TYPE_LONGLONG;
+	bind_param.buffer = (char *)&param;
+
+	if (mysql_stmt_bind_param(stmt, &bind_param)) {
+		diag("'mysql_stmt_bind_param' at line %d failed: %s", __LINE__, mysql_stmt_error(stmt));
+		return -1;
+	}
+	if (mysql_stmt_execute(stmt)) {
+		diag("'mysql_stmt_execute' at line %d failed: %s", __LINE__, mysql_stmt_error(stmt));
+		return -1;
+	}
+
+	int64_t data = -1;
+	my_bool is_null = 0;
+	unsigned long length = 0;
+	MYSQL_BIND bind_res;
+	memset(&bind_res, 0, sizeof(MYSQL_BIND));
+	bind_res.buffer_type = MYSQL_TYPE_LONGLONG;
+	bind_res.buffer = (char *)&data;
+	bind_res.is_null = &is_null;
+	bind_res.length = &length;
+
+	if (mysql_stmt_bind_result(stmt, &bind_res)) {
+		diag("'mysql_stmt_bind_result' at line %d failed: %s", __LINE__, mysql_stmt_error(stmt));
+		return -1;
+	}
+	if (mysql_stmt_store_result(stmt) || mysql_stmt_fetch(stmt)) {
+		diag("Fetching resultset at line %d failed: %s", __LINE__, mysql_stmt_error(stmt));
+		return -1;
+	}
+	mysql_stmt_free_result(stmt);
+
+	return data;
+}
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return EXIT_FAILURE;
+	}
+
+	// (param, expected cache hit)
+	const vector<std::pair<int64_t,bool>> executions {
+		{ 1, false }, { 1, true }, { 2, false }, { 1, true }, { 2, true }, { 3, false }
+	};
+
+	plan(executions.size() * 2);
+
+	MYSQL* proxy_admin = mysql_init(NULL);
+	if (!mysql_real_connect(proxy_admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(proxy_admin));
+		return EXIT_FAILURE;
+	}
+
+	vector<string> admin_queries = {
+		"DELETE FROM mysql_query_rules",
+		"INSERT INTO mysql_query_rules (rule_id,active,match_digest,cache_ttl) VALUES (1,1,'test_query_cache_stmt_execute',60000)",
+		"LOAD MYSQL QUERY RULES TO RUNTIME",
+		"PROXYSQL FLUSH QUERY CACHE",
+	};
+	for (const auto& query : admin_queries) {
+		diag("Running: %s", query.c_str());
+		MYSQL_QUERY(proxy_admin, query.c_str());
+	}
+
+	MYSQL* proxy_mysql = mysql_init(NULL);
+	if (!mysql_real_connect(proxy_mysql, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(proxy_mysql));
+		return EXIT_FAILURE;
+	}
+
+	MYSQL_STMT* stmt = mysql_stmt_init(proxy_mysql);
+	if (mysql_stmt_prepare(stmt, STMT_QUERY, strlen(STMT_QUERY))) {
+		diag("'mysql_stmt_prepare' at line %d failed: %s", __LINE__, mysql_stmt_error(stmt));
+		return EXIT_FAILURE;
+	}
+
+	for (const auto& exec : executions) {
+		int get_ok_before = get_qc_get_ok(proxy_admin);
+		int64_t value = execute_stmt(stmt, exec.first);
+		int get_ok_after = get_qc_get_ok(proxy_admin);
+
+		ok(
+			value == exec.first, "Resultset should hold the bound value - Exp:'%ld', Act:'%ld'",
+			exec.first, value
+		);
+		bool cache_hit = get_ok_after - get_ok_before == 1;
+		ok(
+			cache_hit == exec.second, "Execution with param '%ld' should be served from cache - Exp:'%d', Act:'%d'",
+			exec.first, exec.second, cache_hit
+		);
+	}
+
+	mysql_stmt_close(stmt);
+	mysql_close(proxy_mysql);
+
+	MYSQL_QUERY(proxy_admin, "DELETE FROM mysql_query_rules");
+	MYSQL_QUERY(proxy_admin, "LOAD MYSQL QUERY RULES TO RUNTIME");
+	mysql_close(proxy_admin);
+
+	return exit_status();
+}
@@ -0,0 +1,177 @@
+/**
+ * @file test_session_migration-t.cpp
+ * @brief This test checks that client sessions are migrated between worker threads when
+ *   'mysql-session_migration_threshold' is enabled, and that they keep working.
+ * @details The test sets 'mysql-session_migration_threshold=1' and opens many connections. Using
+ *   'PROXYSQL INTERNAL SESSION' it finds the worker thread with most sessions, and runs queries only on the
+ *   sessions of that thread, from several client threads: that worker is busy while the others are idle.
+ *   It then checks:
+ *   1. All the queries succeed and return the expected result.
+ *   2. 'PROXYSQL INTERNAL SESSION' reports a worker thread for every session.
+ *   3. 'Sessions_migrated' in 'stats_mysql_global' increased.
+ *   4. The sessions that were on the busy worker thread are now served by more than one worker thread.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mysql.h"
+
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+
+#include "json.hpp"
+
+using std::map;
+using std::string;
+using std::vector;
+using nlohmann::json;
+
+const int NUM_CONNS = 64;
+const int NUM_CLIENT_THREADS = 8;
+// sessions are checked for migration once per second
+const int LOAD_DURATION_SEC = 6;
+
+std::atomic<int> failed_queries { 0 };
+
+void run_queries(vector<MYSQL*> conns) {
+	const auto end = std::chrono::steady_clock::now() + std::chrono::seconds(LOAD_DURATION_SEC);
+	for (int i = 0; std::chrono::steady_clock::now() < end; i++) {
+		for (MYSQL* conn : conns) {
+			const string exp { std::to_string(i) };
+			const string q { "SELECT /* test_session_migration */ " + exp };
+			if (mysql_query(conn, q.c_str())) {
+				failed_queries++;
+				continue;
+			}
+			MYSQL_RES* res = mysql_store_result(conn);
+			MYSQL_ROW row = res ? mysql_fetch_row(res) : NULL;
+			if (row == NULL || row[0] == NULL || exp != row[0]) {
+				failed_queries++;
+			}
+			mysql_free_result(res);
+		}
+	}
+}
+
+/**
+ * @brief Returns the address of the worker thread of the session, or an empty string if not reported.
+ */
+string get_session_thread(MYSQL* conn) {
+	json j_session = fetch_internal_session(conn, false);
+	if (j_session.find("thread") == j_session.end()) {
+		return "";
+	}
+	return j_session["thread"];
+}
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return EXIT_FAILURE;
+	}
+
+	plan(4);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return EXIT_FAILURE;
+	}
+
+	MYSQL_QUERY(admin, "SET mysql-session_migration_threshold=1");
+	MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	vector<MYSQL*> conns {};
+	map<string,vector<MYSQL*>> thread_conns {};
+	int no_thread = 0;
+	for (int c = 0; c < NUM_CONNS; c++) {
+		MYSQL* proxy = mysql_init(NULL);
+		if (!mysql_real_connect(proxy, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+			fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(proxy));
+			return EXIT_FAILURE;
+		}
+		conns.push_back(proxy);
+		const string thread_addr { get_session_thread(proxy) };
+		if (thread_addr.empty()) {
+			no_thread++;
+		} else {
+			thread_conns[thread_addr].push_back(proxy);
+		}
+	}
+
+	// the busy worker thread is the one with most sessions
+	string busy_thread {};
+	for (const auto& thr : thread_conns) {
+		diag("Worker thread %s has %lu sessions", thr.first.c_str(), thr.second.size());
+		if (busy_thread.empty() || thr.second.size() > thread_conns[busy_thread].size()) {
+			busy_thread = thr.first;
+		}
+	}
+	if (thread_conns.size() < 2) {
+		diag("Only one worker thread received sessions, migrations require at least two worker threads");
+	}
+	const vector<MYSQL*> busy_conns { busy_thread.empty() ? vector<MYSQL*> {} : thread_conns[busy_thread] };
+
+	const long long migrated_before = get_stats_mysql_global(admin, "Sessions_migrated").val;
+
+	vector<vector<MYSQL*>> client_conns(NUM_CLIENT_THREADS);
+	for (size_t i = 0; i < busy_conns.size(); i++) {
+		client_conns[i % NUM_CLIENT_THREADS].push_back(busy_conns[i]);
+	}
+	vector<std::thread> client_threads;
+	for (int t = 0; t < NUM_CLIENT_THREADS; t++) {
+		client_threads.push_back(std::thread(run_queries, client_conns[t]));
+	}
+	for (std::thread& th : client_threads) {
+		th.join();
+	}
+	ok(failed_queries == 0, "All queries should succeed - Exp:0, Act:%d", failed_queries.load());
+
+	const long long migrated_after = get_stats_mysql_global(admin, "Sessions_migrated").val;
+
+	map<string,int> busy_conns_threads {};
+	for (MYSQL* conn : busy_conns) {
+		const string thread_addr { get_session_thread(conn) };
+		if (thread_addr.empty()) {
+			no_thread++;
+		} else {
+			busy_conns_threads[thread_addr]++;
+		}
+	}
+	for (const auto& thr : busy_conns_threads) {
+		diag("Worker thread %s now has %d of the busy sessions", thr.first.c_str(), thr.second);
+	}
+	ok(no_thread == 0, "Every session should belong to a worker thread - Exp:0, Act:%d", no_thread);
+
+	ok(
+		migrated_before >= 0 && migrated_after > migrated_before,
+		"'Sessions_migrated' should increase - Before:%lld, After:%lld", migrated_before, migrated_after
+	);
+	ok(
+		busy_conns_threads.size() > 1,
+		"The busy sessions should be spread over more worker threads - Exp:'>1', Act:%lu",
+		busy_conns_threads.size()
+	);
+
+	for (MYSQL* conn : conns) {
+		mysql_close(conn);
+	}
+
+	MYSQL_QUERY(admin, "SET mysql-session_migration_threshold=0");
+	MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	mysql_close(admin);
+
+	return exit_status();
+}
@@ -0,0 +1,184 @@
+/**
+ * @file test_session_timeouts_wheel-t.cpp
+ * @brief This test checks that 'mysql-wait_timeout' is enforced on sessions scheduled in the timer
+ *   wheel of the worker threads, also when the variable is changed after the sessions were created.
+ * @details The test:
+ *   1. Opens a connection while 'mysql-wait_timeout' is high, and lowers it to 3 seconds: the
+ *      connection should be killed once idle for longer than the new value.
+ *   2. Opens a connection and keeps it active with a query every second: the connection should not
+ *      be killed, as the timers are checked against the last activity of the session.
+ *   3. Opens a TCP connection that never answers the initial handshake, with 'mysql-wait_timeout' high and
+ *      'mysql-connect_timeout_client' of 2 seconds: the connection should be closed by ProxySQL once the
+ *      connect timeout expired.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/socket.h>
+
+#include <string>
+
+#include "mysql.h"
+#include "mysqld_error.h"
+#include "errmsg.h"
+
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+
+using std::string;
+
+const int WAIT_TIMEOUT_MS = 3000;
+const int CONNECT_TIMEOUT_CLIENT_MS = 2000;
+
+MYSQL* open_proxy_conn(const CommandLine& cl) {
+	MYSQL* proxy = mysql_init(NULL);
+	if (!mysql_real_connect(proxy, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(proxy));
+		mysql_close(proxy);
+		return NULL;
+	}
+	return proxy;
+}
+
+/**
+ * @brief Opens a TCP connection to ProxySQL, and reads the initial handshake without answering it.
+ * @return The socket, or -1 in case of error.
+ */
+int open_unauthenticated_conn(const CommandLine& cl) {
+	struct addrinfo hints;
+	struct addrinfo* res = NULL;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	const string port { std::to_string(cl.port) };
+	if (getaddrinfo(cl.host, port.c_str(), &hints, &res) != 0 || res == NULL) {
+		diag("Failed to resolve '%s'", cl.host);
+		return -1;
+	}
+	int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+	if (fd >= 0 && connect(fd, res->ai_addr, res->ai_addrlen) != 0) {
+		diag("Failed to connect to '%s:%d': %s", cl.host, cl.port, strerror(errno));
+		close(fd);
+		fd = -1;
+	}
+	freeaddrinfo(res);
+	if (fd >= 0) {
+		char buf[1024];
+		if (recv(fd, buf, sizeof(buf), 0) <= 0) {
+			diag("Failed to read the initial handshake");
+			close(fd);
+			fd = -1;
+		}
+	}
+	return fd;
+}
+
+/**
+ * @brief Returns true if the peer closed the connection within 'timeout_ms'.
+ */
+bool wait_for_peer_close(int fd, int timeout_ms) {
+	struct pollfd pfd { fd, POLLIN, 0 };
+	while (poll(&pfd, 1, timeout_ms) > 0) {
+		char buf[1024];
+		ssize_t rc = recv(fd, buf, sizeof(buf), 0);
+		if (rc <= 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return EXIT_FAILURE;
+	}
+
+	plan(3);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return EXIT_FAILURE;
+	}
+
+	MYSQL_QUERY(admin, "SET mysql-wait_timeout=28800000");
+	MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	MYSQL* idle_conn = open_proxy_conn(cl);
+	if (idle_conn == NULL) {
+		return EXIT_FAILURE;
+	}
+	MYSQL_QUERY(idle_conn, "SELECT 1");
+	mysql_free_result(mysql_store_result(idle_conn));
+
+	const string set_wait_timeout { "SET mysql-wait_timeout=" + std::to_string(WAIT_TIMEOUT_MS) };
+	MYSQL_QUERY(admin, set_wait_timeout.c_str());
+	MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	MYSQL* active_conn = open_proxy_conn(cl);
+	if (active_conn == NULL) {
+		return EXIT_FAILURE;
+	}
+	int active_errors = 0;
+	for (int i = 0; i < (WAIT_TIMEOUT_MS / 1000) * 2 + 1; i++) {
+		sleep(1);
+		if (mysql_query(active_conn, "SELECT 1")) {
+			diag("Query on active connection failed: %s", mysql_error(active_conn));
+			active_errors++;
+		} else {
+			mysql_free_result(mysql_store_result(active_conn));
+		}
+	}
+
+	int rc = mysql_query(idle_conn, "SELECT 1");
+	int err = mysql_errno(idle_conn);
+	ok(
+		rc != 0 && (err == CR_SERVER_LOST || err == CR_SERVER_GONE_ERROR),
+		"Idle connection should be killed after the new 'mysql-wait_timeout' - errno:%d, error:'%s'",
+		err, mysql_error(idle_conn)
+	);
+	if (rc == 0) {
+		mysql_free_result(mysql_store_result(idle_conn));
+	}
+	ok(active_errors == 0, "Active connection should not be killed - Exp errors:0, Act:%d", active_errors);
+
+	mysql_close(idle_conn);
+	mysql_close(active_conn);
+
+	string orig_connect_timeout_client {};
+	if (get_variable_value(admin, "mysql-connect_timeout_client", orig_connect_timeout_client)) {
+		diag("Failed to get 'mysql-connect_timeout_client'");
+		return EXIT_FAILURE;
+	}
+	MYSQL_QUERY(admin, "SET mysql-wait_timeout=28800000");
+	const string set_connect_timeout {
+		"SET mysql-connect_timeout_client=" + std::to_string(CONNECT_TIMEOUT_CLIENT_MS)
+	};
+	MYSQL_QUERY(admin, set_connect_timeout.c_str());
+	MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	int unauth_fd = open_unauthenticated_conn(cl);
+	// the timers are checked when the worker thread wakes up, at least every 'mysql-poll_timeout'
+	const bool closed = unauth_fd >= 0 && wait_for_peer_close(unauth_fd, CONNECT_TIMEOUT_CLIENT_MS * 2 + 1000);
+	ok(
+		closed, "Unauthenticated connection should be closed after 'mysql-connect_timeout_client' - fd:%d",
+		unauth_fd
+	);
+	if (unauth_fd >= 0) {
+		close(unauth_fd);
+	}
+
+	MYSQL_QUERY(admin, string { "SET mysql-connect_timeout_client=" + orig_connect_timeout_client }.c_str());
+	MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+	mysql_close(admin);
+
+	return exit_status();
+}
@@ -0,0 +1,100 @@
+/**
+ * @file test_threads_cpu_affinity-t.cpp
+ * @brief This test checks that worker threads are pinned and unpinned following
+ *   'mysql-threads_cpu_affinity', and that client connections keep working meanwhile.
+ * @details The test:
+ *   1. Enables 'mysql-threads_cpu_affinity': 'MySQL_Thread_Workers_pinned' should match 'MySQL_Thread_Workers'.
+ *   2. Runs queries on new connections, and checks that the NUMA locality counters are reported in
+ *      'stats_mysql_global'.
+ *   3. Disables 'mysql-threads_cpu_affinity': 'MySQL_Thread_Workers_pinned' should drop to 0.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+#include <string>
+
+#include "mysql.h"
+
+#include "tap.h"
+#include "command_line.h"
+#include "utils.h"
+
+using std::string;
+
+const int NUM_CONNS = 20;
+// worker threads apply the new value on their next loop, see 'mysql-poll_timeout'
+const int REFRESH_TIMEOUT_S = 10;
+
+bool wait_pinned_threads(MYSQL* admin, int64_t exp, int64_t& act) {
+	for (int i = 0; i < REFRESH_TIMEOUT_S * 10; i++) {
+		act = get_stats_mysql_global(admin, "MySQL_Thread_Workers_pinned").val;
+		if (act == exp) {
+			return true;
+		}
+		usleep(100 * 1000);
+	}
+	return false;
+}
+
+int main(int argc, char** argv) {
+	CommandLine cl;
+
+	if (cl.getEnv()) {
+		diag("Failed to get the required environmental variables.");
+		return EXIT_FAILURE;
+	}
+
+	plan(5);
+
+	MYSQL* admin = mysql_init(NULL);
+	if (!mysql_real_connect(admin, cl.host, cl.admin_username, cl.admin_password, NULL, cl.admin_port, NULL, 0)) {
+		fprintf(stderr, "File %s, line %d, Error: %s\n", __FILE__, __LINE__, mysql_error(admin));
+		return EXIT_FAILURE;
+	}
+
+	const int64_t workers = get_stats_mysql_global(admin, "MySQL_Thread_Workers").val;
+	if (workers < 0) {
+		return EXIT_FAILURE;
+	}
+
+	MYSQL_QUERY(admin, "SET mysql-threads_cpu_affinity=1");
+	MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	int64_t pinned = -1;
+	bool all_pinned = wait_pinned_threads(admin, workers, pinned);
+	ok(all_pinned, "All the worker threads should be pinned - Exp:%ld, Act:%ld", workers, pinned);
+
+	int failed_queries = 0;
+	for (int i = 0; i < NUM_CONNS; i++) {
+		MYSQL* proxy = mysql_init(NULL);
+		if (!mysql_real_connect(proxy, cl.host, cl.username, cl.password, NULL, cl.port, NULL, 0)) {
+			diag("Connection failed: %s", mysql_error(proxy));
+			failed_queries++;
+		} else if (mysql_query(proxy, "SELECT 1")) {
+			diag("Query failed: %s", mysql_error(proxy));
+			failed_queries++;
+		} else {
+			mysql_free_result(mysql_store_result(proxy));
+		}
+		mysql_close(proxy);
+	}
+	ok(failed_queries == 0, "All queries on pinned threads should succeed - Exp:0, Act:%d", failed_queries);
+
+	for (const char* counter : { "Client_Connections_numa_local", "Client_Connections_numa_remote" }) {
+		const ext_val_t<int64_t> value { get_stats_mysql_global(admin, counter) };
+		ok(value.err == 0, "'%s' should be reported - Act:%ld", counter, value.val);
+	}
+
+	MYSQL_QUERY(admin, "SET mysql-threads_cpu_affinity=0");
+	MYSQL_QUERY(admin, "LOAD MYSQL VARIABLES TO RUNTIME");
+
+	bool none_pinned = wait_pinned_threads(admin, 0, pinned);
+	ok(none_pinned, "No worker thread should be pinned - Exp:0, Act:%ld", pinned);
+
+	mysql_close(admin);
+
+	return exit_status();
+}
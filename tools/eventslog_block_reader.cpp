@@ -0,0 +1,331 @@
+// Reader for the events log format 3 (mysql-eventslog_format=3).
+// Blocks whose index (time range, digests and users) doesn't match the filters are skipped without
+// reading their payload, see MySQL_Events_Block in lib/MySQL_Logger.cpp for the format.
+//
+// Usage: eventslog_block_reader [-s start] [-e end] [-d digest] [-u username] [-i] file [file ...]
+//   -s, -e : start time range of the events, as 'YYYY-MM-DD HH:MM:SS' (local time) or microseconds since epoch
+//   -d     : query digest, as printed in the events log (e.g. 0x1F2E3D4C5B6A7980)
+//   -u     : username
+//   -i     : only print the index of the matching blocks
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <zlib.h>
+using namespace std;
+
+#define MYSQL_LOGGER_BLOCK_MAGIC	0x31425350
+#define MYSQL_LOGGER_BLOCK_ZLIB	0x1
+
+enum log_event_type {
+	PROXYSQL_COM_QUERY,
+	PROXYSQL_MYSQL_AUTH_OK,
+	PROXYSQL_MYSQL_AUTH_ERR,
+	PROXYSQL_MYSQL_AUTH_CLOSE,
+	PROXYSQL_MYSQL_AUTH_QUIT,
+	PROXYSQL_MYSQL_CHANGE_USER_OK,
+	PROXYSQL_MYSQL_CHANGE_USER_ERR,
+	PROXYSQL_MYSQL_INITDB,
+	PROXYSQL_ADMIN_AUTH_OK,
+	PROXYSQL_ADMIN_AUTH_ERR,
+	PROXYSQL_ADMIN_AUTH_CLOSE,
+	PROXYSQL_ADMIN_AUTH_QUIT,
+	PROXYSQL_SQLITE_AUTH_OK,
+	PROXYSQL_SQLITE_AUTH_ERR,
+	PROXYSQL_SQLITE_AUTH_CLOSE,
+	PROXYSQL_SQLITE_AUTH_QUIT,
+	PROXYSQL_COM_STMT_EXECUTE,
+	PROXYSQL_COM_STMT_PREPARE
+};
+
+struct filters_t {
+	uint64_t start = 0;
+	uint64_t end = UINT64_MAX;
+	bool have_digest = false;
+	uint64_t digest = 0;
+	bool have_user = false;
+	string user;
+	bool index_only = false;
+};
+
+struct block_index_t {
+	uint64_t min_start_time;
+	uint64_t max_start_time;
+	vector<uint64_t> digests;
+	vector<string> users;
+};
+
+// reads length encoded integers and strings of a format 1 record
+class record_reader {
+	const unsigned char *ptr;
+	const unsigned char *end;
+	public:
+	record_reader(const unsigned char *_ptr, size_t len) : ptr(_ptr), end(_ptr + len) {}
+	bool ok() { return ptr <= end; }
+	uint8_t u8() {
+		return (ptr < end ? *ptr++ : (ptr++, 0));
+	}
+	uint64_t length() {
+		uint64_t v = 0;
+		uint8_t b = u8();
+		unsigned int l = 0;
+		if (b < 0xfb) return b;
+		if (b == 0xfc) l = 2;
+		if (b == 0xfd) l = 3;
+		if (b == 0xfe) l = 8;
+		if (ptr + l > end) { ptr = end + 1; return 0; }
+		memcpy(&v, ptr, l);
+		ptr += l;
+		return v;
+	}
+	string str() {
+		uint64_t l = length();
+		if (ptr + l > end) { ptr = end + 1; return string(); }
+		string s((const char *)ptr, l);
+		ptr += l;
+		return s;
+	}
+};
+
+static string format_time(uint64_t t) {
+	char buffer[26];
+	char buffer2[40];
+	time_t timer = t/1000/1000;
+	struct tm* tm_info = localtime(&timer);
+	strftime(buffer, 26, "%Y-%m-%d %H:%M:%S", tm_info);
+	snprintf(buffer2, sizeof(buffer2), "%s.%06u", buffer, (unsigned)(t%1000000));
+	return string(buffer2);
+}
+
+static uint64_t parse_time(const char *s) {
+	struct tm tm_info;
+	memset(&tm_info, 0, sizeof(tm_info));
+	const char *r = strptime(s, "%Y-%m-%d %H:%M:%S", &tm_info);
+	if (r && *r == 0) {
+		tm_info.tm_isdst = -1;
+		return (uint64_t)mktime(&tm_info) * 1000 * 1000;
+	}
+	return strtoull(s, NULL, 10);
+}
+
+static bool block_matches(const block_index_t& idx, const filters_t& f) {
+	if (idx.max_start_time < f.start || idx.min_start_time > f.end) {
+		return false;
+	}
+	if (f.have_digest && binary_search(idx.digests.begin(), idx.digests.end(), f.digest) == false) {
+		return false;
+	}
+	if (f.have_user && find(idx.users.begin(), idx.users.end(), f.user) == idx.users.end()) {
+		return false;
+	}
+	return true;
+}
+
+static bool parse_footer(const string& footer, block_index_t& idx) {
+	size_t off = 0;
+	uint32_t n = 0;
+	if (footer.size() < sizeof(uint64_t)*2 + sizeof(uint32_t)) return false;
+	memcpy(&idx.min_start_time, footer.data(), sizeof(uint64_t));
+	memcpy(&idx.max_start_time, footer.data() + sizeof(uint64_t), sizeof(uint64_t));
+	off = sizeof(uint64_t)*2;
+	memcpy(&n, footer.data() + off, sizeof(uint32_t));
+	off += sizeof(uint32_t);
+	if (off + n*sizeof(uint64_t) + sizeof(uint32_t) > footer.size()) return false;
+	idx.digests.resize(n);
+	memcpy(idx.digests.data(), footer.data() + off, n*sizeof(uint64_t));
+	off += n*sizeof(uint64_t);
+	memcpy(&n, footer.data() + off, sizeof(uint32_t));
+	off += sizeof(uint32_t);
+	for (uint32_t i = 0; i < n; i++) {
+		uint32_t ul = 0;
+		if (off + sizeof(uint32_t) > footer.size()) return false;
+		memcpy(&ul, footer.data() + off, sizeof(uint32_t));
+		off += sizeof(uint32_t);
+		if (off + ul > footer.size()) return false;
+		idx.users.push_back(footer.substr(off, ul));
+		off += ul;
+	}
+	return true;
+}
+
+// prints the events of a block that match the filters, in the same format of eventslog_reader_sample
+static void print_events(const unsigned char *raw, size_t len, const filters_t& f) {
+	size_t off = 0;
+	while (off + sizeof(uint64_t) <= len) {
+		uint64_t rec_len = 0;
+		memcpy(&rec_len, raw + off, sizeof(uint64_t));
+		off += sizeof(uint64_t);
+		if (off + rec_len > len) {
+			cerr << "Truncated event in block" << endl;
+			return;
+		}
+		record_reader r(raw + off, rec_len);
+		off += rec_len;
+		log_event_type et = (log_event_type)r.u8();
+		uint64_t thread_id = r.length();
+		string username = r.str();
+		string schemaname = r.str();
+		string client = r.str();
+		uint64_t hid = r.length();
+		string server;
+		if (hid != UINT64_MAX) {
+			server = r.str();
+		}
+		uint64_t start_time = r.length();
+		uint64_t end_time = r.length();
+		uint64_t client_stmt_id = 0;
+		if (et == PROXYSQL_COM_STMT_PREPARE || et == PROXYSQL_COM_STMT_EXECUTE) {
+			client_stmt_id = r.length();
+		}
+		uint64_t affected_rows = r.length();
+		uint64_t last_insert_id = r.length();
+		uint64_t rows_sent = r.length();
+		uint64_t query_digest = r.length();
+		string query = r.str();
+		if (r.ok() == false) {
+			cerr << "Invalid event in block" << endl;
+			return;
+		}
+		if (start_time < f.start || start_time > f.end) continue;
+		if (f.have_digest && query_digest != f.digest) continue;
+		if (f.have_user && username != f.user) continue;
+		cout << "ProxySQL LOG ";
+		switch (et) {
+			case PROXYSQL_COM_STMT_EXECUTE:
+				cout << "COM_STMT_EXECUTE";
+				break;
+			case PROXYSQL_COM_STMT_PREPARE:
+				cout << "COM_STMT_PREPARE";
+				break;
+			default:
+				cout << "COM_QUERY";
+				break;
+		}
+		cout << ": thread_id=\"" << thread_id << "\" username=\"" << username << "\" schemaname=\"" << schemaname << "\" client=\"" << client << "\"";
+		if (hid == UINT64_MAX) {
+			cout << " HID=NULL ";
+		} else {
+			cout << " HID=" << hid << " server=\"" << server << "\"";
+		}
+		cout << " starttime=\"" << format_time(start_time) << "\"";
+		cout << " endtime=\"" << format_time(end_time) << "\"";
+		cout << " duration=" << (end_time-start_time) << "us";
+		if (et == PROXYSQL_COM_STMT_PREPARE || et == PROXYSQL_COM_STMT_EXECUTE) {
+			cout << " client_stmt_id=" << client_stmt_id;
+		}
+		char digest_hex[20];
+		sprintf(digest_hex,"0x%016llX", (long long unsigned int)query_digest);
+		cout << " rows_affected=" << affected_rows;
+		cout << " last_insert_id=" << last_insert_id;
+		cout << " rows_sent=" << rows_sent;
+		cout << " digest=\"" << digest_hex << "\"" << endl << query << endl;
+	}
+}
+
+static int read_file(const char *path, const filters_t& f) {
+	ifstream input(path, ios::in | ios::binary);
+	if (input.is_open() == false) {
+		cerr << "Opening log file '" << path << "' failed" << endl;
+		return EXIT_FAILURE;
+	}
+	uint32_t hdr[6];
+	unsigned long long blocks = 0;
+	unsigned long long blocks_read = 0;
+	while (input.read((char *)hdr, sizeof(hdr))) {
+		if (hdr[0] != MYSQL_LOGGER_BLOCK_MAGIC) {
+			cerr << "Invalid block at offset " << (unsigned long long)input.tellg() - sizeof(hdr) << " of '" << path << "'" << endl;
+			return EXIT_FAILURE;
+		}
+		uint32_t payload_len = hdr[1];
+		uint32_t raw_len = hdr[2];
+		uint32_t footer_len = hdr[3];
+		uint32_t n_events = hdr[4];
+		uint32_t flags = hdr[5];
+		streampos payload_pos = input.tellg();
+		// read only the index, the payload is read if the block matches the filters
+		input.seekg(payload_len, ios::cur);
+		string footer(footer_len, '\0');
+		block_index_t idx;
+		if (!input.read(&footer[0], footer_len) || parse_footer(footer, idx) == false) {
+			cerr << "Invalid index of block at offset " << (unsigned long long)payload_pos - sizeof(hdr) << " of '" << path << "'" << endl;
+			return EXIT_FAILURE;
+		}
+		blocks++;
+		if (block_matches(idx, f) == false) {
+			continue;
+		}
+		blocks_read++;
+		if (f.index_only) {
+			cout << "Block at offset " << (unsigned long long)payload_pos - sizeof(hdr) << ": events=" << n_events
+				<< " bytes=" << raw_len << " compressed_bytes=" << payload_len
+				<< " starttime=\"" << format_time(idx.min_start_time) << "\" - \"" << format_time(idx.max_start_time) << "\""
+				<< " digests=" << idx.digests.size() << " users=" << idx.users.size() << endl;
+			continue;
+		}
+		streampos next_pos = input.tellg();
+		input.seekg(payload_pos);
+		vector<unsigned char> payload(payload_len);
+		input.read((char *)payload.data(), payload_len);
+		if (flags & MYSQL_LOGGER_BLOCK_ZLIB) {
+			vector<unsigned char> raw(raw_len);
+			uLongf dest_len = raw_len;
+			if (uncompress(raw.data(), &dest_len, payload.data(), payload_len) != Z_OK || dest_len != raw_len) {
+				cerr << "Failed to uncompress block at offset " << (unsigned long long)payload_pos - sizeof(hdr) << " of '" << path << "'" << endl;
+				return EXIT_FAILURE;
+			}
+			print_events(raw.data(), raw_len, f);
+		} else {
+			print_events(payload.data(), payload_len, f);
+		}
+		input.seekg(next_pos);
+	}
+	cerr << path << ": " << blocks_read << " of " << blocks << " blocks read" << endl;
+	return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv) {
+	filters_t f;
+	int opt;
+	while ((opt = getopt(argc, argv, "s:e:d:u:i")) != -1) {
+		switch (opt) {
+			case 's':
+				f.start = parse_time(optarg);
+				break;
+			case 'e':
+				f.end = parse_time(optarg);
+				break;
+			case 'd':
+				f.have_digest = true;
+				f.digest = strtoull(optarg, NULL, 16);
+				break;
+			case 'u':
+				f.have_user = true;
+				f.user = optarg;
+				break;
+			case 'i':
+				f.index_only = true;
+				break;
+			default:
+				cerr << "Usage: " << argv[0] << " [-s start] [-e end] [-d digest] [-u username] [-i] file [file ...]" << endl;
+				return EXIT_FAILURE;
+		}
+	}
+	if (optind >= argc) {
+		cerr << "Invalid number of arguments. Please supply path to target log file." << endl;
+		return EXIT_FAILURE;
+	}
+	int rc = EXIT_SUCCESS;
+	for (int i = optind; i < argc; i++) {
+		if (read_file(argv[i], f) != EXIT_SUCCESS) {
+			rc = EXIT_FAILURE;
+		}
+	}
+	return rc;
+}